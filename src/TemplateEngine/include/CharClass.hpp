@@ -0,0 +1,99 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#ifndef __CHAR_CLASS_HPP_
+#define __CHAR_CLASS_HPP_
+
+/** \internal
+ * \file CharClass.hpp
+ * \brief Locale free character classification for the lexer.
+ *
+ * The template syntax is pure ASCII, so code units are classified with
+ * a 128 entry table generated at compile time. Everything outside ASCII
+ * is char_class_t::Other, regardless of the code unit size and of the
+ * C locale, which keeps UTF-8 lead bytes and UTF-16 code units above
+ * 0xFF out of std::isalnum() and std::isspace().
+ */
+
+#include <cstdint>
+#include "Types.hpp"
+
+namespace template_engine
+{
+TE_BEGIN_FLAVOUR
+
+/** \internal \brief The character classes distinguished by the lexer. */
+enum class char_class_t : uint8_t {
+	Other,      ///< Any code unit without a special meaning, including everything outside ASCII.
+	Name,       ///< Valid in a name, <code>[A-Za-z0-9_-]</code>.
+	Space,      ///< White space, as std::isspace() in the C locale.
+	Marker,     ///< Instruction markers <code>#</code>, <code>/</code> and <code>:</code>.
+	Open,       ///< <code>{</code>
+	Close,      ///< <code>}</code>
+	Escape,     ///< <code>\\</code>
+	Pipe,       ///< <code>|</code>, separates the filters of an expansion.
+};
+
+/** \internal \brief Number of values in char_class_t */
+const size_t charClassCount = 8;
+
+/** \internal \brief The ASCII character class table, built at compile time. */
+struct CharClassTable
+{
+	char_class_t classes[128];	//!< Class of each ASCII code unit.
+
+	constexpr CharClassTable() : classes()
+	{
+		for (int ch = 0; ch < 128; ++ch) {
+			char_class_t cls = char_class_t::Other;
+			if ((ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9') || ch == '_' || ch == '-')
+				cls = char_class_t::Name;
+			else if (ch == ' ' || (ch >= '\t' && ch <= '\r'))
+				cls = char_class_t::Space;
+			else if (ch == '#' || ch == '/' || ch == ':')
+				cls = char_class_t::Marker;
+			else if (ch == '{')
+				cls = char_class_t::Open;
+			else if (ch == '}')
+				cls = char_class_t::Close;
+			else if (ch == '\\')
+				cls = char_class_t::Escape;
+			else if (ch == '|')
+				cls = char_class_t::Pipe;
+			classes[ch] = cls;
+		}
+	}
+};
+
+/** \internal \brief The one and only character class table. */
+constexpr CharClassTable charClassTable;
+
+/** \internal \brief Classify a code unit. */
+constexpr char_class_t classify(te_char_t ch)
+{
+	unsigned int unit = te_code_unit(ch);
+	return unit < 0x80 ? charClassTable.classes[unit] : char_class_t::Other;
+}
+
+/** \internal \brief ASCII only lower case conversion, other code units are returned unchanged. */
+constexpr te_char_t asciiToLower(te_char_t ch)
+{
+	return (ch >= TE_TEXT('A') && ch <= TE_TEXT('Z')) ? static_cast<te_char_t>(ch - TE_TEXT('A') + TE_TEXT('a')) : ch;
+}
+
+TE_END_FLAVOUR
+}
+#endif // !__CHAR_CLASS_HPP_
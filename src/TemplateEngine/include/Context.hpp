@@ -23,6 +23,7 @@
 #include "Dictionary.hpp"
 
 namespace template_engine {
+TE_BEGIN_FLAVOUR
 
 class Context;
 typedef std::shared_ptr<Context> ContextPtr;
@@ -84,5 +85,6 @@ private:
     DictionaryPtr _dictionary;      //<!@internal The current root dictionary.
 };
 
+TE_END_FLAVOUR
 }
 #endif // !__CONTEXT_HPP_
@@ -17,17 +17,23 @@
 #ifndef __DICTIONARY_HPP_
 #define __DICTIONARY_HPP_
 
+#include <cstdint>
 #include <memory>
 #include <unordered_map>
 #include <iostream>
 #include <utility>
+#include <vector>
 
 #include "Types.hpp"
+#include "TypedValue.hpp"
+#include "ValueProvider.hpp"
 
 namespace template_engine {
+TE_BEGIN_FLAVOUR
 
 class DictionaryList;
 class Context;
+class SpecializedTemplate;
 
 /** \brief Define a pointer to a DictionaryList */
 typedef std::shared_ptr<DictionaryList> DictionaryListPtr;
@@ -42,6 +48,7 @@ class Dictionary : public std::enable_shared_from_this<Dictionary>
 {
 	friend DictionaryList;
 	friend Context;
+	friend SpecializedTemplate;
 private:
 
     /** \brief The element to be stored in the Dictionary
@@ -53,14 +60,19 @@ private:
 	    enum class element_t {
 		Unknown,        ///< Invalid value, only temporarily used internally
 		Value,          ///< The Element is a simple string value
-		List            ///< The Element is a DictionaryList
+		List,           ///< The Element is a DictionaryList
+		Typed,          ///< The Element is a simple TypedValue
+		Provider        ///< The Element is a simple value computed by a ValueProvider
 	    };
 	    element_t type;     ///< The Element variant.
+	    uint64_t version;   ///< When the element was stored, see Dictionary::getVersion().
 
 	    /** Anonymous union holding the specific values */
 	    union {
 		std::shared_ptr<DictionaryList> list;       ///< Dictionary list
 		std::shared_ptr<const te_string> value;     ///< Simple string value
+		TypedValue typed;                           ///< Simple typed value
+		std::shared_ptr<const ValueProvider> provider;  ///< Provider of a simple string value
 	    };
 
 
@@ -71,6 +83,7 @@ private:
          */
 	Element(const te_string value) :
 	    type(element_t::Value),
+	    version(nextVersion()),
 	    value(std::make_shared<const te_string>(te_string(value)))
 	{}
 
@@ -81,11 +94,34 @@ private:
          */
 	Element(DictionaryListPtr value) :
 	    type(element_t::List),
+	    version(nextVersion()),
 	    list(value)
 	{}
 
+        /** \brief Construct a typed value based element
+         *
+         * \param value const TypedValue& The typed value to store.
+         *
+         */
+	Element(const TypedValue& value) :
+	    type(element_t::Typed),
+	    version(nextVersion()),
+	    typed(value)
+	{}
+
+        /** \brief Construct a provider based element
+         *
+         * \param value const std::shared_ptr<const ValueProvider>& The provider to store.
+         *
+         */
+	Element(const std::shared_ptr<const ValueProvider>& value) :
+	    type(element_t::Provider),
+	    version(nextVersion()),
+	    provider(value)
+	{}
+
         /** \brief Copy constructer. */
-	Element(const Element& other) : type(element_t::Unknown), value(nullptr)
+	Element(const Element& other) : type(element_t::Unknown), version(other.version), value(nullptr)
 	{
 	    type = other.type;
 	    switch(other.type) {
@@ -95,6 +131,12 @@ private:
 		case element_t::List:
 		    list = other.list;
 		    break;
+		case element_t::Typed:
+		    typed = other.typed;
+		    break;
+		case element_t::Provider:
+		    provider = other.provider;
+		    break;
 		case element_t::Unknown:
 		default:
 		    break;
@@ -115,6 +157,9 @@ private:
 		    case element_t::Value:
 			value.~shared_ptr<const te_string>();
 			break;
+		    case element_t::Provider:
+			provider.~shared_ptr<const ValueProvider>();
+			break;
 		    case element_t::Unknown:
 			default:
 			break;
@@ -131,12 +176,11 @@ public:
 
 	/** \brief Get a reference to the parent of this dictionary.
 	*
+	* While a list is rendered, its parent is the dictionary it is rendered in, see ListScope.
+	*
 	* \return A pointer to the parent, may be nullptr
 	*/
-	const DictionaryPtr getParent()
-	{
-		return _parent.lock();
-	}
+	const DictionaryPtr getParent() const;
 	
 	/** \brief Can the name be found in the Dictionary hierarchy.
      *
@@ -146,22 +190,77 @@ public:
      */
 	virtual bool exists(const te_string& name) const;
 
-    /** \brief does the specified name represent a simple string value.
+    /** \brief Is the name defined by this Dictionary itself or its layers, the parent scopes are not searched.
+     *
+     * \param name Element name to lookup in this Dictionary.
+     * \return true if the name exists, false otherwise.
+     */
+	bool existsLocal(const te_string& name) const;
+
+    /** \brief does the specified name represent a simple value, a string, a TypedValue or a provided value.
      *
      * \param name Element name to lookup in the Dictionary hierarchy.
-     * \return true if the name represents a simple string value, false otherwise.
+     * \return true if the name represents a simple value, false otherwise.
      * \throw TemplateException if the name cannot be found.
      */
 	virtual bool isValue(const te_string& name) const;
 
+    /** \brief does the specified name represent a TypedValue.
+     *
+     * \param name Element name to lookup in the Dictionary hierarchy.
+     * \return true if the name represents a TypedValue, false otherwise.
+     * \throw TemplateException if the name cannot be found.
+     */
+	bool isTyped(const te_string& name) const;
+
+    /** \brief does the specified name represent a value computed by a ValueProvider.
+     *
+     * \param name Element name to lookup in the Dictionary hierarchy.
+     * \return true if the name represents a provided value, false otherwise.
+     * \throw TemplateException if the name cannot be found.
+     */
+	bool isProvided(const te_string& name) const;
+
     /** \brief Return the simple string value stored with the given key.
+     *
+     * A provided value is computed once per RenderScope, and can only be read within one.
      *
      * \param name Element name to lookup in the Dictionary hierarchy.
      * \return The simple string value represented by the key.
-     * \throw TemplateException if the name cannot be found or isn't a simple string value.
+     * \throw TemplateException if the name cannot be found or isn't a simple string value,
+     *        or is provided and no RenderScope is open.
      */
 	virtual const te_string&  getValue(const te_string& name) const;
 
+    /** \brief Return the TypedValue stored with the given key.
+     *
+     * \param name Element name to lookup in the Dictionary hierarchy.
+     * \return The typed value represented by the key.
+     * \throw TemplateException if the name cannot be found or isn't a TypedValue.
+     */
+	const TypedValue& getTyped(const te_string& name) const;
+
+    /** \brief Find a simple value with a single search of the hierarchy.
+     *
+     * This is what the templates use to expand a value, a name which can't
+     * be found isn't an error.
+     *
+     * \param name Element name to lookup in the Dictionary hierarchy.
+     * \param typed Set to the TypedValue if the value is typed, nullptr otherwise.
+     * \return The simple string value, nullptr if the value is typed, or if the name can't be found or is a list.
+     * \throw TemplateException if the value is provided and no RenderScope is open, or the provider throws.
+     */
+	const te_string* findValue(const te_string& name, const TypedValue*& typed) const;
+
+    /** \brief Append the simple value stored with the given key to out, formatted.
+     *
+     * \param name Element name to lookup in the Dictionary hierarchy.
+     * \param format The format, see ValueFormat.
+     * \param out The string to append to.
+     * \throw TemplateException if the name cannot be found, isn't a simple value, or the format doesn't apply to it.
+     */
+	void formatValue(const te_string& name, const ValueFormat& format, te_string& out) const;
+
     /** \brief does the specified name represent a DictionaryList.
      *
      * \param name Element name to lookup in the Dictionary hierarchy.
@@ -178,13 +277,14 @@ public:
      */
 	virtual const std::shared_ptr<DictionaryList>& getList(const te_string& name) const;
 
-    /** \brief Add a simple UTF-16 string value to the Dictionary.
+    /** \brief Add a simple string value to the Dictionary.
      *
      * \param name The key to the value
      * \param value The value to store
      */
 	virtual void add(const te_string name, const te_string value);
 
+#ifndef TE_USE_UTF8
     /** \brief Add a simple UTF-8 string value to the Dictionary.
      * Note! since UTF-8 values are stored in std::string's there is
      * a risk of polluting the Dictionary with non Unicode strings.
@@ -192,6 +292,7 @@ public:
      * \param value The value to store
      */
 	virtual void add(const te_string name, const std::string& value);
+#endif
 
     /** \brief Add a DictionaryList value to the Dictionary.
      *
@@ -200,6 +301,91 @@ public:
      */
 	virtual void add(const te_string name, DictionaryListPtr value);
 
+    /** \brief Add a simple typed value to the Dictionary, it is formatted when it is expanded.
+     *
+     * \param name The key to the value
+     * \param value The value to store
+     */
+	virtual void add(const te_string name, const TypedValue& value);
+
+    /** \brief Store a simple string value, replacing any element with the same name.
+     *
+     * \param name The key to the value
+     * \param value The value to store
+     */
+	void set(const te_string& name, const te_string& value);
+
+    /** \brief Store a DictionaryList value, replacing any element with the same name.
+     *
+     * \param name The key to the list
+     * \param value The list to store
+     */
+	void set(const te_string& name, DictionaryListPtr value);
+
+    /** \brief Store a simple typed value, replacing any element with the same name.
+     *
+     * \param name The key to the value
+     * \param value The value to store
+     */
+	void set(const te_string& name, const TypedValue& value);
+
+    /** \brief Add a simple value which is computed when it is expanded.
+     *
+     * The provider is only called if a template expands the name, and at
+     * most once per RenderScope, every render opens one. It is called on the
+     * thread rendering the template. A template specialized with the
+     * dictionary keeps the expansion, the value is computed whenever the
+     * residual template is rendered.
+     *
+     * \code
+     * dict->addProvider(TE_TEXT("RECOMMENDED"), [=]() { return recommendations(user); });
+     * \endcode
+     *
+     * \param name The key to the value
+     * \param provider The provider of the value
+     * \throw TemplateException if the provider is empty.
+     */
+	void addProvider(const te_string& name, ValueProvider provider);
+
+    /** \brief Store a simple value which is computed when it is expanded, replacing any element with the same name.
+     *
+     * \param name The key to the value
+     * \param provider The provider of the value
+     * \throw TemplateException if the provider is empty.
+     */
+	void setProvider(const te_string& name, ValueProvider provider);
+
+    /** \brief Remove an element from the Dictionary itself, the parent scopes are not searched.
+     *
+     * \param name The key of the element.
+     * \return true if the element was removed, false if it didn't exist.
+     */
+	bool remove(const te_string& name);
+
+    /** \brief Version of the latest change to the Dictionary itself.
+     *
+     * Every element is stamped with a version when it is stored, taken from
+     * a counter shared by all dictionaries, so a version is never reused.
+     * The version of the dictionary is that of the latest element stored or
+     * removed, and for a DictionaryList also of the latest change to its
+     * sub-dictionaries. A RenderCache compares versions to find out what
+     * has changed since the previous render.
+     */
+	inline uint64_t getVersion() const { return _version; }
+
+    /** \brief Version of the element stored with the given key in the Dictionary itself.
+     *
+     * \param name Element name to lookup, the parent scopes are not searched.
+     * \return The version the element was stored with, 0 if it doesn't exist.
+     */
+	uint64_t getVersion(const te_string& name) const;
+
+protected:
+    /** \brief A version which hasn't been used before. */
+	static uint64_t nextVersion();
+
+	uint64_t _version;      ///< Version of the latest change, see getVersion().
+
 private:
     /** Simplify referencing the STL container */
 	typedef std::unordered_map<te_string, Element> te_dict;
@@ -207,6 +393,16 @@ private:
 	/** STL collection backing the Dictionary */
 	te_dict _map;
 
+	/** Dictionaries whose own elements are looked up after those in _map, see addLayer() */
+	std::vector<DictionaryPtr> _layers;
+
+    /** \brief Search the Dictionary itself and its layers, the parent scopes are not searched.
+     *
+     * \param name The key to search for
+     * \return the element matching the specified key, nullptr if the name isn't defined by the Dictionary.
+     */
+	const Element* findLocal(const te_string& name) const;
+
     /** \brief Perform recursive search of the dictionary hierarchy.
      *
      * \param name The key to search for
@@ -214,6 +410,19 @@ private:
      * \throws TemplateException if the name cannot be located in the hierarchy.
      */
 	const Element& find(const te_string& name) const;
+
+    /** \brief Perform recursive search of the dictionary hierarchy, without throwing.
+     *
+     * \param name The key to search for
+     * \return the element matching the specified key, nullptr if the name cannot be located in the hierarchy.
+     */
+	const Element* findElement(const te_string& name) const;
+
+    /** \brief The value of a provider element, in the RenderScope open on the thread.
+     *
+     * \throws TemplateException if no RenderScope is open.
+     */
+	static const te_string& provide(const te_string& name, const Element& e);
 protected:
 	std::weak_ptr<Dictionary> _parent;    ///< Reference to the parent scope/dictionary (may be nullptr)
 
@@ -225,7 +434,20 @@ protected:
 	{
 	    _parent = parent;
 	}
+
+    /** \brief Look up the own elements of layer after those of this dictionary, and before the parent scope.
+     *
+     * The parent of layer is neither searched nor changed, so a dictionary
+     * can be a layer of any number of scopes at once.
+     *
+     * \param layer The dictionary to add.
+     */
+	void addLayer(const DictionaryPtr& layer)
+	{
+	    _layers.push_back(layer);
+	}
 };
 
+TE_END_FLAVOUR
 }
 #endif // !__DICTIONARY_HPP_
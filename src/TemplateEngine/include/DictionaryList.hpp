@@ -17,30 +17,65 @@
 #ifndef __DICTIONARY_LIST_HPP_
 #define __DICTIONARY_LIST_HPP_
 
+#include <functional>
 #include <memory>
 #include <vector>
 
 #include "Dictionary.hpp"
 
 namespace template_engine {
+TE_BEGIN_FLAVOUR
 
 class RepeatTemplate;
+class GeneratedTemplate;
 
 class DictionaryList;
 typedef std::shared_ptr<DictionaryList> DictionaryListPtr;
 
+/** \brief Produces the next row of a generated DictionaryList, or nullptr when there are no more rows. */
+typedef std::function<DictionaryPtr()> RowGenerator;
+
 /** \brief A Dictionary in it's own right, but also stores a - potentially empty - list/vector of sub-dictionaries.
  * The sub-dictionaries can be iterated over using a simple cursoring mechanism, sorry no fancy STL iterator.
+ *
+ * Rather than storing them, a generated list produces its rows on demand,
+ * e.g. from a database cursor. A repeat calls the generator until it
+ * returns nullptr, and releases each row as soon as it is rendered, so a
+ * list of millions of rows is rendered in constant memory. Rendered into
+ * an OutputSink, the output is handed over to the sink as the rows are
+ * rendered, see Template::renderInto(const ContextPtr, OutputSink&, TemplateEscaper).
+ *
+ * \code
+ * dict->add(TE_TEXT("ORDERS"), std::make_shared<DictionaryList>([&cursor]() -> DictionaryPtr {
+ *     if (!cursor.next())
+ *         return nullptr;
+ *     DictionaryPtr row = std::make_shared<Dictionary>();
+ *     row->add(TE_TEXT("ID"), TypedValue(cursor.id()));
+ *     return row;
+ * }));
+ * \endcode
+ *
+ * Every repeat of the list calls the generator again, a generator reading
+ * a cursor produces its rows once. A generated list has no stored rows, so
+ * the cursor and size() don't apply to it.
  */
 class DictionaryList : public Dictionary
 {
 	friend Dictionary;
 	friend RepeatTemplate;
+	friend GeneratedTemplate;
 
 public:
     /** Construct an empty dictionary list. */
 	DictionaryList();
 
+    /** \brief Construct a list whose rows are produced by a generator.
+     *
+     * \param generator The generator of the rows.
+     * \throw TemplateException if the generator is empty.
+     */
+	explicit DictionaryList(RowGenerator generator);
+
     /** Release all consumed resources. */
 	virtual ~DictionaryList() {};
 
@@ -51,9 +86,54 @@ public:
     /** \brief Add a Dictionary as a sub-dictionary.
      *
      * \param dict The Dictionary to add.
+     * \throw TemplateException if the list is generated.
      */
 	void add(DictionaryPtr dict);
 
+    /** \brief Are the rows of the list produced by a generator? */
+	inline bool isGenerated() const { return static_cast<bool>(_generator); }
+
+    /** \brief Call f with every row in order, a generated list releases each row when f returns.
+     *
+     * \param f Called with the const DictionaryPtr& of each row.
+     * \throw TemplateException whatever the generator or f throws.
+     */
+	template <typename F>
+	void forEachRow(F f)
+	{
+		if (!_generator) {
+			for (size_t i = 0; i < _dictionaries.size(); i++)
+				f(_dictionaries[i]);
+			return;
+		}
+
+		// the row is released before the next one is produced
+		while (true) {
+			DictionaryPtr row = nextRow();
+			if (!row)
+				return;
+			f(row);
+		}
+	}
+
+    /** \brief Replace a sub-dictionary.
+     *
+     * \param index The position of the sub-dictionary to replace.
+     * \param dict The Dictionary to store in its place.
+     * \throw TemplateException if index is outside of the list.
+     */
+	void set(size_t index, DictionaryPtr dict);
+
+    /** \brief Remove a sub-dictionary, the cursor is reset.
+     *
+     * \param index The position of the sub-dictionary to remove.
+     * \throw TemplateException if index is outside of the list.
+     */
+	void remove(size_t index);
+
+	using Dictionary::set;
+	using Dictionary::remove;
+
     /** \brief Restart the cursor at the first sub-dictionary */
 	void resetCursor();
 
@@ -79,11 +159,55 @@ public:
     /** \copydoc Dictionary::add(const te_string, DictionaryListPtr) */
 	virtual void add(const te_string name, DictionaryListPtr value);
 
+    /** \copydoc Dictionary::add(const te_string, const TypedValue&) */
+	virtual void add(const te_string name, const TypedValue& value);
+
 private:
+    /** \brief The next row of the generator, with the list as its parent scope. */
+	DictionaryPtr nextRow();
+
+	RowGenerator _generator;                    ///< Produces the rows of a generated list, empty otherwise.
 	std::vector<DictionaryPtr> _dictionaries;   ///< STL container storing the sub-dictionaries.
 	size_t _activeDictionary;                   ///< current cursor position.
 };
 
+/** \brief Make a dictionary the parent scope of a list, while its rows are rendered.
+ *
+ * The scope is kept on the rendering thread rather than stored in the list,
+ * so rendering never changes a list. A list which is shared, e.g. by the
+ * known values of a residual template, can then be rendered by several
+ * threads at once, each with a parent scope of its own. Scopes nest, while
+ * one is open Dictionary::getParent() of the list returns its dictionary.
+ */
+class ListScope
+{
+public:
+    /** \brief Open the scope.
+     *
+     * \param list The list which is rendered, must outlive the scope.
+     * \param parent The dictionary the list is rendered in, must outlive the scope.
+     */
+	ListScope(const DictionaryList& list, const DictionaryPtr& parent);
+
+    /** \brief Close the scope, the scopes must be closed in the reverse order of opening. */
+	~ListScope();
+
+	ListScope(const ListScope&) = delete;
+	ListScope& operator=(const ListScope&) = delete;
+
+    /** \brief The parent scope of a list in the innermost scope open on this thread.
+     *
+     * \param list The list, or any other dictionary.
+     * \return The dictionary the list is rendered in, nullptr if no scope of the list is open.
+     */
+	static const DictionaryPtr* find(const Dictionary* list);
+
+private:
+	const Dictionary* _list;        ///< The list which is rendered.
+	const DictionaryPtr& _parent;   ///< The dictionary it is rendered in.
+	ListScope* _outer;              ///< The scope which was innermost before this one.
+};
+
 // iterator class for the dictionary list
 //template <typename ValueType> class DictionaryListIterator :
 //	std::iterator<std::input_iterator_tag, ValueType>
@@ -109,5 +233,6 @@ private:
 //typedef DictionaryListIterator<Dictionary> iterator_type;
 //typedef DictionaryListIterator<const Dictionary> const_iterator_type;
 
+TE_END_FLAVOUR
 }
 #endif // !__DICTIONARY_LIST_HPP_
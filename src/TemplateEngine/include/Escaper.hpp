@@ -0,0 +1,83 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#ifndef __ESCAPER_HPP_
+#define __ESCAPER_HPP_
+
+#include "Template.hpp"
+
+namespace template_engine
+{
+TE_BEGIN_FLAVOUR
+
+/** \brief Escapes values for HTML text and attributes, <code>& < > " '</code> become character references.
+ *
+ * An escaper has a static append(), which appends a value to the output
+ * with the special characters of the format escaped. The value is scanned
+ * for special characters with SSE2 or AVX2 where available, the runs in
+ * between are copied in bulk. An escaper can be passed to
+ * Template::renderInto() as a TemplateEscaper, selected with
+ * Template::render<Escaper>(), or wrapped in a TemplateFilter with
+ * escapeFilter() where a filter is expected.
+ */
+struct HtmlEscaper
+{
+    /** \brief Append the value to out, escaped. */
+	static void append(te_string& out, const te_char_t* value, size_t length);
+};
+
+/** \brief Escapes values for XML text and attributes, as HtmlEscaper except <code>'</code> becomes <code>&amp;apos;</code>. */
+struct XmlEscaper
+{
+    /** \copydoc HtmlEscaper::append() */
+	static void append(te_string& out, const te_char_t* value, size_t length);
+};
+
+/** \brief Escapes values for the inside of a JSON string, <code>" \\</code> and control characters are escaped. */
+struct JsonEscaper
+{
+    /** \copydoc HtmlEscaper::append() */
+	static void append(te_string& out, const te_char_t* value, size_t length);
+};
+
+/** \brief Escapes values for the inside of a C or C++ string literal.
+ *
+ * <code>" ' \\ ?</code> and control characters are escaped, control
+ * characters without a short form as three digit octal escapes.
+ */
+struct CEscaper
+{
+    /** \copydoc HtmlEscaper::append() */
+	static void append(te_string& out, const te_char_t* value, size_t length);
+};
+
+/** \brief Wrap an escaper in a TemplateFilter, for the interfaces which take a filter.
+ *
+ * \param escaper TemplateEscaper   The escaper, e.g. &HtmlEscaper::append.
+ * \return TemplateFilter           The filter, nullptr if escaper is.
+ */
+TemplateFilter escapeFilter(TemplateEscaper escaper);
+
+/** \brief Wrap an escaper in a TemplateFilter, e.g. <code>escapeFilter<HtmlEscaper>()</code>. */
+template <typename Escaper>
+TemplateFilter escapeFilter()
+{
+	return escapeFilter(&Escaper::append);
+}
+
+TE_END_FLAVOUR
+}
+#endif // !__ESCAPER_HPP_
@@ -18,6 +18,7 @@
 #define __EXCEPTION_HPP_
 
 #include <exception>
+#include <stdexcept>
 #include <string>
 
 namespace template_engine
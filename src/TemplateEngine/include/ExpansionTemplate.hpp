@@ -18,11 +18,18 @@
 #define __EXPANSION_TEMPLATE_HPP_
 
 #include "Template.hpp"
+#include "FilterChain.hpp"
+#include "TypedValue.hpp"
 
 namespace template_engine
 {
+TE_BEGIN_FLAVOUR
 
 /** \brief Simple value <code>{{Name}}</code> template instruction.
+ *
+ * The value may be formatted, <code>{{Name:.2f}}</code>, and passed through a
+ * chain of filters, <code>{{Name|html}}</code>, before the filter or escaper
+ * of the render is applied.
  */
 class ExpansionTemplate :
 	public Template
@@ -32,8 +39,10 @@ public:
      *
      * \param name te_string    The name to be expanded, enclosed in <code>{{</code> and <code>}}</code>
      * \param scopeWalk uint8_t	The name refers to a dictionary this many steps away on the stack
+     * \param format ValueFormat	Format of the value
+     * \param filters FilterChain	Filters the value is passed through
      */
-	ExpansionTemplate(const te_string& name, uint8_t scopeWalk);
+	ExpansionTemplate(const te_string& name, uint8_t scopeWalk, ValueFormat format = ValueFormat(), FilterChain filters = FilterChain());
 
 protected:
 
@@ -46,10 +55,45 @@ protected:
      */
 	virtual te_string render(const DictionaryPtr& dictionary, TemplateFilter filter) const;
 
+    /** \brief Append the value to the output, escaped with the escaper if there is one. */
+	virtual void renderInto(const DictionaryPtr& dictionary, TemplateEscaper escaper, te_string& out) const;
+
+    /** \brief Fold the expansion into a literal, if the name is a constant of the optimizer.
+     *
+     * Only expansions without a scope walk are folded.
+     */
+	virtual TemplatePtr optimize(const TemplateOptimizer& optimizer) const;
+
+    /** \brief Render the expansion into a literal, if the name is known.
+     *
+     * Inside the body of an unrolled repeat, an expansion of a name which
+     * isn't known is rewritten to be looked up from the root scope.
+     * \throws TemplateException If the name is known, but isn't a simple string value.
+     */
+	virtual TemplatePtr specialize(TemplateSpecializer& specializer) const;
+
+    /** \copydoc Template::write() */
+	virtual void write(TemplateWriter& writer) const;
+
+    /** \brief Expand the value, recording the entries read with the cache. */
+	virtual void renderCached(RenderCache& cache, const DictionaryPtr& dictionary, te_string& out) const;
+
+    /** \brief Add the name and scope walk of the expansion. */
+	virtual void addDependencies(TemplateDependencies& scope) const;
+
 private:
+    /** \brief The value in the scope, formatted into formatted unless it is a string without a format.
+     *
+     * \throws TemplateException If the name isn't found or isn't a simple value, or the format doesn't apply to it.
+     */
+	const te_string& lookup(const Dictionary& scope, te_string& formatted) const;
+
 	te_string _name;        //<! Name of the expansion instruction.
 	uint8_t  _scopeWalk;	///< how far to break out of the current scope
+	ValueFormat _format;	///< format of the value
+	FilterChain _filters;	///< filters the value is passed through
 };
 
+TE_END_FLAVOUR
 }
 #endif // !__EXPANSION_TEMPLATE_HPP_
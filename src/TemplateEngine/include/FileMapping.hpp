@@ -0,0 +1,74 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#ifndef __FILE_MAPPING_HPP_
+#define __FILE_MAPPING_HPP_
+
+#include <string>
+
+namespace template_engine
+{
+
+/** \internal
+ * \brief Read only mapping of a complete file, unmapped on destruction.
+ *
+ * Shared by MappedFileScanner, which reads template definitions, and
+ * TemplateImage, which reads compiled templates.
+ *
+ * Mapping and unmapping a file costs more than reading a few KiB, so files
+ * up to readLimit bytes are read into memory instead of being mapped.
+ */
+class FileMapping
+{
+public:
+	/** \brief Size up to which a file is cheaper to read than to map, on typical systems. */
+	static const size_t smallFileSize = 64 * 1024;
+
+    /** \brief Map the file.
+     *
+     * \param path const std::string&   UTF-8 path of the file.
+     * \param readLimit size_t          Files up to this size are read rather than mapped.
+     * \throws TemplateException        If the file can't be opened, mapped or read.
+     */
+	explicit FileMapping(const std::string& path, size_t readLimit = 0);
+
+	~FileMapping();
+
+	FileMapping(const FileMapping&) = delete;
+	FileMapping& operator=(const FileMapping&) = delete;
+
+	/** \brief The contents of the file, nullptr if it is empty */
+	inline const char* data() const { return _data; }
+
+	/** \brief The number of bytes in data() */
+	inline size_t size() const { return _size; }
+
+	/** \brief The text of the file, without a leading UTF-8 byte order mark */
+	inline const char* text() const { return _data + bomLength(); }
+
+	/** \brief The number of bytes in text() */
+	inline size_t textSize() const { return _size - bomLength(); }
+
+private:
+	size_t bomLength() const;
+
+	const char* _data;  //!< The mapped or read file.
+	size_t _size;       //!< Number of bytes in the file.
+	bool _mapped;       //!< Is _data a mapping, as opposed to allocated with new[].
+};
+
+}
+#endif // !__FILE_MAPPING_HPP_
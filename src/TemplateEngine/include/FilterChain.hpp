@@ -0,0 +1,106 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#ifndef __FILTER_CHAIN_HPP_
+#define __FILTER_CHAIN_HPP_
+
+#include <initializer_list>
+#include <vector>
+
+#include "Template.hpp"
+
+namespace template_engine
+{
+TE_BEGIN_FLAVOUR
+
+/** \brief The named filters which can be used in an expansion, <code>{{Name|html}}</code>.
+ *
+ * A filter has the signature of a TemplateEscaper, it appends the
+ * transformed value to the output. The names are ASCII case insensitive.
+ * The built-in filters are:
+ *
+ * Name   |Filter
+ * :------|:------
+ * html   | HtmlEscaper
+ * xml    | XmlEscaper
+ * json   | JsonEscaper
+ * c      | CEscaper
+ * upper  | ASCII letters to upper case
+ * lower  | ASCII letters to lower case
+ *
+ * Filters are looked up when a template is parsed or loaded, so a filter
+ * must be added before the templates using it, and replacing a filter
+ * doesn't affect the templates already parsed.
+ */
+class FilterRegistry
+{
+public:
+    /** \brief Add a filter, or replace the filter of that name.
+     *
+     * \param name const te_string&     Name of the filter, valid as a name in an instruction.
+     * \param filter TemplateEscaper    The filter.
+     * \throws TemplateException        If the name is empty or the filter is nullptr.
+     */
+	static void add(const te_string& name, TemplateEscaper filter);
+
+    /** \brief The filter of that name, or nullptr if there is none. */
+	static TemplateEscaper find(const te_string& name);
+};
+
+/** \brief The filters of an expansion, applied from left to right to the value.
+ *
+ * The filters are resolved by FilterRegistry when the chain is built,
+ * rendering calls them through plain function pointers. The last filter
+ * appends to the output, only the ones before it need a temporary string.
+ */
+class FilterChain
+{
+public:
+    /** \brief An empty chain, which leaves the value as it is. */
+	FilterChain() {}
+
+    /** \brief A chain of the named filters.
+     *
+     * \throws TemplateException If a filter isn't found in the FilterRegistry.
+     */
+	FilterChain(std::initializer_list<te_string> names);
+
+    /** \brief Add the named filter to the end of the chain.
+     *
+     * \throws TemplateException If the filter isn't found in the FilterRegistry.
+     */
+	void push_back(const te_string& name);
+
+    /** \brief Are there no filters in the chain? */
+	inline bool empty() const { return _filters.empty(); }
+
+    /** \brief Names of the filters, in the order they are applied. */
+	inline const std::vector<te_string>& getNames() const { return _names; }
+
+    /** \brief Append the value to out, passed through every filter of the chain. */
+	void apply(te_string& out, const te_char_t* value, size_t length) const;
+
+    /** \brief The value passed through every filter of the chain. */
+	te_string apply(const te_string& value) const;
+
+private:
+	std::vector<te_string> _names;              ///< Names of the filters, as written in the template.
+	std::vector<TemplateEscaper> _filters;      ///< The filters, resolved.
+};
+
+TE_END_FLAVOUR
+}
+#endif // !__FILTER_CHAIN_HPP_
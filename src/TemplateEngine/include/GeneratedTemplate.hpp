@@ -0,0 +1,111 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#ifndef __GENERATED_TEMPLATE_HPP_
+#define __GENERATED_TEMPLATE_HPP_
+
+#include <cstdint>
+
+#include "Template.hpp"
+#include "FilterChain.hpp"
+#include "TypedValue.hpp"
+#include "Dictionary.hpp"
+#include "DictionaryList.hpp"
+
+/** \brief A string constant in code generated by te-compile, given in both encodings.
+ *
+ * The UTF-8 flavour uses the first argument, the UTF-16 flavour the second.
+ */
+#ifdef TE_USE_UTF8
+#define TE_GENERATED_TEXT(UTF8, UTF16)	UTF8
+#else
+#define TE_GENERATED_TEXT(UTF8, UTF16)	UTF16
+#endif
+
+namespace template_engine
+{
+TE_BEGIN_FLAVOUR
+
+/** \brief A template compiled ahead of time into a C++ render function by te-compile.
+ *
+ * te-compile turns every template file into a straight line function,
+ * literals are constant arrays appended to the output, and expansions and
+ * repeats call the helpers below, which look the names up in the same way
+ * as ExpansionTemplate and RepeatTemplate. Nothing is parsed at runtime and
+ * there is no tree to walk.
+ *
+ * The render functions can be called directly, or wrapped in a
+ * GeneratedTemplate and used as any other template.
+ */
+class GeneratedTemplate :
+	public Template
+{
+public:
+	/** \brief Signature of a generated render function, which appends the rendered text to out. */
+	typedef void (*render_function_t)(te_string& out, const DictionaryPtr& dictionary, const TemplateFilter& filter);
+
+    /** \brief Wrap a generated render function.
+     *
+     * \param function render_function_t   The function generated by te-compile.
+     */
+	explicit GeneratedTemplate(render_function_t function);
+
+    /** \brief Append the value of an expansion, see ExpansionTemplate.
+     *
+     * \throws TemplateException If the scope or the name can't be found, or the name isn't a simple value.
+     */
+	static void expand(te_string& out, const DictionaryPtr& dictionary, const te_string& name, uint8_t scopeWalk, const TemplateFilter& filter);
+
+    /** \brief Append the value of an expansion, formatted, passed through its filters and then the filter of the render.
+     *
+     * \throws TemplateException If the scope or the name can't be found, the name isn't a simple value,
+     *                          or the format doesn't apply to it.
+     */
+	static void expand(te_string& out, const DictionaryPtr& dictionary, const te_string& name, uint8_t scopeWalk,
+		const ValueFormat& format, const FilterChain& filters, const TemplateFilter& filter);
+
+    /** \brief Call body with every item of a list, see RepeatTemplate.
+     *
+     * \param dictionary const DictionaryPtr&   The dictionary to look the list up in.
+     * \param name const te_string&             Name of the list.
+     * \param body Body                         Called with the DictionaryPtr of each item.
+     * \throws TemplateException If the list can't be found.
+     */
+	template <typename Body>
+	static void repeat(const DictionaryPtr& dictionary, const te_string& name, Body body)
+	{
+		const DictionaryListPtr& list = enterList(dictionary, name);
+		ListScope scope(*list, dictionary);
+		list->forEachRow(body);
+	}
+
+protected:
+    /** \brief Call the render function. */
+	virtual te_string render(const DictionaryPtr& dictionary, TemplateFilter filter) const;
+
+    /** \brief Call the render function, with the escaper wrapped in a filter. */
+	virtual void renderInto(const DictionaryPtr& dictionary, TemplateEscaper escaper, te_string& out) const;
+
+private:
+    /** \brief Find the list in the dictionary. */
+	static const DictionaryListPtr& enterList(const DictionaryPtr& dictionary, const te_string& name);
+
+	render_function_t _function;    ///< The generated render function.
+};
+
+TE_END_FLAVOUR
+}
+#endif // !__GENERATED_TEMPLATE_HPP_
@@ -0,0 +1,148 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#ifndef __INCREMENTAL_PARSER_HPP_
+#define __INCREMENTAL_PARSER_HPP_
+
+#include <memory>
+#include <vector>
+
+#include "Template.hpp"
+
+namespace template_engine
+{
+TE_BEGIN_FLAVOUR
+
+/** \brief Keeps a template up to date with a definition which is being edited.
+ *
+ * The definition is kept as a tree of blocks, each holding a part of the
+ * definition and the templates parsed from it. Blocks are split just past
+ * a top level instruction or after a line feed, where the lexer is always
+ * in the plain text state, so a block can be parsed on its own. A repeat
+ * instruction larger than a block becomes a block of its own, with the
+ * blocks of its body nested inside it.
+ *
+ * An edit reparses only the blocks it touches. If the edited text isn't
+ * self contained, e.g. a repeat instruction or a comment was opened, the
+ * following blocks are added until it is, if need be the enclosing repeat
+ * instruction is reparsed as well. Every other block, and the templates
+ * parsed from it, is shared with the previous template, so the cost of an
+ * edit depends on the size of the edit and the block size rather than the
+ * size of the definition.
+ *
+ * The templates render exactly as those returned by Template::parse() for
+ * the same definition, though they are nested in more lists.
+ */
+class IncrementalParser
+{
+public:
+	/** \brief Default size of a block, in code units. */
+	static const size_t defaultBlockSize = 4096;
+
+    /** \brief Create a parser, with an empty definition.
+     *
+     * \param maxDepth size_t       How deep repeat instructions may be nested.
+     * \param blockSize size_t      Size the definition is split into blocks of, in code units.
+     */
+	explicit IncrementalParser(size_t maxDepth = Template::defaultMaxDepth, size_t blockSize = defaultBlockSize);
+
+	~IncrementalParser();
+
+    /** \brief Parse a new definition, from scratch.
+     *
+     * \param definition const te_string&   The template definition.
+     * \return TemplatePtr                  Template hierarchy generated from the definition.
+     * \throws TemplateException            All parse errors are reported as exceptions.
+     */
+	TemplatePtr parse(const te_string& definition);
+
+    /** \brief Replace part of the definition, and reparse what it affects.
+     *
+     * If the edited definition can't be parsed the exception is thrown and
+     * the parser is left as it was, i.e. the edit isn't applied.
+     *
+     * \param offset size_t                 Where the edit starts, in code units.
+     * \param removed size_t                Number of code units removed at offset.
+     * \param inserted const te_string&     The text inserted at offset.
+     * \return TemplatePtr                  Template hierarchy generated from the edited definition.
+     * \throws TemplateException            If the edit is outside of the definition, or on parse errors.
+     */
+	TemplatePtr edit(size_t offset, size_t removed, const te_string& inserted);
+
+    /** \brief The template parsed from the current definition. */
+	inline const TemplatePtr& getTemplate() const { return _templ; }
+
+    /** \brief The current definition, assembled from the blocks. */
+	te_string getDefinition() const;
+
+    /** \brief Length of the current definition, in code units. */
+	inline size_t size() const { return _size; }
+
+private:
+	struct Block;
+	struct Segment;
+	typedef std::shared_ptr<const Block> BlockPtr;
+	typedef std::vector<BlockPtr> Blocks;
+
+	/** \brief The structural pass, see ParallelParser::split().
+	 *
+	 * \return false if the text isn't self contained, i.e. a repeat
+	 *         instruction, a comment or an instruction isn't closed within
+	 *         it, or it holds an unmatched end repeat instruction.
+	 */
+	bool split(const te_string& text, std::vector<Segment>& segments) const;
+
+	/** \brief Parse the blocks of a self contained text, at the given nesting depth. */
+	Blocks build(const te_string& text, const std::vector<Segment>& segments, size_t depth) const;
+
+	/** \brief Parse a text as a single block, at the given nesting depth. */
+	BlockPtr buildText(te_string text, size_t depth) const;
+
+	/** \brief Parse a repeat instruction, and the blocks of its body. */
+	BlockPtr buildRepeat(te_string open, const te_string& body, te_string close, size_t depth) const;
+
+	/** \brief A repeat block with a new body. */
+	BlockPtr buildRepeat(const Block& repeat, Blocks body) const;
+
+	/** \brief Apply the edit to the blocks of a single nesting level.
+	 *
+	 * \param blocks const Blocks&  The blocks of the nesting level.
+	 * \param depth size_t          The nesting depth.
+	 * \param atEnd bool            The level ends the definition, rather than an end repeat instruction.
+	 * \param result Blocks&        The blocks after the edit.
+	 * \return false if the edited level isn't self contained, and must be reparsed by the caller.
+	 */
+	bool edit(const Blocks& blocks, size_t depth, bool atEnd, size_t offset, size_t removed, const te_string& inserted, Blocks& result) const;
+
+	/** \brief Make the blocks the current definition. */
+	void assign(Blocks blocks);
+
+	/** \brief A list of the templates of the blocks. */
+	static TemplatePtr makeList(const Blocks& blocks);
+
+	/** \brief Append the definition of the block to text. */
+	static void appendText(const Block& block, te_string& text);
+
+	size_t _maxDepth;       ///< How deep repeat instructions may be nested
+	size_t _blockSize;      ///< Size the definition is split into blocks of
+	Blocks _blocks;         ///< The blocks of the top level
+	size_t _size;           ///< Length of the definition
+	TemplatePtr _templ;     ///< The template parsed from the definition
+};
+
+TE_END_FLAVOUR
+}
+#endif // !__INCREMENTAL_PARSER_HPP_
@@ -19,13 +19,15 @@
 
 #include <utility>
 #include <stack>
-#include <cctype>
+#include <cstdint>
 
+#include "CharClass.hpp"
 #include "Scanner.hpp"
 #include "LookaheadScanner.hpp"
 
 namespace template_engine
 {
+TE_BEGIN_FLAVOUR
 
 /** \brief Manages lexical analysis of a template definition stream.
  *
@@ -33,10 +35,15 @@ namespace template_engine
  * of the stream (simple text) is LL(2) and the instruction parts of
  * the stream is LL(1). In order to support situations where we go
  * from a LL(2) situation to a LL(0) situation, the lexer supports
- * putting/pushing a token back via the putTokenBack() method.
+ * putting a token back via the putTokenBack() method. The token is
+ * kept in a single token lookahead slot, so nothing is re-lexed and
+ * every code unit of the input is examined once.
  *
  * The lexer is implemented as a state machine, operating in one
- * of four different states.
+ * of four different states. What to do with the next code unit is
+ * looked up in a table, indexed by the state and the class of the
+ * code unit (see CharClass.hpp), both tables are generated at compile
+ * time.
  * 
  * State      |Description
  * :----------|:-----------
@@ -79,9 +86,11 @@ namespace template_engine
  */
 class Lexer
 {
+	enum class states_t;
+
 public:
     /** \internal
-     * \brief Present one or more UTF-16 code units as a token.
+     * \brief Present one or more code units as a token.
      *
      * Some tokens, start/end tags and escape sequences requires that
      * two code points are examined. Fortunately both <code>{</code>,
@@ -99,13 +108,16 @@ public:
 		Token() :
 			_type(token_t::Eos),
 			_char(TE_TEXT('\0')),
-			_name()
+			_name(),
+			_text(nullptr),
+			_textLength(0)
 		{ }
 
         /** \brief The possible types of tokens */
 		enum class token_t {
 			Eos,        ///< End of stream reached.
-			Char,       ///< Token is a UTF-16 code unit
+			Char,       ///< Token is a single code unit
+			Text,       ///< Token is a run of plain text, without any special code units
 			StartTag,   ///< Start of processing template <code>{{</code>
 			EndTag,     ///< End of processing template <code>}}</code>
 			Empty,      ///< Special value used inside lexer, should never be seen
@@ -121,14 +133,24 @@ public:
         /** \brief Only valid if getType() type is \link token_t::Name Name \endlink */
 		inline const te_string& getName() const { return _name; }
 
-		/** \brief non-unicode aware case insensitive compare */
+        /** \brief Only valid if getType() is \link token_t::Text Text \endlink
+         *
+         * The text is not copied, it points straight into the scanner's
+         * input, and is only valid until the lexer is used again.
+         */
+		inline const te_char_t* getText() const { return _text; }
+
+        /** \brief Number of code units in getText() */
+		inline size_t getTextLength() const { return _textLength; }
+
+		/** \brief non-unicode aware case insensitive compare, only ASCII letters are folded */
 		inline bool isName(const te_string& label) const
 		{
 			size_t sz = label.size();
 			if (_name.size() != sz)
 				return false;
 			for (size_t i = 0; i < sz; ++i)
-				if (tolower(_name[i]) != tolower(label[i]))
+				if (asciiToLower(_name[i]) != asciiToLower(label[i]))
 					return false;
 
 			return true;
@@ -138,6 +160,24 @@ public:
 		token_t _type;      ///< Current token type
 		te_char_t _char;    ///< May be garbage if _type != \link token_t::Char Char \endlink
 		te_string _name;    ///< May be garbage if _type != \link token_t::Name Name \endlink
+		const te_char_t* _text; ///< May be garbage if _type != \link token_t::Text Text \endlink
+		size_t _textLength;     ///< May be garbage if _type != \link token_t::Text Text \endlink
+	};
+
+	/** \brief Where the lexer is in the grammar, see getState().
+	 *
+	 * Allows a new lexer to continue where another one stopped, e.g. on
+	 * the next chunk of a template definition which arrives in pieces.
+	 */
+	class State {
+		friend class Lexer;
+	public:
+		/** \brief The state of a lexer at the start of a template definition */
+		State();
+
+	private:
+		states_t _state;        ///< The lexer state
+		uint8_t _escapeCount;   ///< Number of code units left in an escaped start tag
 	};
 
 	/** Initialize a lexer with the given scanner.
@@ -146,7 +186,10 @@ public:
 	Lexer(Scanner& scanner) :
 		_scanner(scanner),
 		_token(),
-		_currentState(states_t::Simple)
+		_tokenPutBack(false),
+		_currentState(states_t::Simple),
+		_escapeCount(0),
+		_partialInput(false)
 	{};
 
 	/** \brief Advance the scanner to the next logical token, and return the token.
@@ -159,39 +202,109 @@ public:
 
     /** \brief Push the current Token back onto the input stream
      *
-     * \param token const Token& The token to push back
+     * The token is returned again by the next call to getNextToken(). Only
+     * a single token can be put back, and the lexer state is left as it was
+     * after the token was read, which is the state the following input must
+     * be read in.
+     *
+     * \param token const Token& The token to push back, normally the one most recently returned.
      */
 	void putTokenBack(const Token& token);
 
+    /** \brief The buffer Text tokens point into, if it outlives the lexer, see Scanner::getSource(). */
+	inline const SourceBuffer* getSource() const { return _scanner.getSource(); }
+
+	/** \brief Where the lexer is in the grammar, between two tokens. */
+	State getState() const;
+
+	/** \brief Continue from a state returned by getState() of another lexer. */
+	void setState(const State& state);
+
+	/** \brief Number of code units read from the scanner, see LookaheadScanner::getPosition(). */
+	inline size_t getPosition() const { return _scanner.getPosition(); }
+
+	/** \brief Has the lexer seen the end of the input, while reading or peeking?
+	 *
+	 * If so, the most recent token might have been different, had there been
+	 * more input. See LookaheadScanner::hasReachedEnd().
+	 */
+	inline bool hasReachedEnd() const { return _scanner.hasReachedEnd(); }
+
+	/** \brief The input may continue beyond the end of the scanner.
+	 *
+	 * A comment which is still open at the end of the input is then not an
+	 * error, the lexer reports the end of the stream instead, and the caller
+	 * is expected to try again once there is more input.
+	 */
+	inline void setPartialInput(bool partial) { _partialInput = partial; }
+
+	/** \internal
+	 * \brief Find the first code unit which can start anything but plain text, i.e. a <code>{</code> or a <code>\\</code>.
+	 *
+	 * Uses SSE2 or AVX2 where available, see Simd.hpp.
+	 *
+	 * \return	A pointer to the code unit, or last if there is none.
+	 */
+	static const te_char_t* findSpecial(const te_char_t* first, const te_char_t* last);
+
 	/** Skip past any white space.
 	* Should only be called while in the instruction state.
 	*/
 	void skipWhiteSpace();
 
 protected:
-	/** \internal  
-	*  \brief Advance the scanner to the next logical token, and return the token.
-	*
-	* The returned token is reused in successive calls, if a reference is held
-	* to the returned value, the values of that token may/will be changed.
-	* This token reader will only return simple character/tag information.
-	* More complex processing is delegated to public getToken() method.
-	*
-	* @return the token parsed from the scanner
-	*/
-	const Token& getNextSimpleToken();
+	/** \internal
+	 * \brief Plain text, everything up to the next <code>{</code> or <code>\\</code> is a single Text token.
+	 *
+	 * \param	ch	The current code unit.
+	 * \return	A Text token, or a Char token for code units in the lookahead buffer.
+	 */
+	const Token& getTextToken(te_char_t ch);
 
-	/** @internal  
-	 * \brief Process the more structured information between start and end tags.
-	 * 		  
-	 * Anything between start and end tags is considered to be some kind of
-	 * processing information and can be dealt with in a more structured manner;
-	*/
-	const Token& getNextInstructionToken();
+	/** \internal
+	 * \brief A <code>{</code> in plain text, which may start an instruction or a comment.
+	 *
+	 * A <code>{{</code> is only a start tag if it is followed by something which
+	 * can be part of an instruction, otherwise the brace is "auto-escaped".
+	 *
+	 * \param	ch	The current code unit.
+	 * \return	A StartTag or Char token, or the token following a comment.
+	 */
+	const Token& getOpenBraceToken(te_char_t ch);
+
+	/** \internal
+	 * \brief A <code>\\</code> in plain text, which may escape a start tag.
+	 *
+	 * \param	ch	The current code unit.
+	 * \return	The first escaped code unit, or the backslash as a Char token.
+	 */
+	const Token& getBackslashToken(te_char_t ch);
+
+	/** \internal
+	 * \brief A single code unit token within an instruction, a marker or white space.
+	 *
+	 * \param	ch	The current code unit.
+	 * \return	The code unit as a Char token.
+	 */
+	const Token& getCharToken(te_char_t ch);
+
+	/** \internal
+	 * \brief A <code>}</code> within an instruction, which may end it.
+	 *
+	 * \return	An EndTag token, or an empty Name token if it is a lone brace.
+	 */
+	const Token& getCloseBraceToken();
+
+	/** @internal
+	 * \brief Read a name within an instruction, a block at a time.
+	 *
+	 * \return	The Name token, which is empty if the current code unit can't be part of a name.
+	 */
+	const Token& getNameToken();
 
 	/**
 	 * \internal
-	 * \brief Scan through the comment section, ignoring everything until just past the ned.
+	 * \brief Scan through the comment section, ignoring everything until just past the end.
 	 *
 	 * \return	The next non comment token.
 	 */
@@ -213,22 +326,43 @@ protected:
 	 *
 	 * \return	true if valid name character, false if not.
 	 */
-	inline bool isValidNameChar(te_char_t ch) { return std::isalnum(ch) || ch == TE_TEXT('_') || ch == TE_TEXT('-'); }
+	inline bool isValidNameChar(te_char_t ch) { return char_class_t::Name == classify(ch); }
 
 	LookaheadScanner _scanner;	///< the Scanner to read the input from.
 	Token			 _token;    ///< the highly reused token, continously being passed around.
+	bool			 _tokenPutBack;	///< _token was put back and is the next token to return.
 
 private:
+	friend struct LexerActionTable;
+
 	/** Enumerate the possible states of the lexer. */
-	enum class states_t { 
+	enum class states_t {
 		Simple,			///< The lexer is processing plain text
 		Instruction,	///< The lexer is processing a template instruction
 		Comment,		///< The lexer is processing a comment
 		Escape			///< The lexer is processing an escape sequence
 	};
 
+	/** Number of values in states_t */
+	static const size_t stateCount = 4;
+
+	/** What to do with the next code unit, looked up by state and character class in LexerActionTable. */
+	enum class action_t : uint8_t {
+		Text,			///< Plain text, see getTextToken()
+		OpenBrace,		///< <code>{</code> in plain text, see getOpenBraceToken()
+		Backslash,		///< <code>\\</code> in plain text, see getBackslashToken()
+		Marker,			///< Single code unit within an instruction, anything but a name or a brace, see getCharToken()
+		CloseBrace,		///< <code>}</code> within an instruction, see getCloseBraceToken()
+		Name,			///< Anything else within an instruction, see getNameToken()
+		Comment,		///< Within a comment, see getNextCommentToken()
+		Escaped			///< Within an escaped start tag, see getNextEscapeToken()
+	};
+
 	states_t _currentState;	///< what is the current state of the lexer
+	uint8_t _escapeCount;	///< number of code units left in an escaped start tag
+	bool _partialInput;		///< the input may continue beyond the end of the scanner, see setPartialInput()
 };
 
+TE_END_FLAVOUR
 }
 #endif//__LEXER_HPP_
@@ -17,17 +17,28 @@
 #ifndef __LOOKAHEAD_SCANNER_HPP_
 #define __LOOKAHEAD_SCANNER_HPP_
 
-#include <queue>
+#include <algorithm>
 #include "Scanner.hpp"
 
 namespace template_engine
 {
+TE_BEGIN_FLAVOUR
 
 /** \brief Internal wrapper and adapter around scanners, enables peeking ahead into the stream.
+ *
+ * The wrapped scanner is read a block at a time, the current block is
+ * cached as a pair of pointers, so reading a code unit is a pointer
+ * compare and a dereference rather than a virtual call. Code units which
+ * were peeked past the end of the current block, or pushed back, are kept
+ * in a small fixed size ring buffer in front of the block, so the
+ * lookahead never allocates.
  */
 class LookaheadScanner : public Scanner
 {
 public:
+	/** \brief Maximum number of code units which can be peeked or pushed back, a power of two. */
+	static const size_t capacity = 16;
+
     /** \brief Wrap the given scanner in an adapter, which supports peeking.
      *
      * \param wrappedScanner Scanner& The scanner to wrap/adapt.
@@ -37,51 +48,129 @@ public:
     /** \copydoc Scanner::moveNext() */
 	inline virtual bool moveNext()
 	{
-		if(_lookAheadBuffer.empty())
-			return _wrappedScanner.moveNext();
-
-		_lookAheadBuffer.pop_front();
+		if (_ringCount)
+			popFront();
+		else if (fillBlock())
+			++_blockCursor;
+		else
+			return false;
 
 		// return false if both are empty
-		return !(_lookAheadBuffer.empty() && _wrappedScanner.atEos());
+		return !atEos();
 	}
 
     /** \copydoc Scanner::atEos() */
 	inline virtual bool atEos() const
 	{
-		if (_lookAheadBuffer.empty())
-			return _wrappedScanner.atEos();
-
-		return false;
+		return !_ringCount && !fillBlock();
 	}
 
     /** \copydoc Scanner::getChar() */
 	inline virtual te_char_t getChar() const
 	{
-		if (_lookAheadBuffer.empty())
-			return _wrappedScanner.getChar();
+		if (_ringCount)
+			return _ring[_ringHead];
 
-		return _lookAheadBuffer.front();
+		if (fillBlock())
+			return *_blockCursor;
+
+		return TE_TEXT('\0');
 	}
 
-    /** \brief Push the UTF-16 code unit back into the stream
+    /** \copydoc Scanner::getBlock()
      *
-     * \param ch te_char_t The UTF-16 code unit to push back.
+     * Code units which have been pushed back or peeked are handed out
+     * first, up to where the ring buffer wraps, after which the blocks
+     * of the wrapped scanner are passed through.
+     */
+	inline virtual const te_char_t* getBlock(size_t& length)
+	{
+		if (_ringCount) {
+			length = std::min(_ringCount, capacity - _ringHead);
+			return &_ring[_ringHead];
+		}
+
+		if (!fillBlock()) {
+			length = 0;
+			return nullptr;
+		}
+
+		length = static_cast<size_t>(_blockEnd - _blockCursor);
+		return _blockCursor;
+	}
+
+    /** \copydoc Scanner::advance()
+     *
+     * Unlike the general contract, n may span the pushed back code units
+     * and the wrapped blocks.
+     */
+	inline virtual void advance(size_t n)
+	{
+		while (n && _ringCount) {
+			popFront();
+			--n;
+		}
+
+		while (n && fillBlock()) {
+			size_t step = std::min(n, static_cast<size_t>(_blockEnd - _blockCursor));
+			_blockCursor += step;
+			n -= step;
+		}
+	}
+
+    /** \copydoc Scanner::getSource()
+     *
+     * The source of the wrapped scanner, it only applies to blocks returned
+     * while isBuffered() is false.
+     */
+	inline virtual const SourceBuffer* getSource() const
+	{
+		return _wrappedScanner.getSource();
+	}
+
+    /** \brief Are there peeked or pushed back code units in front of the wrapped scanner's blocks?
+     *
+     * While this is the case getBlock() returns blocks from the ring buffer,
+     * which are not valid once they have been advanced past.
+     */
+	inline bool isBuffered() const { return _ringCount != 0; }
+
+    /** \brief Number of code units of the wrapped scanner consumed so far.
+     *
+     * Peeked code units are not counted until they are read, code units
+     * which were pushed back with pushFront() or pushBack() are.
+     */
+	inline size_t getPosition() const
+	{
+		return _blockOffset + static_cast<size_t>(_blockCursor - _block) - _ringCount;
+	}
+
+    /** \brief Has the end of the wrapped scanner been seen, by reading or by peeking?
+     *
+     * Once set it stays set, it is used to detect a token which might
+     * have continued, had there been more input.
+     */
+	inline bool hasReachedEnd() const { return _reachedEnd; }
+
+    /** \brief Push the code unit back into the stream, behind any other buffered code units.
+     *
+     * \param ch te_char_t The code unit to push back.
+     * \throw TemplateException if more than #capacity code units are buffered.
      */
 	void pushBack(te_char_t ch);
 
-    /** \brief Push the UTF-16 code unit back into the stream
+    /** \brief Push the code unit back into the stream
      *
-     * \param ch te_char_t The UTF-16 code unit to push back.
+     * \param ch te_char_t The code unit to push back.
+     * \throw TemplateException if more than #capacity code units are buffered.
      */
 	void pushFront(te_char_t ch);
 
 
     /** \brief Look n character ahead into the stream.
-     * There is no magic going on here, the only thing peek() does
-     * is to cache n number of code units. Potentially caching
-     * the complete input stream if n is sufficiently large.
-     * \param n size_t Number of chars to look ahead.
+     * Within the current block this is a plain index, beyond it
+     * peek() buffers the code units up to n.
+     * \param n size_t Number of chars to look ahead, must be less than #capacity.
      *
      * peek() is not allowed to fail. If n reaches beyond the
      * end of the stream NUL (\\u0000) is returned.
@@ -90,9 +179,42 @@ public:
 	te_char_t peek(size_t n);
 
 private:
+    /** \brief Make sure the cached block has unread code units.
+     *
+     * When the cached block is exhausted the wrapped scanner is advanced
+     * past it, and the next block is fetched.
+     *
+     * \return bool false if the wrapped scanner has reached the end of the stream.
+     */
+	inline bool fillBlock() const
+	{
+		if (_blockCursor != _blockEnd)
+			return true;
+
+		return nextBlock();
+	}
+
+    /** \brief Slow path of fillBlock(), fetches the next block from the wrapped scanner. */
+	bool nextBlock() const;
+
+    /** \brief Drop the first code unit of the ring buffer, which must not be empty. */
+	inline void popFront()
+	{
+		_ringHead = (_ringHead + 1) & (capacity - 1);
+		--_ringCount;
+	}
+
 	Scanner& _wrappedScanner;                   //!< The actual scanner being read from.
-	std::deque<te_char_t> _lookAheadBuffer;     //!< Cache of code units which were peeked.
+	te_char_t _ring[capacity];                  //!< Ring buffer of code units which were peeked or pushed back.
+	size_t _ringHead;                           //!< Index of the first buffered code unit.
+	size_t _ringCount;                          //!< Number of buffered code units.
+	mutable const te_char_t* _block;            //!< Start of the block most recently read from the wrapped scanner.
+	mutable const te_char_t* _blockCursor;      //!< Next unread code unit in the cached block.
+	mutable const te_char_t* _blockEnd;         //!< One past the last code unit in the cached block.
+	mutable size_t _blockOffset;                //!< Number of code units in the blocks before the cached one.
+	mutable bool _reachedEnd;                   //!< The wrapped scanner has returned an empty block.
 };
 
+TE_END_FLAVOUR
 }
 #endif // __LOOKAHEAD_SCANNER_HPP_
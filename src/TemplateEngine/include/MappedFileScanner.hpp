@@ -0,0 +1,110 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#ifndef __MAPPED_FILE_SCANNER_HPP_
+#define __MAPPED_FILE_SCANNER_HPP_
+
+#include <memory>
+#include <string>
+
+#include "Scanner.hpp"
+#include "SourceBuffer.hpp"
+
+namespace template_engine
+{
+
+// the same in both flavours
+class FileMapping;
+
+TE_BEGIN_FLAVOUR
+
+/** \brief Scanner reading a UTF-8 template file through a memory mapping.
+ *
+ * The file is mapped read only and the kernel is told it will be read
+ * sequentially, no part of it is copied into an intermediate buffer. A
+ * leading UTF-8 byte order mark is skipped.
+ *
+ * In the UTF-8 flavour the blocks handed to the lexer point straight
+ * into the mapping, and the mapping is exposed as the scanner's source,
+ * so literal text of a parsed template refers to the mapped file, which
+ * is kept mapped until the last such template is destroyed.
+ *
+ * In the UTF-16 flavour the file is decoded on the fly, a chunk at a
+ * time, into a small fixed size buffer. Sequences split by a chunk
+ * boundary are carried over to the next chunk.
+ */
+class MappedFileScanner :
+	public Scanner
+{
+public:
+    /** \brief Map the template file.
+     *
+     * \param path const std::string&   UTF-8 path of the file.
+     * \throws TemplateException        If the file can't be opened or mapped, or isn't valid UTF-8.
+     */
+	explicit MappedFileScanner(const std::string& path);
+
+    /** \brief Scan a template file which is already mapped.
+     *
+     * \param mapping std::shared_ptr<const FileMapping>   The mapped file, it is kept mapped as long as the scanner needs it.
+     * \param path const std::string&                      UTF-8 path of the file, for error messages.
+     * \throws TemplateException                           If the file isn't valid UTF-8.
+     */
+	MappedFileScanner(std::shared_ptr<const FileMapping> mapping, const std::string& path);
+
+	/** \copydoc Scanner::moveNext() */
+	virtual bool moveNext();
+
+    /** \copydoc Scanner::atEos() */
+	virtual bool atEos() const;
+
+    /** \copydoc Scanner::getChar() */
+	virtual te_char_t getChar() const;
+
+    /** \copydoc Scanner::getBlock() */
+	virtual const te_char_t* getBlock(size_t& length);
+
+    /** \copydoc Scanner::advance() */
+	virtual void advance(size_t n);
+
+    /** \copydoc Scanner::getSource() */
+	virtual const SourceBuffer* getSource() const;
+
+private:
+	std::shared_ptr<const FileMapping> _mapping;    //!< The mapped file.
+	std::string _path;                          //!< The file name, for error messages.
+
+#ifdef TE_USE_UTF8
+	SourceBuffer _source;                       //!< The mapped text, owned by _mapping.
+	size_t _position;                           //!< Offset of the current code unit in _source.
+#else
+	/** \brief Decode the next chunk of the file into _chunk. */
+	void decodeNextChunk();
+
+	static const size_t chunkSize = 64 * 1024;  //!< Maximum number of bytes decoded at a time.
+
+	const char* _input;                         //!< The mapped UTF-8 text.
+	size_t _inputSize;                          //!< Number of bytes in _input.
+	size_t _inputPosition;                      //!< Offset of the first byte which isn't decoded yet.
+	std::unique_ptr<te_char_t[]> _chunk;        //!< The decoded chunk.
+	size_t _chunkLength;                        //!< Number of code units in _chunk.
+	size_t _chunkPosition;                      //!< Offset of the current code unit in _chunk.
+#endif
+};
+
+TE_END_FLAVOUR
+}
+#endif // !__MAPPED_FILE_SCANNER_HPP_
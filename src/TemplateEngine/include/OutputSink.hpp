@@ -0,0 +1,136 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#ifndef __OUTPUT_SINK_HPP_
+#define __OUTPUT_SINK_HPP_
+
+#include <ostream>
+#include <string>
+
+#include "Types.hpp"
+
+namespace template_engine
+{
+TE_BEGIN_FLAVOUR
+
+/** \brief Abstract destination for rendered output.
+ *
+ * Rendering into a sink avoids materializing the complete output as a
+ * te_string when it is only going to be written somewhere else anyway.
+ */
+class OutputSink
+{
+public:
+	virtual ~OutputSink() {}
+
+    /** \brief Append code units to the output.
+     *
+     * \param data    The code units to write.
+     * \param length  The number of code units.
+     */
+	virtual void write(const te_char_t* data, size_t length) = 0;
+
+    /** \brief Append a string to the output. */
+	void write(const te_string& str)
+	{
+		write(str.data(), str.size());
+	}
+
+    /** \brief Push any buffered output to the final destination. */
+	virtual void flush() {}
+};
+
+/** \brief Sink writing UTF-8 to a standard stream.
+ *
+ * In the UTF-16 flavour every write is transcoded with the Transcoder,
+ * a surrogate pair split between two writes is carried over to the next
+ * write. In the UTF-8 flavour the code units are written as is.
+ */
+class Utf8StreamSink : public OutputSink
+{
+public:
+    /** \brief Construct a sink writing to the given stream.
+     *
+     * \param stream  The stream to write to, it must outlive the sink.
+     */
+	explicit Utf8StreamSink(std::ostream& stream);
+
+	using OutputSink::write;
+
+	/** \copydoc OutputSink::write(const te_char_t*, size_t) */
+	virtual void write(const te_char_t* data, size_t length);
+
+    /** \copydoc OutputSink::flush()
+     * \throws TemplateException if the output ended with an unpaired high surrogate.
+     */
+	virtual void flush();
+
+private:
+	std::ostream& _stream;      //!< Final destination.
+	std::string _buffer;        //!< Reused conversion buffer.
+	te_char_t _pending;         //!< A high surrogate waiting for its low surrogate, or NUL.
+};
+
+/** \brief A render streamed into a sink, the output is handed over to the sink while it is rendered.
+ *
+ * The template is rendered into buffer(), and after every row of a repeat
+ * the buffer is written to the sink and cleared once it holds chunkSize
+ * code units, so a long list doesn't materialize its output. The stream is
+ * registered with the thread, and the repeats find it there, the buffer is
+ * only handed over by the repeats appending to it rather than to a string
+ * of their own, e.g. for a filter.
+ *
+ * Use Template::renderInto(const ContextPtr, OutputSink&, TemplateEscaper),
+ * which streams the render and writes the rest when it is done.
+ */
+class StreamedOutput
+{
+public:
+	/** \brief The default number of code units buffered before they are handed over. */
+	static const size_t defaultChunkSize = 64 * 1024;
+
+    /** \brief Start streaming into a sink, on this thread.
+     *
+     * \param sink OutputSink&     The destination, it must outlive the stream.
+     * \param chunkSize size_t     Number of code units buffered before they are handed over.
+     */
+	explicit StreamedOutput(OutputSink& sink, size_t chunkSize = defaultChunkSize);
+
+    /** \brief Stop streaming, the output which wasn't handed over is discarded unless finish() was called. */
+	~StreamedOutput();
+
+	StreamedOutput(const StreamedOutput&) = delete;
+	StreamedOutput& operator=(const StreamedOutput&) = delete;
+
+    /** \brief The output is rendered into this buffer. */
+	inline te_string& buffer() { return _buffer; }
+
+    /** \brief Write the rest of the buffer to the sink. */
+	void finish();
+
+    /** \brief Called by the repeats after every row, hands the output over if out is the buffer of the thread's stream and it is full. */
+	static void rowRendered(te_string& out);
+
+private:
+	OutputSink& _sink;          //!< Final destination.
+	size_t _chunkSize;          //!< Code units buffered before they are handed over.
+	te_string _buffer;          //!< The output not yet handed over.
+	StreamedOutput* _outer;     //!< The stream of the thread when this one started.
+};
+
+TE_END_FLAVOUR
+}
+#endif // !__OUTPUT_SINK_HPP_
@@ -0,0 +1,88 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#ifndef __PARALLEL_PARSER_HPP_
+#define __PARALLEL_PARSER_HPP_
+
+#include <vector>
+
+#include "Template.hpp"
+#include "SourceBuffer.hpp"
+
+namespace template_engine
+{
+TE_BEGIN_FLAVOUR
+
+/** \brief Parses a single, very large, template definition on several threads.
+ *
+ * Parsing is done in two phases. A structural pass, which uses the same
+ * SIMD kernel as the lexer to skip plain text, locates every start tag,
+ * end tag, comment and escaped start tag, and matches the repeat
+ * instructions. This yields the positions just past a top level instruction,
+ * where the definition can be split into independent regions of roughly
+ * equal size. The regions are then parsed concurrently by TemplateParser's,
+ * and their templates are spliced together in order.
+ *
+ * The result is identical to that of Template::parse(). A definition which
+ * is small, can't be split (e.g. a single repeat instruction around
+ * everything) or contains an error is parsed on the calling thread, errors
+ * are therefore reported exactly as Template::parse() reports them. So is
+ * a definition for which the threads can't be started.
+ */
+class ParallelParser
+{
+public:
+	/** \brief Default size, in code units, below which a definition isn't split. */
+	static const size_t defaultMinimumSize = 256 * 1024;
+
+    /** \brief Create a parser.
+     *
+     * \param threads unsigned      Number of threads to use, 0 for one per hardware thread.
+     * \param maxDepth size_t       How deep repeat instructions may be nested.
+     * \param minimumSize size_t    Definitions smaller than this are parsed on the calling thread.
+     */
+	explicit ParallelParser(unsigned threads = 0, size_t maxDepth = Template::defaultMaxDepth,
+		size_t minimumSize = defaultMinimumSize);
+
+    /** \brief Parse the definition held by the buffer.
+     *
+     * Literal text refers to the buffer, see StringScanner(const SourceBuffer&).
+     *
+     * \param source const SourceBuffer&    The template definition.
+     * \return TemplatePtr                  Template hierarchy generated from the input.
+     * \throws TemplateException            All parse errors are reported as exceptions.
+     */
+	TemplatePtr parse(const SourceBuffer& source) const;
+
+private:
+	/** \brief The structural pass, where may the definition be split?
+	 *
+	 * \return Offsets of the region starts after the first, empty if the
+	 *         definition can't be split, or the structural pass found an error.
+	 */
+	std::vector<size_t> split(const SourceBuffer& source) const;
+
+	/** \brief Parse [begin, end) of the definition, which is a region found by split(). */
+	TemplatePtr parseRegion(const SourceBuffer& source, size_t begin, size_t end) const;
+
+	unsigned _threads;      ///< Number of regions to split the definition into
+	size_t _maxDepth;       ///< How deep repeat instructions may be nested
+	size_t _minimumSize;    ///< Smallest definition which is split
+};
+
+TE_END_FLAVOUR
+}
+#endif // !__PARALLEL_PARSER_HPP_
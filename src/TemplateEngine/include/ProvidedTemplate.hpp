@@ -0,0 +1,68 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#ifndef __PROVIDED_TEMPLATE_HPP_
+#define __PROVIDED_TEMPLATE_HPP_
+
+#include "Template.hpp"
+#include "Dictionary.hpp"
+
+namespace template_engine
+{
+TE_BEGIN_FLAVOUR
+
+/** \brief Expansion of a value provided by a known dictionary, left in a residual template.
+ *
+ * Created by TemplateSpecializer, a provided value is computed when the
+ * residual template is rendered, not when it is specialized. The expansion
+ * is bound to the known dictionary providing the value, so it is found
+ * whatever the residual template is rendered with.
+ */
+class ProvidedTemplate :
+	public Template
+{
+public:
+    /** \brief Construct a provided template.
+     *
+     * \param scope const DictionaryPtr&        The known dictionary providing the value.
+     * \param expansion const TemplatePtr&      The expansion, looked up in scope.
+     */
+	ProvidedTemplate(const DictionaryPtr& scope, const TemplatePtr& expansion);
+
+protected:
+    /** \brief Render the expansion with the value computed by the provider.
+     *
+     * \param dictionary const DictionaryPtr&   Ignored.
+     * \param filter TemplateFilter             Applied to the value.
+     * \return virtual te_string                The expanded value.
+     * \throws TemplateException                If the provider throws.
+     */
+	virtual te_string render(const DictionaryPtr& dictionary, TemplateFilter filter) const;
+
+    /** \brief Append the expanded value to the output. */
+	virtual void renderInto(const DictionaryPtr& dictionary, TemplateEscaper escaper, te_string& out) const;
+
+    /** \brief Nothing is looked up in the dictionary the template is rendered with. */
+	virtual void addDependencies(TemplateDependencies& scope) const;
+
+private:
+	DictionaryPtr _scope;       ///< The known dictionary providing the value.
+	TemplatePtr _expansion;     ///< The expansion.
+};
+
+TE_END_FLAVOUR
+}
+#endif // !__PROVIDED_TEMPLATE_HPP_
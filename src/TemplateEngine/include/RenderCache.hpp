@@ -0,0 +1,266 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#ifndef __RENDER_CACHE_HPP_
+#define __RENDER_CACHE_HPP_
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "Template.hpp"
+#include "Dictionary.hpp"
+#include "FilterChain.hpp"
+#include "TypedValue.hpp"
+
+namespace template_engine
+{
+TE_BEGIN_FLAVOUR
+
+/** \brief A change to a rendered text, see RenderCache::renderEdits(). */
+struct OutputEdit
+{
+	size_t offset;          ///< Where the change starts, in the text with the preceding edits applied
+	size_t removed;         ///< Number of code units removed
+	te_string inserted;     ///< The text inserted in their place
+};
+
+/** \brief Render a template again and again, reusing the output of what hasn't changed.
+ *
+ * While a template is rendered through the cache, every expansion and
+ * repeat records the dictionary entries it reads, together with their
+ * versions, see Dictionary::getVersion(). The output is memoized for the
+ * whole template and for every row of every repeat. When the template is
+ * rendered again, a memo whose entries all have the same versions, and
+ * whose nested rows are all unchanged, is copied rather than rendered.
+ * - A name which isn't defined by a scope is recorded as well, so a value
+ *   added to a nearer scope, which hides the old one, is noticed.
+ * - The rows of a list are recorded with the version of the list, so rows
+ *   which are added, replaced or removed cause the repeat to walk the
+ *   list again. Each row is still looked up by identity, rows which were
+ *   kept are reused.
+ * - Templates which don't record what they read, e.g. a specialized
+ *   template, are rendered every time, as are the memos around them.
+ *   So are the memos expanding a provided value, see Dictionary::addProvider().
+ *
+ * Rather than the whole text, renderEdits() returns the edits turning the
+ * previous output into the new one, e.g. to push an update to a client.
+ * The edits are found from the memos rather than by comparing the texts:
+ * reused rows are skipped, the rows of a list are paired by identity, and
+ * only the text between the repeats of a row which was rendered again is
+ * compared.
+ *
+ * Values must be changed with Dictionary::set() and Dictionary::remove(),
+ * or the DictionaryList equivalents, for the change to be noticed. The
+ * cache holds on to the template and the memoized dictionaries, and is
+ * not safe to use from several threads at once.
+ *
+ * \code
+ * RenderCache cache(templ, filter);
+ * te_string first = cache.render(context);
+ * row->set(TE_TEXT("PRICE"), TE_TEXT("42"));
+ * te_string second = cache.render(context);  // only the changed row is rendered
+ * \endcode
+ */
+class RenderCache
+{
+public:
+    /** \brief Create a cache for the template.
+     *
+     * \param templ TemplatePtr     The template to render.
+     * \param filter TemplateFilter Optional filter to apply when expanding values.
+     */
+	RenderCache(TemplatePtr templ, TemplateFilter filter = nullptr);
+
+	~RenderCache();
+
+    /** \brief Render the template, reusing the output memoized by the previous render where possible.
+     *
+     * \param context const ContextPtr  The context to use when expanding values.
+     * \return te_string                The same text as Template::render() would return.
+     * \throws TemplateException        As Template::render(), the memoized output is then kept as it was.
+     */
+	te_string render(const ContextPtr context);
+
+    /** \brief Render the template, and return the edits turning the output of the previous render into the new output.
+     *
+     * The edits are ordered by offset, and are applied one after the other,
+     * see apply(). The first render returns a single edit inserting the
+     * whole output.
+     *
+     * \param context const ContextPtr  The context to use when expanding values, its dictionary may differ from the previous one.
+     * \return std::vector<OutputEdit>  The edits, empty if the output is unchanged.
+     * \throws TemplateException        As render().
+     */
+	std::vector<OutputEdit> renderEdits(const ContextPtr context);
+
+    /** \brief Find the edits turning the output rendered with one dictionary into the output rendered with another.
+     *
+     * Rows which are shared by the two dictionaries are paired, as are rows
+     * in the same position which are only found in one of them. The
+     * dictionary of the context is left as newDictionary.
+     *
+     * \param templ TemplatePtr                     The template to render.
+     * \param context const ContextPtr              The context to render with.
+     * \param oldDictionary const DictionaryPtr&    The dictionary the old output is rendered with.
+     * \param newDictionary const DictionaryPtr&    The dictionary the new output is rendered with.
+     * \param filter TemplateFilter                 Optional filter to apply when expanding values.
+     * \return std::vector<OutputEdit>              The edits, see renderEdits().
+     * \throws TemplateException                    As Template::render().
+     */
+	static std::vector<OutputEdit> diff(TemplatePtr templ, const ContextPtr context,
+		const DictionaryPtr& oldDictionary, const DictionaryPtr& newDictionary, TemplateFilter filter = nullptr);
+
+    /** \brief Apply edits, as returned by renderEdits(), to a text.
+     *
+     * \throws TemplateException If an edit is outside of the text.
+     */
+	static void apply(te_string& text, const std::vector<OutputEdit>& edits);
+
+    /** \brief Forget the memoized output, the next render starts from scratch. */
+	void clear();
+
+    /** \brief Number of rows, and the template itself, rendered by the latest render. */
+	inline size_t getRendered() const { return _rendered; }
+
+    /** \brief Number of rows, and the template itself, whose memoized output was reused by the latest render. */
+	inline size_t getReused() const { return _reused; }
+
+    /** \brief The filter the template is rendered with. */
+	inline const TemplateFilter& getFilter() const { return _filter; }
+
+    /** \brief Expand a value, recording the entries read along the scopes.
+     *
+     * \param dictionary const DictionaryPtr&   The scope the expansion is rendered in.
+     * \param name const te_string&             Name of the value, must outlive the cache, e.g. that of the template.
+     * \param scopeWalk uint8_t                 Number of scopes to walk up, before the lookup starts.
+     * \param format const ValueFormat&         Format of the expansion.
+     * \param filters const FilterChain&        Filters of the expansion, applied before the filter of the cache.
+     * \param out te_string&                    The output the filtered value is appended to.
+     * \throws TemplateException                As ExpansionTemplate.
+     */
+	void expand(const DictionaryPtr& dictionary, const te_string& name, uint8_t scopeWalk, const ValueFormat& format,
+		const FilterChain& filters, te_string& out);
+
+    /** \brief Find the list of a repeat, recording the entries read along the scopes, and the rows of the list.
+     *
+     * \param dictionary const DictionaryPtr&   The scope the repeat is rendered in.
+     * \param name const te_string&             Name of the list, must outlive the cache, e.g. that of the template.
+     * \throws TemplateException                As RepeatTemplate.
+     */
+	const DictionaryListPtr& findList(const DictionaryPtr& dictionary, const te_string& name);
+
+    /** \brief Record that the output of the template being rendered can't be reused. */
+	void untracked();
+
+    /** \brief Start memoizing the rows of a repeat. */
+	void beginRepeat(const Template& repeat);
+
+    /** \brief Render a row of the current repeat, or reuse its memoized output.
+     *
+     * \param body const Template&      The repeated template.
+     * \param row const DictionaryPtr&  The sub-dictionary the body is rendered with.
+     * \param out te_string&            The output the row is appended to.
+     */
+	void renderRow(const Template& body, const DictionaryPtr& row, te_string& out);
+
+    /** \brief Stop memoizing the rows of the current repeat. */
+	void endRepeat();
+
+private:
+	struct Memo;
+
+    /** \brief An entry read while rendering a memo. */
+	struct Read
+	{
+		DictionaryPtr dictionary;   ///< The dictionary read
+		const te_string* name;      ///< The name looked up, nullptr for the rows of a list
+		uint64_t dictionaryVersion; ///< Version of the dictionary when it was read
+		uint64_t version;           ///< Version of the entry when it was read, 0 if it didn't exist
+	};
+
+    /** \brief The memoized rows of a repeat. */
+	struct RepeatMemo
+	{
+		const Template* repeat;         ///< The repeat template
+		size_t begin;                   ///< Where the rows start in the output of the enclosing memo
+		size_t end;                     ///< Where the rows end in the output of the enclosing memo
+		std::vector<std::shared_ptr<const Memo>> rows; ///< The rows in order
+		std::unordered_map<const Dictionary*, size_t> index; ///< Position of the rows, by sub-dictionary
+	};
+
+    /** \brief The output of a template, or of a row, and what it depends on. */
+	struct Memo
+	{
+		DictionaryPtr dictionary;       ///< The dictionary it was rendered with, it keeps the address in use
+		te_string output;               ///< The rendered text
+		std::vector<Read> reads;        ///< The entries read, outside of nested rows
+		std::vector<RepeatMemo> repeats; ///< The nested repeats, in the order they were rendered
+		bool untracked = false;         ///< A template which doesn't record its reads was rendered
+		mutable uint64_t checked = 0;   ///< The render which last checked the memo
+		mutable bool valid = false;     ///< The outcome of that check
+	};
+
+    /** \brief A memo being rendered. */
+	struct Frame
+	{
+		Memo* memo;                     ///< The memo being rendered
+		const Memo* previous;           ///< The memo of the previous render, nullptr if there is none
+		RepeatMemo* repeat;             ///< The rows of the repeat being rendered
+		const RepeatMemo* previousRepeat; ///< The rows of the repeat from the previous render
+	};
+
+    /** \brief Render the template into a new root memo, or keep the current one if it is still valid. */
+	void update(const ContextPtr& context);
+
+    /** \brief Append a row to the memo of a repeat. */
+	static void addRow(RepeatMemo& repeat, const std::shared_ptr<const Memo>& row);
+
+    /** \brief Append the edits turning the output of one memo into that of another, rendered from the same template. */
+	void diff(const Memo& before, const Memo& after, size_t& position, std::vector<OutputEdit>& edits) const;
+
+    /** \brief Append the edits turning the rows of one repeat into those of another. */
+	void diffRows(const RepeatMemo& before, const RepeatMemo& after, size_t& position, std::vector<OutputEdit>& edits) const;
+
+    /** \brief Append the edits turning a range of one text into a range of another. */
+	static void diffText(const te_string& before, size_t beforeBegin, size_t beforeEnd,
+		const te_string& after, size_t afterBegin, size_t afterEnd, size_t& position, std::vector<OutputEdit>& edits);
+
+    /** \brief Append an edit, merging it with the previous one if they are adjacent. */
+	static void addEdit(std::vector<OutputEdit>& edits, size_t& position, size_t removed, const te_char_t* inserted, size_t length);
+
+    /** \brief Are the entries a memo read, and its nested rows, unchanged? */
+	bool isValid(const Memo& memo) const;
+
+    /** \brief Find the scope defining name, recording every scope searched.
+     *
+     * \return DictionaryPtr    The scope, nullptr if the name isn't defined.
+     */
+	DictionaryPtr lookup(const DictionaryPtr& dictionary, const te_string& name);
+
+	TemplatePtr _templ;                 ///< The template rendered
+	TemplateFilter _filter;             ///< Filter applied when expanding values
+	std::shared_ptr<const Memo> _root;  ///< The memo of the previous render
+	std::vector<Frame> _frames;         ///< The memos being rendered, the innermost last
+	uint64_t _pass;                     ///< Number of renders so far
+	size_t _rendered;                   ///< Memos rendered by the latest render
+	size_t _reused;                     ///< Memos reused by the latest render
+};
+
+TE_END_FLAVOUR
+}
+#endif // !__RENDER_CACHE_HPP_
@@ -22,6 +22,7 @@
 
 namespace template_engine
 {
+TE_BEGIN_FLAVOUR
 
 /** \brief Repeat all templates and text, zero or more times.
  * A repeat template instruction repeats the template(s) enclosed
@@ -41,6 +42,7 @@ namespace template_engine
 class RepeatTemplate :
 	public Template
 {
+	friend class TemplateList;
 public:
     /** \brief Construct a repeat template.
      *
@@ -59,11 +61,37 @@ protected:
      */
 	virtual te_string render(const DictionaryPtr& dictionary, TemplateFilter filter) const;
 
+    /** \brief Append the body to the output, once for every item of the list. */
+	virtual void renderInto(const DictionaryPtr& dictionary, TemplateEscaper escaper, te_string& out) const;
+
+    /** \brief Optimize the repeated template, the repeat itself is never static. */
+	virtual TemplatePtr optimize(const TemplateOptimizer& optimizer) const;
+
+    /** \brief Unroll the repeat, if the list is known and the body can be specialized for every item.
+     *
+     * Otherwise the repeat is kept as it is, and recorded with the specializer.
+     * \throws TemplateException If the name is known, but isn't a list.
+     */
+	virtual TemplatePtr specialize(TemplateSpecializer& specializer) const;
+
+    /** \copydoc Template::write() */
+	virtual void write(TemplateWriter& writer) const;
+
+    /** \brief Repeat the body through the cache, the output of rows which are unchanged is reused.
+     *
+     * \throws TemplateException If the Dictionary doesn't contain a DictionaryList with the name of the repeat instruction.
+     */
+	virtual void renderCached(RenderCache& cache, const DictionaryPtr& dictionary, te_string& out) const;
+
+    /** \brief Add the list, with the names referenced by the body in the scope of its items. */
+	virtual void addDependencies(TemplateDependencies& scope) const;
+
 private:
 	te_string _name;                    //<! Name of the repeat instruction
 	std::shared_ptr<Template> _templ;   //<! The template to repeat
 };
 
+TE_END_FLAVOUR
 }
 #endif // !__REPEAT_TEMPLATE_HPP_
 
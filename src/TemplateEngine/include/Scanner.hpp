@@ -18,18 +18,32 @@
 #define __SCANNER_HPP_
 
 #include "Types.hpp"
+#include "SourceBuffer.hpp"
 
 namespace template_engine
 {
+TE_BEGIN_FLAVOUR
 /** \brief Abstract class, describing the interface for passing a template
  * description into the template engine.
  *
  * Scanners abstract away the complexities of handing input character streams.
+ *
+ * There are two ways of reading from a scanner. The per code unit interface,
+ * moveNext(), atEos() and getChar(), must be implemented by every scanner.
+ * The block interface, getBlock() and advance(), hands out contiguous runs
+ * of code units, which lets the lexer consume input without a virtual call
+ * per code unit. Scanners backed by memory should override the block
+ * interface, the default implementation is an adapter presenting the per
+ * code unit interface as blocks of a single code unit.
  */
 class Scanner
 {
 public:
-    /** \brief Advance the cursor one UTF-16 code unit.
+	Scanner() : _blockChar(TE_TEXT('\0')) {}
+
+	virtual ~Scanner() {}
+
+    /** \brief Advance the cursor one code unit.
      *
      * \return virtual bool true if the move succeeded, false otherwise, typically due to reaching the end.
      */
@@ -42,12 +56,61 @@ public:
      */
 	virtual bool atEos() const = 0;
 
-    /** \brief Get the next UTF-16 code unit off the stream
+    /** \brief Get the next code unit off the stream
      *
      * \return virtual The next code unit from the stream, or NUL (\\u0000) if at the end.
      */
 	virtual te_char_t getChar() const = 0;
+
+    /** \brief Get the contiguous run of code units starting at the current position.
+     *
+     * Reading a block doesn't move the cursor, use advance() to consume
+     * (part of) it. The returned pointer is only valid until the cursor is
+     * moved.
+     *
+     * \param length size_t& Receives the number of code units in the block, 0 at the end of the stream.
+     * \return virtual const te_char_t* The first code unit of the block.
+     */
+	virtual const te_char_t* getBlock(size_t& length)
+	{
+		if (atEos()) {
+			length = 0;
+			return nullptr;
+		}
+
+		_blockChar = getChar();
+		length = 1;
+		return &_blockChar;
+	}
+
+    /** \brief Advance the cursor a number of code units.
+     *
+     * \param n size_t Number of code units to skip, must not exceed the length of the last block.
+     */
+	virtual void advance(size_t n)
+	{
+		while (n--)
+			moveNext();
+	}
+
+    /** \brief The buffer the blocks are read from, if the blocks outlive the scanner.
+     *
+     * Scanners handing out blocks which point into a SourceBuffer return it
+     * here, which allows templates to refer to their literal text instead of
+     * copying it. The default is nullptr, blocks are then only valid until
+     * the cursor is moved.
+     *
+     * \return virtual const SourceBuffer* The buffer, or nullptr.
+     */
+	virtual const SourceBuffer* getSource() const
+	{
+		return nullptr;
+	}
+
+private:
+	te_char_t _blockChar;	//!< Backing store for the single code unit blocks of the default adapter.
 };
 
+TE_END_FLAVOUR
 }
 #endif//__SCANNER_HPP_
@@ -0,0 +1,99 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#ifndef __SIMD_HPP_
+#define __SIMD_HPP_
+
+/** \internal
+ * \file Simd.hpp
+ * \brief Compiler and CPU feature glue for the vectorized kernels.
+ *
+ * SSE2 is part of the x86-64 baseline and is used unconditionally there.
+ * AVX2 kernels are compiled with a per function target attribute (or
+ * directly on MSVC) and only called when cpuHasAvx2() reports support,
+ * so the library still runs on older CPUs. Every kernel has a scalar
+ * fallback which is the only code path on other architectures.
+ */
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#    define TE_SIMD_SSE2 1
+#    include <emmintrin.h>
+#    if defined(__GNUC__) || defined(_MSC_VER)
+#        define TE_SIMD_AVX2 1
+#        include <immintrin.h>
+#    endif
+#endif
+
+#if defined(TE_SIMD_AVX2) && defined(__GNUC__)
+#    define TE_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#    define TE_TARGET_AVX2
+#endif
+
+#if defined(_MSC_VER)
+#    include <intrin.h>
+#endif
+
+namespace template_engine
+{
+
+/** \internal \brief Is the AVX2 instruction set available on this CPU? */
+inline bool cpuHasAvx2()
+{
+#if defined(TE_SIMD_AVX2) && defined(__GNUC__)
+	static const bool hasAvx2 = __builtin_cpu_supports("avx2");
+	return hasAvx2;
+#elif defined(TE_SIMD_AVX2) && defined(_MSC_VER)
+	static const bool hasAvx2 = []() {
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return false;
+		__cpuid(info, 1);
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		bool avx = (info[2] & (1 << 28)) != 0;
+		if (!(osxsave && avx) || (_xgetbv(0) & 6) != 6)
+			return false;
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+	}();
+	return hasAvx2;
+#else
+	return false;
+#endif
+}
+
+/** \internal \brief Index of the lowest set bit, \p mask must be non zero. */
+inline unsigned int lowestBit(unsigned int mask)
+{
+#if defined(__GNUC__)
+	return static_cast<unsigned int>(__builtin_ctz(mask));
+#elif defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return static_cast<unsigned int>(index);
+#else
+	unsigned int index = 0;
+	while (!(mask & 1)) {
+		mask >>= 1;
+		++index;
+	}
+	return index;
+#endif
+}
+
+}
+#endif // !__SIMD_HPP_
@@ -19,9 +19,11 @@
 
 #include "Types.hpp"
 #include "Template.hpp"
+#include "SourceBuffer.hpp"
 
 namespace template_engine
 {
+TE_BEGIN_FLAVOUR
 
 /** \brief Simple, plain text template, with no substitutions.
  */
@@ -34,6 +36,13 @@ public:
      */
 	SimpleTemplate(te_string value);
 
+    /** \brief Construct a simple template referring to part of a template definition, without copying it.
+     * \param source const SourceBuffer&   The definition, an owned buffer is kept alive by the template.
+     * \param offset size_t                Offset of the text in the source.
+     * \param length size_t                Number of code units in the text.
+     */
+	SimpleTemplate(const SourceBuffer& source, size_t offset, size_t length);
+
 protected:
     /** \brief Copy constant string onto the output buffer.
      *
@@ -43,9 +52,22 @@ protected:
      */
 	virtual te_string render(const DictionaryPtr& dictionary, TemplateFilter filter) const;
 
+    /** \brief Append the constant string to the output. */
+	virtual void renderInto(const DictionaryPtr& dictionary, TemplateEscaper escaper, te_string& out) const;
+
+    /** \copydoc Template::write() */
+	virtual void write(TemplateWriter& writer) const;
+
+    /** \copydoc Template::isStatic() */
+	virtual bool isStatic() const { return true; }
+
 private:
-	te_string _value;   //!< The string to output.
+	te_string _value;       //!< The string to output, unless it is a view into _source.
+	SourceBuffer _source;   //!< The definition the text is a view into, empty if _value holds the text.
+	size_t _offset;         //!< Offset of the text in _source.
+	size_t _length;         //!< Number of code units of the text in _source.
 };
 
+TE_END_FLAVOUR
 }
 #endif // __SIMPLE_TEMPLATE_HPP_
@@ -0,0 +1,107 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#ifndef __SOURCE_BUFFER_HPP_
+#define __SOURCE_BUFFER_HPP_
+
+#include <memory>
+
+#include "Types.hpp"
+
+namespace template_engine
+{
+TE_BEGIN_FLAVOUR
+
+/** \brief The text of a template definition, either owned or borrowed.
+ *
+ * A source buffer is a pointer and a length, plus an optional owner
+ * which keeps the text alive. Copies share the owner, so a compiled
+ * template can refer to the literal text of its definition instead of
+ * copying it, and keeps an owned buffer alive for as long as it needs
+ * it.
+ *
+ * A borrowed buffer has no owner, and the caller guarantees that the
+ * text outlives every scanner reading it, *and* every template parsed
+ * from it.
+ */
+class SourceBuffer
+{
+public:
+    /** \brief An empty buffer. */
+	SourceBuffer();
+
+    /** \brief Take ownership of the text, without copying it.
+     *
+     * \param text te_string&& The template definition.
+     */
+	explicit SourceBuffer(te_string&& text);
+
+    /** \brief Own a copy of the text.
+     *
+     * \param text const te_string& The template definition.
+     */
+	explicit SourceBuffer(const te_string& text);
+
+    /** \brief Text kept alive by some other object, e.g. a memory mapping.
+     *
+     * \param data const te_char_t*             The first code unit of the text.
+     * \param size size_t                       The number of code units.
+     * \param owner std::shared_ptr<const void> Keeps data alive while any copy of the buffer exists.
+     */
+	SourceBuffer(const te_char_t* data, size_t size, std::shared_ptr<const void> owner);
+
+    /** \brief Borrow the text, which must outlive the buffer and any template parsed from it.
+     *
+     * \param data const te_char_t* The first code unit of the text.
+     * \param size size_t           The number of code units.
+     * \return SourceBuffer         A buffer without an owner.
+     */
+	static SourceBuffer borrow(const te_char_t* data, size_t size);
+
+    /** \copydoc borrow(const te_char_t*, size_t) */
+	static SourceBuffer borrow(const te_string& text);
+
+    /** \brief The first code unit of the text */
+	inline const te_char_t* data() const { return _data; }
+
+    /** \brief The number of code units in the text */
+	inline size_t size() const { return _size; }
+
+    /** \brief Is the text kept alive by this buffer, as opposed to borrowed? */
+	inline bool isOwned() const { return _owner != nullptr; }
+
+    /** \brief Part of the text, kept alive by the same owner as this buffer.
+     *
+     * \param offset size_t         Index of the first code unit of the part.
+     * \param size size_t           The number of code units in the part.
+     */
+	SourceBuffer slice(size_t offset, size_t size) const;
+
+    /** \brief Does the range lie within the text of this buffer? */
+	inline bool contains(const te_char_t* data, size_t size) const
+	{
+		return data >= _data && size <= _size && static_cast<size_t>(data - _data) <= _size - size;
+	}
+
+private:
+	const te_char_t* _data;                 //!< The text.
+	size_t _size;                           //!< Number of code units in the text.
+	std::shared_ptr<const void> _owner;     //!< Keeps the text alive, null if borrowed.
+};
+
+TE_END_FLAVOUR
+}
+#endif // !__SOURCE_BUFFER_HPP_
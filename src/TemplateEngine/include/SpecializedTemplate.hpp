@@ -0,0 +1,79 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#ifndef __SPECIALIZED_TEMPLATE_HPP_
+#define __SPECIALIZED_TEMPLATE_HPP_
+
+#include "Template.hpp"
+#include "Dictionary.hpp"
+
+namespace template_engine
+{
+TE_BEGIN_FLAVOUR
+
+/** \brief Residual template of a specialization, which still refers to some of the known values.
+ *
+ * Created by TemplateSpecializer when a repeat could not be unrolled.
+ * While rendering, the known values are looked up after the dictionary
+ * the template is rendered with, and before its parent scope. Each render
+ * has a scope of its own for this, and a known list is repeated in a
+ * ListScope rather than being reparented, so a residual template can be
+ * rendered by several threads at once.
+ */
+class SpecializedTemplate :
+	public Template
+{
+public:
+    /** \brief Construct a specialized template.
+     *
+     * \param known const DictionaryPtr&    The values the template was specialized with.
+     * \param templ const TemplatePtr&      The residual template.
+     */
+	SpecializedTemplate(const DictionaryPtr& known, const TemplatePtr& templ);
+
+protected:
+    /** \brief Render the residual template, with the known values in scope.
+     *
+     * \param dictionary const DictionaryPtr&   The values which weren't known.
+     * \param filter TemplateFilter             Must be the filter the template was specialized with.
+     * \return virtual te_string                The rendered text.
+     * \throws TemplateException                If a name can't be found.
+     */
+	virtual te_string render(const DictionaryPtr& dictionary, TemplateFilter filter) const;
+
+    /** \brief Append the residual template to the output, with the known values in scope. */
+	virtual void renderInto(const DictionaryPtr& dictionary, TemplateEscaper escaper, te_string& out) const;
+
+    /** \brief Optimize the residual template. */
+	virtual TemplatePtr optimize(const TemplateOptimizer& optimizer) const;
+
+    /** \brief Add the names referenced by the residual template, except the top level values which are known.
+     *
+     * A known list is kept, the body of its repeat may reference names which must be given.
+     */
+	virtual void addDependencies(TemplateDependencies& scope) const;
+
+private:
+    /** \brief A scope of its own for one render, with the known values layered behind dictionary. */
+	DictionaryPtr overlay(const DictionaryPtr& dictionary) const;
+
+	DictionaryPtr _known;   ///< The values the template was specialized with.
+	TemplatePtr _templ;     ///< The residual template.
+};
+
+TE_END_FLAVOUR
+}
+#endif // !__SPECIALIZED_TEMPLATE_HPP_
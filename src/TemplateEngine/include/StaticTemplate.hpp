@@ -0,0 +1,585 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#ifndef __STATIC_TEMPLATE_HPP_
+#define __STATIC_TEMPLATE_HPP_
+
+#include <cstdint>
+
+#include "Types.hpp"
+#include "CharClass.hpp"
+#include "Exception.hpp"
+#include "Context.hpp"
+#include "Template.hpp"
+#include "GeneratedTemplate.hpp"
+#include "FilterChain.hpp"
+#include "TypedValue.hpp"
+
+/** \brief Define a StaticTemplate from a string literal, parsed while compiling.
+ *
+ * Declares the constant NAME##_definition holding the definition, and the
+ * constant NAME, a StaticTemplate with exactly the number of nodes the
+ * definition needs. A syntax error in the definition is a compile error.
+ * Use at namespace or function scope.
+ *
+ * \param NAME          Name of the template constant.
+ * \param DEFINITION    The template definition, a plain string literal e.g. "Hello {{NAME}}".
+ */
+#define TE_STATIC_TEMPLATE(NAME, DEFINITION) \
+	static constexpr ::template_engine::te_char_t NAME##_definition[] = TE_TEXT(DEFINITION); \
+	static constexpr ::template_engine::StaticTemplate<::template_engine::StaticParser::countNodes(NAME##_definition)> NAME{ NAME##_definition }
+
+namespace template_engine
+{
+TE_BEGIN_FLAVOUR
+
+/** \internal
+ * \brief A node of a StaticTemplate, the nodes are stored in definition order.
+ *
+ * A repeat is followed by the nodes of its body, end is the index of the
+ * first node after the body. The format specifier of an expansion is
+ * kept as its text, and the filters as the text from the first '|' up to
+ * the end tag.
+ */
+struct StaticNode
+{
+    /** \brief The kinds of nodes */
+	enum class node_t : uint8_t {
+		Literal,    ///< Text copied to the output, offset and length refer to the definition.
+		Expansion,  ///< A name expansion, offset and length is the name, spec and filters its format and filter chain.
+		Repeat,     ///< A repeat instruction, offset and length is the name of the list.
+	};
+
+	constexpr StaticNode() :
+		type(node_t::Literal),
+		scopeWalk(0),
+		offset(0),
+		length(0),
+		end(0),
+		spec(0),
+		specLength(0),
+		filters(0),
+		filtersLength(0)
+	{ }
+
+	node_t type;        ///< The kind of node.
+	uint8_t scopeWalk;  ///< Number of scopes to walk up, expansions only.
+	size_t offset;      ///< Offset of the text or name into the definition.
+	size_t length;      ///< Length of the text or name.
+	size_t end;         ///< Index of the node following the body, repeats only.
+	size_t spec;        ///< Offset of the format specifier into the definition, without the ':', expansions only.
+	size_t specLength;  ///< Length of the format specifier, 0 if there is none.
+	size_t filters;     ///< Offset of the filter chain into the definition, expansions only.
+	size_t filtersLength;   ///< Length of the filter chain, 0 if there are no filters.
+};
+
+/** \internal
+ * \brief Parses a template definition within a constant expression.
+ *
+ * The syntax is the one accepted by TemplateParser, and the errors are
+ * the same TemplateException's. Thrown while compiling the exception
+ * isn't a constant expression, so every syntax error becomes a compile
+ * error pointing at the throw. Filters are registered at runtime, so an
+ * unknown filter name is reported when the expansion is rendered.
+ *
+ * The parse result is handed to a builder, with the member functions
+ * literal(offset, length), expansion(offset, length, scopeWalk, spec, specLength, filters, filtersLength),
+ * beginRepeat(offset, length) and endRepeat().
+ */
+class StaticParser
+{
+public:
+    /** \brief Parse the definition.
+     *
+     * \param text const te_char_t*    The definition.
+     * \param length size_t            Number of code units in the definition.
+     * \param builder Builder&         Receives the parsed nodes.
+     * \throws TemplateException       On syntax errors.
+     */
+	template <typename Builder>
+	static constexpr void parse(const te_char_t* text, size_t length, Builder& builder)
+	{
+		size_t literal = 0;	// start of the current literal
+		size_t depth = 0;
+		size_t pos = 0;
+		while (pos < length) {
+			te_char_t ch = text[pos];
+
+			// escape tag '\{{', the braces are plain text
+			if (TE_TEXT('\\') == ch && at(text, length, pos + 1) == TE_TEXT('{') && at(text, length, pos + 2) == TE_TEXT('{')) {
+				flush(builder, literal, pos);
+				literal = pos + 1;
+				pos += 3;
+				continue;
+			}
+
+			if (TE_TEXT('{') != ch || TE_TEXT('{') != at(text, length, pos + 1)) {
+				++pos;
+				continue;
+			}
+
+			te_char_t ch3 = at(text, length, pos + 2);
+
+			// comment tag '{{-', skipped up to and including '}}'
+			if (TE_TEXT('-') == ch3) {
+				flush(builder, literal, pos);
+				pos += 3;
+				while (pos < length && !(TE_TEXT('}') == text[pos] && TE_TEXT('}') == at(text, length, pos + 1)))
+					++pos;
+				if (pos == length)
+					throw TemplateException("Runaway comment detected");
+				pos += 2;
+				literal = pos;
+				continue;
+			}
+
+			// as for the lexer '{{' only starts an instruction if a marker or a name follows
+			char_class_t cls = classify(ch3);
+			if (char_class_t::Marker != cls && char_class_t::Name != cls) {
+				++pos;
+				continue;
+			}
+
+			flush(builder, literal, pos);
+			pos += 2;
+			if (TE_TEXT('#') == ch3) {
+				pos = parseRepeat(text, length, pos + 1, builder);
+				if (++depth > Template::defaultMaxDepth)
+					throw TemplateException("Repeat instructions are nested too deeply");
+			}
+			else if (TE_TEXT('/') == ch3) {
+				pos = parseEndRepeat(text, length, pos + 1);
+
+				// an end repeat without a matching repeat ends the template
+				if (!depth)
+					return;
+				builder.endRepeat();
+				--depth;
+			}
+			else
+				pos = parseExpansion(text, length, pos, builder);
+			literal = pos;
+		}
+
+		// the end of the definition closes any open repeat instructions
+		flush(builder, literal, length);
+		for (; depth; --depth)
+			builder.endRepeat();
+	}
+
+    /** \brief Number of nodes needed for the definition, see TE_STATIC_TEMPLATE.
+     *
+     * \param definition const te_char_t(&)[N]    The NUL terminated definition.
+     * \throws TemplateException    On syntax errors.
+     */
+	template <size_t N>
+	static constexpr size_t countNodes(const te_char_t (&definition)[N])
+	{
+		NodeCounter counter;
+		parse(definition, N - 1, counter);
+		return counter.count;
+	}
+
+private:
+    /** \brief Counts the nodes, without storing them. */
+	struct NodeCounter
+	{
+		constexpr NodeCounter() : count(0) { }
+		constexpr void literal(size_t, size_t) { ++count; }
+		constexpr void expansion(size_t, size_t, uint8_t, size_t, size_t, size_t, size_t) { ++count; }
+		constexpr void beginRepeat(size_t, size_t) { ++count; }
+		constexpr void endRepeat() { }
+
+		size_t count;   ///< Nodes seen so far.
+	};
+
+    /** \brief The code unit at pos, NUL past the end as for LookaheadScanner::peek(). */
+	static constexpr te_char_t at(const te_char_t* text, size_t length, size_t pos)
+	{
+		return pos < length ? text[pos] : TE_TEXT('\0');
+	}
+
+	static constexpr bool isSpace(te_char_t ch) { return char_class_t::Space == classify(ch); }
+
+	static constexpr size_t skipSpace(const te_char_t* text, size_t length, size_t pos)
+	{
+		while (pos < length && isSpace(text[pos]))
+			++pos;
+		return pos;
+	}
+
+	static constexpr size_t skipName(const te_char_t* text, size_t length, size_t pos)
+	{
+		while (pos < length && char_class_t::Name == classify(text[pos]))
+			++pos;
+		return pos;
+	}
+
+	static constexpr bool isDigit(te_char_t ch) { return ch >= TE_TEXT('0') && ch <= TE_TEXT('9'); }
+
+	static constexpr bool isAlign(te_char_t ch)
+	{
+		return TE_TEXT('<') == ch || TE_TEXT('>') == ch || TE_TEXT('^') == ch;
+	}
+
+	static constexpr bool isType(te_char_t ch)
+	{
+		const char types[] = "dxXobfeEgG%s";
+		for (size_t i = 0; i < sizeof(types) - 1; ++i)
+			if (static_cast<te_char_t>(types[i]) == ch)
+				return true;
+		return false;
+	}
+
+	static constexpr bool isEndTag(const te_char_t* text, size_t length, size_t pos)
+	{
+		return TE_TEXT('}') == at(text, length, pos) && TE_TEXT('}') == at(text, length, pos + 1);
+	}
+
+    /** \brief Report the literal [first, last) unless it is empty. */
+	template <typename Builder>
+	static constexpr void flush(Builder& builder, size_t first, size_t last)
+	{
+		if (first < last)
+			builder.literal(first, last - first);
+	}
+
+    /** \brief Read the 'repeat' keyword following '{{#' or '{{/', and return the position after it. */
+	static constexpr size_t parseKeyword(const te_char_t* text, size_t length, size_t pos)
+	{
+		pos = skipSpace(text, length, pos);
+		size_t first = pos;
+		pos = skipName(text, length, pos);
+		if (first == pos)
+			throw TemplateException("Malformed name expansion");
+
+		const char keyword[] = "repeat";
+		bool match = pos - first == sizeof(keyword) - 1;
+		for (size_t i = 0; match && i < pos - first; ++i)
+			match = asciiToLower(text[first + i]) == static_cast<te_char_t>(keyword[i]);
+		if (!match)
+			throw TemplateException("Unknown processing instruction");
+		return pos;
+	}
+
+    /** \brief {{# repeat <name> }} from after the '#' */
+	template <typename Builder>
+	static constexpr size_t parseRepeat(const te_char_t* text, size_t length, size_t pos, Builder& builder)
+	{
+		pos = parseKeyword(text, length, pos);
+
+		// the keyword must be separated from the name
+		te_char_t ch = at(text, length, pos);
+		if (isSpace(ch) || char_class_t::Marker == classify(ch))
+			++pos;
+
+		pos = skipSpace(text, length, pos);
+		size_t name = pos;
+		pos = skipName(text, length, pos);
+		if (name == pos)
+			throw TemplateException("Malformed repeat instruction, a name was expected");
+
+		pos = skipSpace(text, length, pos);
+		if (!isEndTag(text, length, pos))
+			throw TemplateException("Malformed repeat instruction, an end tag was expected");
+
+		builder.beginRepeat(name, pos - name);
+		return pos + 2;
+	}
+
+    /** \brief {{/ repeat }} from after the '/' */
+	static constexpr size_t parseEndRepeat(const te_char_t* text, size_t length, size_t pos)
+	{
+		pos = skipSpace(text, length, parseKeyword(text, length, pos));
+		if (!isEndTag(text, length, pos))
+			throw TemplateException("Malformed end repeat instruction, an end tag was expected");
+		return pos + 2;
+	}
+
+    /** \brief Check a format specifier as ValueFormat parses it, [[fill]align][sign][0][width][.precision][type]. */
+	static constexpr void checkSpec(const te_char_t* spec, size_t n)
+	{
+		size_t i = 0;
+		if (n >= 2 && isAlign(spec[1]))
+			i = 2;
+		else if (n >= 1 && isAlign(spec[0]))
+			i = 1;
+
+		if (i < n && (TE_TEXT('+') == spec[i] || TE_TEXT('-') == spec[i]))
+			++i;
+		if (i < n && TE_TEXT('0') == spec[i])
+			++i;
+		size_t width = 0;
+		for (; i < n && isDigit(spec[i]) && width <= ValueFormat::maxWidth; ++i)
+			width = 10 * width + static_cast<size_t>(spec[i] - TE_TEXT('0'));
+
+		int precision = 0;
+		if (i < n && TE_TEXT('.') == spec[i]) {
+			if (++i == n || !isDigit(spec[i]))
+				i = n + 1;
+			for (; i < n && isDigit(spec[i]) && precision <= ValueFormat::maxPrecision; ++i)
+				precision = 10 * precision + static_cast<int>(spec[i] - TE_TEXT('0'));
+		}
+
+		if (i < n && isType(spec[i]))
+			++i;
+
+		if (i != n || !n || width > ValueFormat::maxWidth || precision > ValueFormat::maxPrecision)
+			throw TemplateException("Malformed format specifier ':" + to_utf8(te_string(spec, n)) + "'");
+	}
+
+    /** \brief {{ (:)*<name>(:<format>)? (|<filter>)* }} from after the '{{' */
+	template <typename Builder>
+	static constexpr size_t parseExpansion(const te_char_t* text, size_t length, size_t pos, Builder& builder)
+	{
+		uint8_t scopeWalk = 0;
+		for (; TE_TEXT(':') == at(text, length, pos); ++pos)
+			++scopeWalk;
+
+		size_t name = pos;
+		pos = skipName(text, length, pos);
+		if (name == pos)
+			throw TemplateException("Malformed name expansion");
+
+		size_t nameLength = pos - name;
+		pos = skipSpace(text, length, pos);
+
+		// the specifier ends at white space, a filter or the end tag
+		size_t spec = pos;
+		if (TE_TEXT(':') == at(text, length, pos)) {
+			spec = ++pos;
+			while (pos < length && !isSpace(text[pos]) && TE_TEXT('|') != text[pos] && !isEndTag(text, length, pos))
+				++pos;
+			checkSpec(text + spec, pos - spec);
+		}
+		size_t specLength = pos - spec;
+		pos = skipSpace(text, length, pos);
+
+		size_t filters = pos;
+		size_t filtersEnd = pos;
+		while (TE_TEXT('|') == at(text, length, pos)) {
+			pos = skipSpace(text, length, pos + 1);
+			size_t filter = pos;
+			pos = skipName(text, length, pos);
+			if (filter == pos)
+				throw TemplateException("Malformed name expansion, a filter name was expected");
+			filtersEnd = pos;
+			pos = skipSpace(text, length, pos);
+		}
+
+		if (!isEndTag(text, length, pos))
+			throw TemplateException("Missing end tag '}}' in name expansion");
+
+		builder.expansion(name, nameLength, scopeWalk, spec, specLength, filters, filtersEnd - filters);
+		return pos + 2;
+	}
+};
+
+/** \brief A template parsed from a string literal while compiling.
+ *
+ * The definition is parsed by a constexpr constructor into a fixed array
+ * of nodes referring to the literal, so a syntax error is a compile error,
+ * nothing is parsed at runtime and the template itself never touches the
+ * heap. Names are looked up, and lists repeated, exactly as by the
+ * interpreted templates. The format specifier and filter chain of an
+ * expansion are set up when it is rendered, an expansion without them
+ * costs nothing extra.
+ *
+ * The number of nodes is a template argument, TE_STATIC_TEMPLATE works
+ * it out from the definition.
+ *
+ * ~~~.cpp
+ * TE_STATIC_TEMPLATE(greeting, "Hello {{NAME}}{{#repeat ITEMS}} {{ITEM}}{{/repeat}}");
+ * te_string text = greeting.render(context);
+ * ~~~
+ *
+ * \tparam Nodes    Number of nodes the definition is parsed into.
+ */
+template <size_t Nodes>
+class StaticTemplate
+{
+	friend class StaticParser;
+
+public:
+	/** \brief Maximum number of nodes in the template. */
+	static const size_t capacity = Nodes;
+
+    /** \brief Parse the definition.
+     *
+     * \param definition const te_char_t(&)[N]    The NUL terminated definition, which must outlive the template.
+     * \throws TemplateException    On syntax errors, or if the definition needs more than Nodes nodes.
+     */
+	template <size_t N>
+	constexpr StaticTemplate(const te_char_t (&definition)[N]) :
+		_text(definition),
+		_nodes(),
+		_count(0),
+		_open(0),
+		_literalSize(0)
+	{
+		StaticParser::parse(definition, N - 1, *this);
+	}
+
+    /** \brief Number of nodes in the template. */
+	constexpr size_t size() const { return _count; }
+
+    /** \brief Render the template, based on the specified context.
+     *
+     * \param context const ContextPtr  The context to use when expanding values.
+     * \param filter TemplateFilter     Optional filter to apply when expanding values.
+     * \return te_string                String where values from the dictionaries have been expanded.
+     * \throws TemplateException        If a name or a list can't be found.
+     */
+	te_string render(const ContextPtr context, TemplateFilter filter = nullptr) const
+	{
+		te_string out;
+		render(out, context->getDictionary(), filter);
+		return out;
+	}
+
+    /** \brief Render the template, appending the text to out.
+     *
+     * \param out te_string&                    The rendered text is appended here.
+     * \param dictionary const DictionaryPtr&   The dictionary to use when expanding values.
+     * \param filter const TemplateFilter&      Optional filter to apply when expanding values.
+     * \throws TemplateException                If a name or a list can't be found.
+     */
+	void render(te_string& out, const DictionaryPtr& dictionary, const TemplateFilter& filter = nullptr) const
+	{
+		RenderScope scope;
+		out.reserve(out.size() + _literalSize);
+
+		te_string name;
+		render(out, dictionary, filter, name, 0, _count);
+	}
+
+private:
+    /** \brief Render the nodes [first, last), name is scratch space for the name lookups. */
+	void render(te_string& out, const DictionaryPtr& dictionary, const TemplateFilter& filter, te_string& name, size_t first, size_t last) const
+	{
+		for (size_t i = first; i < last; ) {
+			const StaticNode& node = _nodes[i];
+			switch (node.type)
+			{
+				case StaticNode::node_t::Literal:
+					out.append(_text + node.offset, node.length);
+					++i;
+					break;
+
+				case StaticNode::node_t::Expansion:
+					name.assign(_text + node.offset, node.length);
+					if (node.specLength || node.filtersLength)
+						GeneratedTemplate::expand(out, dictionary, name, node.scopeWalk, format(node), filters(node), filter);
+					else
+						GeneratedTemplate::expand(out, dictionary, name, node.scopeWalk, filter);
+					++i;
+					break;
+
+				case StaticNode::node_t::Repeat:
+					name.assign(_text + node.offset, node.length);
+					GeneratedTemplate::repeat(dictionary, name, [&](const DictionaryPtr& item) {
+						render(out, item, filter, name, i + 1, node.end);
+					});
+					i = node.end;
+					break;
+			}
+		}
+	}
+
+    /** \brief The format of an expansion, the default if it has no specifier. */
+	ValueFormat format(const StaticNode& node) const
+	{
+		if (!node.specLength)
+			return ValueFormat();
+		return ValueFormat(te_string(_text + node.spec, node.specLength));
+	}
+
+    /** \brief The filter chain of an expansion, the names are those between the '|'s. */
+	FilterChain filters(const StaticNode& node) const
+	{
+		FilterChain chain;
+		const te_char_t* text = _text + node.filters;
+		size_t length = node.filtersLength;
+		for (size_t pos = 0; pos < length; ) {
+			if (char_class_t::Name != classify(text[pos])) {
+				++pos;
+				continue;
+			}
+			size_t first = pos;
+			while (pos < length && char_class_t::Name == classify(text[pos]))
+				++pos;
+			chain.push_back(te_string(text + first, pos - first));
+		}
+		return chain;
+	}
+
+	constexpr StaticNode& append(StaticNode::node_t type, size_t offset, size_t length)
+	{
+		if (_count == Nodes)
+			throw TemplateException("The definition needs more nodes than the static template has");
+
+		StaticNode& node = _nodes[_count++];
+		node.type = type;
+		node.offset = offset;
+		node.length = length;
+		return node;
+	}
+
+	// the StaticParser builder interface
+
+	constexpr void literal(size_t offset, size_t length)
+	{
+		append(StaticNode::node_t::Literal, offset, length);
+		_literalSize += length;
+	}
+
+	constexpr void expansion(size_t offset, size_t length, uint8_t scopeWalk, size_t spec, size_t specLength, size_t filters, size_t filtersLength)
+	{
+		StaticNode& node = append(StaticNode::node_t::Expansion, offset, length);
+		node.scopeWalk = scopeWalk;
+		node.spec = spec;
+		node.specLength = specLength;
+		node.filters = filters;
+		node.filtersLength = filtersLength;
+	}
+
+	constexpr void beginRepeat(size_t offset, size_t length)
+	{
+		// while the repeat is open, end links to the enclosing open repeat
+		append(StaticNode::node_t::Repeat, offset, length).end = _open;
+		_open = _count;
+	}
+
+	constexpr void endRepeat()
+	{
+		StaticNode& node = _nodes[_open - 1];
+		_open = node.end;
+		node.end = _count;
+	}
+
+	const te_char_t* _text;                     ///< The definition.
+	StaticNode _nodes[Nodes ? Nodes : 1];       ///< The parsed nodes.
+	size_t _count;                              ///< Number of nodes in use.
+	size_t _open;                               ///< One more than the index of the innermost open repeat, 0 if none.
+	size_t _literalSize;                        ///< Total length of the literals, reserved when rendering.
+};
+
+template <size_t Nodes>
+const size_t StaticTemplate<Nodes>::capacity;
+
+TE_END_FLAVOUR
+}
+#endif // !__STATIC_TEMPLATE_HPP_
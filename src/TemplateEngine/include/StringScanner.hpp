@@ -17,12 +17,22 @@
 #ifndef __STRING_CHAR_READER_HPP
 #define __STRING_CHAR_READER_HPP
 
+#include <utility>
+
 #include "Scanner.hpp"
+#include "SourceBuffer.hpp"
 
 namespace template_engine
 {
+TE_BEGIN_FLAVOUR
 
-/** \brief Scanner operating on UTF-16 strings.
+/** \brief Scanner operating on in-memory te_string values.
+ *
+ * The text is held in a SourceBuffer. Templates parsed from a string
+ * scanner refer to the literal text in that buffer, rather than copying
+ * it, so the buffer is kept alive by the templates when it is owned.
+ * Pass a borrowed buffer (SourceBuffer::borrow()) to parse text which
+ * is guaranteed to outlive the templates without copying it at all.
  */
 class StringScanner :
 	public Scanner
@@ -32,14 +42,32 @@ public:
 	 * @param t	string to be parsed, a null pointer will be converted to an empty string
 	 */
 	StringScanner(const te_char_t* const t) :
-		_template(t ? te_string(t) : te_string(TE_TEXT(""))),
-		_templateIterator(_template.begin())
+		_source(t ? te_string(t) : te_string()),
+		_position(0)
 	{};
 
-	/** \copydoc StringScanner::StringScanner(const te_char_t* const) */
+	/** Initialize a string scanner with a copy of the string.
+	 * @param t	string to be parsed
+	 */
 	StringScanner(const te_string& t) :
-		_template(te_string(t)),
-		_templateIterator(_template.begin())
+		_source(t),
+		_position(0)
+	{};
+
+	/** Initialize a string scanner which takes over the string, without copying it.
+	 * @param t	string to be parsed
+	 */
+	StringScanner(te_string&& t) :
+		_source(std::move(t)),
+		_position(0)
+	{};
+
+	/** Initialize a string scanner reading from an owned or borrowed buffer.
+	 * @param source	the text to be parsed
+	 */
+	StringScanner(const SourceBuffer& source) :
+		_source(source),
+		_position(0)
 	{};
 
 	/** \copydoc Scanner::moveNext() */
@@ -51,10 +79,20 @@ public:
     /** \copydoc Scanner::getChar() */
 	virtual te_char_t getChar() const;
 
+    /** \copydoc Scanner::getBlock() */
+	virtual const te_char_t* getBlock(size_t& length);
+
+    /** \copydoc Scanner::advance() */
+	virtual void advance(size_t n);
+
+    /** \copydoc Scanner::getSource() */
+	virtual const SourceBuffer* getSource() const;
+
 private:
-	const te_string _template;
-	te_string::const_iterator _templateIterator;
+	const SourceBuffer _source;     //!< The text being scanned.
+	size_t _position;               //!< Offset of the current code unit in _source.
 };
 
+TE_END_FLAVOUR
 }
 #endif // !__STRING_CHAR_READER_HPP
@@ -23,9 +23,13 @@
 #include "Scanner.hpp"
 #include "Lexer.hpp"
 #include "Context.hpp"
+#include "OutputSink.hpp"
+#include "TemplateDependencies.hpp"
+#include "ValueProvider.hpp"
 
 namespace template_engine
 {
+TE_BEGIN_FLAVOUR
 
 /** \brief Filter expansion prior to the result being pushed to the output buffer.
  * A filter function is responsible for filtering illegal characters
@@ -39,9 +43,21 @@ namespace template_engine
  */
 typedef std::function<te_string(const te_string&)> TemplateFilter;
 
+/** \brief Append an expanded value to the output, escaped, e.g. HtmlEscaper::append.
+ *
+ * Unlike a TemplateFilter an escaper writes straight into the output, and
+ * is a plain function rather than a std::function, see Template::renderInto().
+ */
+typedef void (*TemplateEscaper)(te_string& out, const te_char_t* value, size_t length);
+
 class Template;
 typedef std::shared_ptr<Template> TemplatePtr;  //<! Pointer to a Template
 
+class RenderCache;
+class TemplateOptimizer;
+class TemplateSpecializer;
+class TemplateWriter;
+
 /** \brief Abstract class describing every possible kind of template used.
  * This class is capable of parsing a template definition text, and instantiating
  * a valid hierarchy of templates, based on that definition.
@@ -49,7 +65,13 @@ typedef std::shared_ptr<Template> TemplatePtr;  //<! Pointer to a Template
 class Template
 {
 	friend class TemplateList;
+	friend class ProvidedTemplate;
 	friend class RepeatTemplate;
+	friend class RenderCache;
+	friend class SpecializedTemplate;
+	friend class TemplateOptimizer;
+	friend class TemplateSpecializer;
+	friend class TemplateWriter;
 public:
 	Template() {};
 
@@ -58,15 +80,40 @@ public:
      */
 	virtual ~Template() {};
 
+	/** \brief Default limit on how deep repeat instructions may be nested. */
+	static const size_t defaultMaxDepth = 1024;
+
     /** \brief Scan the given input, and construct a template hierarchy from that definition.
+     *
+     * The definition is parsed by a TemplateParser, which keeps the open
+     * repeat instructions on an explicit stack rather than recursing, so
+     * the nesting depth is only limited by maxDepth.
      *
      * \param s Scanner&            The scanner to read the input configuration from.
+     * \param maxDepth size_t       How deep repeat instructions may be nested.
      * \return TemplatePtr          Template hierarchy generated from the input.
      * \throws TemplateException    All parse errors are reported as exceptions.
      */
-	static TemplatePtr parse(Scanner& s);
+	static TemplatePtr parse(Scanner& s, size_t maxDepth = defaultMaxDepth);
+
+    /** \brief Partially evaluate a template against the part of the dictionary which is known ahead of time.
+     *
+     * Every expansion and repeat which is fully determined by the known
+     * values is rendered into a literal, see TemplateSpecializer. The
+     * residual template is rendered with a dictionary holding the remaining
+     * values only, and with the same filter.
+     *
+     * \param templ const TemplatePtr&      The template to specialize.
+     * \param known const DictionaryPtr&    The values known ahead of time, e.g. those of a tenant.
+     * \param filter TemplateFilter         The filter the residual template is rendered with.
+     * \return TemplatePtr                  The residual template.
+     * \throws TemplateException            If a known name is of the wrong kind, e.g. a list is expanded.
+     */
+	static TemplatePtr specialize(const TemplatePtr& templ, const DictionaryPtr& known, TemplateFilter filter = nullptr);
 
     /** \brief Render the template, based on the specified dictionary/context.
+     *
+     * The render opens a RenderScope, so each provided value is computed once.
      *
      * \param context const Context&    The context to use when expanding values.
      * \param filter TemplateFilter     Optional filter to apply when expanding values.
@@ -75,7 +122,93 @@ public:
      */
 	virtual te_string render(const ContextPtr context, TemplateFilter filter = nullptr) const
 	{
-		return render(context->getDictionary(), filter);
+		RenderScope scope;
+		if (filter)
+			return render(context->getDictionary(), filter);
+
+		te_string out;
+		renderInto(context->getDictionary(), nullptr, out);
+		return out;
+	}
+
+    /** \brief Render the template, escaping the expanded values with an escaper.
+     *
+     * The escaper is selected at compile time, e.g.
+     * <code>templ->render<HtmlEscaper>(context)</code>, see Escaper.hpp.
+     *
+     * \tparam Escaper  A type with a static append() matching TemplateEscaper.
+     * \param context const Context&    The context to use when expanding values.
+     * \return te_string                String where values from the dictionaries have been expanded.
+     * \throws TemplateException        All and all errors encountered, e.g. missing dictionary entries,
+     */
+	template <typename Escaper>
+	te_string render(const ContextPtr context) const
+	{
+		RenderScope scope;
+		te_string out;
+		renderInto(context->getDictionary(), &Escaper::append, out);
+		return out;
+	}
+
+    /** \brief Render the template, appending the text to a string.
+     *
+     * Every template appends directly to out, so no intermediate strings
+     * are created, and out can be reused between renders.
+     *
+     * \param context const Context&    The context to use when expanding values.
+     * \param out te_string&            The string the rendered text is appended to.
+     * \param escaper TemplateEscaper   Optional escaper to apply when expanding values.
+     * \throws TemplateException        All and all errors encountered, out then holds part of the text.
+     */
+	void renderInto(const ContextPtr context, te_string& out, TemplateEscaper escaper = nullptr) const
+	{
+		RenderScope scope;
+		renderInto(context->getDictionary(), escaper, out);
+	}
+
+    /** \brief Render the template into an output sink, handing the output over while the repeats are rendered.
+     *
+     * The output is buffered by a StreamedOutput, so the complete text is
+     * never materialized, with a generated DictionaryList a long list is
+     * rendered in constant memory. The sink isn't flushed.
+     *
+     * \param context const Context&    The context to use when expanding values.
+     * \param sink OutputSink&          Destination of the rendered text, e.g. a Utf8StreamSink.
+     * \param escaper TemplateEscaper   Optional escaper to apply when expanding values.
+     * \throws TemplateException        All and all errors encountered, part of the text may then have been written.
+     */
+	void renderInto(const ContextPtr context, OutputSink& sink, TemplateEscaper escaper = nullptr) const
+	{
+		RenderScope scope;
+		StreamedOutput stream(sink);
+		renderInto(context->getDictionary(), escaper, stream.buffer());
+		stream.finish();
+	}
+
+    /** \brief The names, lists and scope walks the template references, per repeat scope.
+     *
+     * A template wrapping code which can't be inspected, e.g. a
+     * GeneratedTemplate, marks its scope as incomplete.
+     *
+     * \return TemplateDependencies    The references of the top level scope, and of the repeats within it.
+     */
+	TemplateDependencies dependencies() const;
+
+    /** \brief Render the template into an output sink.
+     *
+     * Without a filter the output is streamed, see renderInto(const ContextPtr, OutputSink&, TemplateEscaper).
+     *
+     * \param context const Context&    The context to use when expanding values.
+     * \param sink OutputSink&          Destination of the rendered text, e.g. a Utf8StreamSink.
+     * \param filter TemplateFilter     Optional filter to apply when expanding values.
+     * \throws TemplateException        All and all errors encountered, e.g. missing dictionary entries,
+     */
+	void render(const ContextPtr context, OutputSink& sink, TemplateFilter filter = nullptr) const
+	{
+		if (!filter)
+			renderInto(context, sink);
+		else
+			sink.write(render(context, filter));
 	}
 
 protected:
@@ -89,16 +222,64 @@ protected:
      */
 	virtual te_string render(const DictionaryPtr& dictionary, TemplateFilter filter) const = 0;
 
-private:
-	static TemplatePtr	parse(Lexer& l);
-	static TemplatePtr	parseSimpleTemplate(const Lexer::Token& token, Lexer& lexer);
-	static TemplatePtr	parseInstructionTemplate(Lexer& lexer);
-	static TemplatePtr	parseRepeatTemplate(Lexer& lexer);
-	static te_string	parseStartRepeatTemplate(Lexer& lexer);
-	static TemplatePtr	parseEndRepeatTemplate(Lexer& lexer);
-	static TemplatePtr	parseExpansionTemplate(const Lexer::Token& token, Lexer& lexer);
+    /** \brief Similar to the public renderInto, except the dictionary to use has been resolved.
+     *
+     * The default appends the result of render(), with the escaper wrapped in a filter.
+     *
+     * \param dictionary    The context to use when expanding values.
+     * \param escaper       Optional escaper to apply when expanding values.
+     * \param out           The string the rendered text is appended to.
+     * \throws TemplateException    All and all errors encountered, e.g. missing dictionary entries,
+     */
+	virtual void renderInto(const DictionaryPtr& dictionary, TemplateEscaper escaper, te_string& out) const;
+
+    /** \brief Rewrite the template into an equivalent one which is cheaper to render, see TemplateOptimizer.
+     *
+     * \param optimizer const TemplateOptimizer&    What may be folded.
+     * \return TemplatePtr  The replacement, or nullptr if the template is kept as it is.
+     */
+	virtual TemplatePtr optimize(const TemplateOptimizer& /*optimizer*/) const { return nullptr; }
+
+    /** \brief Render the parts of the template which are determined by the known values, see TemplateSpecializer.
+     *
+     * \param specializer TemplateSpecializer&  The known values, and the scopes entered so far.
+     * \return TemplatePtr  The residual template, or nullptr if the template is kept as it is.
+     */
+	virtual TemplatePtr specialize(TemplateSpecializer& /*specializer*/) const { return nullptr; }
+
+    /** \brief Append the template to a binary image, see TemplateImage.
+     *
+     * \param writer TemplateWriter&    The image being written.
+     * \throws TemplateException        If the template can't be stored in an image.
+     */
+	virtual void write(TemplateWriter& writer) const;
+
+    /** \brief Render the template through a RenderCache, which records the dictionary entries read.
+     *
+     * The default renders the template as usual, so unless it is static
+     * the output can't be reused, and is rendered again every time.
+     *
+     * \param cache RenderCache&                The cache recording what is read.
+     * \param dictionary const DictionaryPtr&   The context to use when expanding values.
+     * \param out te_string&                    The output the rendered text is appended to.
+     * \throws TemplateException                As render().
+     */
+	virtual void renderCached(RenderCache& cache, const DictionaryPtr& dictionary, te_string& out) const;
+
+    /** \brief Add the names the template references to those of the scope, see dependencies().
+     *
+     * The default adds nothing, and marks the scope incomplete unless the template is static.
+     */
+	virtual void addDependencies(TemplateDependencies& scope) const;
+
+    /** \brief Is the rendered text independent of both the dictionary and the filter?
+     *
+     * A static template can be rendered ahead of time, with an empty dictionary and no filter.
+     */
+	virtual bool isStatic() const { return false; }
 };
 
+TE_END_FLAVOUR
 }
 #endif // !__TEMPLATE_HPP_
 
@@ -0,0 +1,83 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#ifndef __TEMPLATE_CACHE_HPP_
+#define __TEMPLATE_CACHE_HPP_
+
+#include <string>
+
+#include "Template.hpp"
+
+namespace template_engine
+{
+
+// the same in both flavours
+class FileMapping;
+
+TE_BEGIN_FLAVOUR
+
+/** \brief On-disk cache of compiled templates, so a template file is only parsed once.
+ *
+ * The image of a template file, see TemplateImage, is stored in the cache
+ * directory under a hash of the file's contents, the format version and
+ * the flavour. Loading a template whose contents haven't changed maps the
+ * cached image instead of parsing the file, a template file which has
+ * changed gets a new image. Old images are never removed, the directory
+ * can be emptied at any time.
+ *
+ * An image is written to a temporary file which is then renamed, so
+ * processes sharing a cache directory never see a partially written image.
+ *
+ * \code
+ * TemplateCache cache("/var/cache/myapp");
+ * TemplatePtr templ = cache.load("templates/page.tmpl");
+ * \endcode
+ */
+class TemplateCache
+{
+public:
+    /** \brief Use the given directory as cache, it is created if it doesn't exist.
+     *
+     * \param directory const std::string&  UTF-8 path of the cache directory.
+     * \throws TemplateException            If the directory doesn't exist and can't be created.
+     */
+	explicit TemplateCache(const std::string& directory);
+
+    /** \brief Load a template file, from its cached image if there is one.
+     *
+     * \param path const std::string&   UTF-8 path of the template file.
+     * \return TemplatePtr              The template.
+     * \throws TemplateException        If the template file can't be read or parsed, or the image can't be written.
+     */
+	TemplatePtr load(const std::string& path) const;
+
+    /** \brief Path of the image a template file is cached as, whether or not it exists.
+     *
+     * \param path const std::string&   UTF-8 path of the template file.
+     * \throws TemplateException        If the template file can't be read.
+     */
+	std::string getImagePath(const std::string& path) const;
+
+private:
+    /** \brief Path of the image of the mapped template file. */
+	std::string getImagePath(const FileMapping& file) const;
+
+	std::string _directory; ///< The cache directory.
+};
+
+TE_END_FLAVOUR
+}
+#endif // !__TEMPLATE_CACHE_HPP_
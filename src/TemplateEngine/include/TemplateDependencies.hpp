@@ -0,0 +1,81 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#ifndef __TEMPLATE_DEPENDENCIES_HPP_
+#define __TEMPLATE_DEPENDENCIES_HPP_
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <utility>
+
+#include "Types.hpp"
+
+namespace template_engine
+{
+TE_BEGIN_FLAVOUR
+
+/** \brief The names a template references in one scope, and in the scopes of its repeats, see Template::dependencies().
+ *
+ * The top level scope is the dictionary the template is rendered with,
+ * the scope of a list is that of the sub-dictionaries of the list. A name
+ * is given as it is written in the template, a value expanded with a
+ * scope walk, e.g. <code>{{:TITLE}}</code>, is looked up starting that
+ * many scopes further out, and further out still if it isn't found there.
+ *
+ * \code
+ * TemplateDependencies used = templ->dependencies();
+ * for (const TemplateDependencies::Value& value : used.values)
+ *     fetch(value.first);
+ * for (const auto& list : used.lists)
+ *     fetchRows(list.first, list.second);
+ * \endcode
+ */
+struct TemplateDependencies
+{
+	/** \brief A value expanded in the scope, with the number of scopes walked up before it is looked up. */
+	typedef std::pair<te_string, uint8_t> Value;
+
+	std::set<Value> values;                             ///< The values expanded in the scope
+	std::map<te_string, TemplateDependencies> lists;    ///< The lists repeated in the scope, with what their bodies reference
+	bool complete = true;   ///< false if the scope contains a template which can't tell what it references, e.g. a generated one
+
+    /** \brief Add the names of another scope to this one, e.g. those of a second repeat over the same list. */
+	void merge(const TemplateDependencies& other)
+	{
+		values.insert(other.values.begin(), other.values.end());
+		for (const auto& list : other.lists)
+			lists[list.first].merge(list.second);
+		complete = complete && other.complete;
+	}
+
+    /** \brief Are the scope and all of the scopes of its repeats complete? */
+	bool isComplete() const
+	{
+		if (!complete)
+			return false;
+
+		for (const auto& list : lists)
+			if (!list.second.isComplete())
+				return false;
+
+		return true;
+	}
+};
+
+TE_END_FLAVOUR
+}
+#endif // !__TEMPLATE_DEPENDENCIES_HPP_
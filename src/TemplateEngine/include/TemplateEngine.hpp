@@ -19,34 +19,60 @@
 
 /* MSVC  linker settings. */
 #if defined(_MSC_VER)
+#    ifdef TE_USE_UTF8
+#        define TE_LIB_NAME "TemplateEngineUtf8"
+#    else
+#        define TE_LIB_NAME "TemplateEngine"
+#    endif
 #    if defined(_M_X64)
 #        ifdef _DEBUG
-#            pragma comment(lib, "TemplateEngine64d.lib")
+#            pragma comment(lib, TE_LIB_NAME "64d.lib")
 #        else
-#            pragma comment(lib, "TemplateEngine64.lib")
+#            pragma comment(lib, TE_LIB_NAME "64.lib")
 #        endif
 #    endif
 #    if defined(_M_IX86)
 #        ifdef _DEBUG
-#            pragma comment(lib, "TemplateEngine32d.lib")
+#            pragma comment(lib, TE_LIB_NAME "32d.lib")
 #        else
-#            pragma comment(lib, "TemplateEngine32.lib")
+#            pragma comment(lib, TE_LIB_NAME "32.lib")
 #        endif
 #    endif
 #    pragma comment(lib, "Kernel32.lib")
+#    undef TE_LIB_NAME
 #endif
 
 #include "Types.hpp"
 #include "Exception.hpp"
+#include "Transcoder.hpp"
+#include "OutputSink.hpp"
+#include "SourceBuffer.hpp"
 #include "StringScanner.hpp"
+#include "MappedFileScanner.hpp"
 #include "LookaheadScanner.hpp"
 #include "Template.hpp"
+#include "Escaper.hpp"
+#include "FilterChain.hpp"
+#include "TemplateParser.hpp"
+#include "ParallelParser.hpp"
+#include "IncrementalParser.hpp"
+#include "TemplateOptimizer.hpp"
+#include "TemplateDependencies.hpp"
+#include "TemplateSpecializer.hpp"
+#include "RenderCache.hpp"
+#include "TemplateImage.hpp"
+#include "TemplateCache.hpp"
+#include "GeneratedTemplate.hpp"
+#include "StaticTemplate.hpp"
+#include "TypedValue.hpp"
+#include "ValueProvider.hpp"
 #include "Dictionary.hpp"
 #include "DictionaryList.hpp"
 
 
 /** \brief All code in libTemplateEngine is contained within this namespace, there
- * are no nested namespaces.
+ * are no nested namespaces other than the inline namespace of the flavour, see
+ * TE_BEGIN_FLAVOUR.
  */
 namespace template_engine {
 }
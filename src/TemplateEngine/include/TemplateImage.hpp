@@ -0,0 +1,144 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#ifndef __TEMPLATE_IMAGE_HPP_
+#define __TEMPLATE_IMAGE_HPP_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Template.hpp"
+#include "FilterChain.hpp"
+#include "TypedValue.hpp"
+
+namespace template_engine
+{
+TE_BEGIN_FLAVOUR
+
+/** \brief Binary image of a compiled template, which is loaded without lexing or parsing.
+ *
+ * An image is relocatable, it holds offsets only, and consists of:
+ * - A header with a magic number, the format version, the size of a code
+ *   unit and a byte order mark, an image is only loaded by the flavour and
+ *   the kind of machine it was written by.
+ * - The instruction stream, 32 bit words describing the template tree in
+ *   pre-order: literals, expansions, and the start and end of repeats.
+ * - The table of interned names, each name is stored once. The filters of
+ *   expansions are stored by name, and their format specifiers as written, and looked up in the FilterRegistry
+ *   when the image is loaded.
+ * - The literal pool, the text of the literals and the names in code units.
+ *
+ * Loading is a single pass over the instruction stream. When loaded from a
+ * file, the file is mapped, or read if it is small, and the literals of the
+ * template refer to the literal pool in place, so no text is copied, and the
+ * file stays mapped until the last template referring to it is destroyed.
+ *
+ * A SpecializedTemplate can't be stored, as it refers to a dictionary.
+ */
+class TemplateImage
+{
+public:
+	/** \brief Version of the image format, images of other versions are rejected. */
+	static const uint16_t formatVersion = 1;
+
+    /** \brief Store the template as an image in memory.
+     *
+     * \param templ const TemplatePtr&  The template to store.
+     * \return std::string              The bytes of the image.
+     * \throws TemplateException        If the template can't be stored.
+     */
+	static std::string save(const TemplatePtr& templ);
+
+    /** \brief Store the template as an image file.
+     *
+     * \param templ const TemplatePtr&  The template to store.
+     * \param path const std::string&   UTF-8 path of the image file, it is overwritten.
+     * \throws TemplateException        If the template can't be stored or the file can't be written.
+     */
+	static void save(const TemplatePtr& templ, const std::string& path);
+
+    /** \brief Load a template from a mapped image file.
+     *
+     * \param path const std::string&   UTF-8 path of the image file.
+     * \return TemplatePtr              The template, referring to the mapped file.
+     * \throws TemplateException        If the file can't be mapped, or isn't a valid image.
+     */
+	static TemplatePtr load(const std::string& path);
+
+    /** \brief Load a template from an image in memory.
+     *
+     * \param data const char*                  The first byte of the image.
+     * \param size size_t                       Number of bytes in the image.
+     * \param owner std::shared_ptr<const void> Keeps data alive for as long as the template exists,
+     *                                          if nullptr the literals are copied.
+     * \return TemplatePtr                      The template.
+     * \throws TemplateException                If the data isn't a valid image.
+     */
+	static TemplatePtr load(const char* data, size_t size, std::shared_ptr<const void> owner);
+};
+
+/** \brief Collects the instruction stream, names and literals of an image, while the template tree is walked.
+ *
+ * The callbacks are virtual, so other back ends can walk a template tree
+ * the same way, e.g. te-compile which generates C++ code.
+ */
+class TemplateWriter
+{
+public:
+	TemplateWriter();
+
+	virtual ~TemplateWriter() {}
+
+    /** \brief Append the template to the image. */
+	void write(const Template& templ);
+
+    /** \brief Append a literal, adjacent literals are merged. */
+	virtual void literal(const te_char_t* data, size_t length);
+
+    /** \brief Append an expansion, and the format and filters of it. */
+	virtual void expansion(const te_string& name, uint8_t scopeWalk, const ValueFormat& format, const FilterChain& filters);
+
+    /** \brief Start the body of a repeat. */
+	virtual void beginRepeat(const te_string& name);
+
+    /** \brief End the body of the repeat started last. */
+	virtual void endRepeat();
+
+    /** \brief The bytes of the image. */
+	std::string finish() const;
+
+private:
+	/** \brief Index of the name in the name table, the name is added if it isn't there yet. */
+	uint32_t intern(const te_string& name);
+
+	/** \brief Append text to the literal pool, and return its offset. */
+	uint32_t append(const te_char_t* data, size_t length);
+
+	static const size_t noLiteral = static_cast<size_t>(-1);   ///< _lastLiteral when the last instruction isn't a literal
+
+	std::vector<uint32_t> _code;                            ///< The instruction stream.
+	std::vector<uint32_t> _names;                           ///< Offset and length in the pool of every name.
+	std::unordered_map<te_string, uint32_t> _nameIndex;     ///< Index of every name in _names.
+	te_string _pool;                                        ///< The literal pool.
+	size_t _lastLiteral;                                    ///< Position of the last instruction, if it is a literal.
+};
+
+TE_END_FLAVOUR
+}
+#endif // !__TEMPLATE_IMAGE_HPP_
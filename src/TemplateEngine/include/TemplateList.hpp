@@ -22,6 +22,7 @@
 
 namespace template_engine
 {
+TE_BEGIN_FLAVOUR
 
 /** \brief An ordered list of templates.
  * When a template definition is parsed, it it broken up into a number of
@@ -37,6 +38,15 @@ namespace template_engine
 class TemplateList : public std::vector<std::shared_ptr<const Template>>,
 	public Template
 {
+public:
+	/** \brief Destroy the nested templates without recursing once per nesting level.
+	 *
+	 * The lists of nested repeat instructions, which aren't shared, are emptied
+	 * onto a local stack first, so deeply nested templates can't overflow the
+	 * call stack when destroyed.
+	 */
+	virtual ~TemplateList();
+
 protected:
     /** \brief Repeat the template length of dictionary list times.
      *
@@ -45,7 +55,33 @@ protected:
      * \return virtual te_string                Expanded template length() times.
      */
 	virtual te_string render(const DictionaryPtr& dictionary, TemplateFilter) const;
+
+    /** \brief Append the templates of the list to the output. */
+	virtual void renderInto(const DictionaryPtr& dictionary, TemplateEscaper escaper, te_string& out) const;
+
+    /** \brief Optimize the templates of the list.
+     *
+     * Runs of adjacent static templates are rendered into a single literal,
+     * and a list which ends up with a single template is replaced by it.
+     */
+	virtual TemplatePtr optimize(const TemplateOptimizer& optimizer) const;
+
+    /** \brief Specialize the templates of the list, see TemplateSpecializer. */
+	virtual TemplatePtr specialize(TemplateSpecializer& specializer) const;
+
+    /** \brief Write the templates of the list, the list itself isn't part of the image. */
+	virtual void write(TemplateWriter& writer) const;
+
+    /** \brief Render the templates of the list through the cache. */
+	virtual void renderCached(RenderCache& cache, const DictionaryPtr& dictionary, te_string& out) const;
+
+    /** \brief Add the names referenced by the templates of the list. */
+	virtual void addDependencies(TemplateDependencies& scope) const;
+
+    /** \brief A list is static if all of its templates are. */
+	virtual bool isStatic() const;
 };
 
+TE_END_FLAVOUR
 }
 #endif // !__TEMPLATELIST_HPP_
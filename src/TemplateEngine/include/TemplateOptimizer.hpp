@@ -0,0 +1,75 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#ifndef __TEMPLATE_OPTIMIZER_HPP_
+#define __TEMPLATE_OPTIMIZER_HPP_
+
+#include "Template.hpp"
+#include "Dictionary.hpp"
+
+namespace template_engine
+{
+TE_BEGIN_FLAVOUR
+
+/** \brief Optimization pass, run on a parsed template to make it cheaper to render.
+ *
+ * The optimizer rewrites the template tree, the original is left untouched.
+ * - Adjacent literals are merged, e.g. the text on both sides of a comment.
+ * - Static subtrees, which don't depend on the dictionary, are rendered into a single literal.
+ * - Lists with a single template, e.g. the root of a template without instructions, are replaced by that template.
+ * - Optionally, expansions of the constants every Context defines, APP and VERSION,
+ *   are folded into literals.
+ *
+ * Folding constants is opt-in, as a dictionary may define a value with the
+ * same name, which then takes precedence when rendering. A folded value has
+ * the filter given to the optimizer applied, so the optimized template must
+ * be rendered with the same filter.
+ *
+ * \code
+ * TemplatePtr templ = TemplateOptimizer(true).optimize(Template::parse(scanner));
+ * \endcode
+ */
+class TemplateOptimizer
+{
+public:
+    /** \brief Create an optimizer.
+     *
+     * \param foldConstants bool    Fold expansions of APP and VERSION into literals.
+     * \param filter TemplateFilter The filter the optimized template is rendered with.
+     */
+	explicit TemplateOptimizer(bool foldConstants = false, TemplateFilter filter = nullptr);
+
+    /** \brief Optimize the template.
+     *
+     * \param templ const TemplatePtr&  The template to optimize.
+     * \return TemplatePtr              An equivalent template, which may be templ itself.
+     */
+	TemplatePtr optimize(const TemplatePtr& templ) const;
+
+    /** \brief The value of a constant which may be folded, nullptr if name isn't one. */
+	const te_string* getConstant(const te_string& name) const;
+
+    /** \brief Apply the filter to a value which is folded into a literal. */
+	te_string filter(const te_string& value) const;
+
+private:
+	DictionaryPtr _constants;   ///< The values which may be folded, nullptr if none may
+	TemplateFilter _filter;     ///< The filter the optimized template is rendered with
+};
+
+TE_END_FLAVOUR
+}
+#endif // !__TEMPLATE_OPTIMIZER_HPP_
@@ -0,0 +1,174 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#ifndef __TEMPLATE_PARSER_HPP_
+#define __TEMPLATE_PARSER_HPP_
+
+#include <vector>
+#include <memory>
+
+#include "Template.hpp"
+#include "TemplateList.hpp"
+#include "Lexer.hpp"
+#include "FilterChain.hpp"
+#include "TypedValue.hpp"
+
+namespace template_engine
+{
+TE_BEGIN_FLAVOUR
+
+/** \brief Parser for template definitions, pulled from a scanner or pushed in chunks.
+ *
+ * parse() pulls the whole definition from a scanner, this is what
+ * Template::parse() does. Alternatively the definition is handed to the
+ * parser a chunk at a time through feed(), and finish() ends the stream and
+ * returns the template hierarchy. This lets the parsing overlap the I/O,
+ * e.g. of a socket or a pipe.
+ *
+ * \code
+ * TemplateParser parser;
+ * while (readChunk(chunk))
+ *     parser.feed(chunk);
+ * TemplatePtr templ = parser.finish();
+ * \endcode
+ *
+ * Chunks may be split anywhere, also within tags, names, comments and escape
+ * sequences. Every chunk is tokenized as far as possible, a token which
+ * reaches the end of the chunk, and therefore might continue in the next
+ * one, is kept back and tokenized again once more input has arrived. It
+ * isn't tried again before the input held back has doubled, so a long
+ * comment or name fed in small chunks is tokenized in linear time. The
+ * parser itself is driven one token at a time with an explicit stack of
+ * open repeat instructions, so only the partial token, the literal text
+ * being collected and the open instructions are held between chunks.
+ *
+ * As nothing recurses, deeply nested repeat instructions can't overflow the
+ * call stack while parsing. The nesting depth is limited by the parser
+ * anyway, as the parsed template is rendered recursively.
+ */
+class TemplateParser
+{
+public:
+    /** \brief Create a parser for a single template definition.
+     *
+     * \param maxDepth size_t       How deep repeat instructions may be nested.
+     */
+	explicit TemplateParser(size_t maxDepth = Template::defaultMaxDepth);
+
+    /** \brief Parse the whole definition read from the scanner.
+     *
+     * Literal text which is a single run of the scanner's stable source (see
+     * Scanner::getSource()) refers to it, instead of being copied. Can't be
+     * combined with feed().
+     *
+     * \param scanner Scanner&      The scanner to read the definition from.
+     * \return TemplatePtr          Template hierarchy generated from the input.
+     * \throws TemplateException    All parse errors are reported as exceptions.
+     */
+	TemplatePtr parse(Scanner& scanner);
+
+    /** \brief Parse the next chunk of the template definition.
+     *
+     * \param data const te_char_t*     The chunk, it is not referenced once feed() returns.
+     * \param length size_t             Number of code units in the chunk.
+     * \throws TemplateException        Parse errors are reported as soon as they are seen,
+     *                                  the parser can't be used afterwards.
+     */
+	void feed(const te_char_t* data, size_t length);
+
+    /** \copydoc feed(const te_char_t*, size_t) */
+	inline void feed(const te_string& chunk) { feed(chunk.data(), chunk.size()); }
+
+    /** \brief End the stream and return the parsed template.
+     *
+     * \return TemplatePtr          Template hierarchy generated from the chunks.
+     * \throws TemplateException    All parse errors are reported as exceptions.
+     */
+	TemplatePtr finish();
+
+    /** \brief Number of code units handed to the lexer so far.
+     *
+     * Input kept back is counted every time it is tokenized again, so this
+     * shows how much work splitting the definition into chunks has caused.
+     */
+	inline size_t getLexedLength() const { return _lexedLength; }
+
+private:
+	/** \brief What the parser expects next, the grammar as a flat state machine. */
+	enum class state_t {
+		Literal,            ///< Plain text, between instructions
+		Instruction,        ///< Just past <code>{{</code>
+		OpenKeyword,        ///< Past <code>{{#</code>, expecting <code>repeat</code>
+		OpenSkip,           ///< Past <code>{{#repeat</code>, the next token is skipped
+		OpenName,           ///< Expecting the name of the repeated list
+		OpenEnd,            ///< Expecting the <code>}}</code> of a repeat instruction
+		CloseKeyword,       ///< Past <code>{{/</code>, expecting <code>repeat</code>
+		CloseEnd,           ///< Expecting the <code>}}</code> of an end repeat instruction
+		Expansion,          ///< Expecting colons or the name of an expansion
+		ExpansionEnd,       ///< Expecting a <code>:</code>, a <code>|</code> or the <code>}}</code> of an expansion
+		FormatSpec,         ///< Past the <code>:</code> following the name, collecting a format specifier
+		FilterName,         ///< Past a <code>|</code>, expecting the name of a filter
+		Done                ///< An unmatched end repeat instruction ended the template
+	};
+
+	/** \brief An open repeat instruction, or the template itself at the bottom of the stack. */
+	struct Frame {
+		std::shared_ptr<TemplateList> list;     ///< The templates parsed so far
+		te_string name;                         ///< Name of the repeated list, empty at the bottom
+	};
+
+	/** \brief Tokenize as much of the pending input as possible.
+	 *
+	 * \param partial bool  More input may follow, if so a token touching the end is kept back.
+	 */
+	void lex(bool partial);
+
+	/** \brief Advance the state machine by a single token. */
+	void consume(const Lexer::Token& token);
+
+	/** \brief The stream has ended, close the literal and any open repeat instructions. */
+	TemplatePtr close();
+
+	/** \brief Add plain text to the literal being collected. */
+	void appendLiteral(const te_char_t* text, size_t length);
+
+	/** \brief Add the literal text collected so far to the innermost list. */
+	void flushLiteral();
+
+	/** \brief Close the innermost repeat instruction. */
+	void closeRepeat();
+
+	size_t _maxDepth;               ///< How deep repeat instructions may be nested
+	std::vector<Frame> _frames;     ///< Open repeat instructions, the template itself first
+	state_t _state;                 ///< Where the parser is in the grammar
+	te_string _literal;             ///< Plain text collected since the last instruction
+	const SourceBuffer* _source;    ///< Stable source of the definition, if parsing from a scanner which has one
+	const te_char_t* _view;         ///< Literal text which refers to _source, instead of being in _literal
+	size_t _viewLength;             ///< Number of code units in _view
+	te_string _name;                ///< Name of the instruction being parsed
+	uint8_t _colonCount;            ///< Scope walk of the expansion being parsed
+	te_string _spec;                ///< Format specifier of the expansion being parsed, as written
+	ValueFormat _format;            ///< Format of the expansion being parsed
+	FilterChain _filters;           ///< Filters of the expansion being parsed
+	te_string _pending;             ///< Input which hasn't been tokenized yet, it starts at a token boundary
+	Lexer::State _lexerState;       ///< Lexer state at the start of the pending input
+	size_t _keptBack;               ///< Size of the pending input when the last lex() kept a token back, 0 if it didn't
+	size_t _lexedLength;            ///< Number of code units handed to the lexer, see getLexedLength()
+};
+
+TE_END_FLAVOUR
+}
+#endif // !__TEMPLATE_PARSER_HPP_
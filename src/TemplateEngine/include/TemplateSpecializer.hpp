@@ -0,0 +1,116 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#ifndef __TEMPLATE_SPECIALIZER_HPP_
+#define __TEMPLATE_SPECIALIZER_HPP_
+
+#include <vector>
+
+#include "Template.hpp"
+#include "Dictionary.hpp"
+
+namespace template_engine
+{
+TE_BEGIN_FLAVOUR
+
+/** \brief Partial evaluation of a template against a dictionary which is only partially known.
+ *
+ * Some values are known long before a template is rendered, e.g. the
+ * settings of a tenant, while the rest change with every request. The
+ * specializer renders everything the known values determine ahead of time,
+ * and leaves a residual template which only contains the dynamic parts.
+ * - Expansions of known values are rendered into literals, with the filter applied.
+ * - Expansions of provided values are kept, bound to the known dictionary
+ *   providing them, so the value is computed whenever the residual template
+ *   is rendered.
+ * - Repeats over known lists are unrolled, and their bodies specialized with
+ *   each of the items in scope. Expansions which are left in an unrolled body
+ *   are rewritten to be looked up from the root scope.
+ * - A repeat which can't be unrolled, e.g. because its list isn't known or
+ *   because it contains such a repeat, is kept as it is. In that case the
+ *   known values are kept with the residual template, and looked up after
+ *   the values of the dictionary it is rendered with.
+ * - The result is optimized, so adjacent literals are merged.
+ *
+ * A name must either be known, or be given when rendering, a name which is
+ * known is never looked up in the rendering dictionary. The residual
+ * template must be rendered with the same filter as it was specialized with.
+ *
+ * \code
+ * TemplatePtr residual = Template::specialize(templ, tenantDictionary);
+ * // for every request
+ * context->setDictionary(requestDictionary);
+ * te_string text = residual->render(context);
+ * \endcode
+ */
+class TemplateSpecializer
+{
+public:
+    /** \brief Create a specializer.
+     *
+     * \param known const DictionaryPtr&    The values known ahead of time.
+     * \param filter TemplateFilter         The filter the residual template is rendered with.
+     */
+	TemplateSpecializer(const DictionaryPtr& known, TemplateFilter filter = nullptr);
+
+    /** \brief Specialize the template.
+     *
+     * \param templ const TemplatePtr&  The template to specialize.
+     * \return TemplatePtr              The residual template, which may be templ itself.
+     * \throws TemplateException        If a known name is of the wrong kind.
+     */
+	TemplatePtr specialize(const TemplatePtr& templ);
+
+    /** \brief Number of scopes between the current scope and the root scope.
+     *
+     * Inside the body of a repeat being unrolled the item and the list
+     * are scopes of their own, so the depth grows by two for every
+     * repeat being unrolled.
+     */
+	inline size_t getDepth() const { return _scopes.size() - 1; }
+
+    /** \brief Find the known dictionary defining name.
+     *
+     * The search starts scopeWalk scopes above the current scope, and stops at the root scope.
+     * \return const Dictionary*    The dictionary, nullptr if the name isn't known.
+     */
+	const Dictionary* find(const te_string& name, size_t scopeWalk) const;
+
+    /** \brief Enter the scope of an item of a known list, while its repeat is unrolled. */
+	void enterScope(const Dictionary* list, const Dictionary* item);
+
+    /** \brief Leave the scope entered last. */
+	void leaveScope();
+
+    /** \brief Number of repeats kept as they are, so far. */
+	inline size_t getKept() const { return _kept; }
+
+    /** \brief Record a repeat kept as it is, or forget the ones recorded after an unroll was abandoned. */
+	inline void setKept(size_t kept) { _kept = kept; }
+
+    /** \brief Apply the filter to a value which is rendered into a literal. */
+	te_string filter(const te_string& value) const;
+
+private:
+	DictionaryPtr _known;                   ///< The values known ahead of time
+	TemplateFilter _filter;                 ///< The filter the residual template is rendered with
+	std::vector<const Dictionary*> _scopes; ///< The root scope first, the current scope last
+	size_t _kept;                           ///< Number of repeats kept as they are
+};
+
+TE_END_FLAVOUR
+}
+#endif // !__TEMPLATE_SPECIALIZER_HPP_
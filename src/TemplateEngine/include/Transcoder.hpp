@@ -0,0 +1,82 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#ifndef __TRANSCODER_HPP_
+#define __TRANSCODER_HPP_
+
+#include <string>
+#include <cstddef>
+
+namespace template_engine
+{
+
+/** \brief Validating conversion between UTF-8 and UTF-16.
+ *
+ * Replaces <code>std::wstring_convert</code>, which is deprecated, locale
+ * bound and slow. Runs of ASCII are converted 16 or 32 code units at a time
+ * using SSE2/AVX2 (selected at runtime), everything else goes through a
+ * scalar decoder which rejects overlong forms, surrogate code points encoded
+ * in UTF-8, unpaired surrogates in UTF-16, values beyond U+10FFFF and
+ * truncated sequences.
+ *
+ * The conversion functions are stateless, malformed input is reported
+ * with a TemplateException holding the offset of the offending code unit.
+ */
+class Transcoder
+{
+public:
+    /** \brief Convert UTF-8 to UTF-16.
+     *
+     * \param in      The UTF-8 input.
+     * \param length  Number of bytes in the input.
+     * \param out     Output buffer, must have room for at least \p length code units.
+     * \return        The number of UTF-16 code units written.
+     * \throws TemplateException if the input isn't valid UTF-8.
+     */
+	static size_t utf8ToUtf16(const char* in, size_t length, char16_t* out);
+
+    /** \brief Convert UTF-16 to UTF-8.
+     *
+     * \param in      The UTF-16 input.
+     * \param length  Number of code units in the input.
+     * \param out     Output buffer, must have room for at least 3 * \p length bytes.
+     * \return        The number of bytes written.
+     * \throws TemplateException if the input isn't valid UTF-16.
+     */
+	static size_t utf16ToUtf8(const char16_t* in, size_t length, char* out);
+
+	/** \copydoc utf8ToUtf16(const char*, size_t, char16_t*) */
+	static std::u16string utf8ToUtf16(const std::string& str);
+
+	/** \copydoc utf16ToUtf8(const char16_t*, size_t, char*) */
+	static std::string utf16ToUtf8(const std::u16string& str);
+
+    /** \brief Length of the longest prefix which doesn't end in a partial UTF-8 sequence.
+     *
+     * Used when UTF-8 arrives in chunks, the remaining (at most three) bytes
+     * are carried over to the next chunk.
+     * \param in      The UTF-8 input.
+     * \param length  Number of bytes in the input.
+     * \return        \p length, or less if the input ends in the middle of a sequence.
+     */
+	static size_t utf8CompleteLength(const char* in, size_t length);
+
+    /** \brief Is the input valid UTF-8? */
+	static bool isValidUtf8(const char* in, size_t length);
+};
+
+}
+#endif // !__TRANSCODER_HPP_
@@ -0,0 +1,201 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#ifndef __TYPED_VALUE_HPP_
+#define __TYPED_VALUE_HPP_
+
+#include <chrono>
+#include <cstdint>
+#include <type_traits>
+
+#include "Types.hpp"
+
+namespace template_engine
+{
+TE_BEGIN_FLAVOUR
+
+class ValueFormat;
+
+/** \brief A number, boolean or timestamp stored in a Dictionary as it is, and formatted when it is expanded.
+ *
+ * Values which no template expands are never formatted, and the ones which
+ * are, are formatted straight into the output.
+ *
+ * \code
+ * dict->add(TE_TEXT("PRICE"), TypedValue(19.95));
+ * dict->add(TE_TEXT("COUNT"), TypedValue(3));
+ * dict->add(TE_TEXT("UPDATED"), TypedValue(std::chrono::system_clock::now()));
+ * \endcode
+ */
+class TypedValue
+{
+public:
+	/** \brief The kinds of value */
+	enum class type_t {
+		Integer,    ///< A signed 64 bit integer
+		Real,       ///< A double
+		Boolean,    ///< true or false
+		Timestamp   ///< A point in time, in nanoseconds since the epoch (UTC)
+	};
+
+	/** \brief Any integral type but bool, unsigned values above the range of int64_t wrap. */
+	template <typename T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value, int>::type = 0>
+	explicit TypedValue(T value) :
+		_type(type_t::Integer),
+		_integer(static_cast<int64_t>(value))
+	{
+	}
+
+	/** \brief Any floating point type. */
+	template <typename T, typename std::enable_if<std::is_floating_point<T>::value, int>::type = 0>
+	explicit TypedValue(T value) :
+		_type(type_t::Real),
+		_real(static_cast<double>(value))
+	{
+	}
+
+	/** \brief A boolean. */
+	explicit TypedValue(bool value) :
+		_type(type_t::Boolean),
+		_boolean(value)
+	{
+	}
+
+	/** \brief A timestamp, kept with nanosecond resolution. */
+	explicit TypedValue(std::chrono::system_clock::time_point value) :
+		_type(type_t::Timestamp),
+		_integer(std::chrono::duration_cast<std::chrono::nanoseconds>(value.time_since_epoch()).count())
+	{
+	}
+
+	/** \brief The kind of value. */
+	inline type_t getType() const { return _type; }
+
+	/** \brief Only valid if getType() is \link type_t::Integer Integer \endlink */
+	inline int64_t getInteger() const { return _integer; }
+
+	/** \brief Only valid if getType() is \link type_t::Real Real \endlink */
+	inline double getReal() const { return _real; }
+
+	/** \brief Only valid if getType() is \link type_t::Boolean Boolean \endlink */
+	inline bool getBoolean() const { return _boolean; }
+
+	/** \brief Nanoseconds since the epoch, only valid if getType() is \link type_t::Timestamp Timestamp \endlink */
+	inline int64_t getTimestamp() const { return _integer; }
+
+	/** \brief The value formatted as it is expanded without a format specifier. */
+	te_string toString() const;
+
+private:
+	type_t _type;           ///< The kind of value
+	union {
+		int64_t _integer;   ///< Integer, or the nanoseconds of a timestamp
+		double _real;       ///< Real
+		bool _boolean;      ///< Boolean
+	};
+};
+
+/** \brief A format specifier of an expansion, <code>{{PRICE:.2f}}</code>, parsed when the template is parsed.
+ *
+ * The syntax is a subset of the format specifiers of Python and std::format:
+ * <code>[[fill]align][sign][0][width][.precision][type]</code>
+ *
+ * Field     |Meaning
+ * :---------|:-------
+ * fill      | Pads the value to the width, a space by default. A single code unit, but not a space, a pipe or a brace.
+ * align     | <code><</code> left, <code>></code> right or <code>^</code> centered. Numbers are right aligned by default, anything else left aligned.
+ * sign      | <code>+</code> a sign for positive numbers too, <code>-</code> only for negative numbers.
+ * 0         | Pad numbers with zeroes, between the sign and the digits.
+ * width     | The minimum number of code units.
+ * precision | Digits after the decimal point (f, e, %), significant digits (g), fractions of a second (timestamps) or the maximum number of code units (strings).
+ * type      | See below.
+ *
+ * Type  |Applies to                  |Format
+ * :-----|:---------------------------|:------
+ * none  | Anything                   | The string, the integer, the shortest double which reads back the same, true or false, or an ISO 8601 timestamp in UTC.
+ * d     | Integers, booleans, timestamps | Decimal, 1 or 0, seconds since the epoch.
+ * x X   | Integers                   | Hexadecimal.
+ * o     | Integers                   | Octal.
+ * b     | Integers                   | Binary.
+ * f     | Numbers                    | Fixed point, 6 digits after the point by default.
+ * e E   | Numbers                    | Scientific notation.
+ * g G   | Numbers                    | Fixed point or scientific notation, whichever is shorter.
+ * %     | Numbers                    | Multiplied by 100, in fixed point, followed by a percent sign.
+ * s     | Strings and booleans       | As no type.
+ *
+ * Formatting is locale independent. A type which doesn't apply to the
+ * value is reported when the value is expanded.
+ */
+class ValueFormat
+{
+public:
+    /** \brief Largest width a specifier may give. */
+	static const size_t maxWidth = 9999;
+
+    /** \brief Largest precision a specifier may give. */
+	static const int maxPrecision = 99;
+
+    /** \brief No format specifier, values are expanded as they are. */
+	ValueFormat();
+
+    /** \brief Parse a format specifier.
+     *
+     * \param spec const te_string&     The specifier, without the leading <code>:</code>.
+     * \throws TemplateException        If the specifier is malformed.
+     */
+	explicit ValueFormat(const te_string& spec);
+
+    /** \brief Is this the format of an expansion without a format specifier? */
+	inline bool isDefault() const { return _spec.empty(); }
+
+    /** \brief The specifier, as written in the template. */
+	inline const te_string& getSpec() const { return _spec; }
+
+    /** \brief Append the formatted string value to out.
+     *
+     * \throws TemplateException If the type of the format doesn't apply to strings.
+     */
+	void format(te_string& out, const te_char_t* value, size_t length) const;
+
+    /** \brief Append the formatted typed value to out.
+     *
+     * \throws TemplateException If the type of the format doesn't apply to the value.
+     */
+	void format(te_string& out, const TypedValue& value) const;
+
+private:
+    /** \brief Append the ASCII text to out, padded to the width.
+     *
+     * \param numeric bool  Numbers are right aligned by default, and may be zero padded after the sign.
+     */
+	void pad(te_string& out, const char* text, size_t length, bool numeric) const;
+
+    /** \brief Append a double formatted with the given type and precision. */
+	void formatReal(te_string& out, double value, char type) const;
+
+	te_string _spec;        ///< The specifier as written, empty if there is none
+	te_char_t _fill;        ///< Padding code unit
+	char _align;            ///< '<', '>', '^' or 0 for the default
+	char _sign;             ///< '+', '-' or 0 for the default
+	bool _zero;             ///< Pad numbers with zeroes
+	size_t _width;          ///< Minimum number of code units
+	int _precision;         ///< -1 if none was given
+	char _type;             ///< The type, 0 if none was given
+};
+
+TE_END_FLAVOUR
+}
+#endif // !__TYPED_VALUE_HPP_
@@ -18,22 +18,54 @@
 #define __TEMPLATE_ENGINE_TYPES_HPP_
 
 #include <string>
-#include <locale>
-#include <codecvt>
+#include <type_traits>
+#include <utility>
+
+/** \brief The two flavours declare the same names with different string
+ * types. Each keeps them in an inline namespace of its own, utf8 or utf16,
+ * so both libraries can be linked into one program. The parts which are the
+ * same in both, such as TemplateException and the Transcoder, are outside it.
+ */
+#ifdef TE_USE_UTF8
+#define TE_BEGIN_FLAVOUR	inline namespace utf8 {
+#else
+#define TE_BEGIN_FLAVOUR	inline namespace utf16 {
+#endif
+/** \brief Closes TE_BEGIN_FLAVOUR */
+#define TE_END_FLAVOUR		}
 
 namespace template_engine
 {
+TE_BEGIN_FLAVOUR
+#ifdef TE_USE_UTF8
+/** \brief Native UTF-8 build, string literals are used as is. */
+#define TE_TEXT(STR)	STR
+
+typedef char			te_char_t;
+typedef std::string		te_string;
+
+/** \brief Identity conversion, kept so code written for the UTF-16 build
+ * compiles unchanged against the UTF-8 build.
+ */
+struct te_converter
+{
+	/** \brief The string is already UTF-8, a copy of it is returned as in the UTF-16 build */
+	std::string to_bytes(const te_string &str) { return str; }
+
+	/** \brief The string is already UTF-8, a copy of it is returned as in the UTF-16 build */
+	te_string from_bytes(const std::string &str) { return str; }
+};
+#else
 #define TE_TEXT(STR)	u##STR
 
 typedef char16_t		te_char_t;
 typedef std::u16string	te_string;
 
-// MSVC has some serious issues linking codecvt and friends.
-#ifndef _WIN32
-/** \brief Convert between UTF-8 and UTF-16 */
-typedef std::wstring_convert<std::codecvt_utf8_utf16<te_char_t>, te_char_t> te_converter;
-#else
-/** \brief Convert between UTF-8 and UTF-16 */
+/** \brief Convert between UTF-8 and UTF-16.
+ * Kept for source compatibility with code written against the former
+ * <code>std::wstring_convert</code> typedef, both directions are handled
+ * by the Transcoder.
+ */
 struct te_converter
 {
 	/** \brief Convert a UTF-16 string to UTF-8
@@ -50,5 +82,44 @@ struct te_converter
 };
 #endif
 
+/** \brief The code unit as an unsigned value, safe to use as a table index
+ * or to compare against code point values.
+ */
+constexpr unsigned int te_code_unit(te_char_t ch)
+{
+	return static_cast<typename std::make_unsigned<te_char_t>::type>(ch);
+}
+
+#ifdef TE_USE_UTF8
+/** \brief Convert an engine string to UTF-8, a copy in the UTF-8 build
+ *
+ * Returned by value as in the UTF-16 build, so binding the result of a
+ * temporary to a reference is safe in both.
+ */
+inline std::string to_utf8(const te_string& str) { return str; }
+
+/** \brief A temporary is moved rather than copied */
+inline std::string to_utf8(te_string&& str) { return std::move(str); }
+
+/** \brief Convert a UTF-8 string to an engine string, a copy in the UTF-8 build */
+inline te_string from_utf8(const std::string& str) { return str; }
+
+/** \brief A temporary is moved rather than copied */
+inline te_string from_utf8(std::string&& str) { return std::move(str); }
+#else
+/** \brief Convert an engine string to UTF-8
+ *  \param str A UTF-16 string
+ *  \return the same string as UTF-8
+ */
+std::string to_utf8(const te_string& str);
+
+/** \brief Convert a UTF-8 string to an engine string
+ *  \param str A UTF-8 string
+ *  \return the same string as UTF-16
+ */
+te_string from_utf8(const std::string& str);
+#endif
+
+TE_END_FLAVOUR
 }
 #endif // !__TEMPLATE_ENGINE_TYPES_HPP_
@@ -0,0 +1,86 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#ifndef __VALUE_PROVIDER_HPP_
+#define __VALUE_PROVIDER_HPP_
+
+#include <functional>
+#include <memory>
+#include <unordered_map>
+
+#include "Types.hpp"
+
+namespace template_engine
+{
+TE_BEGIN_FLAVOUR
+
+/** \brief Computes a value of a Dictionary when it is expanded, see Dictionary::addProvider(). */
+typedef std::function<te_string()> ValueProvider;
+
+/** \brief The values of the providers called during a render, each provider is called at most once per render.
+ *
+ * Every render of a template opens a scope, the outermost scope on a
+ * thread holds the values until it closes, and the scopes nested within
+ * it, e.g. of a template rendered by a provider, share its values. A
+ * provider which throws isn't memoized, so it is called again the next
+ * time it is expanded.
+ *
+ * Open a scope around code which reads provided values outside of a
+ * render, e.g. with Dictionary::getValue(), or to share the values
+ * between several renders.
+ *
+ * \code
+ * RenderScope scope;
+ * te_string header = headerTemplate->render(context);
+ * te_string body = bodyTemplate->render(context);  // the providers expanded by both are called once
+ * \endcode
+ */
+class RenderScope
+{
+public:
+	RenderScope();
+	~RenderScope();
+
+	RenderScope(const RenderScope&) = delete;
+	RenderScope& operator=(const RenderScope&) = delete;
+
+    /** \brief The outermost scope open on this thread, nullptr if there is none. */
+	static RenderScope* current();
+
+    /** \brief The value of the provider, which is called the first time it is requested in the scope.
+     *
+     * \param provider const std::shared_ptr<const ValueProvider>&    The provider, kept alive by the scope once it is called.
+     * \return const te_string&         The value, valid until the scope closes.
+     * \throws TemplateException        If the provider depends on its own value, or whatever the provider throws.
+     */
+	const te_string& evaluate(const std::shared_ptr<const ValueProvider>& provider);
+
+private:
+    /** \brief The value of a provider. */
+	struct Value
+	{
+		std::shared_ptr<const ValueProvider> provider;  ///< Keeps the address of the provider from being reused
+		te_string value;                                ///< The value returned
+		bool evaluated;                                 ///< False while the provider is being called
+	};
+
+	bool _outermost;                                        ///< Does this scope hold the values?
+	std::unordered_map<const ValueProvider*, Value> _values;    ///< The values by provider
+};
+
+TE_END_FLAVOUR
+}
+#endif // !__VALUE_PROVIDER_HPP_
@@ -21,6 +21,7 @@
 #include <locale>
 
 namespace template_engine {
+TE_BEGIN_FLAVOUR
 
 Context::Context() : _dictionary(nullptr)
 {
@@ -37,4 +38,5 @@ Context::Context() : _dictionary(nullptr)
 	    add(TE_TEXT("TIME"), "");
 }
 
+TE_END_FLAVOUR
 }
@@ -15,15 +15,27 @@
 // You should have received a copy of the GNU Lesser General Public
 // License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
 #include "stdafx.h"
+
+#include <atomic>
+
 #include "Types.hpp"
 #include "Exception.hpp"
 #include "Dictionary.hpp"
 #include "DictionaryList.hpp"
 
 namespace template_engine {
+TE_BEGIN_FLAVOUR
+
+namespace
+{
+/** \brief Source of Dictionary versions, shared by all dictionaries. */
+std::atomic<uint64_t> versionCounter(0);
+}
 
 Dictionary::Dictionary() :
+	_version(0),
 	_map(),
+	_layers(),
 	_parent()
 {
 }
@@ -32,47 +44,142 @@ Dictionary::~Dictionary()
 {
 }
 
+const DictionaryPtr Dictionary::getParent() const
+{
+	const DictionaryPtr* scope = ListScope::find(this);
+	return scope ? *scope : _parent.lock();
+}
+
 const Dictionary::Element& Dictionary::find(const te_string& name) const
+{
+	const Element* e = findElement(name);
+	if (e)
+		return *e;
+
+	throw TemplateException("Attempt to find unknown dictionary entry '" + to_utf8(name) + "'");
+}
+
+const Dictionary::Element* Dictionary::findElement(const te_string& name) const
+{
+	const Dictionary* scope = this;
+	DictionaryPtr parent;
+	while (true) {
+		const Element* e = scope->findLocal(name);
+		if (e)
+			return e;
+
+		// the parent keeps its elements alive, as long as the child is alive
+		parent = scope->getParent();
+		if (!parent)
+			return nullptr;
+		scope = parent.get();
+	}
+}
+
+const Dictionary::Element* Dictionary::findLocal(const te_string& name) const
 {
 	te_dict::const_iterator it = _map.find(name);
 	if (it != _map.end())
-		return it->second;
-	else if (!_parent.expired()) {
-		return _parent.lock()->find(name);
+		return &it->second;
+
+	for (const DictionaryPtr& layer : _layers) {
+		const Element* e = layer->findLocal(name);
+		if (e)
+			return e;
 	}
 
-	te_converter converter;
-	throw TemplateException("Attempt to find unknown dictionary entry '" + converter.to_bytes(name) + "'");
+	return nullptr;
 }
 
 bool Dictionary::exists(const te_string& name) const
 {
-	te_dict::const_iterator it = _map.find(name);
-	if (it != _map.end())
-		return true;
-	else if (!_parent.expired())
-		return _parent.lock()->exists(name);
+	return nullptr != findElement(name);
+}
 
-	return false;
+bool Dictionary::existsLocal(const te_string& name) const
+{
+	return nullptr != findLocal(name);
 }
 
 bool Dictionary::isValue(const te_string& name) const
 {
 	const Element& e = find(name);
 
-	return Element::element_t::Value == e.type;
+	return Element::element_t::Value == e.type || Element::element_t::Typed == e.type || Element::element_t::Provider == e.type;
 }
 
-const te_string& Dictionary::getValue(const te_string& name) const
+bool Dictionary::isTyped(const te_string& name) const
 {
-	if (isValue(name)) {
-		const Element& e = find(name);
+	return Element::element_t::Typed == find(name).type;
+}
 
+bool Dictionary::isProvided(const te_string& name) const
+{
+	return Element::element_t::Provider == find(name).type;
+}
+
+const te_string& Dictionary::getValue(const te_string& name) const
+{
+	const Element& e = find(name);
+	if (Element::element_t::Value == e.type)
 		return *e.value;
+	if (Element::element_t::Provider == e.type)
+		return provide(name, e);
+
+	throw TemplateException("Attempt to get '" + to_utf8(name) + "' as a value");
+}
+
+const TypedValue& Dictionary::getTyped(const te_string& name) const
+{
+	const Element& e = find(name);
+	if (Element::element_t::Typed == e.type)
+		return e.typed;
+
+	throw TemplateException("Attempt to get '" + to_utf8(name) + "' as a typed value");
+}
+
+const te_string* Dictionary::findValue(const te_string& name, const TypedValue*& typed) const
+{
+	typed = nullptr;
+	const Element* e = findElement(name);
+	if (!e)
+		return nullptr;
+
+	switch (e->type) {
+	case Element::element_t::Value:
+		return e->value.get();
+	case Element::element_t::Typed:
+		typed = &e->typed;
+		return nullptr;
+	case Element::element_t::Provider:
+		return &provide(name, *e);
+	default:
+		return nullptr;
 	}
+}
+
+const te_string& Dictionary::provide(const te_string& name, const Element& e)
+{
+	RenderScope* scope = RenderScope::current();
+	if (!scope)
+		throw TemplateException("The provided value '" + to_utf8(name) + "' can only be read while rendering, or within a RenderScope");
+
+	return scope->evaluate(e.provider);
+}
 
-	te_converter converter;
-	throw TemplateException("Attempt to get '" + converter.to_bytes(name) + "' as a value");
+void Dictionary::formatValue(const te_string& name, const ValueFormat& format, te_string& out) const
+{
+	const Element& e = find(name);
+	if (Element::element_t::Typed == e.type)
+		format.format(out, e.typed);
+	else if (Element::element_t::Value == e.type)
+		format.format(out, e.value->data(), e.value->size());
+	else if (Element::element_t::Provider == e.type) {
+		const te_string& value = provide(name, e);
+		format.format(out, value.data(), value.size());
+	}
+	else
+		throw TemplateException("Attempt to get '" + to_utf8(name) + "' as a value");
 }
 
 bool Dictionary::isList(const te_string& name) const
@@ -90,25 +197,94 @@ const std::shared_ptr<DictionaryList>& Dictionary::getList(const te_string& name
 		return e.list;
 	}
 
-	te_converter converter;
-	throw TemplateException("Attempt to get '" + converter.to_bytes(name) + "' as a list");
+	throw TemplateException("Attempt to get '" + to_utf8(name) + "' as a list");
 }
 
 void Dictionary::add(const te_string name, const te_string value)
 {
-	_map.insert({ name, Element(value) });
+	std::pair<te_dict::iterator, bool> inserted = _map.insert({ name, Element(value) });
+	if (inserted.second)
+		_version = inserted.first->second.version;
 }
 
+#ifndef TE_USE_UTF8
 void Dictionary::add(const te_string name, const std::string& value)
 {
-	te_converter converter;
-	_map.insert({ name, Element(converter.from_bytes(value)) });
+	add(name, from_utf8(value));
 }
+#endif
 
 void Dictionary::add(const te_string name, DictionaryListPtr value)
 {
-	_map.insert({ name, Element(value) });
+	std::pair<te_dict::iterator, bool> inserted = _map.insert({ name, Element(value) });
+	if (inserted.second)
+		_version = inserted.first->second.version;
 	value->setParent(shared_from_this());
 }
 
+void Dictionary::add(const te_string name, const TypedValue& value)
+{
+	std::pair<te_dict::iterator, bool> inserted = _map.insert({ name, Element(value) });
+	if (inserted.second)
+		_version = inserted.first->second.version;
+}
+
+void Dictionary::set(const te_string& name, const TypedValue& value)
+{
+	_map.erase(name);
+	add(name, value);
+}
+
+void Dictionary::addProvider(const te_string& name, ValueProvider provider)
+{
+	if (!provider)
+		throw TemplateException("The provider of '" + to_utf8(name) + "' is empty");
+
+	std::pair<te_dict::iterator, bool> inserted = _map.insert({ name, Element(std::make_shared<const ValueProvider>(std::move(provider))) });
+	if (inserted.second)
+		_version = inserted.first->second.version;
+}
+
+void Dictionary::setProvider(const te_string& name, ValueProvider provider)
+{
+	if (!provider)
+		throw TemplateException("The provider of '" + to_utf8(name) + "' is empty");
+
+	_map.erase(name);
+	addProvider(name, std::move(provider));
+}
+
+void Dictionary::set(const te_string& name, const te_string& value)
+{
+	_map.erase(name);
+	add(name, value);
+}
+
+void Dictionary::set(const te_string& name, DictionaryListPtr value)
+{
+	_map.erase(name);
+	add(name, value);
+}
+
+bool Dictionary::remove(const te_string& name)
+{
+	if (!_map.erase(name))
+		return false;
+
+	_version = nextVersion();
+	return true;
+}
+
+uint64_t Dictionary::getVersion(const te_string& name) const
+{
+	const Element* e = findLocal(name);
+	return e ? e->version : 0;
+}
+
+uint64_t Dictionary::nextVersion()
+{
+	return ++versionCounter;
+}
+
+TE_END_FLAVOUR
 }
@@ -19,21 +19,70 @@
 #include "Exception.hpp"
 
 namespace template_engine {
+TE_BEGIN_FLAVOUR
+
+namespace
+{
+/** \brief The innermost list scope of each thread */
+thread_local ListScope* innermostScope = nullptr;
+}
 
 DictionaryList::DictionaryList() :
+	_generator(),
+	_dictionaries(),
+	_activeDictionary(0)
+{
+}
+
+DictionaryList::DictionaryList(RowGenerator generator) :
+	_generator(std::move(generator)),
 	_dictionaries(),
 	_activeDictionary(0)
 {
+	if (!_generator)
+		throw TemplateException("The generator of a list is empty");
 }
 
 void DictionaryList::add(DictionaryPtr dict)
 {
+	if (_generator)
+		throw TemplateException("The rows of a generated list are produced by its generator");
+
 	dict->setParent(shared_from_this());
 
 	_dictionaries.push_back(dict);
 
 	// make the newly inserted dictionary the active one
 	_activeDictionary = _dictionaries.size() - 1;
+	_version = nextVersion();
+}
+
+DictionaryPtr DictionaryList::nextRow()
+{
+	DictionaryPtr row = _generator();
+	if (row)
+		row->setParent(shared_from_this());
+	return row;
+}
+
+void DictionaryList::set(size_t index, DictionaryPtr dict)
+{
+	if (index >= _dictionaries.size())
+		throw TemplateException("Sub-dictionary index outside of the valid range");
+
+	dict->setParent(shared_from_this());
+	_dictionaries[index] = dict;
+	_version = nextVersion();
+}
+
+void DictionaryList::remove(size_t index)
+{
+	if (index >= _dictionaries.size())
+		throw TemplateException("Sub-dictionary index outside of the valid range");
+
+	_dictionaries.erase(_dictionaries.begin() + static_cast<std::ptrdiff_t>(index));
+	_activeDictionary = 0;
+	_version = nextVersion();
 }
 
 void DictionaryList::resetCursor()
@@ -69,6 +118,11 @@ void DictionaryList::add(const te_string name, const te_string value)
 	Dictionary::add(name, value);
 }
 
+void DictionaryList::add(const te_string name, const TypedValue& value)
+{
+	Dictionary::add(name, value);
+}
+
 void DictionaryList::add(const te_string name, DictionaryListPtr value)
 {
 	value->setParent(shared_from_this());
@@ -76,4 +130,27 @@ void DictionaryList::add(const te_string name, DictionaryListPtr value)
 	Dictionary::add(name, value);
 }
 
-}
\ No newline at end of file
+ListScope::ListScope(const DictionaryList& list, const DictionaryPtr& parent) :
+	_list(&list),
+	_parent(parent),
+	_outer(innermostScope)
+{
+	innermostScope = this;
+}
+
+ListScope::~ListScope()
+{
+	innermostScope = _outer;
+}
+
+const DictionaryPtr* ListScope::find(const Dictionary* list)
+{
+	for (const ListScope* scope = innermostScope; scope; scope = scope->_outer)
+		if (scope->_list == list)
+			return &scope->_parent;
+
+	return nullptr;
+}
+
+TE_END_FLAVOUR
+}
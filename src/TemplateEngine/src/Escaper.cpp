@@ -0,0 +1,285 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include "stdafx.h"
+
+#include "Escaper.hpp"
+#include "Simd.hpp"
+
+namespace template_engine
+{
+TE_BEGIN_FLAVOUR
+
+namespace
+{
+
+//
+// The formats, each lists the ASCII characters it escapes, and whether
+// control characters are escaped as well. The kernels below find the
+// first code unit which must be escaped, the runs in front of it are
+// appended as they are.
+//
+
+struct HtmlFormat
+{
+	static constexpr char special[] = "&<>\"'";
+	static const bool controls = false;
+
+	static void escape(te_string& out, te_char_t ch)
+	{
+		switch (ch) {
+		case TE_TEXT('&'): out += TE_TEXT("&amp;"); break;
+		case TE_TEXT('<'): out += TE_TEXT("&lt;"); break;
+		case TE_TEXT('>'): out += TE_TEXT("&gt;"); break;
+		case TE_TEXT('"'): out += TE_TEXT("&quot;"); break;
+		default: out += TE_TEXT("&#39;"); break;
+		}
+	}
+};
+
+struct XmlFormat
+{
+	static constexpr char special[] = "&<>\"'";
+	static const bool controls = false;
+
+	static void escape(te_string& out, te_char_t ch)
+	{
+		if (TE_TEXT('\'') == ch)
+			out += TE_TEXT("&apos;");
+		else
+			HtmlFormat::escape(out, ch);
+	}
+};
+
+struct JsonFormat
+{
+	static constexpr char special[] = "\"\\";
+	static const bool controls = true;
+
+	static void escape(te_string& out, te_char_t ch)
+	{
+		static const char hex[] = "0123456789abcdef";
+
+		switch (ch) {
+		case TE_TEXT('"'): out += TE_TEXT("\\\""); break;
+		case TE_TEXT('\\'): out += TE_TEXT("\\\\"); break;
+		case TE_TEXT('\b'): out += TE_TEXT("\\b"); break;
+		case TE_TEXT('\f'): out += TE_TEXT("\\f"); break;
+		case TE_TEXT('\n'): out += TE_TEXT("\\n"); break;
+		case TE_TEXT('\r'): out += TE_TEXT("\\r"); break;
+		case TE_TEXT('\t'): out += TE_TEXT("\\t"); break;
+		default:
+			out += TE_TEXT("\\u00");
+			out += static_cast<te_char_t>(hex[te_code_unit(ch) >> 4]);
+			out += static_cast<te_char_t>(hex[te_code_unit(ch) & 0xF]);
+			break;
+		}
+	}
+};
+
+struct CFormat
+{
+	static constexpr char special[] = "\"'\\?\x7F";
+	static const bool controls = true;
+
+	static void escape(te_string& out, te_char_t ch)
+	{
+		switch (ch) {
+		case TE_TEXT('"'): out += TE_TEXT("\\\""); break;
+		case TE_TEXT('\''): out += TE_TEXT("\\'"); break;
+		case TE_TEXT('\\'): out += TE_TEXT("\\\\"); break;
+		case TE_TEXT('?'): out += TE_TEXT("\\?"); break;
+		case TE_TEXT('\a'): out += TE_TEXT("\\a"); break;
+		case TE_TEXT('\b'): out += TE_TEXT("\\b"); break;
+		case TE_TEXT('\f'): out += TE_TEXT("\\f"); break;
+		case TE_TEXT('\n'): out += TE_TEXT("\\n"); break;
+		case TE_TEXT('\r'): out += TE_TEXT("\\r"); break;
+		case TE_TEXT('\t'): out += TE_TEXT("\\t"); break;
+		case TE_TEXT('\v'): out += TE_TEXT("\\v"); break;
+		default:
+			// three digits, so a digit following it isn't read as part of the escape
+			out += TE_TEXT('\\');
+			out += static_cast<te_char_t>(TE_TEXT('0') + (te_code_unit(ch) >> 6));
+			out += static_cast<te_char_t>(TE_TEXT('0') + ((te_code_unit(ch) >> 3) & 7));
+			out += static_cast<te_char_t>(TE_TEXT('0') + (te_code_unit(ch) & 7));
+			break;
+		}
+	}
+};
+
+constexpr char HtmlFormat::special[];
+constexpr char XmlFormat::special[];
+constexpr char JsonFormat::special[];
+constexpr char CFormat::special[];
+
+template <typename Format>
+inline bool isSpecial(te_char_t ch)
+{
+	if (Format::controls && te_code_unit(ch) < 0x20)
+		return true;
+
+	for (size_t i = 0; i + 1 < sizeof(Format::special); ++i)
+		if (static_cast<te_char_t>(Format::special[i]) == ch)
+			return true;
+
+	return false;
+}
+
+#ifdef TE_SIMD_AVX2
+TE_TARGET_AVX2 inline __m256i equal(__m256i units, char ch)
+{
+#ifdef TE_USE_UTF8
+	return _mm256_cmpeq_epi8(units, _mm256_set1_epi8(ch));
+#else
+	return _mm256_cmpeq_epi16(units, _mm256_set1_epi16(ch));
+#endif
+}
+
+/** Code units below 0x20 */
+TE_TARGET_AVX2 inline __m256i control(__m256i units)
+{
+#ifdef TE_USE_UTF8
+	return _mm256_cmpeq_epi8(_mm256_and_si256(units, _mm256_set1_epi8(static_cast<char>(0xE0))), _mm256_setzero_si256());
+#else
+	return _mm256_cmpeq_epi16(_mm256_and_si256(units, _mm256_set1_epi16(static_cast<short>(0xFFE0))), _mm256_setzero_si256());
+#endif
+}
+
+template <typename Format>
+TE_TARGET_AVX2 const te_char_t* findSpecialAvx2(const te_char_t* first, const te_char_t* last)
+{
+	const size_t lanes = 32 / sizeof(te_char_t);
+	for (; static_cast<size_t>(last - first) >= lanes; first += lanes) {
+		__m256i units = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+		__m256i hits = Format::controls ? control(units) : _mm256_setzero_si256();
+		for (size_t i = 0; i + 1 < sizeof(Format::special); ++i)
+			hits = _mm256_or_si256(hits, equal(units, Format::special[i]));
+
+		unsigned int mask = static_cast<unsigned int>(_mm256_movemask_epi8(hits));
+		if (mask)
+			return first + lowestBit(mask) / sizeof(te_char_t);
+	}
+	return first;
+}
+#endif
+
+#ifdef TE_SIMD_SSE2
+inline __m128i equal(__m128i units, char ch)
+{
+#ifdef TE_USE_UTF8
+	return _mm_cmpeq_epi8(units, _mm_set1_epi8(ch));
+#else
+	return _mm_cmpeq_epi16(units, _mm_set1_epi16(ch));
+#endif
+}
+
+/** Code units below 0x20 */
+inline __m128i control(__m128i units)
+{
+#ifdef TE_USE_UTF8
+	return _mm_cmpeq_epi8(_mm_and_si128(units, _mm_set1_epi8(static_cast<char>(0xE0))), _mm_setzero_si128());
+#else
+	return _mm_cmpeq_epi16(_mm_and_si128(units, _mm_set1_epi16(static_cast<short>(0xFFE0))), _mm_setzero_si128());
+#endif
+}
+
+template <typename Format>
+const te_char_t* findSpecialSse2(const te_char_t* first, const te_char_t* last)
+{
+	const size_t lanes = 16 / sizeof(te_char_t);
+	for (; static_cast<size_t>(last - first) >= lanes; first += lanes) {
+		__m128i units = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+		__m128i hits = Format::controls ? control(units) : _mm_setzero_si128();
+		for (size_t i = 0; i + 1 < sizeof(Format::special); ++i)
+			hits = _mm_or_si128(hits, equal(units, Format::special[i]));
+
+		unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(hits));
+		if (mask)
+			return first + lowestBit(mask) / sizeof(te_char_t);
+	}
+	return first;
+}
+#endif
+
+template <typename Format>
+const te_char_t* findSpecial(const te_char_t* first, const te_char_t* last)
+{
+#ifdef TE_SIMD_AVX2
+	if (cpuHasAvx2())
+		first = findSpecialAvx2<Format>(first, last);
+#endif
+#ifdef TE_SIMD_SSE2
+	// when a kernel stopped on a hit we are done, even if that was at the tail
+	if (first != last && !isSpecial<Format>(*first))
+		first = findSpecialSse2<Format>(first, last);
+#endif
+	while (first != last && !isSpecial<Format>(*first))
+		++first;
+	return first;
+}
+
+template <typename Format>
+void appendEscaped(te_string& out, const te_char_t* value, size_t length)
+{
+	const te_char_t* last = value + length;
+	while (value != last) {
+		const te_char_t* special = findSpecial<Format>(value, last);
+		out.append(value, special);
+		if (special == last)
+			break;
+
+		Format::escape(out, *special);
+		value = special + 1;
+	}
+}
+
+}
+
+void HtmlEscaper::append(te_string& out, const te_char_t* value, size_t length)
+{
+	appendEscaped<HtmlFormat>(out, value, length);
+}
+
+void XmlEscaper::append(te_string& out, const te_char_t* value, size_t length)
+{
+	appendEscaped<XmlFormat>(out, value, length);
+}
+
+void JsonEscaper::append(te_string& out, const te_char_t* value, size_t length)
+{
+	appendEscaped<JsonFormat>(out, value, length);
+}
+
+void CEscaper::append(te_string& out, const te_char_t* value, size_t length)
+{
+	appendEscaped<CFormat>(out, value, length);
+}
+
+TemplateFilter escapeFilter(TemplateEscaper escaper)
+{
+	if (!escaper)
+		return nullptr;
+
+	return [escaper](const te_string& value) {
+		te_string result;
+		result.reserve(value.size());
+		escaper(result, value.data(), value.size());
+		return result;
+	};
+}
+
+TE_END_FLAVOUR
+}
@@ -16,18 +16,44 @@
 // License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
 #include "stdafx.h"
 #include "ExpansionTemplate.hpp"
+#include "SimpleTemplate.hpp"
+#include "TemplateOptimizer.hpp"
+#include "TemplateSpecializer.hpp"
+#include "ProvidedTemplate.hpp"
+#include "TemplateImage.hpp"
+#include "RenderCache.hpp"
 #include "Exception.hpp"
 #include "Types.hpp"
 
 namespace template_engine
 {
+TE_BEGIN_FLAVOUR
 
-ExpansionTemplate::ExpansionTemplate(const te_string& name, uint8_t scopeWalk) :
+ExpansionTemplate::ExpansionTemplate(const te_string& name, uint8_t scopeWalk, ValueFormat format, FilterChain filters) :
 	_name(name),
-	_scopeWalk(scopeWalk)
+	_scopeWalk(scopeWalk),
+	_format(std::move(format)),
+	_filters(std::move(filters))
 {
 }
 
+const te_string& ExpansionTemplate::lookup(const Dictionary& scope, te_string& formatted) const
+{
+	const TypedValue* typed;
+	const te_string* value = scope.findValue(_name, typed);
+
+	if (typed)
+		_format.format(formatted, *typed);
+	else if (!value)
+		throw TemplateException("The name '" + to_utf8(_name) + "' could not be found");
+	else if (!_format.isDefault())
+		_format.format(formatted, value->data(), value->size());
+	else
+		return *value;
+
+	return formatted;
+}
+
 
 te_string ExpansionTemplate::render(const DictionaryPtr& dictionary, TemplateFilter filter) const
 {
@@ -40,16 +66,131 @@ te_string ExpansionTemplate::render(const DictionaryPtr& dictionary, TemplateFil
 	}
 	
 	// do the actual lookup
-	if(currentDictionary->exists(_name) && currentDictionary->isValue(_name)) {
-		if(filter)
-			return filter(currentDictionary->getValue(_name));
+	te_string formatted;
+	const te_string& value = lookup(*currentDictionary, formatted);
+	if (!_filters.empty())
+		return filter ? filter(_filters.apply(value)) : _filters.apply(value);
+	if(filter)
+		return filter(value);
+	else
+		return value;
+}
+
+void ExpansionTemplate::renderInto(const DictionaryPtr& dictionary, TemplateEscaper escaper, te_string& out) const
+{
+	DictionaryPtr scope;
+	const Dictionary* currentDictionary = dictionary.get();
+	// handle scoping
+	if (_scopeWalk) {
+		scope = dictionary;
+		for (uint8_t i = 0; i < _scopeWalk; i++) {
+			scope = scope->getParent();
+			if (nullptr == scope)
+				throw TemplateException("Access to non existing parent scope");
+		}
+		currentDictionary = scope.get();
+	}
+
+	const TypedValue* typed;
+	const te_string* value = currentDictionary->findValue(_name, typed);
+	if (!value && !typed)
+		throw TemplateException("The name '" + to_utf8(_name) + "' could not be found");
+
+	// without filters or an escaper, the value goes straight into the output
+	if (_filters.empty() && !escaper) {
+		if (typed)
+			_format.format(out, *typed);
+		else if (_format.isDefault())
+			out += *value;
 		else
-			return currentDictionary->getValue(_name);
+			_format.format(out, value->data(), value->size());
+		return;
+	}
+
+	te_string formatted;
+	if (typed)
+		_format.format(formatted, *typed);
+	else if (!_format.isDefault())
+		_format.format(formatted, value->data(), value->size());
+	if (typed || !_format.isDefault())
+		value = &formatted;
+
+	if (_filters.empty()) {
+		escaper(out, value->data(), value->size());
+		return;
+	}
+	if (!escaper) {
+		_filters.apply(out, value->data(), value->size());
+		return;
 	}
 
-	te_converter converter;
+	te_string filtered = _filters.apply(*value);
+	escaper(out, filtered.data(), filtered.size());
+}
+
+TemplatePtr ExpansionTemplate::optimize(const TemplateOptimizer& optimizer) const
+{
+	// a scope walk may fail, which folding would hide
+	if (_scopeWalk)
+		return nullptr;
 
-	throw TemplateException("The name '" + converter.to_bytes(_name) + "' could not be found");
+	const te_string* value = optimizer.getConstant(_name);
+	if (!value)
+		return nullptr;
+
+	te_string formatted;
+	if (!_format.isDefault()) {
+		_format.format(formatted, value->data(), value->size());
+		value = &formatted;
+	}
+
+	return std::make_shared<SimpleTemplate>(optimizer.filter(_filters.apply(*value)));
+}
+
+TemplatePtr ExpansionTemplate::specialize(TemplateSpecializer& specializer) const
+{
+	size_t depth = specializer.getDepth();
+
+	// the walk leaves the known scopes, what remains of it starts at the root scope
+	if (_scopeWalk > depth) {
+		if (!depth)
+			return nullptr;
+		return std::make_shared<ExpansionTemplate>(_name, static_cast<uint8_t>(_scopeWalk - depth), _format, _filters);
+	}
+
+	const Dictionary* scope = specializer.find(_name, _scopeWalk);
+	if (!scope) {
+		// not known in any scope up to the root, so it is looked up in the root scope
+		if (!depth)
+			return nullptr;
+		return std::make_shared<ExpansionTemplate>(_name, 0, _format, _filters);
+	}
+
+	// a provided value is computed when the residual template is rendered, as it is for every render
+	if (scope->isProvided(_name)) {
+		DictionaryPtr provider = std::const_pointer_cast<Dictionary>(scope->shared_from_this());
+		return std::make_shared<ProvidedTemplate>(provider, std::make_shared<ExpansionTemplate>(_name, 0, _format, _filters));
+	}
+
+	te_string formatted;
+	const te_string& value = lookup(*scope, formatted);
+	return std::make_shared<SimpleTemplate>(specializer.filter(_filters.apply(value)));
+}
+
+void ExpansionTemplate::write(TemplateWriter& writer) const
+{
+	writer.expansion(_name, _scopeWalk, _format, _filters);
+}
+
+void ExpansionTemplate::renderCached(RenderCache& cache, const DictionaryPtr& dictionary, te_string& out) const
+{
+	cache.expand(dictionary, _name, _scopeWalk, _format, _filters, out);
+}
+
+void ExpansionTemplate::addDependencies(TemplateDependencies& scope) const
+{
+	scope.values.insert({ _name, _scopeWalk });
 }
 
+TE_END_FLAVOUR
 }
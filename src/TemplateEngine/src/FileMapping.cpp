@@ -0,0 +1,142 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include "stdafx.h"
+
+#include <cstring>
+#include <memory>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "FileMapping.hpp"
+#include "Transcoder.hpp"
+#include "Exception.hpp"
+
+namespace template_engine
+{
+
+const size_t FileMapping::smallFileSize;
+
+FileMapping::FileMapping(const std::string& path, size_t readLimit) :
+	_data(nullptr),
+	_size(0),
+	_mapped(false)
+{
+#ifdef _WIN32
+	std::u16string widePath = Transcoder::utf8ToUtf16(path);
+	HANDLE file = CreateFileW(reinterpret_cast<LPCWSTR>(widePath.c_str()), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (INVALID_HANDLE_VALUE == file)
+		throw TemplateException("Unable to open template file '" + path + "'");
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size)) {
+		CloseHandle(file);
+		throw TemplateException("Unable to read the size of template file '" + path + "'");
+	}
+	_size = static_cast<size_t>(size.QuadPart);
+
+	if (_size && _size <= readLimit) {
+		std::unique_ptr<char[]> data(new char[_size]);
+		DWORD length = 0;
+		if (ReadFile(file, data.get(), static_cast<DWORD>(_size), &length, nullptr) && length == _size)
+			_data = data.release();
+		CloseHandle(file);
+		if (!_data)
+			throw TemplateException("Unable to read template file '" + path + "'");
+		return;
+	}
+
+	// an empty file can't be mapped, and doesn't need to be
+	if (_size) {
+		HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping) {
+			_data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+			_mapped = _data != nullptr;
+			CloseHandle(mapping);
+		}
+	}
+	CloseHandle(file);
+#else
+	int file = ::open(path.c_str(), O_RDONLY);
+	if (file < 0)
+		throw TemplateException("Unable to open template file '" + path + "'");
+
+	struct stat info;
+	if (::fstat(file, &info) != 0) {
+		::close(file);
+		throw TemplateException("Unable to read the size of template file '" + path + "'");
+	}
+	_size = static_cast<size_t>(info.st_size);
+
+	if (_size && _size <= readLimit) {
+		std::unique_ptr<char[]> data(new char[_size]);
+		size_t length = 0;
+		while (length < _size) {
+			ssize_t n = ::read(file, data.get() + length, _size - length);
+			if (n <= 0)
+				break;
+			length += static_cast<size_t>(n);
+		}
+		::close(file);
+		if (length != _size)
+			throw TemplateException("Unable to read template file '" + path + "'");
+		_data = data.release();
+		return;
+	}
+
+	// an empty file can't be mapped, and doesn't need to be
+	if (_size) {
+		void* data = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, file, 0);
+		if (MAP_FAILED != data) {
+			::madvise(data, _size, MADV_SEQUENTIAL);
+			_data = static_cast<const char*>(data);
+			_mapped = true;
+		}
+	}
+	::close(file);
+#endif
+	if (_size && !_data)
+		throw TemplateException("Unable to map template file '" + path + "'");
+}
+
+FileMapping::~FileMapping()
+{
+	if (!_data)
+		return;
+
+	if (!_mapped) {
+		delete[] _data;
+		return;
+	}
+#ifdef _WIN32
+	UnmapViewOfFile(_data);
+#else
+	::munmap(const_cast<char*>(_data), _size);
+#endif
+}
+
+size_t FileMapping::bomLength() const
+{
+	return (_size >= 3 && std::memcmp(_data, "\xEF\xBB\xBF", 3) == 0) ? 3 : 0;
+}
+
+}
@@ -0,0 +1,150 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include "stdafx.h"
+
+#include <mutex>
+#include <unordered_map>
+
+#include "FilterChain.hpp"
+#include "Escaper.hpp"
+#include "CharClass.hpp"
+#include "Exception.hpp"
+
+namespace template_engine
+{
+TE_BEGIN_FLAVOUR
+
+namespace
+{
+
+void upperFilter(te_string& out, const te_char_t* value, size_t length)
+{
+	size_t start = out.size();
+	out.append(value, length);
+	for (size_t i = start; i < out.size(); i++)
+		if (out[i] >= TE_TEXT('a') && out[i] <= TE_TEXT('z'))
+			out[i] = static_cast<te_char_t>(out[i] - TE_TEXT('a') + TE_TEXT('A'));
+}
+
+void lowerFilter(te_string& out, const te_char_t* value, size_t length)
+{
+	size_t start = out.size();
+	out.append(value, length);
+	for (size_t i = start; i < out.size(); i++)
+		out[i] = asciiToLower(out[i]);
+}
+
+te_string foldName(const te_string& name)
+{
+	te_string folded(name);
+	for (te_char_t& ch : folded)
+		ch = asciiToLower(ch);
+	return folded;
+}
+
+/** \brief The filters by folded name, filters are added and looked up from any thread */
+struct Registry
+{
+	Registry() :
+		filters{
+			{ TE_TEXT("html"), &HtmlEscaper::append },
+			{ TE_TEXT("xml"), &XmlEscaper::append },
+			{ TE_TEXT("json"), &JsonEscaper::append },
+			{ TE_TEXT("c"), &CEscaper::append },
+			{ TE_TEXT("upper"), &upperFilter },
+			{ TE_TEXT("lower"), &lowerFilter }
+		}
+	{
+	}
+
+	std::mutex mutex;
+	std::unordered_map<te_string, TemplateEscaper> filters;
+};
+
+Registry& registry()
+{
+	static Registry instance;
+	return instance;
+}
+
+}
+
+void FilterRegistry::add(const te_string& name, TemplateEscaper filter)
+{
+	if (name.empty() || !filter)
+		throw TemplateException("A filter must have a name and a function");
+
+	Registry& r = registry();
+	std::lock_guard<std::mutex> lock(r.mutex);
+	r.filters[foldName(name)] = filter;
+}
+
+TemplateEscaper FilterRegistry::find(const te_string& name)
+{
+	Registry& r = registry();
+	std::lock_guard<std::mutex> lock(r.mutex);
+	std::unordered_map<te_string, TemplateEscaper>::const_iterator it = r.filters.find(foldName(name));
+	return it == r.filters.end() ? nullptr : it->second;
+}
+
+FilterChain::FilterChain(std::initializer_list<te_string> names)
+{
+	for (const te_string& name : names)
+		push_back(name);
+}
+
+void FilterChain::push_back(const te_string& name)
+{
+	TemplateEscaper filter = FilterRegistry::find(name);
+	if (!filter)
+		throw TemplateException("Unknown filter: '" + to_utf8(name) + "'");
+
+	_names.push_back(name);
+	_filters.push_back(filter);
+}
+
+void FilterChain::apply(te_string& out, const te_char_t* value, size_t length) const
+{
+	size_t count = _filters.size();
+	if (!count) {
+		out.append(value, length);
+		return;
+	}
+
+	// every filter but the last writes to one of two scratch strings
+	te_string scratch[2];
+	for (size_t i = 0; i + 1 < count; i++) {
+		te_string& result = scratch[i & 1];
+		result.clear();
+		_filters[i](result, value, length);
+		value = result.data();
+		length = result.size();
+	}
+
+	_filters[count - 1](out, value, length);
+}
+
+te_string FilterChain::apply(const te_string& value) const
+{
+	te_string result;
+	result.reserve(value.size());
+	apply(result, value.data(), value.size());
+	return result;
+}
+
+TE_END_FLAVOUR
+}
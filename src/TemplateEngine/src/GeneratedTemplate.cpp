@@ -0,0 +1,95 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include "stdafx.h"
+
+#include "GeneratedTemplate.hpp"
+#include "Escaper.hpp"
+#include "Exception.hpp"
+
+namespace template_engine
+{
+TE_BEGIN_FLAVOUR
+
+GeneratedTemplate::GeneratedTemplate(render_function_t function) :
+	_function(function)
+{
+}
+
+te_string GeneratedTemplate::render(const DictionaryPtr& dictionary, TemplateFilter filter) const
+{
+	te_string result;
+	_function(result, dictionary, filter);
+	return result;
+}
+
+void GeneratedTemplate::renderInto(const DictionaryPtr& dictionary, TemplateEscaper escaper, te_string& out) const
+{
+	_function(out, dictionary, escapeFilter(escaper));
+}
+
+void GeneratedTemplate::expand(te_string& out, const DictionaryPtr& dictionary, const te_string& name, uint8_t scopeWalk, const TemplateFilter& filter)
+{
+	static const ValueFormat noFormat;
+	static const FilterChain noFilters;
+	expand(out, dictionary, name, scopeWalk, noFormat, noFilters, filter);
+}
+
+void GeneratedTemplate::expand(te_string& out, const DictionaryPtr& dictionary, const te_string& name, uint8_t scopeWalk,
+	const ValueFormat& format, const FilterChain& filters, const TemplateFilter& filter)
+{
+	DictionaryPtr scope;
+	const Dictionary* currentDictionary = dictionary.get();
+	if (scopeWalk) {
+		scope = dictionary;
+		for (uint8_t i = 0; i < scopeWalk; i++) {
+			scope = scope->getParent();
+			if (nullptr == scope)
+				throw TemplateException("Access to non existing parent scope");
+		}
+		currentDictionary = scope.get();
+	}
+
+	const TypedValue* typed;
+	const te_string* value = currentDictionary->findValue(name, typed);
+	if (!value && !typed)
+		throw TemplateException("The name '" + to_utf8(name) + "' could not be found");
+
+	te_string formatted;
+	if (typed || !format.isDefault()) {
+		if (typed)
+			format.format(formatted, *typed);
+		else
+			format.format(formatted, value->data(), value->size());
+		value = &formatted;
+	}
+
+	if (filter)
+		out += filter(filters.empty() ? *value : filters.apply(*value));
+	else
+		filters.apply(out, value->data(), value->size());
+}
+
+const DictionaryListPtr& GeneratedTemplate::enterList(const DictionaryPtr& dictionary, const te_string& name)
+{
+	if (!(dictionary->exists(name) && dictionary->isList(name)))
+		throw TemplateException("The list '" + to_utf8(name) + "' could not be found");
+
+	return dictionary->getList(name);
+}
+
+TE_END_FLAVOUR
+}
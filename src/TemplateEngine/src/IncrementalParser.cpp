@@ -0,0 +1,415 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include "stdafx.h"
+
+#include <algorithm>
+#include <string>
+
+#include "IncrementalParser.hpp"
+#include "TemplateParser.hpp"
+#include "TemplateList.hpp"
+#include "RepeatTemplate.hpp"
+#include "StringScanner.hpp"
+#include "SourceBuffer.hpp"
+#include "CharClass.hpp"
+#include "Lexer.hpp"
+#include "Exception.hpp"
+
+namespace template_engine
+{
+TE_BEGIN_FLAVOUR
+
+/** \brief A part of the definition, and the templates parsed from it.
+ *
+ * A text block is parsed as a whole, a repeat block is a repeat
+ * instruction whose body is split into blocks of its own. Blocks are never
+ * changed once built, so they can be shared between the templates of
+ * succeeding edits.
+ */
+struct IncrementalParser::Block
+{
+	bool repeat;            ///< Is this a repeat block?
+	size_t length;          ///< Code units of the definition covered by the block.
+	TemplatePtr templ;      ///< The templates parsed from the block.
+	SourceBuffer text;      ///< Text blocks: the definition, the literals refer to it.
+	te_string name;         ///< Repeat blocks: name of the list.
+	te_string open;         ///< Repeat blocks: the start repeat tag.
+	te_string close;        ///< Repeat blocks: the end repeat tag.
+	Blocks body;            ///< Repeat blocks: the blocks of the body.
+};
+
+/** \brief A block found by the structural pass, [begin, end) of the text. */
+struct IncrementalParser::Segment
+{
+	bool repeat;            ///< Is this a repeat instruction, larger than a block?
+	size_t begin;           ///< First code unit.
+	size_t end;             ///< One past the last code unit.
+	size_t bodyBegin;       ///< Repeat instructions: first code unit of the body.
+	size_t bodyEnd;         ///< Repeat instructions: one past the last code unit of the body.
+};
+
+namespace
+{
+/** \brief First occurrence of <code>}}</code> in [first, last), or last. */
+const te_char_t* findEndTag(const te_char_t* first, const te_char_t* last)
+{
+	for (; first + 1 < last; ++first)
+		if (TE_TEXT('}') == first[0] && TE_TEXT('}') == first[1])
+			return first;
+	return last;
+}
+
+/** \brief Does the lexer look past a text ending with ch, i.e. is it '{' or '\'? */
+inline bool isOpenEnded(te_char_t ch)
+{
+	return TE_TEXT('{') == ch || TE_TEXT('\\') == ch;
+}
+}
+
+IncrementalParser::IncrementalParser(size_t maxDepth, size_t blockSize) :
+	_maxDepth(maxDepth),
+	_blockSize(std::max<size_t>(blockSize, 1)),
+	_blocks(),
+	_size(0),
+	_templ(std::make_shared<TemplateList>())
+{
+}
+
+IncrementalParser::~IncrementalParser()
+{
+}
+
+TemplatePtr IncrementalParser::parse(const te_string& definition)
+{
+	std::vector<Segment> segments;
+	if (split(definition, segments))
+		assign(build(definition, segments, 0));
+	else {
+		// not self contained, parsed as a whole the errors are reported as by Template::parse()
+		assign(Blocks{ buildText(definition, 0) });
+	}
+
+	return _templ;
+}
+
+TemplatePtr IncrementalParser::edit(size_t offset, size_t removed, const te_string& inserted)
+{
+	if (offset > _size || removed > _size - offset)
+		throw TemplateException("The edit is outside of the definition");
+
+	Blocks blocks;
+	if (!edit(_blocks, 0, true, offset, removed, inserted, blocks)) {
+		te_string definition = getDefinition();
+		definition.replace(offset, removed, inserted);
+		blocks = Blocks{ buildText(std::move(definition), 0) };
+	}
+
+	assign(std::move(blocks));
+	return _templ;
+}
+
+te_string IncrementalParser::getDefinition() const
+{
+	te_string definition;
+	definition.reserve(_size);
+	for (const BlockPtr& block : _blocks)
+		appendText(*block, definition);
+	return definition;
+}
+
+bool IncrementalParser::split(const te_string& text, std::vector<Segment>& segments) const
+{
+	const te_char_t* first = text.data();
+	const te_char_t* last = first + text.size();
+	const te_char_t* p = first;
+	size_t depth = 0;
+	size_t begin = 0;			// start of the current segment
+	size_t repeatBegin = 0;		// start of the current top level repeat instruction
+	size_t bodyBegin = 0;
+
+	// mirrors the lexer's simple state, see Lexer::getNextToken()
+	while (true) {
+		const te_char_t* special = Lexer::findSpecial(p, last);
+
+		// plain text at the top level can be split after a line feed
+		while (!depth && static_cast<size_t>(special - first) - begin > _blockSize) {
+			const te_char_t* from = std::max(p, first + begin + _blockSize - 1);
+			const te_char_t* lf = std::find(from, special, TE_TEXT('\n'));
+			if (lf == special)
+				break;
+			size_t cut = static_cast<size_t>(lf + 1 - first);
+			segments.push_back(Segment{ false, begin, cut, cut, cut });
+			begin = cut;
+		}
+
+		if ((p = special) == last)
+			break;
+
+		// \{{ is an escaped start tag
+		if (TE_TEXT('\\') == *p) {
+			p += (last - p > 2 && TE_TEXT('{') == p[1] && TE_TEXT('{') == p[2]) ? 3 : 1;
+			continue;
+		}
+
+		// a lone {, or {{ followed by something which can't start an instruction, is plain text
+		if (last - p < 2 || TE_TEXT('{') != p[1]) {
+			++p;
+			continue;
+		}
+		te_char_t ch3 = last - p > 2 ? p[2] : TE_TEXT('\0');
+
+		// {{- comment }}
+		if (TE_TEXT('-') == ch3) {
+			p = findEndTag(p + 3, last);
+			if (p == last)
+				return false;
+			p += 2;
+			continue;
+		}
+
+		char_class_t cls = classify(ch3);
+		if (char_class_t::Marker != cls && char_class_t::Name != cls) {
+			++p;
+			continue;
+		}
+
+		// {{...}}, the first } within an instruction must be the end tag
+		const te_char_t* instruction = p + 2;
+		const te_char_t* end = std::find(instruction, last, TE_TEXT('}'));
+		if (last - end < 2 || TE_TEXT('}') != end[1])
+			return false;
+
+		size_t tagBegin = static_cast<size_t>(p - first);
+		p = end + 2;
+		size_t tagEnd = static_cast<size_t>(p - first);
+
+		if (TE_TEXT('#') == *instruction) {
+			if (!depth++) {
+				repeatBegin = tagBegin;
+				bodyBegin = tagEnd;
+			}
+		}
+		else if (TE_TEXT('/') == *instruction) {
+			// an unmatched end repeat ends the enclosing repeat instruction, or the template
+			if (!depth)
+				return false;
+
+			// a large top level repeat instruction is a segment of its own
+			if (!--depth && tagEnd - repeatBegin > _blockSize) {
+				if (repeatBegin > begin)
+					segments.push_back(Segment{ false, begin, repeatBegin, repeatBegin, repeatBegin });
+				segments.push_back(Segment{ true, repeatBegin, tagEnd, bodyBegin, tagBegin });
+				begin = tagEnd;
+				continue;
+			}
+		}
+
+		// past a top level instruction is a segment boundary
+		if (!depth && tagEnd - begin >= _blockSize) {
+			segments.push_back(Segment{ false, begin, tagEnd, tagEnd, tagEnd });
+			begin = tagEnd;
+		}
+	}
+
+	if (depth)
+		return false;
+
+	if (begin < text.size())
+		segments.push_back(Segment{ false, begin, text.size(), text.size(), text.size() });
+	return true;
+}
+
+IncrementalParser::Blocks IncrementalParser::build(const te_string& text, const std::vector<Segment>& segments, size_t depth) const
+{
+	Blocks blocks;
+	blocks.reserve(segments.size());
+	for (const Segment& segment : segments) {
+		if (segment.repeat)
+			blocks.push_back(buildRepeat(text.substr(segment.begin, segment.bodyBegin - segment.begin),
+				text.substr(segment.bodyBegin, segment.bodyEnd - segment.bodyBegin),
+				text.substr(segment.bodyEnd, segment.end - segment.bodyEnd), depth));
+		else
+			blocks.push_back(buildText(text.substr(segment.begin, segment.end - segment.begin), depth));
+	}
+	return blocks;
+}
+
+IncrementalParser::BlockPtr IncrementalParser::buildText(te_string text, size_t depth) const
+{
+	std::shared_ptr<Block> block = std::make_shared<Block>();
+	block->repeat = false;
+	block->length = text.size();
+	block->text = SourceBuffer(std::move(text));
+
+	// the literals refer to the text of the block
+	StringScanner scanner(block->text);
+	TemplateParser parser(_maxDepth - depth);
+	block->templ = parser.parse(scanner);
+	return block;
+}
+
+IncrementalParser::BlockPtr IncrementalParser::buildRepeat(te_string open, const te_string& body, te_string close, size_t depth) const
+{
+	if (depth >= _maxDepth)
+		throw TemplateException("Repeat instructions are nested deeper than " + std::to_string(_maxDepth) + " levels");
+
+	// the tags are checked by the parser, for the errors to be those of Template::parse()
+	StringScanner tags(open + close);
+	TemplateParser(1).parse(tags);
+
+	std::vector<Segment> segments;
+	Blocks blocks;
+	if (split(body, segments))
+		blocks = build(body, segments, depth + 1);
+	else
+		blocks = Blocks{ buildText(body, depth + 1) };
+
+	// in a valid start repeat tag, the name is the last run of name characters
+	std::shared_ptr<Block> block = std::make_shared<Block>();
+	size_t nameEnd = open.size();
+	while (nameEnd && char_class_t::Name != classify(open[nameEnd - 1]))
+		--nameEnd;
+	size_t nameBegin = nameEnd;
+	while (nameBegin && char_class_t::Name == classify(open[nameBegin - 1]))
+		--nameBegin;
+
+	block->repeat = true;
+	block->name = open.substr(nameBegin, nameEnd - nameBegin);
+	block->open = std::move(open);
+	block->close = std::move(close);
+	return buildRepeat(*block, std::move(blocks));
+}
+
+IncrementalParser::BlockPtr IncrementalParser::buildRepeat(const Block& repeat, Blocks body) const
+{
+	std::shared_ptr<Block> block = std::make_shared<Block>(repeat);
+	block->length = block->open.size() + block->close.size();
+	for (const BlockPtr& child : body)
+		block->length += child->length;
+	block->templ = std::make_shared<RepeatTemplate>(block->name, std::const_pointer_cast<Template>(makeList(body)));
+	block->body = std::move(body);
+	return block;
+}
+
+bool IncrementalParser::edit(const Blocks& blocks, size_t depth, bool atEnd, size_t offset, size_t removed, const te_string& inserted, Blocks& result) const
+{
+	// the block holding offset, at the end of the level the last block
+	size_t first = 0;
+	size_t begin = 0;
+	while (first + 1 < blocks.size() && begin + blocks[first]->length <= offset)
+		begin += blocks[first++]->length;
+
+	// text inserted between two blocks goes into a text block, rather than a repeat block
+	if (!removed && first && begin == offset && blocks[first]->repeat) {
+		--first;
+		begin -= blocks[first]->length;
+	}
+
+	// a block which ends where the lexer looks ahead is reparsed along with the edit
+	while (first && !blocks[first - 1]->repeat && blocks[first - 1]->length
+		&& isOpenEnded(blocks[first - 1]->text.data()[blocks[first - 1]->length - 1]))
+		begin -= blocks[--first]->length;
+
+	// and the blocks holding the removed text
+	size_t last = first;
+	size_t end = begin + (blocks.empty() ? 0 : blocks[first]->length);
+	while (last + 1 < blocks.size() && end < offset + removed)
+		end += blocks[++last]->length;
+
+	// an edit of the body of a single repeat instruction is done within the body
+	if (first == last && !blocks.empty() && blocks[first]->repeat) {
+		const Block& repeat = *blocks[first];
+		size_t bodyBegin = begin + repeat.open.size();
+		size_t bodyEnd = end - repeat.close.size();
+
+		Blocks body;
+		if (offset >= bodyBegin && offset + removed <= bodyEnd
+			&& edit(repeat.body, depth + 1, false, offset - bodyBegin, removed, inserted, body)) {
+			result = blocks;
+			result[first] = buildRepeat(repeat, std::move(body));
+			return true;
+		}
+	}
+
+	te_string text;
+	for (size_t i = first; i <= last && i < blocks.size(); ++i)
+		appendText(*blocks[i], text);
+	text.replace(offset - begin, removed, inserted);
+
+	// add the following blocks, until the edited text is self contained
+	while (true) {
+		bool toEnd = last + 1 >= blocks.size();
+
+		std::vector<Segment> segments;
+		if (split(text, segments) && ((toEnd && atEnd) || text.empty() || !isOpenEnded(text.back()))) {
+			Blocks edited = build(text, segments, depth);
+
+			result.clear();
+			result.reserve(blocks.size() - (last - first) + edited.size());
+			result.insert(result.end(), blocks.begin(), blocks.begin() + first);
+			result.insert(result.end(), edited.begin(), edited.end());
+			if (!toEnd)
+				result.insert(result.end(), blocks.begin() + last + 1, blocks.end());
+			return true;
+		}
+
+		if (toEnd)
+			return false;
+
+		// as many blocks again, so the text is split a logarithmic number of times
+		for (size_t count = last - first + 1; count && last + 1 < blocks.size(); --count)
+			appendText(*blocks[++last], text);
+	}
+}
+
+void IncrementalParser::assign(Blocks blocks)
+{
+	TemplatePtr templ = makeList(blocks);
+
+	size_t size = 0;
+	for (const BlockPtr& block : blocks)
+		size += block->length;
+
+	_blocks = std::move(blocks);
+	_templ = std::move(templ);
+	_size = size;
+}
+
+TemplatePtr IncrementalParser::makeList(const Blocks& blocks)
+{
+	std::shared_ptr<TemplateList> list = std::make_shared<TemplateList>();
+	list->reserve(blocks.size());
+	for (const BlockPtr& block : blocks)
+		list->push_back(block->templ);
+	return list;
+}
+
+void IncrementalParser::appendText(const Block& block, te_string& text)
+{
+	if (!block.repeat) {
+		text.append(block.text.data(), block.text.size());
+		return;
+	}
+
+	text += block.open;
+	for (const BlockPtr& child : block.body)
+		appendText(*child, text);
+	text += block.close;
+}
+
+TE_END_FLAVOUR
+}
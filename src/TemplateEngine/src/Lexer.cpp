@@ -18,140 +18,284 @@
 
 #include "Lexer.hpp"
 #include "Exception.hpp"
-#include "ReverseIterator.hpp"
+#include "Simd.hpp"
 
 namespace template_engine
 {
+TE_BEGIN_FLAVOUR
 
-const Lexer::Token& Lexer::getNextSimpleToken()
+namespace
 {
-	// grab a character from the scanner
-	te_char_t ch = _scanner.getChar();
-
-	// for a simple token only '{' and '\' are special
-	if( !(TE_TEXT('{') == ch || TE_TEXT('\\') == ch) )
-	{
-		_scanner.moveNext();				// eat ch;
-		_token._char = ch;
-		_token._type = Token::token_t::Char;
-		return _token;
-	}
 
-	// not a simple char copy, so peek at the next chars
-	te_char_t ch2 = _scanner.peek(1);
-	te_char_t ch3 = _scanner.peek(2);
+//
+// Literal run kernels, each returns a pointer to the first '{' or '\' in
+// [first, last). In the simple state these are the only code units which
+// can start anything but plain text. The vector kernels stop when less
+// than a full register is left, the caller finishes with the scalar loop.
+//
 
-	// Comment tag? '{{-'
-	if ((TE_TEXT('{') == ch && TE_TEXT('{') == ch2 && TE_TEXT('-') == ch3)) {
-		_scanner.moveNext();				// eat ch
-		_scanner.moveNext();				// eat ch2
-		_scanner.moveNext();				// eat ch3
+inline bool isSpecial(te_char_t ch)
+{
+	return TE_TEXT('{') == ch || TE_TEXT('\\') == ch;
+}
 
-		_currentState = states_t::Comment;
-		return getNextToken();
+#ifdef TE_SIMD_AVX2
+TE_TARGET_AVX2 const te_char_t* findSpecialAvx2(const te_char_t* first, const te_char_t* last)
+{
+	const size_t lanes = 32 / sizeof(te_char_t);
+#ifdef TE_USE_UTF8
+	const __m256i brace = _mm256_set1_epi8('{');
+	const __m256i backslash = _mm256_set1_epi8('\\');
+#else
+	const __m256i brace = _mm256_set1_epi16(u'{');
+	const __m256i backslash = _mm256_set1_epi16(u'\\');
+#endif
+	for (; static_cast<size_t>(last - first) >= lanes; first += lanes) {
+		__m256i units = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+#ifdef TE_USE_UTF8
+		__m256i hits = _mm256_or_si256(_mm256_cmpeq_epi8(units, brace), _mm256_cmpeq_epi8(units, backslash));
+#else
+		__m256i hits = _mm256_or_si256(_mm256_cmpeq_epi16(units, brace), _mm256_cmpeq_epi16(units, backslash));
+#endif
+		unsigned int mask = static_cast<unsigned int>(_mm256_movemask_epi8(hits));
+		if (mask)
+			return first + lowestBit(mask) / sizeof(te_char_t);
 	}
+	return first;
+}
+#endif
 
-	// Escape tag? '\{{'
-	if ( (TE_TEXT('\\') == ch && TE_TEXT('{') == ch2 && TE_TEXT('{') == ch3) ) {
-		_scanner.moveNext();				// eat the backslash
-
-		_currentState = states_t::Escape;
-		return getNextEscapeToken();
+#ifdef TE_SIMD_SSE2
+const te_char_t* findSpecialSse2(const te_char_t* first, const te_char_t* last)
+{
+	const size_t lanes = 16 / sizeof(te_char_t);
+#ifdef TE_USE_UTF8
+	const __m128i brace = _mm_set1_epi8('{');
+	const __m128i backslash = _mm_set1_epi8('\\');
+#else
+	const __m128i brace = _mm_set1_epi16(u'{');
+	const __m128i backslash = _mm_set1_epi16(u'\\');
+#endif
+	for (; static_cast<size_t>(last - first) >= lanes; first += lanes) {
+		__m128i units = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+#ifdef TE_USE_UTF8
+		__m128i hits = _mm_or_si128(_mm_cmpeq_epi8(units, brace), _mm_cmpeq_epi8(units, backslash));
+#else
+		__m128i hits = _mm_or_si128(_mm_cmpeq_epi16(units, brace), _mm_cmpeq_epi16(units, backslash));
+#endif
+		unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(hits));
+		if (mask)
+			return first + lowestBit(mask) / sizeof(te_char_t);
 	}
+	return first;
+}
+#endif
+
+}
 
-	// two '{{' in a row
-	if ((TE_TEXT('{') == ch && TE_TEXT('{') == ch2)) {
+/** \internal
+ * \brief What the lexer does with the next code unit, by lexer state and character class.
+ *
+ * The table is generated at compile time from the rules in the constructor,
+ * turning getNextToken() into a lookup and a single switch.
+ */
+struct LexerActionTable
+{
+	typedef Lexer::states_t states_t;
+	typedef Lexer::action_t action_t;
 
-		// examine ch3, if it can be part of an instruction we report a start tag
-		// otherwise we "auto-escape" ch
-		if (TE_TEXT('#') == ch3 || TE_TEXT('/') == ch3 || TE_TEXT(':') == ch3 || isValidNameChar(ch3)) {
-			_currentState = states_t::Instruction;
+	action_t actions[Lexer::stateCount][charClassCount];	//!< The action for each state and class.
 
-			_scanner.moveNext();				// eat ch
-			_scanner.moveNext();				// eat ch2
-			_token._type = Token::token_t::StartTag;
-		}
-		else {
-			_scanner.moveNext();				// eat ch, but nothing more
-			_token._char = ch;
-			_token._type = Token::token_t::Char;
+	constexpr LexerActionTable() : actions()
+	{
+		for (size_t c = 0; c < charClassCount; ++c) {
+			char_class_t cls = static_cast<char_class_t>(c);
+
+			// in plain text only '{' and '\' are special
+			set(states_t::Simple, cls,
+				char_class_t::Open == cls ? action_t::OpenBrace :
+				char_class_t::Escape == cls ? action_t::Backslash : action_t::Text);
+
+			// within an instruction, names are read as a whole, '}' may end the
+			// instruction, '{' and '\' are empty names and anything else, such as
+			// markers, pipes, white space and format specifiers, is a single code unit
+			set(states_t::Instruction, cls,
+				char_class_t::Close == cls ? action_t::CloseBrace :
+				(char_class_t::Name == cls || char_class_t::Open == cls || char_class_t::Escape == cls) ? action_t::Name : action_t::Marker);
+
+			set(states_t::Comment, cls, action_t::Comment);
+			set(states_t::Escape, cls, action_t::Escaped);
 		}
-		return _token;
 	}
 
-	// despite appearances ch is really just a simple char, i.e. a single backslash
-	// or curly parenthesis
-	_scanner.moveNext();				// eat ch;
-	_token._char = ch;
-	_token._type = Token::token_t::Char;
-	return _token;
+	constexpr void set(states_t state, char_class_t cls, action_t action)
+	{
+		actions[static_cast<size_t>(state)][static_cast<size_t>(cls)] = action;
+	}
+
+	constexpr action_t get(states_t state, char_class_t cls) const
+	{
+		return actions[static_cast<size_t>(state)][static_cast<size_t>(cls)];
+	}
+};
+
+namespace
+{
+constexpr LexerActionTable lexerActions;
+}
+
+const te_char_t* Lexer::findSpecial(const te_char_t* first, const te_char_t* last)
+{
+#ifdef TE_SIMD_AVX2
+	if (cpuHasAvx2())
+		first = findSpecialAvx2(first, last);
+#endif
+#ifdef TE_SIMD_SSE2
+	// when a kernel stopped on a hit we are done, even if that was at the tail
+	if (first != last && !isSpecial(*first))
+		first = findSpecialSse2(first, last);
+#endif
+	while (first != last && !isSpecial(*first))
+		++first;
+	return first;
 }
 
 const Lexer::Token& Lexer::getNextToken()
 {
+	if (_tokenPutBack) {
+		_tokenPutBack = false;
+		return _token;
+	}
+
 	if (_scanner.atEos()) {
 		_token._type = Token::token_t::Eos;
 		return _token;
 	}
 
-	switch (_currentState)
+	te_char_t ch = _scanner.getChar();
+
+	switch (lexerActions.get(_currentState, classify(ch)))
 	{
-		case states_t::Simple:
-			return getNextSimpleToken();
-		case states_t::Instruction:
-			return getNextInstructionToken();
-		case states_t::Comment:
+		case action_t::Text:
+			return getTextToken(ch);
+		case action_t::OpenBrace:
+			return getOpenBraceToken(ch);
+		case action_t::Backslash:
+			return getBackslashToken(ch);
+		case action_t::Marker:
+			return getCharToken(ch);
+		case action_t::CloseBrace:
+			return getCloseBraceToken();
+		case action_t::Name:
+			return getNameToken();
+		case action_t::Comment:
 			return getNextCommentToken();
-		case states_t::Escape:
+		case action_t::Escaped:
 			return getNextEscapeToken();
-		default:
-			break;
 	}
 
 	throw TemplateException("Unknown internal lexer state");
 }
 
-const Lexer::Token& Lexer::getNextInstructionToken()
+const Lexer::Token& Lexer::getTextToken(te_char_t ch)
 {
-	te_char_t ch = _scanner.getChar();
+	// peeked or pushed back code units are handed out one at a time
+	if (_scanner.isBuffered())
+		return getCharToken(ch);
+
+	// everything up to the next special code unit is a single token
+	size_t length;
+	const te_char_t* block = _scanner.getBlock(length);
+	_token._text = block;
+	_token._textLength = static_cast<size_t>(findSpecial(block, block + length) - block);
+	_token._type = Token::token_t::Text;
+	_scanner.advance(_token._textLength);		// eat the run
+	return _token;
+}
+
+const Lexer::Token& Lexer::getOpenBraceToken(te_char_t ch)
+{
+	te_char_t ch2 = _scanner.peek(1);
+	if (TE_TEXT('{') != ch2)
+		return getCharToken(ch);			// just a curly parenthesis
 
-	// is the current token a charcter and one of the special processing characters?
-	if (TE_TEXT('#') == ch || TE_TEXT('/') == ch || TE_TEXT(':') == ch || ::isspace(ch)) {
-		_token._type = Token::token_t::Char;
-		_token._char = ch;
+	te_char_t ch3 = _scanner.peek(2);
 
-		_scanner.moveNext();	// eat ch
-		return _token;
+	// Comment tag? '{{-'
+	if (TE_TEXT('-') == ch3) {
+		_scanner.advance(3);				// eat ch, ch2 and ch3
+
+		_currentState = states_t::Comment;
+		return getNextToken();
 	}
 
-	// End of instruction tag? '}}'
-	te_char_t ch2 = _scanner.peek(1);
-	if (TE_TEXT('}') == ch && TE_TEXT('}') == ch2) {
-		_scanner.moveNext();				// eat ch
-		_scanner.moveNext();				// eat ch2
+	// examine ch3, if it can be part of an instruction we report a start tag
+	// otherwise we "auto-escape" ch
+	char_class_t cls = classify(ch3);
+	if (char_class_t::Marker != cls && char_class_t::Name != cls)
+		return getCharToken(ch);			// eat ch, but nothing more
 
-		_token._type = Token::token_t::EndTag;
+	_scanner.advance(2);					// eat ch and ch2
+	_currentState = states_t::Instruction;
+	_token._type = Token::token_t::StartTag;
+	return _token;
+}
 
-		_currentState = states_t::Simple;
-		return _token;
+const Lexer::Token& Lexer::getBackslashToken(te_char_t ch)
+{
+	// Escape tag? '\{{'
+	if (TE_TEXT('{') == _scanner.peek(1) && TE_TEXT('{') == _scanner.peek(2)) {
+		_scanner.moveNext();				// eat the backslash
+
+		_currentState = states_t::Escape;
+		_escapeCount = 2;
+		return getNextEscapeToken();
 	}
 
-	// we've eliminated everything but a name token,
-	// so this must be a name token.
+	// despite appearances ch is really just a single backslash
+	return getCharToken(ch);
+}
+
+const Lexer::Token& Lexer::getCharToken(te_char_t ch)
+{
+	_scanner.moveNext();					// eat ch
+	_token._char = ch;
+	_token._type = Token::token_t::Char;
+	return _token;
+}
+
+const Lexer::Token& Lexer::getCloseBraceToken()
+{
+	// End of instruction tag? '}}'
+	if (TE_TEXT('}') != _scanner.peek(1))
+		return getNameToken();				// a lone brace, which isn't a name
+
+	_scanner.advance(2);					// eat ch and ch2
+
+	_token._type = Token::token_t::EndTag;
+	_currentState = states_t::Simple;
+	return _token;
+}
+
+const Lexer::Token& Lexer::getNameToken()
+{
+	// names are read a block at a time
 	_token._name.clear();
 	_token._type = Token::token_t::Name;
-	while (!_scanner.atEos()) {
-		if (isValidNameChar(ch)) {
-			_token._name += ch;
-			_scanner.moveNext();
-
-			// we shouldn't be able to reach eos here, but it might happen
-			if (_scanner.atEos())
-				break;
-		}
-		else
+
+	size_t length;
+	const te_char_t* block;
+	while ((block = _scanner.getBlock(length)) != nullptr) {
+		size_t n = 0;
+		while (n < length && isValidNameChar(block[n]))
+			++n;
+
+		_token._name.append(block, n);
+		_scanner.advance(n);
+
+		// the name ended inside the block
+		if (n < length)
 			break;
-		ch = _scanner.getChar();
 	}
 
 	return _token;
@@ -159,92 +303,96 @@ const Lexer::Token& Lexer::getNextInstructionToken()
 
 const Lexer::Token& Lexer::getNextCommentToken()
 {
-	while (!_scanner.atEos())
+	size_t length;
+	const te_char_t* block;
+	while ((block = _scanner.getBlock(length)) != nullptr)
 	{
-		te_char_t ch = _scanner.getChar();
-		if (TE_TEXT('}') == ch) {
-			te_char_t ch2 = _scanner.peek(1);
-			if (TE_TEXT('}') == ch2) {
-				_scanner.moveNext();		// eat ch
-				_scanner.moveNext();		// eat ch2
-
-				_currentState = states_t::Simple;
-				return getNextToken();
-			}
+		// skip everything up to the next '}'
+		size_t n = 0;
+		while (n < length && TE_TEXT('}') != block[n])
+			++n;
+
+		_scanner.advance(n);
+		if (n == length)
+			continue;
+
+		if (TE_TEXT('}') == _scanner.peek(1)) {
+			_scanner.advance(2);		// eat ch and ch2
+
+			_currentState = states_t::Simple;
+			return getNextToken();
 		}
 		_scanner.moveNext();
 	}
-	
+
+	// the rest of the comment may still arrive
+	if (_partialInput) {
+		_token._type = Token::token_t::Eos;
+		return _token;
+	}
+
 	throw TemplateException("Runaway comment detected");
 }
 
 const Lexer::Token& Lexer::getNextEscapeToken()
 {
-	static uint32_t count = 3;
-
-	if (--count) {
-		_token._char = _scanner.getChar();
-		_token._type = Token::token_t::Char;
-		_scanner.moveNext();
-		return _token;
-	}
+	// the two braces of the escaped start tag are passed on as plain chars
+	if (--_escapeCount == 0)
+		_currentState = states_t::Simple;
 
-	_currentState = states_t::Simple;
-	count = 3;
-	return getNextToken();
+	return getCharToken(_scanner.getChar());
 }
 
 void Lexer::skipWhiteSpace()
 {
-	if (_scanner.atEos())
-		return;
-
-	te_char_t ch = _scanner.getChar();
-	while (std::isspace(ch)) {
-		_scanner.moveNext();
-		if (_scanner.atEos())
+	if (_tokenPutBack) {
+		// a token which was put back comes first, only white space can be skipped
+		if (Token::token_t::Char != _token._type || char_class_t::Space != classify(_token._char))
 			return;
+		_tokenPutBack = false;
+	}
 
-		ch = _scanner.getChar();
+	size_t length;
+	const te_char_t* block;
+	while ((block = _scanner.getBlock(length)) != nullptr) {
+		size_t n = 0;
+		while (n < length && char_class_t::Space == classify(block[n]))
+			++n;
+
+		_scanner.advance(n);
+		if (n < length)
+			return;
 	}
 }
 
+Lexer::State::State() :
+	_state(states_t::Simple),
+	_escapeCount(0)
+{
+}
+
+Lexer::State Lexer::getState() const
+{
+	State state;
+	state._state = _currentState;
+	state._escapeCount = _escapeCount;
+	return state;
+}
+
+void Lexer::setState(const State& state)
+{
+	_currentState = state._state;
+	_escapeCount = state._escapeCount;
+}
 
 void Lexer::putTokenBack(const Token& token)
 {
-	// only insert tokens which has a representation in the input stream
-	switch (token.getType())
-	{
-        case Token::token_t::Char:
-            _scanner.pushFront(token.getChar());
-
-            // special case for escaping the backslash
-            if (TE_TEXT('\\') == token.getChar())
-                _scanner.pushFront(TE_TEXT('\\'));
-            break;
-        case Token::token_t::EndTag:
-            _scanner.pushFront(TE_TEXT('}'));
-            _scanner.pushFront(TE_TEXT('}'));
-			// if we scanned an end tag, we entered the simple state
-			// and need to return to the instruction state
-			_currentState = states_t::Instruction;
-			break;
-        case Token::token_t::StartTag:
-            _scanner.pushFront(TE_TEXT('{'));
-            _scanner.pushFront(TE_TEXT('{'));
+	// the token is normally the one just returned, which doesn't need copying
+	if (&token != &_token)
+		_token = token;
 
-			// if we scanned a start tag, we entered the instruction state
-			// and need to leave that state
-			_currentState = states_t::Simple;
-			break;
-        case Token::token_t::Name:
-            for (te_char_t ch : reverse(token.getName()))
-                _scanner.pushFront(ch);
-            break;
-        case Token::token_t::Eos:       // don't put anything back for these
-        case Token::token_t::Empty:
-            break;
-	}
+	_tokenPutBack = true;
 }
 
+TE_END_FLAVOUR
 }
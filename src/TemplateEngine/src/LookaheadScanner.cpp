@@ -16,44 +16,85 @@
 // License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
 #include "stdafx.h"
 #include "LookaheadScanner.hpp"
+#include "Exception.hpp"
 
 namespace template_engine
 {
+TE_BEGIN_FLAVOUR
 
 LookaheadScanner::LookaheadScanner(Scanner& wrappedScanner) :
 	_wrappedScanner(wrappedScanner),
-	_lookAheadBuffer()
+	_ringHead(0),
+	_ringCount(0),
+	_block(nullptr),
+	_blockCursor(nullptr),
+	_blockEnd(nullptr),
+	_blockOffset(0),
+	_reachedEnd(false)
 {
+	static_assert((capacity & (capacity - 1)) == 0, "the lookahead capacity must be a power of two");
+}
+
+bool LookaheadScanner::nextBlock() const
+{
+	// the wrapped scanner is only moved once the whole block has been consumed,
+	// this keeps the cached block valid while it is being read.
+	_wrappedScanner.advance(static_cast<size_t>(_blockEnd - _block));
+	_blockOffset += static_cast<size_t>(_blockEnd - _block);
+
+	size_t length;
+	_block = _wrappedScanner.getBlock(length);
+	_blockCursor = _block;
+	_blockEnd = _block + length;
+
+	if (!length)
+		_reachedEnd = true;
+
+	return length != 0;
 }
 
 void LookaheadScanner::pushBack(te_char_t ch)
 {
-	_lookAheadBuffer.push_back(ch);
+	if (_ringCount == capacity)
+		throw TemplateException("Lookahead buffer overflow");
+
+	_ring[(_ringHead + _ringCount) & (capacity - 1)] = ch;
+	++_ringCount;
 }
 
 void LookaheadScanner::pushFront(te_char_t ch)
 {
-	_lookAheadBuffer.push_front(ch);
+	if (_ringCount == capacity)
+		throw TemplateException("Lookahead buffer overflow");
+
+	_ringHead = (_ringHead - 1) & (capacity - 1);
+	_ring[_ringHead] = ch;
+	++_ringCount;
 }
 
 te_char_t LookaheadScanner::peek(size_t n)
 {
 	// simple case!, the buffer already contains the requested character
-	if (_lookAheadBuffer.size() > n) {
-		return _lookAheadBuffer.at(n);
+	if (_ringCount > n) {
+		return _ring[(_ringHead + n) & (capacity - 1)];
+	}
+
+	// almost as simple, the character is in the current block
+	size_t offset = n - _ringCount;
+	if (fillBlock() && static_cast<size_t>(_blockEnd - _blockCursor) > offset) {
+		return _blockCursor[offset];
 	}
 
-	// read characters from the scanner and put them on the buffer
+	// move characters from the block(s) onto the buffer
 	// until we have enough or we've reached the end of stream
-	while (_lookAheadBuffer.size() <= n && !_wrappedScanner.atEos())
+	while (_ringCount <= n && fillBlock())
 	{
-		_lookAheadBuffer.push_back(_wrappedScanner.getChar());
-		_wrappedScanner.moveNext();
+		pushBack(*_blockCursor++);
 	}
 
 	// either the buffer has the character or the buffer was emptied
-	if (_lookAheadBuffer.size() > n) {
-		return _lookAheadBuffer.at(n);
+	if (_ringCount > n) {
+		return _ring[(_ringHead + n) & (capacity - 1)];
 	}
 
 	// peek is not allowed to fail, and returns \0 beyond the end.
@@ -61,4 +102,5 @@ te_char_t LookaheadScanner::peek(size_t n)
 }
 
 
+TE_END_FLAVOUR
 }
\ No newline at end of file
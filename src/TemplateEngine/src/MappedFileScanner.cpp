@@ -0,0 +1,175 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include "stdafx.h"
+
+#include <utility>
+
+#include "MappedFileScanner.hpp"
+#include "FileMapping.hpp"
+#include "Transcoder.hpp"
+#include "Exception.hpp"
+
+namespace template_engine
+{
+TE_BEGIN_FLAVOUR
+
+#ifdef TE_USE_UTF8
+
+MappedFileScanner::MappedFileScanner(const std::string& path) :
+	MappedFileScanner(std::make_shared<FileMapping>(path), path)
+{
+}
+
+MappedFileScanner::MappedFileScanner(std::shared_ptr<const FileMapping> mapping, const std::string& path) :
+	_mapping(std::move(mapping)),
+	_path(path),
+	_source(_mapping->text(), _mapping->textSize(), _mapping),
+	_position(0)
+{
+	// the blocks are handed out as is, so the text must be validated up front
+	if (!Transcoder::isValidUtf8(_source.data(), _source.size()))
+		throw TemplateException("Template file '" + path + "' isn't valid UTF-8");
+}
+
+bool MappedFileScanner::atEos() const
+{
+	return _position == _source.size();
+}
+
+bool MappedFileScanner::moveNext()
+{
+	if (atEos())
+		return false;
+
+	_position++;
+
+	return !atEos();
+}
+
+te_char_t MappedFileScanner::getChar() const
+{
+	return atEos() ? TE_TEXT('\0') : _source.data()[_position];
+}
+
+const te_char_t* MappedFileScanner::getBlock(size_t& length)
+{
+	length = _source.size() - _position;
+
+	return _source.data() + _position;
+}
+
+void MappedFileScanner::advance(size_t n)
+{
+	_position += n;
+}
+
+const SourceBuffer* MappedFileScanner::getSource() const
+{
+	return &_source;
+}
+
+#else
+
+MappedFileScanner::MappedFileScanner(const std::string& path) :
+	MappedFileScanner(std::make_shared<FileMapping>(path), path)
+{
+}
+
+MappedFileScanner::MappedFileScanner(std::shared_ptr<const FileMapping> mapping, const std::string& path) :
+	_mapping(std::move(mapping)),
+	_path(path),
+	_input(_mapping->text()),
+	_inputSize(_mapping->textSize()),
+	_inputPosition(0),
+	_chunk(new te_char_t[chunkSize]),
+	_chunkLength(0),
+	_chunkPosition(0)
+{
+	decodeNextChunk();
+}
+
+void MappedFileScanner::decodeNextChunk()
+{
+	_chunkLength = 0;
+	_chunkPosition = 0;
+
+	size_t remaining = _inputSize - _inputPosition;
+	if (!remaining)
+		return;
+
+	// don't split a sequence, unless the input ends with a partial one
+	size_t length = remaining;
+	if (length > chunkSize) {
+		length = Transcoder::utf8CompleteLength(_input + _inputPosition, chunkSize);
+		if (!length)
+			length = chunkSize;
+	}
+
+	try {
+		_chunkLength = Transcoder::utf8ToUtf16(_input + _inputPosition, length, _chunk.get());
+	}
+	catch (const TemplateException&) {
+		throw TemplateException("Template file '" + _path + "' isn't valid UTF-8");
+	}
+	_inputPosition += length;
+}
+
+bool MappedFileScanner::atEos() const
+{
+	// a chunk is decoded as soon as the previous one is exhausted
+	return _chunkPosition == _chunkLength;
+}
+
+bool MappedFileScanner::moveNext()
+{
+	if (atEos())
+		return false;
+
+	advance(1);
+
+	return !atEos();
+}
+
+te_char_t MappedFileScanner::getChar() const
+{
+	return atEos() ? TE_TEXT('\0') : _chunk[_chunkPosition];
+}
+
+const te_char_t* MappedFileScanner::getBlock(size_t& length)
+{
+	length = _chunkLength - _chunkPosition;
+
+	return _chunk.get() + _chunkPosition;
+}
+
+void MappedFileScanner::advance(size_t n)
+{
+	_chunkPosition += n;
+	if (_chunkPosition == _chunkLength)
+		decodeNextChunk();
+}
+
+const SourceBuffer* MappedFileScanner::getSource() const
+{
+	// the chunks are reused, literals must be copied
+	return nullptr;
+}
+
+#endif
+
+TE_END_FLAVOUR
+}
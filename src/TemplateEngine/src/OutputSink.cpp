@@ -0,0 +1,114 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include "stdafx.h"
+#include "OutputSink.hpp"
+#include "Transcoder.hpp"
+#include "Exception.hpp"
+
+namespace template_engine
+{
+TE_BEGIN_FLAVOUR
+
+namespace
+{
+/** \brief The stream of each thread, a plain pointer so it is cheap to reach after every row */
+thread_local StreamedOutput* currentStream = nullptr;
+}
+
+Utf8StreamSink::Utf8StreamSink(std::ostream& stream) :
+	_stream(stream),
+	_buffer(),
+	_pending(TE_TEXT('\0'))
+{
+}
+
+#ifdef TE_USE_UTF8
+void Utf8StreamSink::write(const te_char_t* data, size_t length)
+{
+	_stream.write(data, static_cast<std::streamsize>(length));
+}
+#else
+void Utf8StreamSink::write(const te_char_t* data, size_t length)
+{
+	if (0 == length)
+		return;
+
+	_buffer.resize(3 * (length + 1));
+	size_t written = 0;
+
+	// complete a surrogate pair started by the previous write
+	if (_pending) {
+		te_char_t pair[2] = { _pending, data[0] };
+		_pending = TE_TEXT('\0');
+		written = Transcoder::utf16ToUtf8(pair, 2, &_buffer[0]);
+		++data;
+		--length;
+	}
+
+	// hold back a trailing high surrogate
+	if (length && data[length - 1] >= 0xD800 && data[length - 1] <= 0xDBFF) {
+		_pending = data[length - 1];
+		--length;
+	}
+
+	written += Transcoder::utf16ToUtf8(data, length, &_buffer[written]);
+	_stream.write(_buffer.data(), static_cast<std::streamsize>(written));
+}
+#endif
+
+StreamedOutput::StreamedOutput(OutputSink& sink, size_t chunkSize) :
+	_sink(sink),
+	_chunkSize(chunkSize),
+	_buffer(),
+	_outer(currentStream)
+{
+	_buffer.reserve(chunkSize);
+	currentStream = this;
+}
+
+StreamedOutput::~StreamedOutput()
+{
+	currentStream = _outer;
+}
+
+void StreamedOutput::finish()
+{
+	if (!_buffer.empty())
+		_sink.write(_buffer);
+	_buffer.clear();
+}
+
+void StreamedOutput::rowRendered(te_string& out)
+{
+	StreamedOutput* stream = currentStream;
+	if (stream && &out == &stream->_buffer && out.size() >= stream->_chunkSize) {
+		stream->_sink.write(out);
+		out.clear();
+	}
+}
+
+void Utf8StreamSink::flush()
+{
+	if (_pending) {
+		_pending = TE_TEXT('\0');
+		throw TemplateException("Output ended with an unpaired surrogate");
+	}
+	_stream.flush();
+}
+
+TE_END_FLAVOUR
+}
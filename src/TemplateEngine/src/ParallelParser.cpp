@@ -0,0 +1,170 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include "stdafx.h"
+
+#include <algorithm>
+#include <future>
+#include <system_error>
+#include <thread>
+#include <iterator>
+
+#include "ParallelParser.hpp"
+#include "TemplateParser.hpp"
+#include "TemplateList.hpp"
+#include "StringScanner.hpp"
+#include "CharClass.hpp"
+#include "Lexer.hpp"
+#include "Exception.hpp"
+
+namespace template_engine
+{
+TE_BEGIN_FLAVOUR
+
+namespace
+{
+/** \brief First occurrence of <code>}}</code> in [first, last), or last. */
+const te_char_t* findEndTag(const te_char_t* first, const te_char_t* last)
+{
+	for (; first + 1 < last; ++first)
+		if (TE_TEXT('}') == first[0] && TE_TEXT('}') == first[1])
+			return first;
+	return last;
+}
+}
+
+ParallelParser::ParallelParser(unsigned threads, size_t maxDepth, size_t minimumSize) :
+	_threads(threads ? threads : std::max(1u, std::thread::hardware_concurrency())),
+	_maxDepth(maxDepth),
+	_minimumSize(minimumSize)
+{
+}
+
+TemplatePtr ParallelParser::parse(const SourceBuffer& source) const
+{
+	std::vector<size_t> starts;
+	if (_threads > 1 && source.size() >= _minimumSize)
+		starts = split(source);
+
+	if (!starts.empty()) {
+		try {
+			starts.insert(starts.begin(), 0);
+			starts.push_back(source.size());
+
+			// the first region is parsed on the calling thread, while the others are parsed on threads of their own
+			std::vector<std::future<TemplatePtr>> regions;
+			for (size_t i = 1; i + 1 < starts.size(); ++i)
+				regions.push_back(std::async(std::launch::async, &ParallelParser::parseRegion, this,
+					std::cref(source), starts[i], starts[i + 1]));
+
+			std::shared_ptr<TemplateList> templ = std::static_pointer_cast<TemplateList>(parseRegion(source, starts[0], starts[1]));
+			for (std::future<TemplatePtr>& region : regions) {
+				std::shared_ptr<TemplateList> list = std::static_pointer_cast<TemplateList>(region.get());
+				templ->insert(templ->end(), std::make_move_iterator(list->begin()), std::make_move_iterator(list->end()));
+			}
+
+			return templ;
+		}
+		catch (const TemplateException&) {
+			// fall through, and let the sequential parser report the first error
+		}
+		catch (const std::system_error&) {
+			// a thread couldn't be started, parse it all on the calling thread
+		}
+	}
+
+	StringScanner scanner(source);
+	return Template::parse(scanner, _maxDepth);
+}
+
+std::vector<size_t> ParallelParser::split(const SourceBuffer& source) const
+{
+	std::vector<size_t> starts;
+
+	const te_char_t* first = source.data();
+	const te_char_t* last = first + source.size();
+	const te_char_t* p = first;
+	size_t depth = 0;
+	size_t next = source.size() / _threads;
+
+	// mirrors the lexer's simple state, see Lexer::getNextToken()
+	while ((p = Lexer::findSpecial(p, last)) != last) {
+		// \{{ is an escaped start tag
+		if (TE_TEXT('\\') == *p) {
+			p += (last - p > 2 && TE_TEXT('{') == p[1] && TE_TEXT('{') == p[2]) ? 3 : 1;
+			continue;
+		}
+
+		// a lone {, or {{ followed by something which can't start an instruction, is plain text
+		if (last - p < 2 || TE_TEXT('{') != p[1]) {
+			++p;
+			continue;
+		}
+		te_char_t ch3 = last - p > 2 ? p[2] : TE_TEXT('\0');
+
+		// {{- comment }}
+		if (TE_TEXT('-') == ch3) {
+			p = findEndTag(p + 3, last);
+			if (p == last)
+				return std::vector<size_t>();
+			p += 2;
+			continue;
+		}
+
+		char_class_t cls = classify(ch3);
+		if (char_class_t::Marker != cls && char_class_t::Name != cls) {
+			++p;
+			continue;
+		}
+
+		// {{...}}, the first } within an instruction must be the end tag
+		const te_char_t* instruction = p + 2;
+		const te_char_t* end = std::find(instruction, last, TE_TEXT('}'));
+		if (last - end < 2 || TE_TEXT('}') != end[1])
+			return std::vector<size_t>();
+		p = end + 2;
+
+		if (TE_TEXT('#') == *instruction)
+			++depth;
+		else if (TE_TEXT('/') == *instruction) {
+			// an unmatched end repeat ends the template, leave that to the sequential parser
+			if (!depth)
+				return std::vector<size_t>();
+			--depth;
+		}
+
+		// past a top level instruction is a region boundary
+		size_t offset = static_cast<size_t>(p - first);
+		if (!depth && offset >= next && offset < source.size()) {
+			starts.push_back(offset);
+			if (starts.size() + 1 == _threads)
+				break;
+			next = (starts.size() + 1) * (source.size() / _threads);
+		}
+	}
+
+	return starts;
+}
+
+TemplatePtr ParallelParser::parseRegion(const SourceBuffer& source, size_t begin, size_t end) const
+{
+	StringScanner scanner(source.slice(begin, end - begin));
+	TemplateParser parser(_maxDepth);
+	return parser.parse(scanner);
+}
+
+TE_END_FLAVOUR
+}
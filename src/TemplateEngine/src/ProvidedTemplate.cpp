@@ -0,0 +1,46 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include "stdafx.h"
+
+#include "ProvidedTemplate.hpp"
+
+namespace template_engine
+{
+TE_BEGIN_FLAVOUR
+
+ProvidedTemplate::ProvidedTemplate(const DictionaryPtr& scope, const TemplatePtr& expansion) :
+	_scope(scope),
+	_expansion(expansion)
+{
+}
+
+te_string ProvidedTemplate::render(const DictionaryPtr& /*dictionary*/, TemplateFilter filter) const
+{
+	return _expansion->render(_scope, filter);
+}
+
+void ProvidedTemplate::renderInto(const DictionaryPtr& /*dictionary*/, TemplateEscaper escaper, te_string& out) const
+{
+	_expansion->renderInto(_scope, escaper, out);
+}
+
+void ProvidedTemplate::addDependencies(TemplateDependencies& /*scope*/) const
+{
+}
+
+TE_END_FLAVOUR
+}
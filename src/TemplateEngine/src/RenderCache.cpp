@@ -0,0 +1,387 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include "stdafx.h"
+#include "RenderCache.hpp"
+#include "DictionaryList.hpp"
+#include "Exception.hpp"
+#include "Types.hpp"
+
+namespace template_engine
+{
+TE_BEGIN_FLAVOUR
+
+RenderCache::RenderCache(TemplatePtr templ, TemplateFilter filter) :
+	_templ(templ),
+	_filter(filter),
+	_root(),
+	_frames(),
+	_pass(0),
+	_rendered(0),
+	_reused(0)
+{
+}
+
+RenderCache::~RenderCache()
+{
+}
+
+te_string RenderCache::render(const ContextPtr context)
+{
+	update(context);
+	return _root->output;
+}
+
+std::vector<OutputEdit> RenderCache::renderEdits(const ContextPtr context)
+{
+	std::shared_ptr<const Memo> previous = _root;
+	update(context);
+
+	std::vector<OutputEdit> edits;
+	size_t position = 0;
+	if (previous)
+		diff(*previous, *_root, position, edits);
+	else
+		addEdit(edits, position, 0, _root->output.data(), _root->output.size());
+
+	return edits;
+}
+
+std::vector<OutputEdit> RenderCache::diff(TemplatePtr templ, const ContextPtr context,
+	const DictionaryPtr& oldDictionary, const DictionaryPtr& newDictionary, TemplateFilter filter)
+{
+	RenderCache cache(templ, filter);
+
+	context->setDictionary(oldDictionary);
+	cache.update(context);
+	context->setDictionary(newDictionary);
+	return cache.renderEdits(context);
+}
+
+void RenderCache::apply(te_string& text, const std::vector<OutputEdit>& edits)
+{
+	for (const OutputEdit& edit : edits) {
+		if (edit.offset > text.size() || edit.removed > text.size() - edit.offset)
+			throw TemplateException("The edit is outside of the text");
+
+		text.replace(edit.offset, edit.removed, edit.inserted);
+	}
+}
+
+void RenderCache::update(const ContextPtr& context)
+{
+	const DictionaryPtr& dictionary = context->getDictionary();
+	RenderScope scope;
+
+	++_pass;
+	_rendered = 0;
+	_reused = 0;
+
+	// a memo of another dictionary is never reused
+	const Memo* previous = _root && _root->dictionary == dictionary ? _root.get() : nullptr;
+	if (previous && isValid(*previous)) {
+		++_reused;
+		return;
+	}
+
+	std::shared_ptr<Memo> memo = std::make_shared<Memo>();
+	memo->dictionary = dictionary;
+	_frames.push_back(Frame{ memo.get(), previous, nullptr, nullptr });
+
+	try {
+		_templ->renderCached(*this, dictionary, memo->output);
+	}
+	catch (...) {
+		_frames.clear();
+		throw;
+	}
+
+	_frames.clear();
+	_root = memo;
+	++_rendered;
+}
+
+void RenderCache::clear()
+{
+	_root.reset();
+}
+
+void RenderCache::expand(const DictionaryPtr& dictionary, const te_string& name, uint8_t scopeWalk, const ValueFormat& format,
+	const FilterChain& filters, te_string& out)
+{
+	DictionaryPtr currentDictionary = dictionary;
+	// handle scoping
+	for (uint8_t i = 0; i < scopeWalk; i++) {
+		currentDictionary = currentDictionary->getParent();
+		if (nullptr == currentDictionary)
+			throw TemplateException("Access to non existing parent scope");
+	}
+
+	DictionaryPtr scope = lookup(currentDictionary, name);
+	const TypedValue* typed = nullptr;
+	const te_string* value = scope ? scope->findValue(name, typed) : nullptr;
+	if (!value && !typed)
+		throw TemplateException("The name '" + to_utf8(name) + "' could not be found");
+
+	// a provided value may differ from one render to the next
+	if (scope->isProvided(name))
+		untracked();
+
+	te_string formatted;
+	if (typed || !format.isDefault()) {
+		if (typed)
+			format.format(formatted, *typed);
+		else
+			format.format(formatted, value->data(), value->size());
+		value = &formatted;
+	}
+
+	if (_filter)
+		out += _filter(filters.empty() ? *value : filters.apply(*value));
+	else
+		filters.apply(out, value->data(), value->size());
+}
+
+const DictionaryListPtr& RenderCache::findList(const DictionaryPtr& dictionary, const te_string& name)
+{
+	DictionaryPtr scope = lookup(dictionary, name);
+	if (!scope || !scope->isList(name))
+		throw TemplateException("The list '" + to_utf8(name) + "' could not be found");
+
+	// the list is kept alive by the scope, which is kept alive by the rows being rendered
+	const DictionaryListPtr& list = scope->getList(name);
+	_frames.back().memo->reads.push_back(Read{ list, nullptr, list->getVersion(), 0 });
+
+	return list;
+}
+
+void RenderCache::untracked()
+{
+	_frames.back().memo->untracked = true;
+}
+
+void RenderCache::beginRepeat(const Template& repeat)
+{
+	Frame& frame = _frames.back();
+	std::vector<RepeatMemo>& repeats = frame.memo->repeats;
+
+	repeats.push_back(RepeatMemo{ &repeat, frame.memo->output.size(), 0, {}, {} });
+	frame.repeat = &repeats.back();
+
+	// the repeats of a template are always rendered in the same order
+	frame.previousRepeat = nullptr;
+	if (frame.previous && repeats.size() <= frame.previous->repeats.size()) {
+		const RepeatMemo& previous = frame.previous->repeats[repeats.size() - 1];
+		if (previous.repeat == &repeat)
+			frame.previousRepeat = &previous;
+	}
+}
+
+void RenderCache::renderRow(const Template& body, const DictionaryPtr& row, te_string& out)
+{
+	const Memo* previous = nullptr;
+	if (_frames.back().previousRepeat) {
+		const RepeatMemo& rows = *_frames.back().previousRepeat;
+		auto it = rows.index.find(row.get());
+		if (it != rows.index.end()) {
+			const std::shared_ptr<const Memo>& memo = rows.rows[it->second];
+			if (isValid(*memo)) {
+				out += memo->output;
+				addRow(*_frames.back().repeat, memo);
+				++_reused;
+				return;
+			}
+
+			// the nested rows may still be reused
+			previous = memo.get();
+		}
+	}
+
+	std::shared_ptr<Memo> memo = std::make_shared<Memo>();
+	memo->dictionary = row;
+
+	_frames.push_back(Frame{ memo.get(), previous, nullptr, nullptr });
+	body.renderCached(*this, row, memo->output);
+	_frames.pop_back();
+
+	out += memo->output;
+	addRow(*_frames.back().repeat, memo);
+	++_rendered;
+}
+
+void RenderCache::endRepeat()
+{
+	Frame& frame = _frames.back();
+	frame.repeat->end = frame.memo->output.size();
+	frame.repeat = nullptr;
+	frame.previousRepeat = nullptr;
+}
+
+bool RenderCache::isValid(const Memo& memo) const
+{
+	if (memo.checked == _pass)
+		return memo.valid;
+
+	memo.checked = _pass;
+	memo.valid = false;
+
+	if (memo.untracked)
+		return false;
+
+	for (const Read& read : memo.reads) {
+		if (read.dictionary->getVersion() == read.dictionaryVersion)
+			continue;
+
+		// something else in the dictionary changed
+		if (!read.name || read.dictionary->getVersion(*read.name) != read.version)
+			return false;
+	}
+
+	for (const RepeatMemo& repeat : memo.repeats) {
+		for (const std::shared_ptr<const Memo>& row : repeat.rows) {
+			if (!isValid(*row))
+				return false;
+		}
+	}
+
+	memo.valid = true;
+	return true;
+}
+
+DictionaryPtr RenderCache::lookup(const DictionaryPtr& dictionary, const te_string& name)
+{
+	std::vector<Read>& reads = _frames.back().memo->reads;
+
+	for (DictionaryPtr scope = dictionary; scope; scope = scope->getParent()) {
+		uint64_t version = scope->getVersion(name);
+		reads.push_back(Read{ scope, &name, scope->getVersion(), version });
+		if (version)
+			return scope;
+	}
+
+	return nullptr;
+}
+
+void RenderCache::addRow(RepeatMemo& repeat, const std::shared_ptr<const Memo>& row)
+{
+	repeat.index.insert({ row->dictionary.get(), repeat.rows.size() });
+	repeat.rows.push_back(row);
+}
+
+void RenderCache::diff(const Memo& before, const Memo& after, size_t& position, std::vector<OutputEdit>& edits) const
+{
+	if (&before == &after) {
+		position += after.output.size();
+		return;
+	}
+
+	// both are rendered from the same template, so they have the same repeats
+	size_t repeats = after.repeats.size();
+	if (before.repeats.size() != repeats) {
+		addEdit(edits, position, before.output.size(), after.output.data(), after.output.size());
+		return;
+	}
+
+	size_t beforeText = 0;
+	size_t afterText = 0;
+	for (size_t i = 0; i < repeats; ++i) {
+		const RepeatMemo& beforeRepeat = before.repeats[i];
+		const RepeatMemo& afterRepeat = after.repeats[i];
+
+		diffText(before.output, beforeText, beforeRepeat.begin, after.output, afterText, afterRepeat.begin, position, edits);
+		diffRows(beforeRepeat, afterRepeat, position, edits);
+
+		beforeText = beforeRepeat.end;
+		afterText = afterRepeat.end;
+	}
+
+	diffText(before.output, beforeText, before.output.size(), after.output, afterText, after.output.size(), position, edits);
+}
+
+void RenderCache::diffRows(const RepeatMemo& before, const RepeatMemo& after, size_t& position, std::vector<OutputEdit>& edits) const
+{
+	size_t i = 0;
+	size_t j = 0;
+
+	while (i < before.rows.size() || j < after.rows.size()) {
+		const Memo* beforeRow = i < before.rows.size() ? before.rows[i].get() : nullptr;
+		const Memo* afterRow = j < after.rows.size() ? after.rows[j].get() : nullptr;
+
+		if (afterRow) {
+			// a row which wasn't there, or which has been passed because it was moved
+			auto it = before.index.find(afterRow->dictionary.get());
+			if (it == before.index.end() || it->second < i) {
+				// replacing a row which is gone too
+				if (beforeRow && !after.index.count(beforeRow->dictionary.get())) {
+					diff(*beforeRow, *afterRow, position, edits);
+					++i;
+				}
+				else
+					addEdit(edits, position, 0, afterRow->output.data(), afterRow->output.size());
+				++j;
+				continue;
+			}
+		}
+
+		if (!afterRow || beforeRow->dictionary != afterRow->dictionary) {
+			addEdit(edits, position, beforeRow->output.size(), nullptr, 0);
+			++i;
+			continue;
+		}
+
+		diff(*beforeRow, *afterRow, position, edits);
+		++i;
+		++j;
+	}
+}
+
+void RenderCache::diffText(const te_string& before, size_t beforeBegin, size_t beforeEnd,
+	const te_string& after, size_t afterBegin, size_t afterEnd, size_t& position, std::vector<OutputEdit>& edits)
+{
+	// only the part between the common prefix and suffix is changed
+	while (beforeBegin < beforeEnd && afterBegin < afterEnd && before[beforeBegin] == after[afterBegin]) {
+		++beforeBegin;
+		++afterBegin;
+		++position;
+	}
+
+	size_t suffix = 0;
+	while (beforeBegin < beforeEnd && afterBegin < afterEnd && before[beforeEnd - 1] == after[afterEnd - 1]) {
+		--beforeEnd;
+		--afterEnd;
+		++suffix;
+	}
+
+	if (beforeBegin != beforeEnd || afterBegin != afterEnd)
+		addEdit(edits, position, beforeEnd - beforeBegin, after.data() + afterBegin, afterEnd - afterBegin);
+
+	position += suffix;
+}
+
+void RenderCache::addEdit(std::vector<OutputEdit>& edits, size_t& position, size_t removed, const te_char_t* inserted, size_t length)
+{
+	if (!edits.empty() && edits.back().offset + edits.back().inserted.size() == position) {
+		edits.back().removed += removed;
+		edits.back().inserted.append(inserted, length);
+	}
+	else
+		edits.push_back(OutputEdit{ position, removed, te_string(inserted, length) });
+
+	position += length;
+}
+
+TE_END_FLAVOUR
+}
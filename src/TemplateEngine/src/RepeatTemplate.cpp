@@ -17,11 +17,16 @@
 #include "stdafx.h"
 #include "RepeatTemplate.hpp"
 #include "DictionaryList.hpp"
+#include "TemplateList.hpp"
+#include "TemplateSpecializer.hpp"
+#include "TemplateImage.hpp"
+#include "RenderCache.hpp"
 #include "Exception.hpp"
 #include "Types.hpp"
 
 namespace template_engine
 {
+TE_BEGIN_FLAVOUR
 
 RepeatTemplate::RepeatTemplate(te_string name, std::shared_ptr<Template> templ) :
 	_name(name),
@@ -34,24 +39,121 @@ te_string RepeatTemplate::render(const DictionaryPtr& dictionary, TemplateFilter
 	te_string result;
 
 	if (!(dictionary->exists(_name) && dictionary->isList(_name))) {
-		te_converter converter;
-
-		throw TemplateException("The list '" + converter.to_bytes(_name) + "' could not be found");
+		throw TemplateException("The list '" + to_utf8(_name) + "' could not be found");
 	}
 
 	DictionaryListPtr list = dictionary->getList(_name);
 
-	// assign the current dictionary as the parent scope
-	list->setParent(dictionary);
+	// the current dictionary is the parent scope of the list
+	ListScope scope(*list, dictionary);
+
+	list->forEachRow([&](const DictionaryPtr& row) {
+		result += _templ->render(row, filter);
+	});
+
+	return result;
+}
+
+void RepeatTemplate::renderInto(const DictionaryPtr& dictionary, TemplateEscaper escaper, te_string& out) const
+{
+	if (!(dictionary->exists(_name) && dictionary->isList(_name))) {
+		throw TemplateException("The list '" + to_utf8(_name) + "' could not be found");
+	}
+
+	const DictionaryListPtr& list = dictionary->getList(_name);
+
+	// the current dictionary is the parent scope of the list
+	ListScope scope(*list, dictionary);
+
+	list->forEachRow([&](const DictionaryPtr& row) {
+		_templ->renderInto(row, escaper, out);
+		StreamedOutput::rowRendered(out);
+	});
+}
+
+TemplatePtr RepeatTemplate::optimize(const TemplateOptimizer& optimizer) const
+{
+	TemplatePtr templ = _templ->optimize(optimizer);
+	if (!templ)
+		return nullptr;
+
+	return std::make_shared<RepeatTemplate>(_name, templ);
+}
+
+TemplatePtr RepeatTemplate::specialize(TemplateSpecializer& specializer) const
+{
+	const Dictionary* scope = specializer.find(_name, 0);
+	if (!scope) {
+		specializer.setKept(specializer.getKept() + 1);
+		return nullptr;
+	}
+
+	if (!scope->isList(_name))
+		throw TemplateException("The list '" + to_utf8(_name) + "' could not be found");
+
+	const DictionaryListPtr& list = scope->getList(_name);
+	size_t kept = specializer.getKept();
+
+	// the rows of a generated list are specialized as they are produced now
+	std::vector<DictionaryPtr> generated;
+	if (list->isGenerated())
+		list->forEachRow([&](const DictionaryPtr& row) { generated.push_back(row); });
+	const std::vector<DictionaryPtr>& rows = list->isGenerated() ? generated : list->_dictionaries;
+
+	std::shared_ptr<TemplateList> result = std::make_shared<TemplateList>();
+	for (const DictionaryPtr& item : rows) {
+		specializer.enterScope(list.get(), item.get());
+		TemplatePtr templ = _templ->specialize(specializer);
+		specializer.leaveScope();
 
-	list->resetCursor();
+		// a repeat kept in the body must be rendered in the scope of the item
+		if (specializer.getKept() != kept) {
+			specializer.setKept(kept + 1);
+			return nullptr;
+		}
 
-	for (size_t i = 0; i < list->size(); i++) {
-		result += _templ->render(list->getCurrent(), filter);
-		list->advanceCursor();
+		result->push_back(templ ? templ : _templ);
 	}
 
 	return result;
 }
 
-}
\ No newline at end of file
+void RepeatTemplate::write(TemplateWriter& writer) const
+{
+	writer.beginRepeat(_name);
+	writer.write(*_templ);
+	writer.endRepeat();
+}
+
+void RepeatTemplate::renderCached(RenderCache& cache, const DictionaryPtr& dictionary, te_string& out) const
+{
+	const DictionaryListPtr& list = cache.findList(dictionary, _name);
+
+	// the current dictionary is the parent scope of the list
+	ListScope scope(*list, dictionary);
+
+	// generated rows are new every time, and can't be compared with those of the previous render
+	if (list->isGenerated()) {
+		cache.untracked();
+		list->forEachRow([&](const DictionaryPtr& row) {
+			if (cache.getFilter())
+				out += _templ->render(row, cache.getFilter());
+			else
+				_templ->renderInto(row, nullptr, out);
+		});
+		return;
+	}
+
+	cache.beginRepeat(*this);
+	for (const DictionaryPtr& row : list->_dictionaries)
+		cache.renderRow(*_templ, row, out);
+	cache.endRepeat();
+}
+
+void RepeatTemplate::addDependencies(TemplateDependencies& scope) const
+{
+	_templ->addDependencies(scope.lists[_name]);
+}
+
+TE_END_FLAVOUR
+}
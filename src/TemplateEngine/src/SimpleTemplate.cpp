@@ -15,21 +15,56 @@
 // You should have received a copy of the GNU Lesser General Public
 // License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
 #include "stdafx.h"
+#include <utility>
+
 #include "SimpleTemplate.hpp"
+#include "TemplateImage.hpp"
 
 
 namespace template_engine
 {
+TE_BEGIN_FLAVOUR
 
 SimpleTemplate::SimpleTemplate(te_string value) :
-	_value(value)
+	_value(std::move(value)),
+	_source(),
+	_offset(0),
+	_length(0)
+{
+}
+
+SimpleTemplate::SimpleTemplate(const SourceBuffer& source, size_t offset, size_t length) :
+	_value(),
+	_source(source),
+	_offset(offset),
+	_length(length)
 {
 }
 
 
 te_string SimpleTemplate::render(const DictionaryPtr& /*dictionary*/, TemplateFilter /*filter*/) const
 {
+	if (_length)
+		return te_string(_source.data() + _offset, _length);
+
 	return _value;
 }
 
-}
\ No newline at end of file
+void SimpleTemplate::renderInto(const DictionaryPtr& /*dictionary*/, TemplateEscaper /*escaper*/, te_string& out) const
+{
+	if (_length)
+		out.append(_source.data() + _offset, _length);
+	else
+		out += _value;
+}
+
+void SimpleTemplate::write(TemplateWriter& writer) const
+{
+	if (_length)
+		writer.literal(_source.data() + _offset, _length);
+	else
+		writer.literal(_value.data(), _value.size());
+}
+
+TE_END_FLAVOUR
+}
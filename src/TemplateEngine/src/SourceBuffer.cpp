@@ -0,0 +1,75 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include "stdafx.h"
+
+#include <utility>
+
+#include "SourceBuffer.hpp"
+
+namespace template_engine
+{
+TE_BEGIN_FLAVOUR
+
+namespace
+{
+const te_char_t emptyText[] = TE_TEXT("");
+}
+
+SourceBuffer::SourceBuffer() :
+	_data(emptyText),
+	_size(0),
+	_owner()
+{
+}
+
+SourceBuffer::SourceBuffer(te_string&& text)
+{
+	std::shared_ptr<te_string> owner = std::make_shared<te_string>(std::move(text));
+	_data = owner->data();
+	_size = owner->size();
+	_owner = std::move(owner);
+}
+
+SourceBuffer::SourceBuffer(const te_string& text) :
+	SourceBuffer(te_string(text))
+{
+}
+
+SourceBuffer::SourceBuffer(const te_char_t* data, size_t size, std::shared_ptr<const void> owner) :
+	_data(data),
+	_size(size),
+	_owner(std::move(owner))
+{
+}
+
+SourceBuffer SourceBuffer::borrow(const te_char_t* data, size_t size)
+{
+	return SourceBuffer(data, size, nullptr);
+}
+
+SourceBuffer SourceBuffer::borrow(const te_string& text)
+{
+	return borrow(text.data(), text.size());
+}
+
+SourceBuffer SourceBuffer::slice(size_t offset, size_t size) const
+{
+	return SourceBuffer(_data + offset, size, _owner);
+}
+
+TE_END_FLAVOUR
+}
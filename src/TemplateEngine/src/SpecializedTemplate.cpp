@@ -0,0 +1,86 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include "stdafx.h"
+
+#include "SpecializedTemplate.hpp"
+
+namespace template_engine
+{
+TE_BEGIN_FLAVOUR
+
+SpecializedTemplate::SpecializedTemplate(const DictionaryPtr& known, const TemplatePtr& templ) :
+	_known(known),
+	_templ(templ)
+{
+}
+
+DictionaryPtr SpecializedTemplate::overlay(const DictionaryPtr& dictionary) const
+{
+	// dictionary -> known -> the parent scope of dictionary, in a scope of its own
+	// so neither the shared known values nor the dictionary are changed
+	DictionaryPtr scope = std::make_shared<Dictionary>();
+	scope->addLayer(dictionary);
+	scope->addLayer(_known);
+	scope->setParent(dictionary->getParent());
+	return scope;
+}
+
+te_string SpecializedTemplate::render(const DictionaryPtr& dictionary, TemplateFilter filter) const
+{
+	if (dictionary == _known)
+		return _templ->render(dictionary, filter);
+
+	return _templ->render(overlay(dictionary), filter);
+}
+
+void SpecializedTemplate::renderInto(const DictionaryPtr& dictionary, TemplateEscaper escaper, te_string& out) const
+{
+	if (dictionary == _known) {
+		_templ->renderInto(dictionary, escaper, out);
+		return;
+	}
+
+	_templ->renderInto(overlay(dictionary), escaper, out);
+}
+
+TemplatePtr SpecializedTemplate::optimize(const TemplateOptimizer& optimizer) const
+{
+	TemplatePtr templ = _templ->optimize(optimizer);
+	if (!templ)
+		return nullptr;
+
+	return std::make_shared<SpecializedTemplate>(_known, templ);
+}
+
+void SpecializedTemplate::addDependencies(TemplateDependencies& scope) const
+{
+	TemplateDependencies residual;
+	_templ->addDependencies(residual);
+
+	// a name which is known is never looked up in the rendering dictionary
+	for (auto it = residual.values.begin(); it != residual.values.end();) {
+		if (!it->second && _known->existsLocal(it->first))
+			it = residual.values.erase(it);
+		else
+			++it;
+	}
+
+	scope.merge(residual);
+}
+
+TE_END_FLAVOUR
+}
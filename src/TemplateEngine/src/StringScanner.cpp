@@ -19,10 +19,11 @@
 
 namespace template_engine
 {
+TE_BEGIN_FLAVOUR
 
 bool StringScanner::atEos() const
 {
-	return _templateIterator == _template.end();
+	return _position == _source.size();
 }
 
 bool StringScanner::moveNext()
@@ -30,14 +31,32 @@ bool StringScanner::moveNext()
 	if(atEos())
 		return false;
 	
-	_templateIterator++;
+	_position++;
 
 	return !atEos();
 }
 
 te_char_t StringScanner::getChar() const
 {
-	return *_templateIterator;
+	return atEos() ? TE_TEXT('\0') : _source.data()[_position];
 }
 
+const te_char_t* StringScanner::getBlock(size_t& length)
+{
+	length = _source.size() - _position;
+
+	return _source.data() + _position;
+}
+
+void StringScanner::advance(size_t n)
+{
+	_position += n;
+}
+
+const SourceBuffer* StringScanner::getSource() const
+{
+	return &_source;
+}
+
+TE_END_FLAVOUR
 }
\ No newline at end of file
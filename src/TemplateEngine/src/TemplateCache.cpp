@@ -0,0 +1,119 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include "stdafx.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <random>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+#include "TemplateCache.hpp"
+#include "TemplateImage.hpp"
+#include "MappedFileScanner.hpp"
+#include "FileMapping.hpp"
+#include "Transcoder.hpp"
+#include "Exception.hpp"
+
+namespace template_engine
+{
+TE_BEGIN_FLAVOUR
+
+namespace
+{
+
+/** \brief 64 bit FNV-1a hash */
+uint64_t hash(uint64_t value, const char* data, size_t size)
+{
+	for (size_t i = 0; i < size; i++) {
+		value ^= static_cast<unsigned char>(data[i]);
+		value *= 0x100000001b3ull;
+	}
+
+	return value;
+}
+
+}
+
+TemplateCache::TemplateCache(const std::string& directory) :
+	_directory(directory)
+{
+#ifdef _WIN32
+	int result = _wmkdir(reinterpret_cast<const wchar_t*>(Transcoder::utf8ToUtf16(directory).c_str()));
+#else
+	int result = ::mkdir(directory.c_str(), 0777);
+#endif
+	if (result != 0 && errno != EEXIST)
+		throw TemplateException("Unable to create the template cache directory '" + directory + "'");
+}
+
+TemplatePtr TemplateCache::load(const std::string& path) const
+{
+	// the key and the template are taken from the same contents, even if the file is rewritten meanwhile
+	std::shared_ptr<const FileMapping> file = std::make_shared<FileMapping>(path, FileMapping::smallFileSize);
+	std::string image = getImagePath(*file);
+
+	// a missing or damaged image is simply written again
+	try {
+		return TemplateImage::load(image);
+	}
+	catch (const TemplateException&) {
+	}
+
+	MappedFileScanner scanner(file, path);
+	TemplatePtr templ = Template::parse(scanner);
+
+	static std::atomic<unsigned> sequence(0);
+	std::string temporary = image + "." + std::to_string(std::random_device()()) + "." + std::to_string(++sequence) + ".tmp";
+	TemplateImage::save(templ, temporary);
+#ifdef _WIN32
+	std::remove(image.c_str());
+#endif
+	if (std::rename(temporary.c_str(), image.c_str()) != 0) {
+		std::remove(temporary.c_str());
+		throw TemplateException("Unable to write template image '" + image + "'");
+	}
+
+	return templ;
+}
+
+std::string TemplateCache::getImagePath(const std::string& path) const
+{
+	FileMapping file(path, FileMapping::smallFileSize);
+	return getImagePath(file);
+}
+
+std::string TemplateCache::getImagePath(const FileMapping& file) const
+{
+	// images of other versions and flavours have keys of their own
+	const uint64_t flavour[] = { TemplateImage::formatVersion, sizeof(te_char_t) };
+	uint64_t key = hash(0xcbf29ce484222325ull, reinterpret_cast<const char*>(flavour), sizeof(flavour));
+	key = hash(key, file.data(), file.size());
+
+	char name[17];
+	std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+	return _directory + "/" + name + ".tei";
+}
+
+TE_END_FLAVOUR
+}
@@ -0,0 +1,339 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include "stdafx.h"
+
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+#include "TemplateImage.hpp"
+#include "TemplateList.hpp"
+#include "SimpleTemplate.hpp"
+#include "ExpansionTemplate.hpp"
+#include "RepeatTemplate.hpp"
+#include "FileMapping.hpp"
+#include "Exception.hpp"
+
+namespace template_engine
+{
+TE_BEGIN_FLAVOUR
+
+namespace
+{
+
+const char magic[4] = { 'T', 'E', 'I', 'M' };
+const uint32_t byteOrderMark = 0x01020304;
+
+/** \brief The instructions of the instruction stream, followed by their operands */
+enum class op_t : uint32_t {
+	Literal = 1,    ///< offset and length in the literal pool
+	Expansion,      ///< name index and scope walk
+	Repeat,         ///< name index, the body follows up to the matching End
+	End,            ///< no operands
+	FilteredExpansion,  ///< name index, scope walk, number of filters and the name index of each filter
+	FormattedExpansion  ///< name index, scope walk, name index of the format specifier, then as FilteredExpansion
+};
+
+/** \brief Layout of the fixed size header, all fields are in the byte order of the writer */
+struct Header
+{
+	char magic[4];
+	uint16_t version;
+	uint8_t codeUnitSize;
+	uint8_t reserved;
+	uint32_t byteOrder;
+	uint32_t codeCount;     ///< number of words in the instruction stream
+	uint32_t nameCount;     ///< number of entries in the name table
+	uint32_t poolSize;      ///< number of code units in the literal pool
+};
+
+/** \brief The literal pool starts at the first 8 byte boundary after the name table */
+inline uint64_t poolOffset(uint64_t codeCount, uint64_t nameCount)
+{
+	uint64_t offset = sizeof(Header) + 4 * codeCount + 8 * nameCount;
+	return (offset + 7) & ~uint64_t(7);
+}
+
+inline uint32_t readWord(const char* data)
+{
+	uint32_t word;
+	std::memcpy(&word, data, sizeof(word));
+	return word;
+}
+
+[[noreturn]] void invalidImage()
+{
+	throw TemplateException("The template image is invalid");
+}
+
+}
+
+std::string TemplateImage::save(const TemplatePtr& templ)
+{
+	TemplateWriter writer;
+	writer.write(*templ);
+	return writer.finish();
+}
+
+void TemplateImage::save(const TemplatePtr& templ, const std::string& path)
+{
+	std::string image = save(templ);
+
+	std::ofstream file(path.c_str(), std::ios::binary | std::ios::trunc);
+	file.write(image.data(), static_cast<std::streamsize>(image.size()));
+	file.close();
+	if (!file)
+		throw TemplateException("Unable to write template image '" + path + "'");
+}
+
+TemplatePtr TemplateImage::load(const std::string& path)
+{
+	std::shared_ptr<const FileMapping> mapping = std::make_shared<FileMapping>(path, FileMapping::smallFileSize);
+	return load(mapping->data(), mapping->size(), mapping);
+}
+
+TemplatePtr TemplateImage::load(const char* data, size_t size, std::shared_ptr<const void> owner)
+{
+	Header header;
+	if (size < sizeof(header))
+		invalidImage();
+	std::memcpy(&header, data, sizeof(header));
+
+	if (std::memcmp(header.magic, magic, sizeof(magic)) != 0)
+		invalidImage();
+	if (header.version != formatVersion || header.codeUnitSize != sizeof(te_char_t) || header.byteOrder != byteOrderMark)
+		throw TemplateException("The template image was written by an incompatible version or platform");
+
+	uint64_t pool = poolOffset(header.codeCount, header.nameCount);
+	if (pool + uint64_t(header.poolSize) * sizeof(te_char_t) > size)
+		invalidImage();
+
+	// the literals refer to the pool, unless it has to be copied
+	SourceBuffer source;
+	const te_char_t* poolData = reinterpret_cast<const te_char_t*>(data + pool);
+	if (owner && reinterpret_cast<uintptr_t>(poolData) % alignof(te_char_t) == 0)
+		source = SourceBuffer(poolData, header.poolSize, owner);
+	else {
+		te_string copy(header.poolSize, TE_TEXT('\0'));
+		std::memcpy(&copy[0], data + pool, header.poolSize * sizeof(te_char_t));
+		source = SourceBuffer(std::move(copy));
+	}
+
+	const char* nameTable = data + sizeof(Header) + 4 * uint64_t(header.codeCount);
+	std::vector<te_string> names;
+	names.reserve(header.nameCount);
+	for (uint32_t i = 0; i < header.nameCount; i++) {
+		uint32_t offset = readWord(nameTable + 8 * i);
+		uint32_t length = readWord(nameTable + 8 * i + 4);
+		if (offset > header.poolSize || length > header.poolSize - offset)
+			invalidImage();
+		names.emplace_back(source.data() + offset, length);
+	}
+
+	// the lists of the repeats being read, and the name index of each repeat
+	std::vector<std::pair<std::shared_ptr<TemplateList>, uint32_t>> stack;
+	stack.emplace_back(std::make_shared<TemplateList>(), 0);
+
+	const char* code = data + sizeof(Header);
+	uint32_t count = header.codeCount;
+	uint32_t i = 0;
+	auto operand = [&]() {
+		if (i >= count)
+			invalidImage();
+		return readWord(code + 4 * i++);
+	};
+
+	while (i < count) {
+		op_t op = static_cast<op_t>(operand());
+		switch (op) {
+		case op_t::Literal: {
+			uint32_t offset = operand();
+			uint32_t length = operand();
+			if (offset > header.poolSize || length > header.poolSize - offset)
+				invalidImage();
+			stack.back().first->push_back(std::make_shared<SimpleTemplate>(source, offset, length));
+			break;
+		}
+		case op_t::Expansion: {
+			uint32_t name = operand();
+			uint32_t scopeWalk = operand();
+			if (name >= names.size() || scopeWalk > std::numeric_limits<uint8_t>::max())
+				invalidImage();
+			stack.back().first->push_back(std::make_shared<ExpansionTemplate>(names[name], static_cast<uint8_t>(scopeWalk)));
+			break;
+		}
+		case op_t::FilteredExpansion:
+		case op_t::FormattedExpansion: {
+			uint32_t name = operand();
+			uint32_t scopeWalk = operand();
+			uint32_t spec = op == op_t::FormattedExpansion ? operand() : 0;
+			uint32_t filterCount = operand();
+			if (name >= names.size() || scopeWalk > std::numeric_limits<uint8_t>::max() || spec >= names.size())
+				invalidImage();
+			ValueFormat format = op == op_t::FormattedExpansion ? ValueFormat(names[spec]) : ValueFormat();
+			FilterChain filters;
+			for (uint32_t f = 0; f < filterCount; f++) {
+				uint32_t filter = operand();
+				if (filter >= names.size())
+					invalidImage();
+				filters.push_back(names[filter]);
+			}
+			stack.back().first->push_back(std::make_shared<ExpansionTemplate>(names[name], static_cast<uint8_t>(scopeWalk),
+				std::move(format), std::move(filters)));
+			break;
+		}
+		case op_t::Repeat: {
+			uint32_t name = operand();
+			if (name >= names.size())
+				invalidImage();
+			stack.emplace_back(std::make_shared<TemplateList>(), name);
+			break;
+		}
+		case op_t::End: {
+			if (stack.size() < 2)
+				invalidImage();
+			std::pair<std::shared_ptr<TemplateList>, uint32_t> repeat = std::move(stack.back());
+			stack.pop_back();
+			stack.back().first->push_back(std::make_shared<RepeatTemplate>(names[repeat.second], repeat.first));
+			break;
+		}
+		default:
+			invalidImage();
+		}
+	}
+
+	if (stack.size() != 1)
+		invalidImage();
+
+	return stack.front().first;
+}
+
+TemplateWriter::TemplateWriter() :
+	_code(),
+	_names(),
+	_nameIndex(),
+	_pool(),
+	_lastLiteral(noLiteral)
+{
+}
+
+void TemplateWriter::write(const Template& templ)
+{
+	templ.write(*this);
+}
+
+void TemplateWriter::literal(const te_char_t* data, size_t length)
+{
+	if (!length)
+		return;
+
+	uint32_t offset = append(data, length);
+
+	// the previous instruction is a literal, which ends where this one starts
+	if (_lastLiteral != noLiteral) {
+		_code[_lastLiteral + 2] += static_cast<uint32_t>(length);
+		return;
+	}
+
+	_lastLiteral = _code.size();
+	_code.insert(_code.end(), { static_cast<uint32_t>(op_t::Literal), offset, static_cast<uint32_t>(length) });
+}
+
+void TemplateWriter::expansion(const te_string& name, uint8_t scopeWalk, const ValueFormat& format, const FilterChain& filters)
+{
+	_lastLiteral = noLiteral;
+	if (format.isDefault() && filters.empty()) {
+		_code.insert(_code.end(), { static_cast<uint32_t>(op_t::Expansion), intern(name), scopeWalk });
+		return;
+	}
+
+	const std::vector<te_string>& filterNames = filters.getNames();
+	if (format.isDefault())
+		_code.insert(_code.end(), { static_cast<uint32_t>(op_t::FilteredExpansion), intern(name), scopeWalk });
+	else
+		_code.insert(_code.end(), { static_cast<uint32_t>(op_t::FormattedExpansion), intern(name), scopeWalk, intern(format.getSpec()) });
+	_code.push_back(static_cast<uint32_t>(filterNames.size()));
+	for (const te_string& filter : filterNames)
+		_code.push_back(intern(filter));
+}
+
+void TemplateWriter::beginRepeat(const te_string& name)
+{
+	_lastLiteral = noLiteral;
+	_code.insert(_code.end(), { static_cast<uint32_t>(op_t::Repeat), intern(name) });
+}
+
+void TemplateWriter::endRepeat()
+{
+	_lastLiteral = noLiteral;
+	_code.push_back(static_cast<uint32_t>(op_t::End));
+}
+
+std::string TemplateWriter::finish() const
+{
+	Header header;
+	std::memcpy(header.magic, magic, sizeof(magic));
+	header.version = TemplateImage::formatVersion;
+	header.codeUnitSize = sizeof(te_char_t);
+	header.reserved = 0;
+	header.byteOrder = byteOrderMark;
+	header.codeCount = static_cast<uint32_t>(_code.size());
+	header.nameCount = static_cast<uint32_t>(_names.size() / 2);
+	header.poolSize = static_cast<uint32_t>(_pool.size());
+
+	if (_code.size() > std::numeric_limits<uint32_t>::max())
+		throw TemplateException("The template is too large to be stored as an image");
+
+	uint64_t pool = poolOffset(header.codeCount, header.nameCount);
+	std::string image(static_cast<size_t>(pool) + _pool.size() * sizeof(te_char_t), '\0');
+	char* out = &image[0];
+	std::memcpy(out, &header, sizeof(header));
+	if (!_code.empty())
+		std::memcpy(out + sizeof(header), _code.data(), _code.size() * 4);
+	if (!_names.empty())
+		std::memcpy(out + sizeof(header) + _code.size() * 4, _names.data(), _names.size() * 4);
+	if (!_pool.empty())
+		std::memcpy(out + pool, _pool.data(), _pool.size() * sizeof(te_char_t));
+
+	return image;
+}
+
+uint32_t TemplateWriter::intern(const te_string& name)
+{
+	std::unordered_map<te_string, uint32_t>::const_iterator it = _nameIndex.find(name);
+	if (it != _nameIndex.end())
+		return it->second;
+
+	uint32_t index = static_cast<uint32_t>(_names.size() / 2);
+	_names.push_back(append(name.data(), name.size()));
+	_names.push_back(static_cast<uint32_t>(name.size()));
+	_nameIndex.emplace(name, index);
+	return index;
+}
+
+uint32_t TemplateWriter::append(const te_char_t* data, size_t length)
+{
+	if (_pool.size() + length > std::numeric_limits<uint32_t>::max())
+		throw TemplateException("The template is too large to be stored as an image");
+
+	uint32_t offset = static_cast<uint32_t>(_pool.size());
+	_pool.append(data, length);
+	return offset;
+}
+
+TE_END_FLAVOUR
+}
@@ -16,9 +16,40 @@
 // License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
 #include "stdafx.h"
 #include "TemplateList.hpp"
+#include "RepeatTemplate.hpp"
+#include "SimpleTemplate.hpp"
+#include "TemplateImage.hpp"
+#include "RenderCache.hpp"
 
 namespace template_engine
 {
+TE_BEGIN_FLAVOUR
+
+TemplateList::~TemplateList()
+{
+	std::vector<std::shared_ptr<const Template>> doomed;
+	doomed.swap(*this);
+
+	while (!doomed.empty()) {
+		std::shared_ptr<const Template> templ = std::move(doomed.back());
+		doomed.pop_back();
+
+		// a shared template is destroyed by its last owner
+		if (templ.use_count() != 1)
+			continue;
+
+		const RepeatTemplate* repeat = dynamic_cast<const RepeatTemplate*>(templ.get());
+		if (!repeat || repeat->_templ.use_count() != 1)
+			continue;
+
+		// the template is going away, so its nested list can be taken apart
+		TemplateList* nested = dynamic_cast<TemplateList*>(repeat->_templ.get());
+		if (nested) {
+			std::move(nested->begin(), nested->end(), std::back_inserter(doomed));
+			nested->clear();
+		}
+	}
+}
 
 te_string TemplateList::render(const DictionaryPtr& dictionary, TemplateFilter filter) const
 {
@@ -30,4 +61,103 @@ te_string TemplateList::render(const DictionaryPtr& dictionary, TemplateFilter f
 	return value;
 }
 
-}
\ No newline at end of file
+void TemplateList::renderInto(const DictionaryPtr& dictionary, TemplateEscaper escaper, te_string& out) const
+{
+	for (const std::shared_ptr<const Template>& t : *this)
+		t->renderInto(dictionary, escaper, out);
+}
+
+TemplatePtr TemplateList::optimize(const TemplateOptimizer& optimizer) const
+{
+	std::shared_ptr<TemplateList> result = std::make_shared<TemplateList>();
+	bool changed = false;
+
+	// the current run of static templates
+	std::shared_ptr<const Template> first;
+	te_string literal;
+	size_t count = 0;
+
+	auto flush = [&]() {
+		if (count == 1)
+			result->push_back(first);
+		else if (count > 1) {
+			result->push_back(std::make_shared<SimpleTemplate>(std::move(literal)));
+			changed = true;
+		}
+		literal.clear();
+		count = 0;
+	};
+
+	for (const std::shared_ptr<const Template>& child : *this) {
+		std::shared_ptr<const Template> t = child;
+		TemplatePtr replacement = child->optimize(optimizer);
+		if (replacement) {
+			t = replacement;
+			changed = true;
+		}
+
+		if (t->isStatic()) {
+			if (!count++)
+				first = t;
+			literal += t->render(DictionaryPtr(), nullptr);
+			continue;
+		}
+
+		flush();
+		result->push_back(t);
+	}
+	flush();
+
+	if (result->size() == 1)
+		return std::const_pointer_cast<Template>(result->front());
+
+	return changed ? result : nullptr;
+}
+
+TemplatePtr TemplateList::specialize(TemplateSpecializer& specializer) const
+{
+	std::shared_ptr<TemplateList> result = std::make_shared<TemplateList>();
+	bool changed = false;
+
+	for (const std::shared_ptr<const Template>& child : *this) {
+		TemplatePtr replacement = child->specialize(specializer);
+		if (replacement) {
+			result->push_back(replacement);
+			changed = true;
+		}
+		else
+			result->push_back(child);
+	}
+
+	return changed ? result : nullptr;
+}
+
+bool TemplateList::isStatic() const
+{
+	for (const std::shared_ptr<const Template>& t : *this)
+		if (!t->isStatic())
+			return false;
+
+	return true;
+}
+
+void TemplateList::write(TemplateWriter& writer) const
+{
+	for (const std::shared_ptr<const Template>& t : *this)
+		writer.write(*t);
+}
+
+void TemplateList::renderCached(RenderCache& cache, const DictionaryPtr& dictionary, te_string& out) const
+{
+	for (const std::shared_ptr<const Template>& t : *this)
+		t->renderCached(cache, dictionary, out);
+}
+
+void TemplateList::addDependencies(TemplateDependencies& scope) const
+{
+	for (const std::shared_ptr<const Template>& t : *this)
+		t->addDependencies(scope);
+}
+
+TE_END_FLAVOUR
+}
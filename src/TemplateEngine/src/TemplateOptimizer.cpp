@@ -0,0 +1,62 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include "stdafx.h"
+
+#include "TemplateOptimizer.hpp"
+#include "Context.hpp"
+
+namespace template_engine
+{
+TE_BEGIN_FLAVOUR
+
+TemplateOptimizer::TemplateOptimizer(bool foldConstants, TemplateFilter filter) :
+	_constants(),
+	_filter(filter)
+{
+	if (!foldConstants)
+		return;
+
+	// the values are those every context is created with, TIME is left
+	// alone as it differs between contexts
+	ContextPtr context = Context::BuildContext();
+	_constants = std::make_shared<Dictionary>();
+	for (const te_char_t* name : { TE_TEXT("APP"), TE_TEXT("VERSION") })
+		_constants->add(name, context->getValue(name));
+}
+
+TemplatePtr TemplateOptimizer::optimize(const TemplatePtr& templ) const
+{
+	TemplatePtr result = templ->optimize(*this);
+
+	return result ? result : templ;
+}
+
+const te_string* TemplateOptimizer::getConstant(const te_string& name) const
+{
+	if (!_constants || !_constants->exists(name))
+		return nullptr;
+
+	return &_constants->getValue(name);
+}
+
+te_string TemplateOptimizer::filter(const te_string& value) const
+{
+	return _filter ? _filter(value) : value;
+}
+
+TE_END_FLAVOUR
+}
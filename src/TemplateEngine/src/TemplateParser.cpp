@@ -0,0 +1,345 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include "stdafx.h"
+
+#include <string>
+
+#include "TemplateParser.hpp"
+#include "SimpleTemplate.hpp"
+#include "ExpansionTemplate.hpp"
+#include "RepeatTemplate.hpp"
+#include "StringScanner.hpp"
+#include "LookaheadScanner.hpp"
+#include "Exception.hpp"
+
+namespace template_engine
+{
+TE_BEGIN_FLAVOUR
+
+namespace
+{
+inline bool isWhiteSpace(const Lexer::Token& token)
+{
+	return Lexer::Token::token_t::Char == token.getType() && char_class_t::Space == classify(token.getChar());
+}
+}
+
+TemplateParser::TemplateParser(size_t maxDepth) :
+	_maxDepth(maxDepth),
+	_frames(),
+	_state(state_t::Literal),
+	_literal(),
+	_source(nullptr),
+	_view(nullptr),
+	_viewLength(0),
+	_name(),
+	_colonCount(0),
+	_spec(),
+	_format(),
+	_filters(),
+	_pending(),
+	_lexerState(),
+	_keptBack(0),
+	_lexedLength(0)
+{
+	_frames.push_back(Frame{ std::make_shared<TemplateList>(), te_string() });
+}
+
+void TemplateParser::feed(const te_char_t* data, size_t length)
+{
+	if (!length || state_t::Done == _state)
+		return;
+
+	_pending.append(data, length);
+
+	// a token kept back is tokenized again once the input has doubled, not for every chunk
+	if (_pending.size() >= 2 * _keptBack)
+		lex(true);
+}
+
+TemplatePtr TemplateParser::parse(Scanner& scanner)
+{
+	Lexer lexer(scanner);
+	_source = lexer.getSource();
+
+	// an unmatched end repeat instruction ends the template, the rest isn't read
+	while (state_t::Done != _state) {
+		const Lexer::Token& token = lexer.getNextToken();
+		if (Lexer::Token::token_t::Eos == token.getType())
+			break;
+		consume(token);
+	}
+
+	return close();
+}
+
+TemplatePtr TemplateParser::finish()
+{
+	lex(false);
+	return close();
+}
+
+TemplatePtr TemplateParser::close()
+{
+	// the end of the stream closes the literal, and any open repeat instructions
+	consume(Lexer::Token());
+	while (_frames.size() > 1)
+		closeRepeat();
+
+	return _frames.front().list;
+}
+
+void TemplateParser::lex(bool partial)
+{
+	_lexedLength += _pending.size();
+	_keptBack = 0;
+
+	StringScanner scanner(SourceBuffer::borrow(_pending));
+	Lexer lexer(scanner);
+	lexer.setState(_lexerState);
+	lexer.setPartialInput(partial);
+
+	size_t start = 0;
+	while (true) {
+		if (state_t::Done == _state) {
+			// as in parse(), the rest of the input is ignored
+			_pending.clear();
+			return;
+		}
+
+		Lexer::State state = lexer.getState();
+		start = lexer.getPosition();
+
+		const Lexer::Token& token = lexer.getNextToken();
+		if (partial && lexer.hasReachedEnd()) {
+			// the token may continue in the next chunk, try again from its start
+			_lexerState = state;
+			_keptBack = _pending.size() - start;
+			break;
+		}
+		if (Lexer::Token::token_t::Eos == token.getType()) {
+			_lexerState = lexer.getState();
+			break;
+		}
+
+		consume(token);
+	}
+
+	_pending.erase(0, start);
+}
+
+void TemplateParser::consume(const Lexer::Token& token)
+{
+	typedef Lexer::Token::token_t token_t;
+
+	switch (_state)
+	{
+		case state_t::Literal:
+			if (token_t::Text == token.getType())
+				appendLiteral(token.getText(), token.getTextLength());
+			else if (token_t::Char == token.getType()) {
+				te_char_t ch = token.getChar();
+				appendLiteral(&ch, 1);
+			}
+			else {
+				flushLiteral();
+				if (token_t::StartTag == token.getType())
+					_state = state_t::Instruction;
+			}
+			break;
+
+		case state_t::Instruction:
+			// {{? <name> }}
+			//   ^
+			_colonCount = 0;
+			_spec.clear();
+			_format = ValueFormat();
+			_filters = FilterChain();
+			if (token_t::Char == token.getType() && TE_TEXT('#') == token.getChar())
+				_state = state_t::OpenKeyword;
+			else if (token_t::Char == token.getType() && TE_TEXT('/') == token.getChar())
+				_state = state_t::CloseKeyword;
+			else {
+				_state = state_t::Expansion;
+				consume(token);
+			}
+			break;
+
+		case state_t::OpenKeyword:
+		case state_t::CloseKeyword:
+			if (isWhiteSpace(token))
+				break;
+			if (token_t::Name != token.getType())
+				throw TemplateException("Malformed name expansion");
+			if (!token.isName(TE_TEXT("repeat")))
+				throw TemplateException("Unknown processing instruction: '" + to_utf8(token.getName()) + "'");
+			_state = state_t::OpenKeyword == _state ? state_t::OpenSkip : state_t::CloseEnd;
+			break;
+
+		case state_t::OpenSkip:
+			// {{# repeat  <name> }}
+			//           ^
+			if (token_t::Eos == token.getType())
+				throw TemplateException("Malformed repeat instruction, a name was expected");
+			_state = state_t::OpenName;
+			break;
+
+		case state_t::OpenName:
+			if (isWhiteSpace(token))
+				break;
+			if (token_t::Name != token.getType())
+				throw TemplateException("Malformed repeat instruction, a name was expected");
+			_name = token.getName();
+			_state = state_t::OpenEnd;
+			break;
+
+		case state_t::OpenEnd:
+			if (isWhiteSpace(token))
+				break;
+			if (token_t::EndTag != token.getType())
+				throw TemplateException("Malformed repeat instruction, an end tag was expected");
+			if (_frames.size() > _maxDepth)
+				throw TemplateException("Repeat instructions are nested deeper than " + std::to_string(_maxDepth) + " levels");
+			_frames.push_back(Frame{ std::make_shared<TemplateList>(), std::move(_name) });
+			_state = state_t::Literal;
+			break;
+
+		case state_t::CloseEnd:
+			// {{/ repeat }}
+			//           ^
+			if (isWhiteSpace(token))
+				break;
+			if (token_t::EndTag != token.getType())
+				throw TemplateException("Malformed end repeat instruction, an end tag was expected");
+
+			// an end repeat without a matching repeat ends the template
+			if (_frames.size() > 1) {
+				closeRepeat();
+				_state = state_t::Literal;
+			}
+			else
+				_state = state_t::Done;
+			break;
+
+		case state_t::Expansion:
+			// {{ (:)*<name>(:<format>)? (|<filter>)* }}
+			//     ^
+			if (token_t::Char == token.getType() && TE_TEXT(':') == token.getChar()) {
+				++_colonCount;
+				break;
+			}
+			if (token_t::Name != token.getType())
+				throw TemplateException("Malformed name expansion");
+			_name = token.getName();
+			_state = state_t::ExpansionEnd;
+			break;
+
+		case state_t::ExpansionEnd:
+			// {{ (:)*<name>(:<format>)? (|<filter>)* }}
+			//              ^           ^           ^
+			if (isWhiteSpace(token))
+				break;
+			if (token_t::Char == token.getType() && TE_TEXT(':') == token.getChar() && _format.isDefault() && _filters.empty()) {
+				_state = state_t::FormatSpec;
+				break;
+			}
+			if (token_t::Char == token.getType() && TE_TEXT('|') == token.getChar()) {
+				_state = state_t::FilterName;
+				break;
+			}
+			if (token_t::EndTag != token.getType())
+				throw TemplateException("Missing end tag '}}' in name expansion");
+			_frames.back().list->push_back(std::make_shared<ExpansionTemplate>(_name, _colonCount, std::move(_format), std::move(_filters)));
+			_state = state_t::Literal;
+			break;
+
+		case state_t::FormatSpec:
+			// {{ (:)*<name>(:<format>)? (|<filter>)* }}
+			//                ^
+			if (token_t::Name == token.getType() && !token.getName().empty()) {
+				_spec += token.getName();
+				break;
+			}
+			if (token_t::Char == token.getType() && !isWhiteSpace(token) && TE_TEXT('|') != token.getChar()) {
+				_spec += token.getChar();
+				break;
+			}
+
+			// the specifier ends, and is parsed once and for all
+			_format = ValueFormat(_spec);
+			_state = state_t::ExpansionEnd;
+			consume(token);
+			break;
+
+		case state_t::FilterName:
+			// {{ (:)*<name>(:<format>)? (|<filter>)* }}
+			//                             ^
+			if (isWhiteSpace(token))
+				break;
+			if (token_t::Name != token.getType() || token.getName().empty())
+				throw TemplateException("Malformed name expansion, a filter name was expected");
+			_filters.push_back(token.getName());
+			_state = state_t::ExpansionEnd;
+			break;
+
+		case state_t::Done:
+			break;
+	}
+}
+
+void TemplateParser::appendLiteral(const te_char_t* text, size_t length)
+{
+	// a literal which is a single run of plain text can refer to the
+	// template definition, instead of being copied
+	if (_literal.empty() && !_view && _source && _source->contains(text, length)) {
+		_view = text;
+		_viewLength = length;
+		return;
+	}
+
+	if (_view) {
+		_literal.assign(_view, _viewLength);
+		_view = nullptr;
+	}
+	_literal.append(text, length);
+}
+
+void TemplateParser::flushLiteral()
+{
+	if (_view) {
+		_frames.back().list->push_back(std::make_shared<SimpleTemplate>(*_source, static_cast<size_t>(_view - _source->data()), _viewLength));
+		_view = nullptr;
+		return;
+	}
+
+	if (_literal.empty())
+		return;
+
+	_frames.back().list->push_back(std::make_shared<SimpleTemplate>(std::move(_literal)));
+	_literal.clear();
+}
+
+void TemplateParser::closeRepeat()
+{
+	Frame frame = std::move(_frames.back());
+	_frames.pop_back();
+
+	_frames.back().list->push_back(std::make_shared<RepeatTemplate>(std::move(frame.name), frame.list));
+}
+
+TE_END_FLAVOUR
+}
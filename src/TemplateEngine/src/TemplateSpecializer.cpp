@@ -0,0 +1,78 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include "stdafx.h"
+
+#include "TemplateSpecializer.hpp"
+#include "TemplateOptimizer.hpp"
+#include "SpecializedTemplate.hpp"
+
+namespace template_engine
+{
+TE_BEGIN_FLAVOUR
+
+TemplateSpecializer::TemplateSpecializer(const DictionaryPtr& known, TemplateFilter filter) :
+	_known(known),
+	_filter(filter),
+	_scopes(),
+	_kept(0)
+{
+}
+
+TemplatePtr TemplateSpecializer::specialize(const TemplatePtr& templ)
+{
+	_scopes.assign(1, _known.get());
+	_kept = 0;
+
+	TemplatePtr result = templ->specialize(*this);
+	result = TemplateOptimizer().optimize(result ? result : templ);
+
+	// a repeat which was kept may still refer to the known values
+	if (_kept)
+		result = std::make_shared<SpecializedTemplate>(_known, result);
+
+	return result;
+}
+
+const Dictionary* TemplateSpecializer::find(const te_string& name, size_t scopeWalk) const
+{
+	for (size_t i = scopeWalk; i < _scopes.size(); i++) {
+		const Dictionary* scope = _scopes[_scopes.size() - 1 - i];
+		if (scope->existsLocal(name))
+			return scope;
+	}
+
+	return nullptr;
+}
+
+void TemplateSpecializer::enterScope(const Dictionary* list, const Dictionary* item)
+{
+	_scopes.push_back(list);
+	_scopes.push_back(item);
+}
+
+void TemplateSpecializer::leaveScope()
+{
+	_scopes.resize(_scopes.size() - 2);
+}
+
+te_string TemplateSpecializer::filter(const te_string& value) const
+{
+	return _filter ? _filter(value) : value;
+}
+
+TE_END_FLAVOUR
+}
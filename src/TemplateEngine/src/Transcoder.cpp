@@ -0,0 +1,341 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include "stdafx.h"
+
+#include <cstdint>
+
+#include "Transcoder.hpp"
+#include "Exception.hpp"
+#include "Simd.hpp"
+
+namespace template_engine
+{
+
+namespace
+{
+
+[[noreturn]] void throwInvalid(const char* encoding, size_t offset)
+{
+	throw TemplateException(std::string("Invalid ") + encoding + " sequence at offset " + std::to_string(offset));
+}
+
+//
+// ASCII run kernels, each converts the longest ASCII prefix of the input
+// and returns its length. They may stop early, the caller simply resumes
+// with the scalar decoder which will hand back to the kernel afterwards.
+//
+
+#ifdef TE_SIMD_AVX2
+TE_TARGET_AVX2 size_t asciiToUtf16Avx2(const uint8_t* in, size_t length, char16_t* out)
+{
+	size_t i = 0;
+	for (; i + 32 <= length; i += 32) {
+		__m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+		unsigned int nonAscii = static_cast<unsigned int>(_mm256_movemask_epi8(bytes));
+		if (nonAscii) {
+			unsigned int n = lowestBit(nonAscii);
+			for (unsigned int j = 0; j < n; ++j)
+				out[i + j] = in[i + j];
+			return i + n;
+		}
+		__m256i lo = _mm256_cvtepu8_epi16(_mm256_castsi256_si128(bytes));
+		__m256i hi = _mm256_cvtepu8_epi16(_mm256_extracti128_si256(bytes, 1));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), lo);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i + 16), hi);
+	}
+	return i;
+}
+
+TE_TARGET_AVX2 size_t asciiToUtf8Avx2(const char16_t* in, size_t length, uint8_t* out)
+{
+	const __m256i highBits = _mm256_set1_epi16(static_cast<short>(0xFF80));
+	size_t i = 0;
+	for (; i + 16 <= length; i += 16) {
+		__m256i units = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+		if (!_mm256_testz_si256(units, highBits)) {
+			__m256i ascii = _mm256_cmpeq_epi16(_mm256_and_si256(units, highBits), _mm256_setzero_si256());
+			unsigned int nonAscii = ~static_cast<unsigned int>(_mm256_movemask_epi8(ascii));
+			unsigned int n = lowestBit(nonAscii) / 2;
+			for (unsigned int j = 0; j < n; ++j)
+				out[i + j] = static_cast<uint8_t>(in[i + j]);
+			return i + n;
+		}
+		__m128i packed = _mm_packus_epi16(_mm256_castsi256_si128(units), _mm256_extracti128_si256(units, 1));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), packed);
+	}
+	return i;
+}
+#endif
+
+#ifdef TE_SIMD_SSE2
+size_t asciiToUtf16Sse2(const uint8_t* in, size_t length, char16_t* out)
+{
+	const __m128i zero = _mm_setzero_si128();
+	size_t i = 0;
+	for (; i + 16 <= length; i += 16) {
+		__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+		unsigned int nonAscii = static_cast<unsigned int>(_mm_movemask_epi8(bytes));
+		if (nonAscii) {
+			unsigned int n = lowestBit(nonAscii);
+			for (unsigned int j = 0; j < n; ++j)
+				out[i + j] = in[i + j];
+			return i + n;
+		}
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_unpacklo_epi8(bytes, zero));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 8), _mm_unpackhi_epi8(bytes, zero));
+	}
+	return i;
+}
+
+size_t asciiToUtf8Sse2(const char16_t* in, size_t length, uint8_t* out)
+{
+	const __m128i highBits = _mm_set1_epi16(static_cast<short>(0xFF80));
+	const __m128i zero = _mm_setzero_si128();
+	size_t i = 0;
+	for (; i + 8 <= length; i += 8) {
+		__m128i units = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+		__m128i ascii = _mm_cmpeq_epi16(_mm_and_si128(units, highBits), zero);
+		unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(ascii));
+		if (mask != 0xFFFF) {
+			unsigned int n = lowestBit(~mask) / 2;
+			for (unsigned int j = 0; j < n; ++j)
+				out[i + j] = static_cast<uint8_t>(in[i + j]);
+			return i + n;
+		}
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(units, units));
+	}
+	return i;
+}
+#endif
+
+size_t asciiToUtf16(const uint8_t* in, size_t length, char16_t* out)
+{
+	size_t i = 0;
+#ifdef TE_SIMD_AVX2
+	if (cpuHasAvx2())
+		i = asciiToUtf16Avx2(in, length, out);
+#endif
+#ifdef TE_SIMD_SSE2
+	i += asciiToUtf16Sse2(in + i, length - i, out + i);
+#endif
+	while (i < length && in[i] < 0x80) {
+		out[i] = in[i];
+		++i;
+	}
+	return i;
+}
+
+size_t asciiToUtf8(const char16_t* in, size_t length, uint8_t* out)
+{
+	size_t i = 0;
+#ifdef TE_SIMD_AVX2
+	if (cpuHasAvx2())
+		i = asciiToUtf8Avx2(in, length, out);
+#endif
+#ifdef TE_SIMD_SSE2
+	i += asciiToUtf8Sse2(in + i, length - i, out + i);
+#endif
+	while (i < length && in[i] < 0x80) {
+		out[i] = static_cast<uint8_t>(in[i]);
+		++i;
+	}
+	return i;
+}
+
+/** Expected length of a UTF-8 sequence given its lead byte, 0 if the byte can't start a sequence */
+inline size_t utf8SequenceLength(uint8_t lead)
+{
+	if (lead < 0x80)
+		return 1;
+	if (lead < 0xC2)
+		return 0;	// continuation byte or overlong two byte form
+	if (lead < 0xE0)
+		return 2;
+	if (lead < 0xF0)
+		return 3;
+	if (lead < 0xF5)
+		return 4;
+	return 0;
+}
+
+/**
+ * Decode the non-ASCII sequence starting at in[i], returns the code point
+ * and advances i. Throws on malformed input.
+ */
+inline uint32_t decodeUtf8(const uint8_t* in, size_t length, size_t& i)
+{
+	uint8_t lead = in[i];
+	size_t n = utf8SequenceLength(lead);
+	if (n < 2 || i + n > length)
+		throwInvalid("UTF-8", i);
+
+	uint8_t c1 = in[i + 1];
+	if ((c1 & 0xC0) != 0x80)
+		throwInvalid("UTF-8", i);
+
+	uint32_t cp;
+	switch (n) {
+		case 2:
+			cp = ((lead & 0x1Fu) << 6) | (c1 & 0x3Fu);
+			break;
+		case 3:
+			if ((lead == 0xE0 && c1 < 0xA0) ||		// overlong
+				(lead == 0xED && c1 >= 0xA0) ||		// surrogate code point
+				(in[i + 2] & 0xC0) != 0x80)
+				throwInvalid("UTF-8", i);
+			cp = ((lead & 0x0Fu) << 12) | ((c1 & 0x3Fu) << 6) | (in[i + 2] & 0x3Fu);
+			break;
+		default:
+			if ((lead == 0xF0 && c1 < 0x90) ||		// overlong
+				(lead == 0xF4 && c1 >= 0x90) ||		// beyond U+10FFFF
+				(in[i + 2] & 0xC0) != 0x80 ||
+				(in[i + 3] & 0xC0) != 0x80)
+				throwInvalid("UTF-8", i);
+			cp = ((lead & 0x07u) << 18) | ((c1 & 0x3Fu) << 12) | ((in[i + 2] & 0x3Fu) << 6) | (in[i + 3] & 0x3Fu);
+			break;
+	}
+
+	i += n;
+	return cp;
+}
+
+}
+
+size_t Transcoder::utf8ToUtf16(const char* input, size_t length, char16_t* out)
+{
+	const uint8_t* in = reinterpret_cast<const uint8_t*>(input);
+	size_t i = 0;
+	char16_t* o = out;
+
+	while (i < length) {
+		size_t ascii = asciiToUtf16(in + i, length - i, o);
+		i += ascii;
+		o += ascii;
+
+		// decode non-ASCII sequences until the next ASCII byte
+		while (i < length && in[i] >= 0x80) {
+			uint32_t cp = decodeUtf8(in, length, i);
+			if (cp < 0x10000)
+				*o++ = static_cast<char16_t>(cp);
+			else {
+				cp -= 0x10000;
+				*o++ = static_cast<char16_t>(0xD800 + (cp >> 10));
+				*o++ = static_cast<char16_t>(0xDC00 + (cp & 0x3FF));
+			}
+		}
+	}
+
+	return static_cast<size_t>(o - out);
+}
+
+size_t Transcoder::utf16ToUtf8(const char16_t* in, size_t length, char* output)
+{
+	uint8_t* out = reinterpret_cast<uint8_t*>(output);
+	uint8_t* o = out;
+	size_t i = 0;
+
+	while (i < length) {
+		size_t ascii = asciiToUtf8(in + i, length - i, o);
+		i += ascii;
+		o += ascii;
+
+		while (i < length && in[i] >= 0x80) {
+			uint32_t cp = in[i];
+			if (cp < 0x800) {
+				*o++ = static_cast<uint8_t>(0xC0 | (cp >> 6));
+				*o++ = static_cast<uint8_t>(0x80 | (cp & 0x3F));
+				++i;
+			}
+			else if (cp < 0xD800 || cp > 0xDFFF) {
+				*o++ = static_cast<uint8_t>(0xE0 | (cp >> 12));
+				*o++ = static_cast<uint8_t>(0x80 | ((cp >> 6) & 0x3F));
+				*o++ = static_cast<uint8_t>(0x80 | (cp & 0x3F));
+				++i;
+			}
+			else {
+				// must be a high surrogate followed by a low surrogate
+				if (cp > 0xDBFF || i + 1 >= length || in[i + 1] < 0xDC00 || in[i + 1] > 0xDFFF)
+					throwInvalid("UTF-16", i);
+				cp = 0x10000 + ((cp - 0xD800) << 10) + (in[i + 1] - 0xDC00u);
+				*o++ = static_cast<uint8_t>(0xF0 | (cp >> 18));
+				*o++ = static_cast<uint8_t>(0x80 | ((cp >> 12) & 0x3F));
+				*o++ = static_cast<uint8_t>(0x80 | ((cp >> 6) & 0x3F));
+				*o++ = static_cast<uint8_t>(0x80 | (cp & 0x3F));
+				i += 2;
+			}
+		}
+	}
+
+	return static_cast<size_t>(o - out);
+}
+
+std::u16string Transcoder::utf8ToUtf16(const std::string& str)
+{
+	std::u16string result(str.size(), u'\0');
+	if (!str.empty())
+		result.resize(utf8ToUtf16(str.data(), str.size(), &result[0]));
+	return result;
+}
+
+std::string Transcoder::utf16ToUtf8(const std::u16string& str)
+{
+	std::string result(str.size() * 3, '\0');
+	if (!str.empty())
+		result.resize(utf16ToUtf8(str.data(), str.size(), &result[0]));
+	return result;
+}
+
+size_t Transcoder::utf8CompleteLength(const char* input, size_t length)
+{
+	const uint8_t* in = reinterpret_cast<const uint8_t*>(input);
+
+	// find the start of the last sequence, at most three bytes back
+	size_t start = length;
+	while (start > 0 && length - start < 4) {
+		--start;
+		if ((in[start] & 0xC0) != 0x80)
+			break;
+	}
+	if (start == length)
+		return length;
+
+	size_t n = utf8SequenceLength(in[start]);
+	if (n > 1 && start + n > length)
+		return start;
+	return length;
+}
+
+bool Transcoder::isValidUtf8(const char* input, size_t length)
+{
+	const uint8_t* in = reinterpret_cast<const uint8_t*>(input);
+	size_t i = 0;
+
+	try {
+		while (i < length) {
+			if (in[i] < 0x80)
+				++i;
+			else
+				decodeUtf8(in, length, i);
+		}
+	}
+	catch (const TemplateException&) {
+		return false;
+	}
+	return true;
+}
+
+}
@@ -0,0 +1,443 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include "stdafx.h"
+
+#include <algorithm>
+#include <clocale>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "TypedValue.hpp"
+#include "Exception.hpp"
+
+namespace template_engine
+{
+TE_BEGIN_FLAVOUR
+
+namespace
+{
+
+/** \brief Large enough for a double in fixed point with the maximum precision */
+const size_t bufferSize = 512;
+
+const char digitPairs[] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+/** \brief Write the digits of value in decimal, backwards from end, two at a time.
+ *
+ * \return The first digit.
+ */
+char* writeDecimal(char* end, uint64_t value)
+{
+	while (value >= 100) {
+		const char* pair = digitPairs + 2 * (value % 100);
+		value /= 100;
+		*--end = pair[1];
+		*--end = pair[0];
+	}
+	if (value >= 10) {
+		const char* pair = digitPairs + 2 * value;
+		*--end = pair[1];
+		*--end = pair[0];
+	}
+	else
+		*--end = static_cast<char>('0' + value);
+	return end;
+}
+
+/** \brief Write the digits of value in a power of two base, backwards from end. */
+char* writeBinary(char* end, uint64_t value, unsigned int shift, const char* digits)
+{
+	uint64_t mask = (uint64_t(1) << shift) - 1;
+	do {
+		*--end = digits[value & mask];
+		value >>= shift;
+	} while (value);
+	return end;
+}
+
+/** \brief Write exactly count digits of value, forwards. */
+char* writeFixed(char* out, uint64_t value, int count)
+{
+	for (int i = count - 1; i >= 0; i--) {
+		out[i] = static_cast<char>('0' + value % 10);
+		value /= 10;
+	}
+	return out + count;
+}
+
+/** \brief Floor division, the timestamps before the epoch are negative */
+int64_t floorDiv(int64_t value, int64_t divisor)
+{
+	int64_t quotient = value / divisor;
+	return (value % divisor < 0) ? quotient - 1 : quotient;
+}
+
+/** \brief Year, month and day of the days since 1970-01-01 in the proleptic Gregorian calendar.
+ *
+ * See Howard Hinnant, chrono-Compatible Low-Level Date Algorithms.
+ */
+void civilFromDays(int64_t days, int64_t& year, unsigned int& month, unsigned int& day)
+{
+	days += 719468;
+	int64_t era = floorDiv(days, 146097);
+	unsigned int dayOfEra = static_cast<unsigned int>(days - era * 146097);
+	unsigned int yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+	unsigned int dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+	unsigned int monthIndex = (5 * dayOfYear + 2) / 153;
+
+	day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+	month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+	year = yearOfEra + era * 400 + (month <= 2);
+}
+
+/** \brief snprintf uses the decimal point of the C locale, which may not be a period */
+void fixDecimalPoint(char* text, size_t length)
+{
+	const char* point = std::localeconv()->decimal_point;
+	if (!point || (point[0] == '.' && point[1] == '\0'))
+		return;
+
+	size_t pointLength = std::strlen(point);
+	char* found = std::search(text, text + length, point, point + pointLength);
+	if (found == text + length)
+		return;
+
+	// the locale's decimal point may be longer than a period
+	*found = '.';
+	std::memmove(found + 1, found + pointLength, static_cast<size_t>(text + length - found - pointLength) + 1);
+}
+
+/** \brief Write value in fixed point without snprintf, if the rounding to the precision is unambiguous.
+ *
+ * value * 10^precision is off by at most half an ulp, so unless its fraction
+ * is about that close to a half, rounding it gives the digits snprintf would.
+ *
+ * \return The length written, 0 if snprintf must be used.
+ */
+size_t writeFixedPoint(char* out, double value, int precision, bool plus)
+{
+	static const uint64_t powers[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+	if (precision >= static_cast<int>(sizeof(powers) / sizeof(powers[0])) || !(std::fabs(value) < 1e15))
+		return 0;
+
+	double scaled = std::fabs(value) * static_cast<double>(powers[precision]);
+	double whole = std::floor(scaled);
+	double fraction = scaled - whole;
+	if (std::fabs(fraction - 0.5) <= scaled * 4.5e-16)
+		return 0;
+
+	uint64_t digits = static_cast<uint64_t>(whole) + (fraction > 0.5 ? 1 : 0);
+	char* p = out;
+	if (std::signbit(value))
+		*p++ = '-';
+	else if (plus)
+		*p++ = '+';
+
+	char integer[24];
+	char* end = integer + sizeof(integer);
+	char* first = writeDecimal(end, digits / powers[precision]);
+	p = std::copy(first, end, p);
+	if (precision) {
+		*p++ = '.';
+		p = writeFixed(p, digits % powers[precision], precision);
+	}
+	return static_cast<size_t>(p - out);
+}
+
+inline bool isAlign(te_char_t ch)
+{
+	return TE_TEXT('<') == ch || TE_TEXT('>') == ch || TE_TEXT('^') == ch;
+}
+
+inline bool isDigit(te_char_t ch)
+{
+	return ch >= TE_TEXT('0') && ch <= TE_TEXT('9');
+}
+
+inline bool isType(te_char_t ch)
+{
+	unsigned int unit = te_code_unit(ch);
+	return unit && unit < 0x80 && std::strchr("dxXobfeEgG%s", static_cast<int>(unit));
+}
+
+}
+
+te_string TypedValue::toString() const
+{
+	te_string result;
+	ValueFormat().format(result, *this);
+	return result;
+}
+
+ValueFormat::ValueFormat() :
+	_spec(),
+	_fill(TE_TEXT(' ')),
+	_align(0),
+	_sign(0),
+	_zero(false),
+	_width(0),
+	_precision(-1),
+	_type(0)
+{
+}
+
+ValueFormat::ValueFormat(const te_string& spec) :
+	ValueFormat()
+{
+	size_t i = 0;
+	size_t n = spec.size();
+
+	// [[fill]align]
+	if (n >= 2 && isAlign(spec[1])) {
+		_fill = spec[0];
+		_align = static_cast<char>(spec[1]);
+		i = 2;
+	}
+	else if (n >= 1 && isAlign(spec[0])) {
+		_align = static_cast<char>(spec[0]);
+		i = 1;
+	}
+
+	// [sign][0][width]
+	if (i < n && (TE_TEXT('+') == spec[i] || TE_TEXT('-') == spec[i]))
+		_sign = static_cast<char>(spec[i++]);
+	if (i < n && TE_TEXT('0') == spec[i]) {
+		_zero = true;
+		++i;
+	}
+	for (; i < n && isDigit(spec[i]) && _width <= maxWidth; ++i)
+		_width = 10 * _width + static_cast<size_t>(spec[i] - TE_TEXT('0'));
+
+	// [.precision]
+	if (i < n && TE_TEXT('.') == spec[i]) {
+		_precision = 0;
+		if (++i == n || !isDigit(spec[i]))
+			i = n + 1;
+		for (; i < n && isDigit(spec[i]) && _precision <= maxPrecision; ++i)
+			_precision = 10 * _precision + static_cast<int>(spec[i] - TE_TEXT('0'));
+	}
+
+	// [type]
+	if (i < n && isType(spec[i]))
+		_type = static_cast<char>(spec[i++]);
+
+	if (i != n || spec.empty() || _width > maxWidth || _precision > maxPrecision)
+		throw TemplateException("Malformed format specifier ':" + to_utf8(spec) + "'");
+
+	_spec = spec;
+}
+
+void ValueFormat::format(te_string& out, const te_char_t* value, size_t length) const
+{
+	if (_type && 's' != _type)
+		throw TemplateException("The format specifier ':" + to_utf8(_spec) + "' doesn't apply to a string");
+
+	if (_precision >= 0 && length > static_cast<size_t>(_precision))
+		length = static_cast<size_t>(_precision);
+
+	size_t padding = _width > length ? _width - length : 0;
+	size_t before = '>' == _align ? padding : '^' == _align ? padding / 2 : 0;
+	out.append(before, _fill);
+	out.append(value, length);
+	out.append(padding - before, _fill);
+}
+
+void ValueFormat::format(te_string& out, const TypedValue& value) const
+{
+	char buffer[bufferSize];
+	char* end = buffer + sizeof(buffer);
+	char* text = end;
+
+	switch (value.getType()) {
+	case TypedValue::type_t::Integer: {
+		if (_type && !std::strchr("dxXob", _type)) {
+			formatReal(out, static_cast<double>(value.getInteger()), _type);
+			return;
+		}
+
+		int64_t integer = value.getInteger();
+		uint64_t magnitude = integer < 0 ? 0 - static_cast<uint64_t>(integer) : static_cast<uint64_t>(integer);
+		switch (_type) {
+		case 'x': text = writeBinary(end, magnitude, 4, "0123456789abcdef"); break;
+		case 'X': text = writeBinary(end, magnitude, 4, "0123456789ABCDEF"); break;
+		case 'o': text = writeBinary(end, magnitude, 3, "01234567"); break;
+		case 'b': text = writeBinary(end, magnitude, 1, "01"); break;
+		default: text = writeDecimal(end, magnitude); break;
+		}
+		if (integer < 0)
+			*--text = '-';
+		else if ('+' == _sign)
+			*--text = '+';
+		pad(out, text, static_cast<size_t>(end - text), true);
+		return;
+	}
+
+	case TypedValue::type_t::Real:
+		formatReal(out, value.getReal(), _type);
+		return;
+
+	case TypedValue::type_t::Boolean:
+		if ('d' == _type) {
+			pad(out, value.getBoolean() ? "1" : "0", 1, true);
+			return;
+		}
+		if (_type && 's' != _type)
+			break;
+		if (value.getBoolean())
+			pad(out, "true", 4, false);
+		else
+			pad(out, "false", 5, false);
+		return;
+
+	case TypedValue::type_t::Timestamp: {
+		const int64_t nanosecondsPerSecond = 1000000000;
+		int64_t seconds = floorDiv(value.getTimestamp(), nanosecondsPerSecond);
+		if ('d' == _type) {
+			uint64_t magnitude = seconds < 0 ? 0 - static_cast<uint64_t>(seconds) : static_cast<uint64_t>(seconds);
+			text = writeDecimal(end, magnitude);
+			if (seconds < 0)
+				*--text = '-';
+			pad(out, text, static_cast<size_t>(end - text), true);
+			return;
+		}
+		if (_type)
+			break;
+
+		int64_t year;
+		unsigned int month, day;
+		civilFromDays(floorDiv(seconds, 86400), year, month, day);
+		int64_t secondOfDay = seconds - floorDiv(seconds, 86400) * 86400;
+
+		// YYYY-MM-DDTHH:MM:SS[.fraction]Z, years outside 0-9999 as they are
+		char* p = buffer;
+		if (year >= 0 && year <= 9999)
+			p = writeFixed(p, static_cast<uint64_t>(year), 4);
+		else
+			p += std::snprintf(p, 32, "%lld", static_cast<long long>(year));
+		*p++ = '-';
+		p = writeFixed(p, month, 2);
+		*p++ = '-';
+		p = writeFixed(p, day, 2);
+		*p++ = 'T';
+		p = writeFixed(p, static_cast<uint64_t>(secondOfDay / 3600), 2);
+		*p++ = ':';
+		p = writeFixed(p, static_cast<uint64_t>(secondOfDay / 60 % 60), 2);
+		*p++ = ':';
+		p = writeFixed(p, static_cast<uint64_t>(secondOfDay % 60), 2);
+		if (_precision > 0) {
+			uint64_t fraction = static_cast<uint64_t>(value.getTimestamp() - seconds * nanosecondsPerSecond);
+			*p++ = '.';
+			for (int digit = 0; digit < _precision; digit++) {
+				fraction *= 10;
+				*p++ = static_cast<char>('0' + fraction / nanosecondsPerSecond);
+				fraction %= nanosecondsPerSecond;
+			}
+		}
+		*p++ = 'Z';
+		pad(out, buffer, static_cast<size_t>(p - buffer), false);
+		return;
+	}
+	}
+
+	throw TemplateException("The format specifier ':" + to_utf8(_spec) + "' doesn't apply to the value");
+}
+
+void ValueFormat::pad(te_string& out, const char* text, size_t length, bool numeric) const
+{
+	size_t padding = _width > length ? _width - length : 0;
+
+	// zeroes go between the sign and the digits
+	if (numeric && _zero && !_align) {
+		size_t sign = length && ('+' == text[0] || '-' == text[0]) ? 1 : 0;
+		out.append(text, text + sign);
+		out.append(padding, TE_TEXT('0'));
+		out.append(text + sign, text + length);
+		return;
+	}
+
+	char align = _align ? _align : numeric ? '>' : '<';
+	size_t before = '>' == align ? padding : '^' == align ? padding / 2 : 0;
+	out.append(before, _fill);
+	out.append(text, text + length);
+	out.append(padding - before, _fill);
+}
+
+void ValueFormat::formatReal(te_string& out, double value, char type) const
+{
+	char buffer[bufferSize];
+	int length;
+	const char* sign = '+' == _sign ? "+" : "";
+
+	switch (type) {
+	case 0:
+		if (_precision >= 0) {
+			length = std::snprintf(buffer, sizeof(buffer), "%s%.*g", sign, _precision, value);
+			break;
+		}
+
+		// the fewest significant digits which read back the same, any 15 digits do for a normal
+		// double, so %.15g gives the shortest up to 15, a subnormal one may need fewer
+		for (int digits = FP_SUBNORMAL == std::fpclassify(value) ? 1 : 15; ; digits++) {
+			length = std::snprintf(buffer, sizeof(buffer), "%s%.*g", sign, digits, value);
+			if (digits == 17 || std::strtod(buffer, nullptr) == value || value != value)
+				break;
+		}
+		break;
+
+	case 'f':
+		length = static_cast<int>(writeFixedPoint(buffer, value, _precision >= 0 ? _precision : 6, '+' == _sign));
+		if (length) {
+			pad(out, buffer, static_cast<size_t>(length), true);
+			return;
+		}
+		// fall through
+	case 'e': case 'E': case 'g': case 'G': {
+		char format[] = "%s%.*f";
+		format[5] = type;
+		length = std::snprintf(buffer, sizeof(buffer), format, sign, _precision >= 0 ? _precision : 6, value);
+		break;
+	}
+
+	case '%':
+		length = std::snprintf(buffer, sizeof(buffer), "%s%.*f%%", sign, _precision >= 0 ? _precision : 6, value * 100);
+		break;
+
+	default:
+		throw TemplateException("The format specifier ':" + to_utf8(_spec) + "' doesn't apply to the value");
+	}
+
+	if (length < 0 || static_cast<size_t>(length) >= sizeof(buffer))
+		throw TemplateException("Unable to format the value with ':" + to_utf8(_spec) + "'");
+
+	fixDecimalPoint(buffer, static_cast<size_t>(length));
+	pad(out, buffer, std::strlen(buffer), true);
+}
+
+TE_END_FLAVOUR
+}
@@ -17,27 +17,32 @@
 #include "stdafx.h"
 
 #include "Types.hpp"
+#include "Transcoder.hpp"
+
 namespace template_engine {
+TE_BEGIN_FLAVOUR
 
-#ifdef _WIN32
+#ifndef TE_USE_UTF8
 std::string te_converter::to_bytes(const te_string &wstr)
 {
-	if (wstr.empty()) return std::string();
-	int size_needed = WideCharToMultiByte(CP_UTF8, 0, (LPCWCH)&wstr[0], (int)wstr.size(), NULL, 0, NULL, NULL);
-	std::string strTo(size_needed, 0);
-	WideCharToMultiByte(CP_UTF8, 0, (LPCWCH)&wstr[0], (int)wstr.size(), (LPSTR)&strTo[0], size_needed, NULL, NULL);
-	return strTo;
+	return Transcoder::utf16ToUtf8(wstr);
 }
 
-// Convert an UTF8 string to a wide Unicode String
 te_string te_converter::from_bytes(const std::string &str)
 {
-	if (str.empty()) return te_string();
-	int size_needed = MultiByteToWideChar(CP_UTF8, 0, &str[0], (int)str.size(), NULL, 0);
-	te_string wstrTo(size_needed, 0);
-	MultiByteToWideChar(CP_UTF8, 0, &str[0], (int)str.size(), (LPWSTR)&wstrTo[0], size_needed);
-	return wstrTo;
+	return Transcoder::utf8ToUtf16(str);
+}
+
+std::string to_utf8(const te_string& str)
+{
+	return Transcoder::utf16ToUtf8(str);
+}
+
+te_string from_utf8(const std::string& str)
+{
+	return Transcoder::utf8ToUtf16(str);
 }
 #endif
 
+TE_END_FLAVOUR
 }
@@ -0,0 +1,76 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include "stdafx.h"
+
+#include "ValueProvider.hpp"
+#include "Exception.hpp"
+
+namespace template_engine
+{
+TE_BEGIN_FLAVOUR
+
+namespace
+{
+/** \brief The outermost scope of each thread, a plain pointer so it is cheap to reach */
+thread_local RenderScope* outermostScope = nullptr;
+}
+
+RenderScope::RenderScope() :
+	_outermost(!outermostScope),
+	_values()
+{
+	if (_outermost)
+		outermostScope = this;
+}
+
+RenderScope::~RenderScope()
+{
+	if (_outermost)
+		outermostScope = nullptr;
+}
+
+RenderScope* RenderScope::current()
+{
+	return outermostScope;
+}
+
+const te_string& RenderScope::evaluate(const std::shared_ptr<const ValueProvider>& provider)
+{
+	std::pair<std::unordered_map<const ValueProvider*, Value>::iterator, bool> inserted =
+		_values.insert({ provider.get(), Value{ provider, te_string(), false } });
+	Value& entry = inserted.first->second;
+	if (!inserted.second) {
+		if (!entry.evaluated)
+			throw TemplateException("A value provider depends on its own value");
+		return entry.value;
+	}
+
+	// the provider may expand other provided values, the map keeps the entries where they are
+	try {
+		entry.value = (*provider)();
+	}
+	catch (...) {
+		_values.erase(inserted.first);
+		throw;
+	}
+
+	entry.evaluated = true;
+	return entry.value;
+}
+
+TE_END_FLAVOUR
+}
@@ -0,0 +1,135 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#ifndef __BENCHMARK_HPP_
+#define __BENCHMARK_HPP_
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <functional>
+
+#include <TemplateEngine.hpp>
+
+/** \brief Minimal self contained benchmark harness.
+ *
+ * A benchmark is a function taking a State&, the body to measure is
+ * placed inside a <code>while (state.keepRunning())</code> loop. The
+ * loop is repeated until at least State::minimumTime has passed.
+ * Throughput is reported when the benchmark calls setBytesProcessed().
+ */
+namespace bench
+{
+
+class State
+{
+public:
+	/** \brief How long each benchmark is repeated for. */
+	static constexpr double minimumTime = 0.5;
+
+	State() : _iterations(0), _bytes(0), _running(false), _seconds(0) {}
+
+	/** \brief Returns true as long as another iteration should be timed. */
+	bool keepRunning()
+	{
+		clock::time_point now = clock::now();
+		if (!_running) {
+			_running = true;
+			_start = now;
+			return true;
+		}
+
+		++_iterations;
+		_seconds = std::chrono::duration<double>(now - _start).count();
+		return _seconds < minimumTime;
+	}
+
+	/** \brief Number of bytes processed by a single iteration. */
+	void setBytesProcessed(size_t bytes) { _bytes = bytes; }
+
+	size_t iterations() const { return _iterations; }
+	size_t bytes() const { return _bytes; }
+	double seconds() const { return _seconds; }
+
+private:
+	typedef std::chrono::steady_clock clock;
+
+	size_t _iterations;
+	size_t _bytes;
+	bool _running;
+	double _seconds;
+	clock::time_point _start;
+};
+
+typedef std::function<void(State&)> BenchmarkFunction;
+
+/** \brief A named benchmark */
+struct Benchmark
+{
+	std::string name;
+	BenchmarkFunction function;
+};
+
+/** \brief All benchmarks registered with BENCHMARK() */
+inline std::vector<Benchmark>& registry()
+{
+	static std::vector<Benchmark> benchmarks;
+	return benchmarks;
+}
+
+/** \brief Used by BENCHMARK() to register a benchmark during static initialization */
+struct Registrar
+{
+	Registrar(const char* name, BenchmarkFunction function)
+	{
+		registry().push_back({ name, function });
+	}
+};
+
+/** \brief Prevent the optimizer from discarding a computed value. */
+template <typename T> inline void doNotOptimize(const T& value)
+{
+#if defined(__GNUC__)
+	asm volatile("" : : "g"(&value) : "memory");
+#else
+	static volatile const void* sink;
+	sink = &value;
+#endif
+}
+
+/** \brief Total number of bytes requested from operator new so far, counted in run.cpp. */
+size_t allocatedBytes();
+
+/** \brief Name of the flavour the benchmark was built against. */
+inline const char* flavour()
+{
+#ifdef TE_USE_UTF8
+	return "UTF-8";
+#else
+	return "UTF-16";
+#endif
+}
+
+}
+
+/** \brief Define and register a benchmark */
+#define BENCHMARK(NAME) \
+	static void NAME(bench::State&); \
+	static bench::Registrar NAME##_registrar(#NAME, NAME); \
+	static void NAME(bench::State& state)
+
+#endif // !__BENCHMARK_HPP_
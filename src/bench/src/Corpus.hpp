@@ -0,0 +1,134 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#ifndef __CORPUS_HPP_
+#define __CORPUS_HPP_
+
+#include <string>
+#include <memory>
+
+#include <TemplateEngine.hpp>
+
+/** \brief Generated inputs shared by the benchmarks.
+ *
+ * All templates are produced as UTF-8 so both flavours start from the
+ * same bytes, exactly as templates read from disk would.
+ */
+namespace bench
+{
+
+/** \brief An ASCII heavy template of roughly the requested size in bytes. */
+inline std::string textTemplate(size_t bytes)
+{
+	static const char paragraph[] =
+		"Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor "
+		"incididunt ut labore et dolore magna aliqua. Ut enim ad minim veniam, quis nostrud "
+		"exercitation ullamco laboris nisi ut aliquip ex ea commodo consequat.\n";
+
+	std::string result;
+	result.reserve(bytes + sizeof(paragraph) + 128);
+	while (result.size() < bytes) {
+		result += "<p class=\"row\">{{TITLE}}: ";
+		result += paragraph;
+		result += "{{- this comment is dropped }}<ul>{{#repeat ITEMS}}<li>{{NAME}} = {{:VALUE}}</li>{{/repeat}}</ul></p>\n";
+	}
+
+	return result;
+}
+
+/** \brief A template which is mostly plain text, with an expansion every few kilobytes. */
+inline std::string literalTemplate(size_t bytes)
+{
+	static const char sentence[] =
+		"Sed ut perspiciatis unde omnis iste natus error sit voluptatem accusantium doloremque "
+		"laudantium, totam rem aperiam, eaque ipsa quae ab illo inventore veritatis et quasi.\n";
+
+	std::string result;
+	result.reserve(bytes + 4096);
+	while (result.size() < bytes) {
+		for (int i = 0; i < 24; ++i)
+			result += sentence;
+		result += "{{TITLE}}\n";
+	}
+
+	return result;
+}
+
+/** \brief A template which is almost nothing but instructions, i.e. <code>{{...}}</code> tags. */
+inline std::string instructionTemplate(size_t bytes)
+{
+	std::string result;
+	result.reserve(bytes + 256);
+	while (result.size() < bytes) {
+		result += "{{TITLE}}{{ :TITLE }}{{#repeat ITEMS}}{{NAME}}{{:VALUE}}{{- note }}{{/repeat}}";
+		result += "{{# repeat ITEMS }}{{ NAME }}{{ ::TITLE }}{{/ repeat }}\n";
+	}
+
+	return result;
+}
+
+/** \brief A generated looking template, with expansions of the context's constants and single expansion lists. */
+inline std::string constantTemplate(size_t bytes)
+{
+	std::string result;
+	result.reserve(bytes + 256);
+	while (result.size() < bytes) {
+		result += "<header>{{APP}} {{VERSION}}</header>{{- generated }}\n<h1>{{TITLE}}</h1>";
+		result += "<ul>{{#repeat ITEMS}}<li>{{NAME}}</li>{{/repeat}}</ul>{{- generated }}<footer>{{APP}}</footer>\n";
+	}
+
+	return result;
+}
+
+/** \brief Repeat instructions nested depth levels deep, with a little text at every level. */
+inline std::string nestedTemplate(size_t depth)
+{
+	std::string result;
+	for (size_t i = 0; i < depth; ++i)
+		result += "{{#repeat ITEMS}}{{NAME}} ";
+	for (size_t i = 0; i < depth; ++i)
+		result += "{{/repeat}}";
+
+	return result;
+}
+
+/** \brief A context able to render textTemplate() */
+inline template_engine::ContextPtr textContext()
+{
+	using namespace template_engine;
+
+	DictionaryPtr root = std::make_shared<Dictionary>();
+	root->add(TE_TEXT("TITLE"), TE_TEXT("Benchmark"));
+
+	DictionaryListPtr items = std::make_shared<DictionaryList>();
+	items->add(TE_TEXT("VALUE"), TE_TEXT("42"));
+	root->add(TE_TEXT("ITEMS"), items);
+
+	static const te_char_t* names[] = { TE_TEXT("alpha"), TE_TEXT("beta"), TE_TEXT("gamma") };
+	for (const te_char_t* name : names) {
+		DictionaryPtr row = std::make_shared<Dictionary>();
+		row->add(TE_TEXT("NAME"), name);
+		items->add(row);
+	}
+
+	ContextPtr context = Context::BuildContext();
+	context->setDictionary(root);
+	return context;
+}
+
+}
+
+#endif // !__CORPUS_HPP_
@@ -0,0 +1,466 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include "Benchmark.hpp"
+#include "Corpus.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+using namespace template_engine;
+
+// End to end cost of the engine for UTF-8 templates, data and output.
+// Run both 'bench' and 'bench_utf8' to compare the two flavours, the
+// throughput is always reported in UTF-8 input bytes.
+
+namespace
+{
+const size_t templateSize = 1024 * 1024;
+}
+
+BENCHMARK(engine_ingest_template)
+{
+	std::string source = bench::textTemplate(templateSize);
+
+	while (state.keepRunning()) {
+		te_string text = from_utf8(source);
+		bench::doNotOptimize(text);
+	}
+	state.setBytesProcessed(source.size());
+}
+
+BENCHMARK(engine_parse)
+{
+	std::string source = bench::textTemplate(templateSize);
+
+	while (state.keepRunning()) {
+		StringScanner scanner(from_utf8(source));
+		TemplatePtr compiled = Template::parse(scanner);
+		bench::doNotOptimize(compiled);
+	}
+	state.setBytesProcessed(source.size());
+}
+
+BENCHMARK(engine_render)
+{
+	std::string source = bench::textTemplate(templateSize);
+	StringScanner scanner(from_utf8(source));
+	TemplatePtr compiled = Template::parse(scanner);
+	ContextPtr context = bench::textContext();
+	size_t outputSize = 0;
+
+	while (state.keepRunning()) {
+		std::string output = to_utf8(compiled->render(context));
+		outputSize = output.size();
+		bench::doNotOptimize(output);
+	}
+	state.setBytesProcessed(outputSize);
+}
+
+BENCHMARK(engine_render_constants)
+{
+	std::string source = bench::constantTemplate(templateSize / 4);
+	StringScanner scanner(from_utf8(source));
+	TemplatePtr compiled = Template::parse(scanner);
+	ContextPtr context = bench::textContext();
+	size_t outputSize = 0;
+
+	while (state.keepRunning()) {
+		te_string output = compiled->render(context);
+		outputSize = output.size();
+		bench::doNotOptimize(output);
+	}
+	state.setBytesProcessed(outputSize);
+}
+
+BENCHMARK(engine_render_optimized)
+{
+	// as engine_render_constants, after the optimization pass has folded APP and VERSION
+	std::string source = bench::constantTemplate(templateSize / 4);
+	StringScanner scanner(from_utf8(source));
+	TemplatePtr compiled = TemplateOptimizer(true).optimize(Template::parse(scanner));
+	ContextPtr context = bench::textContext();
+	size_t outputSize = 0;
+
+	while (state.keepRunning()) {
+		te_string output = compiled->render(context);
+		outputSize = output.size();
+		bench::doNotOptimize(output);
+	}
+	state.setBytesProcessed(outputSize);
+}
+
+BENCHMARK(engine_render_specialized)
+{
+	// as engine_render_constants, with the list known ahead of time and only TITLE given per render
+	std::string source = bench::constantTemplate(templateSize / 4);
+	StringScanner scanner(from_utf8(source));
+	ContextPtr context = bench::textContext();
+
+	DictionaryPtr known = std::make_shared<Dictionary>();
+	known->add(TE_TEXT("ITEMS"), context->getDictionary()->getList(TE_TEXT("ITEMS")));
+	TemplatePtr compiled = Template::specialize(Template::parse(scanner), known);
+
+	DictionaryPtr request = std::make_shared<Dictionary>();
+	request->add(TE_TEXT("TITLE"), TE_TEXT("Benchmark"));
+	context->setDictionary(request);
+	size_t outputSize = 0;
+
+	while (state.keepRunning()) {
+		te_string output = compiled->render(context);
+		outputSize = output.size();
+		bench::doNotOptimize(output);
+	}
+	state.setBytesProcessed(outputSize);
+}
+
+namespace
+{
+/** A catalogue page, a table row for every product, and the product's details in it */
+const char catalogueTemplate[] =
+	"<h1>{{TITLE}}</h1><table>{{#repeat PRODUCTS}}<tr><td>{{NAME}}</td><td>{{PRICE}} {{:CURRENCY}}</td>"
+	"<td>{{#repeat TAGS}}<span>{{TAG}}</span>{{/repeat}}</td></tr>\n{{/repeat}}</table>";
+
+/** The values of the catalogue, returns the product rows through rows */
+ContextPtr catalogueContext(size_t products, std::vector<DictionaryPtr>& rows)
+{
+	DictionaryPtr root = std::make_shared<Dictionary>();
+	root->add(TE_TEXT("TITLE"), TE_TEXT("Catalogue"));
+	root->add(TE_TEXT("CURRENCY"), TE_TEXT("EUR"));
+
+	DictionaryListPtr list = std::make_shared<DictionaryList>();
+	root->add(TE_TEXT("PRODUCTS"), list);
+	for (size_t i = 0; i < products; ++i) {
+		DictionaryPtr row = std::make_shared<Dictionary>();
+		list->add(row);
+		row->add(TE_TEXT("NAME"), from_utf8("product number " + std::to_string(i)));
+		row->add(TE_TEXT("PRICE"), from_utf8(std::to_string(10 + i % 90)));
+
+		DictionaryListPtr tags = std::make_shared<DictionaryList>();
+		row->add(TE_TEXT("TAGS"), tags);
+		for (const te_char_t* tag : { TE_TEXT("new"), TE_TEXT("sale"), TE_TEXT("popular") }) {
+			DictionaryPtr item = std::make_shared<Dictionary>();
+			tags->add(item);
+			item->add(TE_TEXT("TAG"), tag);
+		}
+		rows.push_back(row);
+	}
+
+	ContextPtr context = Context::BuildContext();
+	context->setDictionary(root);
+	return context;
+}
+}
+
+BENCHMARK(engine_rerender_full)
+{
+	// a single price changes between renders, the whole page is rendered every time
+	StringScanner scanner(from_utf8(catalogueTemplate));
+	TemplatePtr compiled = Template::parse(scanner);
+	std::vector<DictionaryPtr> rows;
+	ContextPtr context = catalogueContext(2000, rows);
+	size_t outputSize = 0;
+	size_t i = 0;
+
+	while (state.keepRunning()) {
+		rows[i % rows.size()]->set(TE_TEXT("PRICE"), from_utf8(std::to_string(i % 100)));
+		++i;
+		te_string output = compiled->render(context);
+		outputSize = output.size();
+		bench::doNotOptimize(output);
+	}
+	state.setBytesProcessed(outputSize);
+}
+
+BENCHMARK(engine_rerender_cached)
+{
+	// as engine_rerender_full, through a RenderCache which only renders the changed row
+	StringScanner scanner(from_utf8(catalogueTemplate));
+	RenderCache cache(Template::parse(scanner));
+	std::vector<DictionaryPtr> rows;
+	ContextPtr context = catalogueContext(2000, rows);
+	size_t outputSize = 0;
+	size_t i = 0;
+
+	while (state.keepRunning()) {
+		rows[i % rows.size()]->set(TE_TEXT("PRICE"), from_utf8(std::to_string(i % 100)));
+		++i;
+		te_string output = cache.render(context);
+		outputSize = output.size();
+		bench::doNotOptimize(output);
+	}
+	state.setBytesProcessed(outputSize);
+}
+
+BENCHMARK(engine_rerender_edits)
+{
+	// as engine_rerender_cached, returning the edits to the previous output rather than the output
+	StringScanner scanner(from_utf8(catalogueTemplate));
+	RenderCache cache(Template::parse(scanner));
+	std::vector<DictionaryPtr> rows;
+	ContextPtr context = catalogueContext(2000, rows);
+	size_t outputSize = cache.render(context).size();
+	size_t editSize = 0;
+	size_t i = 0;
+
+	while (state.keepRunning()) {
+		rows[i % rows.size()]->set(TE_TEXT("PRICE"), from_utf8(std::to_string(i % 100)));
+		++i;
+		std::vector<OutputEdit> edits = cache.renderEdits(context);
+		editSize = 0;
+		for (const OutputEdit& edit : edits)
+			editSize += edit.inserted.size();
+		bench::doNotOptimize(edits);
+	}
+	std::printf("  %zu code units of edits for %zu code units of output\n", editSize, outputSize);
+	state.setBytesProcessed(outputSize);
+}
+
+BENCHMARK(engine_dictionary_add_utf8)
+{
+	std::vector<std::pair<te_string, std::string>> values;
+	size_t bytes = 0;
+	for (int i = 0; i < 1000; ++i) {
+		std::string value = "value number " + std::to_string(i) + " with some ordinary ASCII text";
+		bytes += value.size();
+		values.push_back({ from_utf8("NAME" + std::to_string(i)), value });
+	}
+
+	while (state.keepRunning()) {
+		DictionaryPtr dictionary = std::make_shared<Dictionary>();
+		for (const auto& v : values)
+			dictionary->add(v.first, from_utf8(v.second));
+		bench::doNotOptimize(dictionary);
+	}
+	state.setBytesProcessed(bytes);
+}
+
+namespace
+{
+const char requestTemplate[] = "<h1>{{TITLE}}</h1><p>{{VALUE3}}</p>{{#repeat ITEMS}}<li>{{NAME}} {{:VALUE3}}</li>{{/repeat}}";
+const int requestValues = 8;
+
+/** Stands in for a value which is expensive to compute, e.g. an aggregate over the database */
+te_string expensiveValue(int seed)
+{
+	uint32_t hash = 2166136261u;
+	for (int i = 0; i < 20000; ++i)
+		hash = (hash ^ static_cast<uint32_t>(seed + i)) * 16777619u;
+	return from_utf8(std::to_string(hash));
+}
+
+/** A request's dictionary, the values are computed up front, or provided when expanded */
+DictionaryPtr requestDictionary(bool provided)
+{
+	DictionaryPtr root = std::make_shared<Dictionary>();
+	root->add(TE_TEXT("TITLE"), TE_TEXT("Request"));
+	for (int v = 0; v < requestValues; ++v) {
+		te_string name = from_utf8("VALUE" + std::to_string(v));
+		if (provided)
+			root->addProvider(name, [v]() { return expensiveValue(v); });
+		else
+			root->add(name, expensiveValue(v));
+	}
+
+	DictionaryListPtr items = std::make_shared<DictionaryList>();
+	root->add(TE_TEXT("ITEMS"), items);
+	for (int i = 0; i < 20; ++i) {
+		DictionaryPtr row = std::make_shared<Dictionary>();
+		row->add(TE_TEXT("NAME"), from_utf8("item " + std::to_string(i)));
+		items->add(row);
+	}
+	return root;
+}
+
+void renderRequests(bench::State& state, bool provided)
+{
+	StringScanner scanner(from_utf8(requestTemplate));
+	TemplatePtr compiled = Template::parse(scanner);
+	ContextPtr context = Context::BuildContext();
+	size_t outputSize = 0;
+
+	while (state.keepRunning()) {
+		context->setDictionary(requestDictionary(provided));
+		te_string output = compiled->render(context);
+		outputSize = output.size();
+		bench::doNotOptimize(output);
+	}
+	state.setBytesProcessed(outputSize);
+}
+}
+
+// a template variant expanding one of the request's expensive values, 21 times
+BENCHMARK(engine_request_values_eager)
+{
+	renderRequests(state, false);
+}
+
+BENCHMARK(engine_request_values_provided)
+{
+	renderRequests(state, true);
+}
+
+namespace
+{
+const char exportTemplate[] = "<table>{{#repeat ROWS}}<tr><td>{{ID}}</td><td>{{NAME}}</td><td>{{AMOUNT:.2f}}</td></tr>\n{{/repeat}}</table>";
+const int exportRows = 200000;
+
+DictionaryPtr exportRow(int i)
+{
+	DictionaryPtr row = std::make_shared<Dictionary>();
+	row->add(TE_TEXT("ID"), TypedValue(i));
+	row->add(TE_TEXT("NAME"), TE_TEXT("customer name"));
+	row->add(TE_TEXT("AMOUNT"), TypedValue(i * 0.25));
+	return row;
+}
+
+/** Counts the code units written, and the largest write */
+class CountingSink : public OutputSink
+{
+public:
+	CountingSink() : total(0), largest(0) {}
+
+	using OutputSink::write;
+
+	virtual void write(const te_char_t* data, size_t length)
+	{
+		bench::doNotOptimize(data);
+		total += length;
+		largest = std::max(largest, length);
+	}
+
+	size_t total;
+	size_t largest;
+};
+}
+
+// an export, with every row stored in a list and the output rendered into a
+// string, or with the rows produced on demand and the output streamed
+BENCHMARK(engine_export_materialized)
+{
+	StringScanner scanner(from_utf8(exportTemplate));
+	TemplatePtr compiled = Template::parse(scanner);
+	ContextPtr context = Context::BuildContext();
+	CountingSink sink;
+
+	while (state.keepRunning()) {
+		DictionaryPtr root = std::make_shared<Dictionary>();
+		DictionaryListPtr rows = std::make_shared<DictionaryList>();
+		root->add(TE_TEXT("ROWS"), rows);
+		for (int i = 0; i < exportRows; ++i)
+			rows->add(exportRow(i));
+		context->setDictionary(root);
+
+		sink = CountingSink();
+		sink.write(compiled->render(context));
+	}
+	std::printf("  %zu code units held at once for %zu code units of output\n", sink.largest, sink.total);
+	state.setBytesProcessed(sink.total);
+}
+
+BENCHMARK(engine_export_streamed)
+{
+	StringScanner scanner(from_utf8(exportTemplate));
+	TemplatePtr compiled = Template::parse(scanner);
+	ContextPtr context = Context::BuildContext();
+	CountingSink sink;
+
+	while (state.keepRunning()) {
+		DictionaryPtr root = std::make_shared<Dictionary>();
+		int next = 0;
+		root->add(TE_TEXT("ROWS"), std::make_shared<DictionaryList>([&next]() {
+			return next < exportRows ? exportRow(next++) : nullptr;
+		}));
+		context->setDictionary(root);
+
+		sink = CountingSink();
+		compiled->renderInto(context, sink);
+	}
+	std::printf("  %zu code units held at once for %zu code units of output\n", sink.largest, sink.total);
+	state.setBytesProcessed(sink.total);
+}
+
+BENCHMARK(engine_template_footprint)
+{
+	// not a timing benchmark as such, reports the memory used to hold the template text
+	std::string source = bench::textTemplate(templateSize);
+	te_string text;
+
+	while (state.keepRunning()) {
+		text = from_utf8(source);
+	}
+	std::printf("  template text: %zu UTF-8 bytes held in %zu bytes\n",
+		source.size(), text.size() * sizeof(te_char_t));
+	state.setBytesProcessed(source.size());
+}
+
+namespace
+{
+/** A template file, removed again when the benchmark is done */
+struct TemplateFile
+{
+	TemplateFile(const std::string& content) :
+		path("bench_" + std::to_string(sizeof(te_char_t)) + ".tmp")
+	{
+		std::ofstream file(path.c_str(), std::ios::binary);
+		file << content;
+	}
+
+	~TemplateFile() { std::remove(path.c_str()); }
+
+	std::string path;
+};
+}
+
+BENCHMARK(engine_parse_file_read)
+{
+	// the traditional way: read the file into a string, convert it and scan it
+	std::string source = bench::literalTemplate(templateSize);
+	TemplateFile file(source);
+	size_t allocated = 0;
+
+	while (state.keepRunning()) {
+		size_t before = bench::allocatedBytes();
+		std::ifstream stream(file.path.c_str(), std::ios::binary);
+		std::stringstream buffer;
+		buffer << stream.rdbuf();
+		StringScanner scanner(from_utf8(buffer.str()));
+		TemplatePtr compiled = Template::parse(scanner);
+		allocated = bench::allocatedBytes() - before;
+		bench::doNotOptimize(compiled);
+	}
+	std::printf("  %zu bytes allocated for a %zu byte file\n", allocated, source.size());
+	state.setBytesProcessed(source.size());
+}
+
+BENCHMARK(engine_parse_file_mapped)
+{
+	std::string source = bench::literalTemplate(templateSize);
+	TemplateFile file(source);
+	size_t allocated = 0;
+
+	while (state.keepRunning()) {
+		size_t before = bench::allocatedBytes();
+		MappedFileScanner scanner(file.path);
+		TemplatePtr compiled = Template::parse(scanner);
+		allocated = bench::allocatedBytes() - before;
+		bench::doNotOptimize(compiled);
+	}
+	std::printf("  %zu bytes allocated for a %zu byte file\n", allocated, source.size());
+	state.setBytesProcessed(source.size());
+}
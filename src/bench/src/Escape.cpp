@@ -0,0 +1,211 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include "Benchmark.hpp"
+#include "Corpus.hpp"
+
+using namespace template_engine;
+
+// HTML escaping of the expanded values, through a std::function filter
+// escaping a code unit at a time, through the same filter wrapping the
+// vectorized HtmlEscaper, and with the escaper selected at compile time.
+// The mixed benchmarks escape everything with a filter, or only the
+// expansions which need it, with a filter chain in the template.
+
+namespace
+{
+const char listTemplate[] =
+	"<ul>{{#repeat ITEMS}}<li title=\"{{NAME}}\">{{DESCRIPTION}}</li>\n{{/repeat}}</ul>";
+
+const char mixedTemplate[] =
+	"<ul>{{#repeat ITEMS}}<li id=\"item-{{ID}}\"><a href=\"/product/{{ID}}\">{{NAME}}</a> "
+	"<span class=\"price\">{{PRICE}}</span> {{DESCRIPTION}}</li>\n{{/repeat}}</ul>";
+
+const char chainTemplate[] =
+	"<ul>{{#repeat ITEMS}}<li id=\"item-{{ID}}\"><a href=\"/product/{{ID}}\">{{NAME|html}}</a> "
+	"<span class=\"price\">{{PRICE}}</span> {{DESCRIPTION|html}}</li>\n{{/repeat}}</ul>";
+
+/** Product descriptions, mostly plain text with the odd character which must be escaped */
+ContextPtr listContext()
+{
+	DictionaryPtr root = std::make_shared<Dictionary>();
+	DictionaryListPtr items = std::make_shared<DictionaryList>();
+	root->add(TE_TEXT("ITEMS"), items);
+
+	for (int i = 0; i < 2000; ++i) {
+		DictionaryPtr row = std::make_shared<Dictionary>();
+		row->add(TE_TEXT("ID"), from_utf8(std::to_string(100000 + i)));
+		row->add(TE_TEXT("PRICE"), from_utf8(std::to_string(10 + i % 90) + ".95"));
+		row->add(TE_TEXT("NAME"), from_utf8("Product " + std::to_string(i) + (i % 10 ? "" : " \"special\"")));
+		row->add(TE_TEXT("DESCRIPTION"), from_utf8(
+			"A sturdy, well made product which will serve you for years, comes with a two year "
+			"warranty & free shipping on orders above 50 EUR. Available in three colours, number " + std::to_string(i)));
+		items->add(row);
+	}
+
+	ContextPtr context = Context::BuildContext();
+	context->setDictionary(root);
+	return context;
+}
+
+TemplatePtr parseList(const char* definition = listTemplate)
+{
+	StringScanner scanner(from_utf8(definition));
+	return Template::parse(scanner);
+}
+
+/** The straightforward filter, a code unit at a time */
+te_string escapeHtml(const te_string& value)
+{
+	te_string result;
+	for (te_char_t ch : value) {
+		switch (ch) {
+		case TE_TEXT('&'): result += TE_TEXT("&amp;"); break;
+		case TE_TEXT('<'): result += TE_TEXT("&lt;"); break;
+		case TE_TEXT('>'): result += TE_TEXT("&gt;"); break;
+		case TE_TEXT('"'): result += TE_TEXT("&quot;"); break;
+		case TE_TEXT('\''): result += TE_TEXT("&#39;"); break;
+		default: result += ch; break;
+		}
+	}
+	return result;
+}
+}
+
+BENCHMARK(escape_render_lambda)
+{
+	TemplatePtr compiled = parseList();
+	ContextPtr context = listContext();
+	TemplateFilter filter = [](const te_string& value) { return escapeHtml(value); };
+	size_t outputSize = 0;
+
+	while (state.keepRunning()) {
+		te_string output = compiled->render(context, filter);
+		outputSize = output.size();
+		bench::doNotOptimize(output);
+	}
+	state.setBytesProcessed(outputSize);
+}
+
+BENCHMARK(escape_render_filter)
+{
+	TemplatePtr compiled = parseList();
+	ContextPtr context = listContext();
+	TemplateFilter filter = escapeFilter<HtmlEscaper>();
+	size_t outputSize = 0;
+
+	while (state.keepRunning()) {
+		te_string output = compiled->render(context, filter);
+		outputSize = output.size();
+		bench::doNotOptimize(output);
+	}
+	state.setBytesProcessed(outputSize);
+}
+
+BENCHMARK(escape_render_escaper)
+{
+	TemplatePtr compiled = parseList();
+	ContextPtr context = listContext();
+	size_t outputSize = 0;
+
+	while (state.keepRunning()) {
+		te_string output = compiled->render<HtmlEscaper>(context);
+		outputSize = output.size();
+		bench::doNotOptimize(output);
+	}
+	state.setBytesProcessed(outputSize);
+}
+
+BENCHMARK(escape_render_into)
+{
+	// as escape_render_escaper, appending to a buffer which is reused between renders
+	TemplatePtr compiled = parseList();
+	ContextPtr context = listContext();
+	te_string output;
+
+	while (state.keepRunning()) {
+		output.clear();
+		compiled->renderInto(context, output, &HtmlEscaper::append);
+		bench::doNotOptimize(output);
+	}
+	state.setBytesProcessed(output.size());
+}
+
+BENCHMARK(escape_mixed_filter)
+{
+	TemplatePtr compiled = parseList(mixedTemplate);
+	ContextPtr context = listContext();
+	TemplateFilter filter = escapeFilter<HtmlEscaper>();
+	size_t outputSize = 0;
+
+	while (state.keepRunning()) {
+		te_string output = compiled->render(context, filter);
+		outputSize = output.size();
+		bench::doNotOptimize(output);
+	}
+	state.setBytesProcessed(outputSize);
+}
+
+BENCHMARK(escape_mixed_chain)
+{
+	TemplatePtr compiled = parseList(chainTemplate);
+	ContextPtr context = listContext();
+	size_t outputSize = 0;
+
+	while (state.keepRunning()) {
+		te_string output = compiled->render(context);
+		outputSize = output.size();
+		bench::doNotOptimize(output);
+	}
+	state.setBytesProcessed(outputSize);
+}
+
+BENCHMARK(escape_html_scalar)
+{
+	te_string text = from_utf8(bench::textTemplate(1024 * 1024));
+
+	while (state.keepRunning()) {
+		te_string output = escapeHtml(text);
+		bench::doNotOptimize(output);
+	}
+	state.setBytesProcessed(text.size());
+}
+
+BENCHMARK(escape_html)
+{
+	te_string text = from_utf8(bench::textTemplate(1024 * 1024));
+	te_string output;
+
+	while (state.keepRunning()) {
+		output.clear();
+		HtmlEscaper::append(output, text.data(), text.size());
+		bench::doNotOptimize(output);
+	}
+	state.setBytesProcessed(text.size());
+}
+
+BENCHMARK(escape_json)
+{
+	te_string text = from_utf8(bench::textTemplate(1024 * 1024));
+	te_string output;
+
+	while (state.keepRunning()) {
+		output.clear();
+		JsonEscaper::append(output, text.data(), text.size());
+		bench::doNotOptimize(output);
+	}
+	state.setBytesProcessed(text.size());
+}
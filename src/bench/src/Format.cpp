@@ -0,0 +1,146 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include "Benchmark.hpp"
+
+#include <cstdio>
+
+using namespace template_engine;
+
+// Numbers, booleans and timestamps formatted by the producer into strings
+// up front, against typed values formatted by the template when they are
+// expanded. The rows carry more values than the template expands, as the
+// rows of a real producer do. The throughput is the rendered output.
+
+namespace
+{
+const int rowCount = 2000;
+
+const char rowTemplate[] =
+	"<ul>{{#repeat ITEMS}}<li id=\"item-{{ID}}\">{{PRICE}} ({{STOCK}})</li>\n{{/repeat}}</ul>";
+
+const char formattedTemplate[] =
+	"<ul>{{#repeat ITEMS}}<li id=\"item-{{ID}}\">{{PRICE:.2f}} ({{STOCK}})</li>\n{{/repeat}}</ul>";
+
+const std::chrono::system_clock::time_point updated = std::chrono::system_clock::time_point() + std::chrono::hours(24 * 20000);
+
+te_string formatted(const char* format, double value)
+{
+	char buffer[64];
+	std::snprintf(buffer, sizeof(buffer), format, value);
+	return from_utf8(buffer);
+}
+
+ContextPtr context(DictionaryPtr root)
+{
+	ContextPtr result = Context::BuildContext();
+	result->setDictionary(root);
+	return result;
+}
+
+/** Every value formatted to a string as the dictionary is built */
+ContextPtr stringContext()
+{
+	DictionaryPtr root = std::make_shared<Dictionary>();
+	DictionaryListPtr items = std::make_shared<DictionaryList>();
+	root->add(TE_TEXT("ITEMS"), items);
+
+	for (int i = 0; i < rowCount; ++i) {
+		DictionaryPtr row = std::make_shared<Dictionary>();
+		row->add(TE_TEXT("ID"), from_utf8(std::to_string(100000 + i)));
+		row->add(TE_TEXT("PRICE"), formatted("%.2f", 10 + i % 90 + 0.95));
+		row->add(TE_TEXT("STOCK"), from_utf8(std::to_string(i % 1000)));
+		row->add(TE_TEXT("WEIGHT"), formatted("%.3f", 0.25 * (i % 17)));
+		row->add(TE_TEXT("DISCOUNTED"), (i % 7) ? TE_TEXT("false") : TE_TEXT("true"));
+		row->add(TE_TEXT("UPDATED"), TypedValue(updated + std::chrono::seconds(i)).toString());
+		items->add(row);
+	}
+	return context(root);
+}
+
+/** The values stored as they are */
+ContextPtr typedContext()
+{
+	DictionaryPtr root = std::make_shared<Dictionary>();
+	DictionaryListPtr items = std::make_shared<DictionaryList>();
+	root->add(TE_TEXT("ITEMS"), items);
+
+	for (int i = 0; i < rowCount; ++i) {
+		DictionaryPtr row = std::make_shared<Dictionary>();
+		row->add(TE_TEXT("ID"), TypedValue(100000 + i));
+		row->add(TE_TEXT("PRICE"), TypedValue(10 + i % 90 + 0.95));
+		row->add(TE_TEXT("STOCK"), TypedValue(i % 1000));
+		row->add(TE_TEXT("WEIGHT"), TypedValue(0.25 * (i % 17)));
+		row->add(TE_TEXT("DISCOUNTED"), TypedValue(i % 7 == 0));
+		row->add(TE_TEXT("UPDATED"), TypedValue(updated + std::chrono::seconds(i)));
+		items->add(row);
+	}
+	return context(root);
+}
+
+TemplatePtr parse(const char* definition)
+{
+	StringScanner scanner(from_utf8(definition));
+	return Template::parse(scanner);
+}
+
+template <typename Build>
+void buildAndRender(bench::State& state, const char* definition, Build build)
+{
+	TemplatePtr compiled = parse(definition);
+	size_t outputSize = 0;
+
+	while (state.keepRunning()) {
+		te_string output = compiled->render(build());
+		outputSize = output.size();
+		bench::doNotOptimize(output);
+	}
+	state.setBytesProcessed(outputSize);
+}
+
+void render(bench::State& state, const char* definition, ContextPtr context)
+{
+	TemplatePtr compiled = parse(definition);
+	size_t outputSize = 0;
+
+	while (state.keepRunning()) {
+		te_string output = compiled->render(context);
+		outputSize = output.size();
+		bench::doNotOptimize(output);
+	}
+	state.setBytesProcessed(outputSize);
+}
+}
+
+BENCHMARK(format_build_strings)
+{
+	buildAndRender(state, rowTemplate, &stringContext);
+}
+
+BENCHMARK(format_build_typed)
+{
+	buildAndRender(state, formattedTemplate, &typedContext);
+}
+
+BENCHMARK(format_render_strings)
+{
+	render(state, rowTemplate, stringContext());
+}
+
+BENCHMARK(format_render_typed)
+{
+	render(state, formattedTemplate, typedContext());
+}
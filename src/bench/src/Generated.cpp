@@ -0,0 +1,77 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include "Benchmark.hpp"
+#include "Corpus.hpp"
+
+// generated by te-compile from templates/page.tmpl
+#include "bench_templates.hpp"
+
+using namespace template_engine;
+
+// A template compiled into C++ by te-compile, against the same template
+// parsed at runtime and rendered by walking the template tree.
+
+namespace
+{
+TemplatePtr parsePage()
+{
+	MappedFileScanner scanner(std::string(BENCH_TEMPLATE_DIR) + "/page.tmpl");
+	return Template::parse(scanner);
+}
+}
+
+BENCHMARK(generated_render_interpreted)
+{
+	TemplatePtr compiled = parsePage();
+	ContextPtr context = bench::textContext();
+	size_t outputSize = 0;
+
+	while (state.keepRunning()) {
+		te_string output = compiled->render(context);
+		outputSize = output.size();
+		bench::doNotOptimize(output);
+	}
+	state.setBytesProcessed(outputSize);
+}
+
+BENCHMARK(generated_render_optimized)
+{
+	TemplatePtr compiled = TemplateOptimizer(true).optimize(parsePage());
+	ContextPtr context = bench::textContext();
+	size_t outputSize = 0;
+
+	while (state.keepRunning()) {
+		te_string output = compiled->render(context);
+		outputSize = output.size();
+		bench::doNotOptimize(output);
+	}
+	state.setBytesProcessed(outputSize);
+}
+
+BENCHMARK(generated_render_function)
+{
+	ContextPtr context = bench::textContext();
+	size_t outputSize = 0;
+
+	while (state.keepRunning()) {
+		te_string output;
+		templates::render_page(output, context->getDictionary());
+		outputSize = output.size();
+		bench::doNotOptimize(output);
+	}
+	state.setBytesProcessed(outputSize);
+}
@@ -0,0 +1,273 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include "Benchmark.hpp"
+#include "Corpus.hpp"
+
+using namespace template_engine;
+
+// Parser throughput, measured in UTF-8 input bytes. The template is
+// converted up front, so only scanning, lexing and tree building are timed.
+
+namespace
+{
+const size_t templateSize = 1024 * 1024;
+
+/** \brief A scanner implementing nothing but the per code unit interface.
+ *
+ * This is how every scanner looked before the block interface, the
+ * default Scanner::getBlock() adapter hands it to the lexer one code
+ * unit at a time, i.e. one virtual call per code unit.
+ */
+class PerUnitScanner : public Scanner
+{
+public:
+	PerUnitScanner(const te_string& t) : _scanner(t) {}
+
+	virtual bool moveNext() { return _scanner.moveNext(); }
+	virtual bool atEos() const { return _scanner.atEos(); }
+	virtual te_char_t getChar() const { return _scanner.getChar(); }
+
+private:
+	StringScanner _scanner;
+};
+
+/** \brief Parse nestedTemplate(depth) a number of times, the input is kept small enough to be cache resident. */
+void parseNested(bench::State& state, size_t depth)
+{
+	std::string source;
+	while (source.size() < 64 * 1024)
+		source += bench::nestedTemplate(depth);
+	te_string text = from_utf8(source);
+
+	while (state.keepRunning()) {
+		StringScanner scanner(SourceBuffer::borrow(text));
+		TemplatePtr compiled = Template::parse(scanner, depth);
+		bench::doNotOptimize(compiled);
+	}
+	state.setBytesProcessed(source.size());
+}
+
+/** \brief Parse a large tag dense template with the ParallelParser, on the given number of threads. */
+void parseParallel(bench::State& state, unsigned threads)
+{
+	std::string source = bench::instructionTemplate(8 * templateSize);
+	te_string text = from_utf8(source);
+	ParallelParser parser(threads);
+
+	while (state.keepRunning()) {
+		TemplatePtr compiled = parser.parse(SourceBuffer::borrow(text));
+		bench::doNotOptimize(compiled);
+	}
+	state.setBytesProcessed(source.size());
+}
+}
+
+BENCHMARK(parse_block_scanner)
+{
+	std::string source = bench::textTemplate(templateSize);
+	te_string text = from_utf8(source);
+
+	while (state.keepRunning()) {
+		StringScanner scanner(text);
+		TemplatePtr compiled = Template::parse(scanner);
+		bench::doNotOptimize(compiled);
+	}
+	state.setBytesProcessed(source.size());
+}
+
+BENCHMARK(parse_per_unit_scanner)
+{
+	std::string source = bench::textTemplate(templateSize);
+	te_string text = from_utf8(source);
+
+	while (state.keepRunning()) {
+		PerUnitScanner scanner(text);
+		TemplatePtr compiled = Template::parse(scanner);
+		bench::doNotOptimize(compiled);
+	}
+	state.setBytesProcessed(source.size());
+}
+
+BENCHMARK(parse_literal_runs)
+{
+	std::string source = bench::literalTemplate(templateSize);
+	te_string text = from_utf8(source);
+
+	while (state.keepRunning()) {
+		StringScanner scanner(text);
+		TemplatePtr compiled = Template::parse(scanner);
+		bench::doNotOptimize(compiled);
+	}
+	state.setBytesProcessed(source.size());
+}
+
+BENCHMARK(parse_instruction_dense)
+{
+	std::string source = bench::instructionTemplate(templateSize);
+	te_string text = from_utf8(source);
+
+	while (state.keepRunning()) {
+		StringScanner scanner(text);
+		TemplatePtr compiled = Template::parse(scanner);
+		bench::doNotOptimize(compiled);
+	}
+	state.setBytesProcessed(source.size());
+}
+
+BENCHMARK(lex_instruction_dense)
+{
+	// the lexer on its own, without building the template tree
+	std::string source = bench::instructionTemplate(templateSize);
+	te_string text = from_utf8(source);
+	size_t tokens = 0;
+
+	while (state.keepRunning()) {
+		StringScanner scanner(text);
+		Lexer lexer(scanner);
+		while (Lexer::Token::token_t::Eos != lexer.getNextToken().getType())
+			++tokens;
+	}
+	bench::doNotOptimize(tokens);
+	state.setBytesProcessed(source.size());
+}
+
+BENCHMARK(parse_footprint)
+{
+	// not a timing benchmark as such, reports the memory allocated while parsing,
+	// which includes the text held by the parsed template
+	std::string source = bench::literalTemplate(templateSize);
+	te_string text = from_utf8(source);
+	size_t owned = 0;
+	size_t borrowed = 0;
+
+	while (state.keepRunning()) {
+		te_string copy = text;
+		size_t before = bench::allocatedBytes();
+		{
+			StringScanner scanner(std::move(copy));
+			TemplatePtr compiled = Template::parse(scanner);
+			owned = bench::allocatedBytes() - before;
+		}
+
+		before = bench::allocatedBytes();
+		{
+			StringScanner scanner(SourceBuffer::borrow(text));
+			TemplatePtr compiled = Template::parse(scanner);
+			borrowed = bench::allocatedBytes() - before;
+		}
+	}
+	std::printf("  %zu bytes of text, parsing allocated %zu bytes when owned and %zu bytes when borrowed\n",
+		text.size() * sizeof(te_char_t), owned, borrowed);
+	state.setBytesProcessed(source.size());
+}
+
+BENCHMARK(parse_push_chunks)
+{
+	// the push parser fed 4 KiB at a time, as if the template arrived over a socket
+	std::string source = bench::instructionTemplate(templateSize);
+	te_string text = from_utf8(source);
+	const size_t chunkSize = 4096;
+
+	while (state.keepRunning()) {
+		TemplateParser parser;
+		for (size_t pos = 0; pos < text.size(); pos += chunkSize)
+			parser.feed(text.data() + pos, std::min(chunkSize, text.size() - pos));
+		TemplatePtr compiled = parser.finish();
+		bench::doNotOptimize(compiled);
+	}
+	state.setBytesProcessed(source.size());
+}
+
+BENCHMARK(parse_nesting_1)
+{
+	parseNested(state, 1);
+}
+
+BENCHMARK(parse_nesting_10)
+{
+	parseNested(state, 10);
+}
+
+BENCHMARK(parse_nesting_100)
+{
+	parseNested(state, 100);
+}
+
+BENCHMARK(parse_nesting_1000)
+{
+	parseNested(state, 1000);
+}
+
+BENCHMARK(parse_nesting_10000)
+{
+	parseNested(state, 10000);
+}
+
+BENCHMARK(parse_parallel_1)
+{
+	parseParallel(state, 1);
+}
+
+BENCHMARK(parse_parallel_2)
+{
+	parseParallel(state, 2);
+}
+
+BENCHMARK(parse_parallel_4)
+{
+	parseParallel(state, 4);
+}
+
+BENCHMARK(parse_parallel_8)
+{
+	parseParallel(state, 8);
+}
+
+// a keystroke at a time in a 2 MB template, reparsed from scratch and incrementally
+
+BENCHMARK(parse_edit_full_2mb)
+{
+	te_string text = from_utf8(bench::textTemplate(2 * templateSize));
+	size_t offset = text.size() / 2;
+	bool inserted = false;
+
+	while (state.keepRunning()) {
+		if (inserted)
+			text.erase(offset, 1);
+		else
+			text.insert(offset, 1, TE_TEXT('x'));
+		inserted = !inserted;
+
+		StringScanner scanner(SourceBuffer::borrow(text));
+		TemplatePtr compiled = Template::parse(scanner);
+		bench::doNotOptimize(compiled);
+	}
+}
+
+BENCHMARK(parse_edit_incremental_2mb)
+{
+	IncrementalParser parser;
+	parser.parse(from_utf8(bench::textTemplate(2 * templateSize)));
+	size_t offset = parser.size() / 2;
+	bool inserted = false;
+
+	while (state.keepRunning()) {
+		TemplatePtr compiled = inserted ? parser.edit(offset, 1, te_string()) : parser.edit(offset, 0, TE_TEXT("x"));
+		inserted = !inserted;
+		bench::doNotOptimize(compiled);
+	}
+}
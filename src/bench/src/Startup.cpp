@@ -0,0 +1,140 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include "Benchmark.hpp"
+#include "Corpus.hpp"
+
+#include <cstdio>
+#include <fstream>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+using namespace template_engine;
+
+// Cost of getting an application's templates ready at startup, 5000
+// templates of about 2 KiB each, parsed from their files, compiled into
+// an empty cache directory (cold) and loaded from the cache (warm).
+
+namespace
+{
+const size_t templateCount = 5000;
+const size_t templateSize = 2 * 1024;
+
+/** The template files, removed again when the benchmarks are done */
+struct TemplateFiles
+{
+	TemplateFiles() :
+		directory("bench_startup_" + std::to_string(sizeof(te_char_t))),
+		bytes(0)
+	{
+#ifdef _WIN32
+		_mkdir(directory.c_str());
+#else
+		::mkdir(directory.c_str(), 0777);
+#endif
+		for (size_t i = 0; i < templateCount; ++i) {
+			// every template is different, so each gets an image of its own
+			std::string content = "{{- template " + std::to_string(i) + " }}" + bench::textTemplate(templateSize);
+			paths.push_back(directory + "/" + std::to_string(i) + ".tmpl");
+			std::ofstream file(paths.back().c_str(), std::ios::binary);
+			file << content;
+			bytes += content.size();
+		}
+	}
+
+	~TemplateFiles()
+	{
+		for (const std::string& path : paths)
+			std::remove(path.c_str());
+		std::remove(directory.c_str());
+	}
+
+	/** Remove the images of the templates from the cache */
+	void clear(const TemplateCache& cache) const
+	{
+		for (const std::string& path : paths)
+			std::remove(cache.getImagePath(path).c_str());
+	}
+
+	std::string directory;
+	std::vector<std::string> paths;
+	size_t bytes;
+};
+
+const TemplateFiles& files()
+{
+	static TemplateFiles instance;
+	return instance;
+}
+
+std::string cacheDirectory()
+{
+	return "bench_startup_cache_" + std::to_string(sizeof(te_char_t));
+}
+}
+
+BENCHMARK(startup_parse_5k)
+{
+	const TemplateFiles& templates = files();
+
+	while (state.keepRunning()) {
+		std::vector<TemplatePtr> compiled;
+		for (const std::string& path : templates.paths) {
+			MappedFileScanner scanner(path);
+			compiled.push_back(Template::parse(scanner));
+		}
+		bench::doNotOptimize(compiled);
+	}
+	state.setBytesProcessed(templates.bytes);
+}
+
+BENCHMARK(startup_cache_cold_5k)
+{
+	const TemplateFiles& templates = files();
+	TemplateCache cache(cacheDirectory());
+
+	while (state.keepRunning()) {
+		templates.clear(cache);
+		std::vector<TemplatePtr> compiled;
+		for (const std::string& path : templates.paths)
+			compiled.push_back(cache.load(path));
+		bench::doNotOptimize(compiled);
+	}
+	state.setBytesProcessed(templates.bytes);
+}
+
+BENCHMARK(startup_cache_warm_5k)
+{
+	const TemplateFiles& templates = files();
+	TemplateCache cache(cacheDirectory());
+	for (const std::string& path : templates.paths)
+		cache.load(path);
+
+	while (state.keepRunning()) {
+		std::vector<TemplatePtr> compiled;
+		for (const std::string& path : templates.paths)
+			compiled.push_back(cache.load(path));
+		bench::doNotOptimize(compiled);
+	}
+	state.setBytesProcessed(templates.bytes);
+
+	templates.clear(cache);
+	std::remove(cacheDirectory().c_str());
+}
@@ -0,0 +1,77 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include "Benchmark.hpp"
+#include "Corpus.hpp"
+
+using namespace template_engine;
+
+// A small template given as a string literal, parsed at runtime for every
+// render, parsed once at runtime, and parsed while compiling.
+
+namespace
+{
+TE_STATIC_TEMPLATE(card,
+	"<div class=\"card\">\n<h3>{{TITLE}}</h3>{{- the items }}\n"
+	"<ul>{{#repeat ITEMS}}<li><b>{{NAME}}</b> = {{:VALUE}} in {{::TITLE}}</li>{{/repeat}}</ul>\n"
+	"<p>Rendered from a string literal compiled into the application.</p>\n</div>\n");
+
+TemplatePtr parseCard()
+{
+	StringScanner scanner(card_definition);
+	return Template::parse(scanner);
+}
+}
+
+BENCHMARK(static_parse_and_render)
+{
+	ContextPtr context = bench::textContext();
+	size_t outputSize = 0;
+
+	while (state.keepRunning()) {
+		te_string output = parseCard()->render(context);
+		outputSize = output.size();
+		bench::doNotOptimize(output);
+	}
+	state.setBytesProcessed(outputSize);
+}
+
+BENCHMARK(static_render_interpreted)
+{
+	TemplatePtr compiled = parseCard();
+	ContextPtr context = bench::textContext();
+	size_t outputSize = 0;
+
+	while (state.keepRunning()) {
+		te_string output = compiled->render(context);
+		outputSize = output.size();
+		bench::doNotOptimize(output);
+	}
+	state.setBytesProcessed(outputSize);
+}
+
+BENCHMARK(static_render_static)
+{
+	ContextPtr context = bench::textContext();
+	size_t outputSize = 0;
+
+	while (state.keepRunning()) {
+		te_string output = card.render(context);
+		outputSize = output.size();
+		bench::doNotOptimize(output);
+	}
+	state.setBytesProcessed(outputSize);
+}
@@ -0,0 +1,125 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include <locale>
+#include <codecvt>
+
+#include "Benchmark.hpp"
+
+using namespace template_engine;
+
+// Throughput of the UTF-8 <-> UTF-16 transcoder on four corpora, reported
+// in UTF-8 bytes per second. The *_codecvt variants measure the former
+// std::wstring_convert based te_converter as a baseline.
+
+namespace
+{
+
+const size_t corpusSize = 4 * 1024 * 1024;
+
+std::string repeatTo(const char* text, size_t bytes)
+{
+	std::string result;
+	while (result.size() < bytes)
+		result += text;
+	return result;
+}
+
+std::string asciiCorpus()
+{
+	return repeatTo("The quick brown fox jumps over the lazy dog. 0123456789 <tag attr=\"value\"/>\n", corpusSize);
+}
+
+std::string latinCorpus()
+{
+	return repeatTo("Le cœur déçu mais l'âme plutôt naïve, Louÿs rêva de crapaüter en canoë au delà des îles. ", corpusSize);
+}
+
+std::string cjkCorpus()
+{
+	return repeatTo("日本語のテキストは主に三バイトの文字で構成されています。中文文本同样如此。", corpusSize);
+}
+
+std::string astralCorpus()
+{
+	return repeatTo("\U0001F600\U0001F601\U0001F602\U0001F923\U0001F603 \U00020000\U0002A6D6\U0001D11E ", corpusSize);
+}
+
+void toUtf16(bench::State& state, const std::string& corpus)
+{
+	std::u16string out(corpus.size(), u'\0');
+	while (state.keepRunning()) {
+		size_t n = Transcoder::utf8ToUtf16(corpus.data(), corpus.size(), &out[0]);
+		bench::doNotOptimize(n);
+	}
+	state.setBytesProcessed(corpus.size());
+}
+
+void toUtf8(bench::State& state, const std::string& corpus)
+{
+	std::u16string wide = Transcoder::utf8ToUtf16(corpus);
+	std::string out(wide.size() * 3, '\0');
+	while (state.keepRunning()) {
+		size_t n = Transcoder::utf16ToUtf8(wide.data(), wide.size(), &out[0]);
+		bench::doNotOptimize(n);
+	}
+	state.setBytesProcessed(corpus.size());
+}
+
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+#endif
+void codecvtToUtf16(bench::State& state, const std::string& corpus)
+{
+	while (state.keepRunning()) {
+		std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t> converter;
+		std::u16string out = converter.from_bytes(corpus);
+		bench::doNotOptimize(out);
+	}
+	state.setBytesProcessed(corpus.size());
+}
+
+void codecvtToUtf8(bench::State& state, const std::string& corpus)
+{
+	std::u16string wide = Transcoder::utf8ToUtf16(corpus);
+	while (state.keepRunning()) {
+		std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t> converter;
+		std::string out = converter.to_bytes(wide);
+		bench::doNotOptimize(out);
+	}
+	state.setBytesProcessed(corpus.size());
+}
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
+}
+
+BENCHMARK(transcode_ascii_to_utf16) { toUtf16(state, asciiCorpus()); }
+BENCHMARK(transcode_latin_to_utf16) { toUtf16(state, latinCorpus()); }
+BENCHMARK(transcode_cjk_to_utf16) { toUtf16(state, cjkCorpus()); }
+BENCHMARK(transcode_astral_to_utf16) { toUtf16(state, astralCorpus()); }
+
+BENCHMARK(transcode_ascii_to_utf8) { toUtf8(state, asciiCorpus()); }
+BENCHMARK(transcode_latin_to_utf8) { toUtf8(state, latinCorpus()); }
+BENCHMARK(transcode_cjk_to_utf8) { toUtf8(state, cjkCorpus()); }
+BENCHMARK(transcode_astral_to_utf8) { toUtf8(state, astralCorpus()); }
+
+BENCHMARK(transcode_ascii_to_utf16_codecvt) { codecvtToUtf16(state, asciiCorpus()); }
+BENCHMARK(transcode_cjk_to_utf16_codecvt) { codecvtToUtf16(state, cjkCorpus()); }
+BENCHMARK(transcode_ascii_to_utf8_codecvt) { codecvtToUtf8(state, asciiCorpus()); }
+BENCHMARK(transcode_cjk_to_utf8_codecvt) { codecvtToUtf8(state, cjkCorpus()); }
@@ -0,0 +1,82 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include "Benchmark.hpp"
+
+// Count the bytes allocated, so benchmarks can report memory footprints.
+namespace
+{
+std::atomic<size_t> allocated(0);
+}
+
+size_t bench::allocatedBytes()
+{
+	return allocated;
+}
+
+void* operator new(size_t size)
+{
+	allocated += size;
+	if (void* p = std::malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	std::free(p);
+}
+
+// Run all benchmarks, or only those whose name contains the first argument.
+int main(int argc, char** argv)
+{
+	const char* filter = argc > 1 ? argv[1] : nullptr;
+
+	std::printf("libTemplateEngine benchmarks, %s flavour (%u byte code units)\n",
+		bench::flavour(), static_cast<unsigned>(sizeof(template_engine::te_char_t)));
+	std::printf("%-40s %12s %14s %12s\n", "benchmark", "iterations", "ns/iteration", "throughput");
+
+	for (const bench::Benchmark& b : bench::registry()) {
+		if (filter && !std::strstr(b.name.c_str(), filter))
+			continue;
+
+		bench::State state;
+		b.function(state);
+
+		double nsPerIteration = state.iterations() ? state.seconds() * 1e9 / state.iterations() : 0;
+		std::printf("%-40s %12zu %14.0f", b.name.c_str(), state.iterations(), nsPerIteration);
+
+		if (state.bytes() && state.seconds() > 0) {
+			double mbPerSecond = state.bytes() * state.iterations() / state.seconds() / 1e6;
+			if (mbPerSecond >= 1000)
+				std::printf(" %7.2f GB/s", mbPerSecond / 1000);
+			else
+				std::printf(" %7.1f MB/s", mbPerSecond);
+		}
+		std::printf("\n");
+	}
+
+	return 0;
+}
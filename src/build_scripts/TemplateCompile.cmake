@@ -0,0 +1,42 @@
+#
+# te_compile_templates(<target> [NAMESPACE <namespace>] [NAME <name>] TEMPLATES <file>...)
+#
+# Compiles the template files into C++ render functions with te-compile, and
+# adds the generated source to the target. The generated header <name>.hpp,
+# by default <target>_templates.hpp, declares render_<file name>() and
+# <file name>() for every template, in the namespace, by default 'templates'.
+# Its directory is added to the include path of the target.
+#
+# The templates are compiled again when they, or te-compile, change.
+#
+include(CMakeParseArguments)
+
+function(te_compile_templates TARGET)
+	cmake_parse_arguments(TE "" "NAMESPACE;NAME" "TEMPLATES" ${ARGN})
+	if(NOT TE_NAMESPACE)
+		set(TE_NAMESPACE templates)
+	endif()
+	if(NOT TE_NAME)
+		set(TE_NAME ${TARGET}_templates)
+	endif()
+
+	set(OUTPUT_DIR ${CMAKE_CURRENT_BINARY_DIR}/${TARGET}_te)
+	set(HEADER ${OUTPUT_DIR}/${TE_NAME}.hpp)
+	set(SOURCE ${OUTPUT_DIR}/${TE_NAME}.cpp)
+
+	set(FILES)
+	foreach(FILE ${TE_TEMPLATES})
+		get_filename_component(FILE ${FILE} ABSOLUTE)
+		list(APPEND FILES ${FILE})
+	endforeach()
+
+	add_custom_command(OUTPUT ${HEADER} ${SOURCE}
+		COMMAND ${CMAKE_COMMAND} -E make_directory ${OUTPUT_DIR}
+		COMMAND te-compile --namespace ${TE_NAMESPACE} --header ${HEADER} --source ${SOURCE} ${FILES}
+		DEPENDS te-compile ${FILES}
+		COMMENT "Compiling templates of ${TARGET}"
+		VERBATIM)
+
+	target_sources(${TARGET} PRIVATE ${HEADER} ${SOURCE})
+	target_include_directories(${TARGET} PRIVATE ${OUTPUT_DIR})
+endfunction()
@@ -0,0 +1,346 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include "CodeGenerator.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+
+using namespace template_engine;
+
+namespace
+{
+
+/** \brief Escape a code unit below 0x80 for a C++ string literal */
+void escapeAscii(std::string& out, unsigned int ch)
+{
+	switch (ch) {
+	case '\\': out += "\\\\"; return;
+	case '"': out += "\\\""; return;
+	case '?': out += "\\?"; return;    // no trigraphs
+	case '\n': out += "\\n"; return;
+	case '\r': out += "\\r"; return;
+	case '\t': out += "\\t"; return;
+	}
+
+	if (ch >= 0x20 && ch < 0x7f) {
+		out += static_cast<char>(ch);
+		return;
+	}
+
+	// three octal digits always terminate the escape
+	char escape[8];
+	std::snprintf(escape, sizeof(escape), "\\%03o", ch);
+	out += escape;
+}
+
+/** \brief Length of the UTF-8 sequence starting with the byte */
+size_t sequenceLength(unsigned char ch)
+{
+	return ch < 0xe0 ? 2 : ch < 0xf0 ? 3 : 4;
+}
+
+/** \brief The code point of a UTF-8 sequence, which has been validated by the scanner */
+unsigned int decode(const std::string& text, size_t i, size_t length)
+{
+	static const unsigned char masks[] = { 0, 0, 0x1f, 0x0f, 0x07 };
+	unsigned int cp = static_cast<unsigned char>(text[i]) & masks[length];
+	for (size_t k = 1; k < length; k++)
+		cp = (cp << 6) | (static_cast<unsigned char>(text[i + k]) & 0x3f);
+	return cp;
+}
+
+/** \brief A chunk of UTF-8 text as a string constant valid in both flavours */
+std::string quoteChunk(const std::string& text)
+{
+	std::string narrow;
+	std::string wide;
+	bool ascii = true;
+
+	for (size_t i = 0; i < text.size();) {
+		unsigned char ch = static_cast<unsigned char>(text[i]);
+		if (ch < 0x80) {
+			escapeAscii(narrow, ch);
+			escapeAscii(wide, ch);
+			i++;
+			continue;
+		}
+
+		ascii = false;
+		size_t length = std::min(sequenceLength(ch), text.size() - i);
+		for (size_t k = 0; k < length; k++)
+			escapeAscii(narrow, static_cast<unsigned char>(text[i + k]));
+
+		// universal character names have a fixed number of digits
+		char escape[16];
+		unsigned int cp = decode(text, i, length);
+		std::snprintf(escape, sizeof(escape), cp > 0xffff ? "\\U%08x" : "\\u%04x", cp);
+		wide += escape;
+		i += length;
+	}
+
+	if (ascii)
+		return "TE_TEXT(\"" + narrow + "\")";
+
+	return "TE_GENERATED_TEXT(\"" + narrow + "\", u\"" + wide + "\")";
+}
+
+}
+
+/** \brief Generates the statements of a render function, while the template tree is walked. */
+class CodeGenerator::FunctionWriter :
+	public TemplateWriter
+{
+public:
+	FunctionWriter(CodeGenerator& generator) :
+		_generator(generator),
+		_depth(0),
+		_size(0)
+	{
+	}
+
+	virtual void literal(const te_char_t* data, size_t length)
+	{
+		_pending.append(data, length);
+	}
+
+	virtual void expansion(const te_string& name, uint8_t scopeWalk, const ValueFormat& format, const FilterChain& filters)
+	{
+		flush();
+		line() << "GeneratedTemplate::expand(out, d" << _depth << ", " << intern(name) << ", "
+			<< static_cast<unsigned int>(scopeWalk) << ", ";
+		if (!format.isDefault() || !filters.empty()) {
+			_body << (format.isDefault() ? std::string("ValueFormat()") : internFormat(format.getSpec())) << ", "
+				<< (filters.empty() ? std::string("FilterChain()") : internFilters(filters.getNames())) << ", ";
+		}
+		_body << "filter);\n";
+	}
+
+	virtual void beginRepeat(const te_string& name)
+	{
+		flush();
+		line() << "GeneratedTemplate::repeat(d" << _depth << ", " << intern(name) << ", [&](const DictionaryPtr& d"
+			<< _depth + 1 << ") {\n";
+		++_depth;
+	}
+
+	virtual void endRepeat()
+	{
+		flush();
+		--_depth;
+		line() << "});\n";
+	}
+
+	/** \brief The body of the render function. */
+	std::string finish()
+	{
+		flush();
+
+		std::string result;
+		for (const std::string& name : _names)
+			result += "\tstatic const te_string name_" + std::to_string(&name - &_names[0]) + "(" + quote(name) + ");\n";
+		for (const std::vector<std::string>& chain : _filters) {
+			result += "\tstatic const FilterChain filters_" + std::to_string(&chain - &_filters[0]) + " {";
+			for (const std::string& filter : chain)
+				result += (&filter == &chain[0] ? " " : ", ") + quote(filter);
+			result += " };\n";
+		}
+		for (const std::string& spec : _formats)
+			result += "\tstatic const ValueFormat format_" + std::to_string(&spec - &_formats[0]) + "(" + quote(spec) + ");\n";
+		if (!_names.empty() || !_filters.empty() || !_formats.empty())
+			result += "\n";
+		// the provided values are computed once per render, as by the interpreter
+		if (!_names.empty())
+			result += "\tRenderScope scope;\n";
+		if (_size)
+			result += "\tout.reserve(out.size() + " + std::to_string(_size) + ");\n";
+
+		return result + _body.str();
+	}
+
+private:
+	std::ostream& line()
+	{
+		return _body << std::string(_depth + 1, '\t');
+	}
+
+	void flush()
+	{
+		if (_pending.empty())
+			return;
+
+		std::string name = _generator.literal(_pending);
+		line() << "out.append(" << name << ", sizeof(" << name << ") / sizeof(te_char_t) - 1);\n";
+		_size += _pending.size();
+		_pending.clear();
+	}
+
+	std::string intern(const te_string& name)
+	{
+		for (size_t i = 0; i < _names.size(); i++)
+			if (_names[i] == name)
+				return "name_" + std::to_string(i);
+
+		_names.push_back(name);
+		return "name_" + std::to_string(_names.size() - 1);
+	}
+
+	std::string internFilters(const std::vector<std::string>& chain)
+	{
+		for (size_t i = 0; i < _filters.size(); i++)
+			if (_filters[i] == chain)
+				return "filters_" + std::to_string(i);
+
+		_filters.push_back(chain);
+		return "filters_" + std::to_string(_filters.size() - 1);
+	}
+
+	std::string internFormat(const std::string& spec)
+	{
+		for (size_t i = 0; i < _formats.size(); i++)
+			if (_formats[i] == spec)
+				return "format_" + std::to_string(i);
+
+		_formats.push_back(spec);
+		return "format_" + std::to_string(_formats.size() - 1);
+	}
+
+	CodeGenerator& _generator;
+	std::ostringstream _body;
+	std::vector<std::string> _names;
+	std::vector<std::vector<std::string>> _filters;
+	std::vector<std::string> _formats;
+	std::string _pending;
+	size_t _depth;
+	size_t _size;
+};
+
+CodeGenerator::CodeGenerator(const std::string& nameSpace)
+{
+	size_t start = 0;
+	while (start <= nameSpace.size()) {
+		size_t end = nameSpace.find("::", start);
+		if (end == std::string::npos)
+			end = nameSpace.size();
+		if (end > start)
+			_namespaces.push_back(nameSpace.substr(start, end - start));
+		start = end + 2;
+	}
+}
+
+void CodeGenerator::add(const std::string& name, const std::string& source, const TemplatePtr& templ)
+{
+	FunctionWriter writer(*this);
+	writer.write(*templ);
+
+	_templates.emplace_back(name, source);
+	_functions += "// " + source + "\n";
+	_functions += "void render_" + name + "(te_string& out, const DictionaryPtr& d0, const TemplateFilter& filter)\n{\n";
+	_functions += writer.finish();
+	_functions += "}\n\n";
+	_functions += "TemplatePtr " + name + "()\n{\n";
+	_functions += "\treturn std::make_shared<GeneratedTemplate>(&render_" + name + ");\n}\n\n";
+}
+
+std::string CodeGenerator::header(const std::string& guard) const
+{
+	std::ostringstream out;
+	out << "// Generated by te-compile, do not edit.\n";
+	out << "#ifndef " << guard << "\n#define " << guard << "\n\n";
+	out << "#include <GeneratedTemplate.hpp>\n\n";
+
+	for (const std::string& ns : _namespaces)
+		out << "namespace " << ns << "\n{\n";
+	out << "\n";
+
+	for (const std::pair<std::string, std::string>& t : _templates) {
+		out << "/** \\brief Render " << t.second << ", appending the text to out. */\n";
+		out << "void render_" << t.first << "(template_engine::te_string& out, const template_engine::DictionaryPtr& dictionary,\n";
+		out << "\tconst template_engine::TemplateFilter& filter = nullptr);\n\n";
+		out << "/** \\brief " << t.second << " as a template. */\n";
+		out << "template_engine::TemplatePtr " << t.first << "();\n\n";
+	}
+
+	for (size_t i = 0; i < _namespaces.size(); i++)
+		out << "}\n";
+	out << "\n#endif // !" << guard << "\n";
+
+	return out.str();
+}
+
+std::string CodeGenerator::source(const std::string& headerName) const
+{
+	std::ostringstream out;
+	out << "// Generated by te-compile, do not edit.\n";
+	out << "#include \"" << headerName << "\"\n\n";
+	out << "using namespace template_engine;\n\n";
+
+	for (const std::string& ns : _namespaces)
+		out << "namespace " << ns << "\n{\n";
+	out << "\n";
+
+	if (!_literals.empty()) {
+		out << "namespace\n{\n";
+		for (size_t i = 0; i < _literals.size(); i++)
+			out << "const te_char_t literal_" << i << "[] = " << quote(_literals[i]) << ";\n";
+		out << "}\n\n";
+	}
+
+	out << _functions;
+
+	for (size_t i = 0; i < _namespaces.size(); i++)
+		out << "}\n";
+
+	return out.str();
+}
+
+std::string CodeGenerator::quote(const std::string& text)
+{
+	if (text.empty())
+		return "TE_TEXT(\"\")";
+
+	// a chunk per line, long lines are split up
+	std::string result;
+	size_t start = 0;
+	while (start < text.size()) {
+		size_t end = text.find('\n', start);
+		end = end == std::string::npos ? text.size() : end + 1;
+		end = std::min(end, start + 96);
+
+		// don't split a UTF-8 sequence
+		while (end < text.size() && (static_cast<unsigned char>(text[end]) & 0xc0) == 0x80)
+			--end;
+
+		if (!result.empty())
+			result += "\n\t";
+		result += quoteChunk(text.substr(start, end - start));
+		start = end;
+	}
+
+	return result;
+}
+
+std::string CodeGenerator::literal(const std::string& text)
+{
+	std::map<std::string, size_t>::const_iterator it = _literalIndex.find(text);
+	if (it == _literalIndex.end()) {
+		it = _literalIndex.emplace(text, _literals.size()).first;
+		_literals.push_back(text);
+	}
+
+	return "literal_" + std::to_string(it->second);
+}
@@ -0,0 +1,70 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#ifndef __CODE_GENERATOR_HPP_
+#define __CODE_GENERATOR_HPP_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <TemplateEngine.hpp>
+
+/** \brief Generates C++ source with a render function for every template.
+ *
+ * Every template becomes a straight line function appending to an output
+ * string: literals are constant arrays, identical literals are shared
+ * between the functions, and expansions and repeats call the helpers of
+ * template_engine::GeneratedTemplate. The string constants are written in
+ * both encodings, so the generated code builds with either flavour.
+ */
+class CodeGenerator
+{
+public:
+    /** \brief Generate the functions into the namespace, which may be nested, e.g. "app::views". */
+	explicit CodeGenerator(const std::string& nameSpace);
+
+    /** \brief Add the render function of a parsed template.
+     *
+     * \param name const std::string&   Identifier of the template, the function is called render_<name>.
+     * \param source const std::string& The template file, for the comments.
+     * \param templ const template_engine::TemplatePtr& The parsed template.
+     */
+	void add(const std::string& name, const std::string& source, const template_engine::TemplatePtr& templ);
+
+    /** \brief The header declaring the functions. */
+	std::string header(const std::string& guard) const;
+
+    /** \brief The source defining the functions, which includes the header. */
+	std::string source(const std::string& headerName) const;
+
+    /** \brief A C++ expression for the string constant, given in UTF-8, which is valid in both flavours. */
+	static std::string quote(const std::string& text);
+
+private:
+	class FunctionWriter;
+
+    /** \brief Name of the constant array holding the literal, it is added if needed. */
+	std::string literal(const std::string& text);
+
+	std::vector<std::string> _namespaces;                   ///< The nested namespaces.
+	std::vector<std::pair<std::string, std::string>> _templates; ///< Name and file of every template.
+	std::map<std::string, size_t> _literalIndex;            ///< Index of every literal in _literals.
+	std::vector<std::string> _literals;                     ///< The literals, in UTF-8.
+	std::string _functions;                                 ///< The definitions of the render functions.
+};
+
+#endif // !__CODE_GENERATOR_HPP_
@@ -0,0 +1,133 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <set>
+
+#include <TemplateEngine.hpp>
+
+#include "CodeGenerator.hpp"
+
+using namespace template_engine;
+
+// te-compile [--namespace <namespace>] --header <file.hpp> --source <file.cpp> <template>...
+//
+// Compiles every template file into a render function, named after the
+// file: templates/page.tmpl becomes render_page() and page().
+
+namespace
+{
+
+void usage()
+{
+	std::cerr << "usage: te-compile [--namespace <namespace>] --header <file.hpp> --source <file.cpp> <template>..." << std::endl;
+}
+
+/** \brief The identifier of a template, its file name without the directory and the extension */
+std::string identifier(const std::string& path)
+{
+	size_t start = path.find_last_of("/\\");
+	start = start == std::string::npos ? 0 : start + 1;
+	size_t end = path.find('.', start);
+	std::string name = path.substr(start, end == std::string::npos ? std::string::npos : end - start);
+
+	for (char& ch : name)
+		if (!std::isalnum(static_cast<unsigned char>(ch)))
+			ch = '_';
+	if (name.empty() || std::isdigit(static_cast<unsigned char>(name[0])))
+		name = "_" + name;
+
+	return name;
+}
+
+/** \brief The file name of a path, without the directory */
+std::string fileName(const std::string& path)
+{
+	size_t start = path.find_last_of("/\\");
+	return start == std::string::npos ? path : path.substr(start + 1);
+}
+
+bool writeFile(const std::string& path, const std::string& content)
+{
+	std::ofstream file(path.c_str(), std::ios::binary | std::ios::trunc);
+	file << content;
+	file.close();
+	if (file)
+		return true;
+
+	std::cerr << "te-compile: unable to write '" << path << "'" << std::endl;
+	return false;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+	std::string nameSpace("templates");
+	std::string headerPath;
+	std::string sourcePath;
+	std::vector<std::string> templates;
+
+	for (int i = 1; i < argc; i++) {
+		std::string arg(argv[i]);
+		if ((arg == "--namespace" || arg == "--header" || arg == "--source") && i + 1 < argc) {
+			std::string& value = arg == "--namespace" ? nameSpace : arg == "--header" ? headerPath : sourcePath;
+			value = argv[++i];
+		}
+		else if (arg.compare(0, 2, "--") == 0) {
+			usage();
+			return 2;
+		}
+		else
+			templates.push_back(arg);
+	}
+
+	if (headerPath.empty() || sourcePath.empty()) {
+		usage();
+		return 2;
+	}
+
+	CodeGenerator generator(nameSpace);
+	std::set<std::string> names;
+
+	for (const std::string& path : templates) {
+		std::string name = identifier(path);
+		if (!names.insert(name).second) {
+			std::cerr << "te-compile: " << path << ": another template is also called '" << name << "'" << std::endl;
+			return 1;
+		}
+
+		try {
+			MappedFileScanner scanner(path);
+			generator.add(name, fileName(path), Template::parse(scanner));
+		}
+		catch (const TemplateException& e) {
+			std::cerr << "te-compile: " << path << ": " << e.what() << std::endl;
+			return 1;
+		}
+	}
+
+	std::string guard = "TE_COMPILE_" + identifier(headerPath) + "_HPP_";
+	for (char& ch : guard)
+		ch = static_cast<char>(std::toupper(static_cast<unsigned char>(ch)));
+
+	if (!writeFile(headerPath, generator.header(guard)) || !writeFile(sourcePath, generator.source(fileName(headerPath))))
+		return 1;
+
+	return 0;
+}
@@ -47,11 +47,8 @@ int main(int argc, char **argv) {
     // render the template
     te::te_string result = compiledTemplate->render(context);
 
-    // convert template result to UTF-8
-    te::te_converter converter;
-
-    // print the generated template
-    std::cout << converter.to_bytes(result) << std::endl;
+    // print the generated template, converted to UTF-8
+    std::cout << te::to_utf8(result) << std::endl;
 
     return 0;
 }
@@ -0,0 +1,115 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include <boost/test/unit_test.hpp>
+
+
+#include <TemplateEngine.hpp>
+#include <TemplateList.hpp>
+using namespace template_engine;
+namespace utf = boost::unit_test;
+
+// Boost test doesn't know these types and cannot output their value
+BOOST_TEST_DONT_PRINT_LOG_VALUE(te_string);
+
+namespace
+{
+TemplatePtr parse(const te_string& definition)
+{
+	StringScanner s(definition);
+	return Template::parse(s);
+}
+
+void renderNothing(te_string& /*out*/, const DictionaryPtr& /*dictionary*/, const TemplateFilter& /*filter*/)
+{
+}
+}
+
+BOOST_AUTO_TEST_SUITE(DependenciesTest);
+
+BOOST_AUTO_TEST_CASE(scopes)
+{
+	TemplatePtr t = parse(TE_TEXT("{{TITLE}} {{APP}}{{#repeat items}}{{NAME}}{{:TITLE}}{{#repeat rows}}{{CELL}}{{::NAME}}{{/repeat}}{{/repeat}}{{#repeat items}}{{PRICE}}{{/repeat}}{{TITLE}}"));
+	TemplateDependencies used = t->dependencies();
+
+	BOOST_CHECK(used.isComplete());
+	BOOST_CHECK(used.values == std::set<TemplateDependencies::Value>({ { TE_TEXT("TITLE"), 0 }, { TE_TEXT("APP"), 0 } }));
+	BOOST_REQUIRE_EQUAL(used.lists.size(), 1u);
+
+	// both repeats over the list are merged
+	const TemplateDependencies& items = used.lists.at(TE_TEXT("items"));
+	BOOST_CHECK(items.values == std::set<TemplateDependencies::Value>({ { TE_TEXT("NAME"), 0 }, { TE_TEXT("TITLE"), 1 }, { TE_TEXT("PRICE"), 0 } }));
+	BOOST_REQUIRE_EQUAL(items.lists.size(), 1u);
+
+	const TemplateDependencies& rows = items.lists.at(TE_TEXT("rows"));
+	BOOST_CHECK(rows.values == std::set<TemplateDependencies::Value>({ { TE_TEXT("CELL"), 0 }, { TE_TEXT("NAME"), 2 } }));
+	BOOST_CHECK(rows.lists.empty());
+
+	// an optimized template references the same names
+	TemplateDependencies optimized = TemplateOptimizer().optimize(t)->dependencies();
+	BOOST_CHECK(optimized.values == used.values);
+	BOOST_CHECK(optimized.lists.at(TE_TEXT("items")).values == items.values);
+
+	TemplateDependencies none = parse(TE_TEXT("plain {{- comment }} text"))->dependencies();
+	BOOST_CHECK(none.values.empty() && none.lists.empty() && none.isComplete());
+}
+
+BOOST_AUTO_TEST_CASE(specialized)
+{
+	DictionaryPtr known = std::make_shared<Dictionary>();
+	known->add(TE_TEXT("TENANT"), TE_TEXT("acme"));
+	DictionaryListPtr menu = std::make_shared<DictionaryList>();
+	known->add(TE_TEXT("menu"), menu);
+	DictionaryPtr item = std::make_shared<Dictionary>();
+	item->add(TE_TEXT("LABEL"), TE_TEXT("home"));
+	menu->add(item);
+
+	// the known names need not be given when rendering
+	TemplatePtr residual = Template::specialize(parse(TE_TEXT("{{TENANT}}{{USER}}{{#repeat menu}}{{LABEL}}{{#repeat rows}}{{CELL}}{{/repeat}}{{/repeat}}")), known);
+	TemplateDependencies used = residual->dependencies();
+	BOOST_CHECK(used.isComplete());
+	BOOST_CHECK(used.values == std::set<TemplateDependencies::Value>({ { TE_TEXT("USER"), 0 } }));
+	BOOST_REQUIRE_EQUAL(used.lists.size(), 1u);
+
+	// the repeat over the known list is kept, as its body repeats a list which isn't known
+	const TemplateDependencies& body = used.lists.at(TE_TEXT("menu"));
+	BOOST_CHECK(body.values == std::set<TemplateDependencies::Value>({ { TE_TEXT("LABEL"), 0 } }));
+	BOOST_CHECK(body.lists.at(TE_TEXT("rows")).values == std::set<TemplateDependencies::Value>({ { TE_TEXT("CELL"), 0 } }));
+
+	// an unrolled repeat references nothing
+	residual = Template::specialize(parse(TE_TEXT("{{#repeat menu}}{{LABEL}}{{USER}}{{/repeat}}")), known);
+	used = residual->dependencies();
+	BOOST_CHECK(used.lists.empty());
+	BOOST_CHECK(used.values == std::set<TemplateDependencies::Value>({ { TE_TEXT("USER"), 0 } }));
+}
+
+BOOST_AUTO_TEST_CASE(incomplete)
+{
+	std::shared_ptr<TemplateList> list = std::make_shared<TemplateList>();
+	list->push_back(parse(TE_TEXT("{{TITLE}}")));
+	list->push_back(std::make_shared<GeneratedTemplate>(&renderNothing));
+
+	TemplateDependencies used = list->dependencies();
+	BOOST_CHECK(!used.isComplete());
+	BOOST_CHECK_EQUAL(used.values.size(), 1u);
+
+	TemplateDependencies merged;
+	merged.lists[TE_TEXT("items")].merge(used);
+	BOOST_CHECK(merged.complete);
+	BOOST_CHECK(!merged.isComplete());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
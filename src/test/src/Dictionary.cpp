@@ -179,4 +179,57 @@ BOOST_AUTO_TEST_CASE(Dictionary05)
     BOOST_CHECK(result == TE_TEXT("libTemplateEngine <NAME>"));
 }
 
+BOOST_AUTO_TEST_CASE(Dictionary06)
+{
+    DictionaryPtr root = std::make_shared<Dictionary>();
+    BOOST_CHECK(root->getVersion() == 0);
+
+    // every change is stamped with a new version
+    root->add(TE_TEXT("NAME"), TE_TEXT("first"));
+    uint64_t added = root->getVersion(TE_TEXT("NAME"));
+    BOOST_CHECK(added != 0);
+    BOOST_CHECK(root->getVersion() == added);
+    BOOST_CHECK(root->getVersion(TE_TEXT("OTHER")) == 0);
+
+    // add doesn't replace, set does
+    root->add(TE_TEXT("NAME"), TE_TEXT("second"));
+    BOOST_CHECK(root->getValue(TE_TEXT("NAME")) == TE_TEXT("first"));
+    BOOST_CHECK(root->getVersion() == added);
+    root->set(TE_TEXT("NAME"), TE_TEXT("second"));
+    BOOST_CHECK(root->getValue(TE_TEXT("NAME")) == TE_TEXT("second"));
+    BOOST_CHECK(root->getVersion(TE_TEXT("NAME")) > added);
+
+    uint64_t set = root->getVersion();
+    BOOST_CHECK(root->remove(TE_TEXT("NAME")));
+    BOOST_CHECK(!root->remove(TE_TEXT("NAME")));
+    BOOST_CHECK(!root->exists(TE_TEXT("NAME")));
+    BOOST_CHECK(root->getVersion() > set);
+
+    // changes to the rows of a list are stamped on the list
+    DictionaryListPtr list = std::make_shared<DictionaryList>();
+    root->set(TE_TEXT("list"), list);
+    for (const te_char_t* name : { TE_TEXT("CHILD1"), TE_TEXT("CHILD2") }) {
+        DictionaryPtr child = std::make_shared<Dictionary>();
+        child->add(TE_TEXT("NAME"), name);
+        list->add(child);
+    }
+    uint64_t rows = list->getVersion();
+
+    DictionaryPtr replacement = std::make_shared<Dictionary>();
+    replacement->add(TE_TEXT("NAME"), TE_TEXT("CHILD3"));
+    list->set(1, replacement);
+    BOOST_CHECK(list->getVersion() > rows);
+    BOOST_CHECK(replacement->getParent() == list);
+
+    rows = list->getVersion();
+    list->remove(0);
+    BOOST_CHECK(list->size() == 1);
+    BOOST_CHECK(list->getVersion() > rows);
+    list->resetCursor();
+    BOOST_CHECK(list->getCurrent()->getValue(TE_TEXT("NAME")) == TE_TEXT("CHILD3"));
+
+    BOOST_REQUIRE_THROW(list->set(1, replacement), TemplateException);
+    BOOST_REQUIRE_THROW(list->remove(1), TemplateException);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
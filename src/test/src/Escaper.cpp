@@ -0,0 +1,134 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include <boost/test/unit_test.hpp>
+
+
+#include <TemplateEngine.hpp>
+using namespace template_engine;
+namespace utf = boost::unit_test;
+
+// Boost test doesn't know these types and cannot output their value
+BOOST_TEST_DONT_PRINT_LOG_VALUE(te_string);
+
+namespace
+{
+template <typename Escaper>
+te_string escape(const te_string& value)
+{
+	te_string out;
+	Escaper::append(out, value.data(), value.size());
+	return out;
+}
+
+TemplatePtr parse(const te_string& definition)
+{
+	StringScanner s(definition);
+	return Template::parse(s);
+}
+
+void renderGenerated(te_string& out, const DictionaryPtr& dictionary, const TemplateFilter& filter)
+{
+	out += TE_TEXT("<b>");
+	GeneratedTemplate::expand(out, dictionary, TE_TEXT("NAME"), 0, filter);
+	out += TE_TEXT("</b>");
+}
+}
+
+BOOST_AUTO_TEST_SUITE(EscaperTest);
+
+BOOST_AUTO_TEST_CASE(formats)
+{
+	te_string value = TE_TEXT("a&b<c>d\"e'f\\g?h\ni\x01j\x7Fk");
+	BOOST_CHECK_EQUAL(escape<HtmlEscaper>(value), TE_TEXT("a&amp;b&lt;c&gt;d&quot;e&#39;f\\g?h\ni\x01j\x7Fk"));
+	BOOST_CHECK_EQUAL(escape<XmlEscaper>(value), TE_TEXT("a&amp;b&lt;c&gt;d&quot;e&apos;f\\g?h\ni\x01j\x7Fk"));
+	BOOST_CHECK_EQUAL(escape<JsonEscaper>(value), TE_TEXT("a&b<c>d\\\"e'f\\\\g?h\\ni\\u0001j\x7Fk"));
+	BOOST_CHECK_EQUAL(escape<CEscaper>(value), TE_TEXT("a&b<c>d\\\"e\\'f\\\\g\\?h\\ni\\001j\\177k"));
+
+	BOOST_CHECK_EQUAL(escape<JsonEscaper>(TE_TEXT("\b\f\r\t\x1F")), TE_TEXT("\\b\\f\\r\\t\\u001f"));
+	BOOST_CHECK_EQUAL(escape<CEscaper>(TE_TEXT("\a\b\f\r\t\v\x1F" "1")), TE_TEXT("\\a\\b\\f\\r\\t\\v\\0371"));
+	BOOST_CHECK(escape<HtmlEscaper>(te_string()).empty());
+
+	// non ASCII text is passed through
+	te_string unicode = from_utf8("bl\xC3\xA5" "b\xC3\xA6r & \xE2\x82\xAC \xF0\x9F\x98\x80");
+	BOOST_CHECK_EQUAL(escape<HtmlEscaper>(unicode), from_utf8("bl\xC3\xA5" "b\xC3\xA6r &amp; \xE2\x82\xAC \xF0\x9F\x98\x80"));
+	BOOST_CHECK_EQUAL(escape<CEscaper>(unicode), unicode);
+}
+
+BOOST_AUTO_TEST_CASE(runs)
+{
+	// a special character at every position around the vector widths, and at the tail
+	for (size_t length = 0; length < 80; ++length) {
+		for (size_t position = 0; position < length; ++position) {
+			te_string value(length, TE_TEXT('x'));
+			value[position] = TE_TEXT('<');
+			if (position + 1 < length)
+				value[length - 1] = TE_TEXT('\n');
+
+			te_string expected;
+			for (te_char_t ch : value) {
+				if (TE_TEXT('<') == ch)
+					expected += TE_TEXT("&lt;");
+				else
+					expected += ch;
+			}
+			BOOST_REQUIRE_EQUAL(escape<HtmlEscaper>(value), expected);
+
+			te_string json = escape<JsonEscaper>(value);
+			BOOST_REQUIRE_EQUAL(json.size(), length + (position + 1 < length ? 1 : 0));
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(render)
+{
+	DictionaryPtr root = std::make_shared<Dictionary>();
+	root->add(TE_TEXT("NAME"), TE_TEXT("<Tom & Jerry>"));
+	DictionaryListPtr items = std::make_shared<DictionaryList>();
+	root->add(TE_TEXT("items"), items);
+	for (const te_char_t* value : { TE_TEXT("\"a\""), TE_TEXT("b's") }) {
+		DictionaryPtr item = std::make_shared<Dictionary>();
+		item->add(TE_TEXT("VALUE"), value);
+		items->add(item);
+	}
+	ContextPtr ctx = Context::BuildContext();
+	ctx->setDictionary(root);
+
+	TemplatePtr t = parse(TE_TEXT("<h1>{{NAME}}</h1>{{#repeat items}}<li>{{VALUE}}/{{:NAME}}</li>{{/repeat}}"));
+	te_string expected = TE_TEXT("<h1>&lt;Tom &amp; Jerry&gt;</h1><li>&quot;a&quot;/&lt;Tom &amp; Jerry&gt;</li><li>b&#39;s/&lt;Tom &amp; Jerry&gt;</li>");
+
+	// the escaper, the same escaper as a filter, and appended to a string
+	BOOST_CHECK_EQUAL(t->render<HtmlEscaper>(ctx), expected);
+	BOOST_CHECK_EQUAL(t->render(ctx, escapeFilter<HtmlEscaper>()), expected);
+	te_string out = TE_TEXT("!");
+	t->renderInto(ctx, out, &HtmlEscaper::append);
+	BOOST_CHECK_EQUAL(out, TE_TEXT("!") + expected);
+
+	// without an escaper
+	BOOST_CHECK_EQUAL(t->render(ctx), TE_TEXT("<h1><Tom & Jerry></h1><li>\"a\"/<Tom & Jerry></li><li>b's/<Tom & Jerry></li>"));
+	BOOST_CHECK(!escapeFilter(nullptr));
+
+	// templates which wrap other templates or code
+	DictionaryPtr known = std::make_shared<Dictionary>();
+	known->add(TE_TEXT("SITE"), TE_TEXT("a&b"));
+	TemplatePtr residual = Template::specialize(parse(TE_TEXT("{{SITE}}{{#repeat items}}{{VALUE}}{{SITE}}{{/repeat}}{{NAME}}")), known, escapeFilter<HtmlEscaper>());
+	BOOST_CHECK_EQUAL(residual->render<HtmlEscaper>(ctx), TE_TEXT("a&amp;b&quot;a&quot;a&amp;bb&#39;sa&amp;b&lt;Tom &amp; Jerry&gt;"));
+	TemplatePtr generated = std::make_shared<GeneratedTemplate>(&renderGenerated);
+	BOOST_CHECK_EQUAL(generated->render<JsonEscaper>(ctx), TE_TEXT("<b><Tom & Jerry></b>"));
+	BOOST_CHECK_THROW(parse(TE_TEXT("{{MISSING}}"))->render<HtmlEscaper>(ctx), TemplateException);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,148 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include <boost/test/unit_test.hpp>
+
+
+#include <TemplateEngine.hpp>
+using namespace template_engine;
+
+// Boost test doesn't know these types and cannot output their value
+BOOST_TEST_DONT_PRINT_LOG_VALUE(te_string);
+
+namespace
+{
+TemplatePtr parse(const te_string& definition)
+{
+	StringScanner s(definition);
+	return Template::parse(s);
+}
+
+void bracketFilter(te_string& out, const te_char_t* value, size_t length)
+{
+	out += TE_TEXT('[');
+	out.append(value, length);
+	out += TE_TEXT(']');
+}
+
+struct FilterFixture {
+	FilterFixture() : dict(std::make_shared<Dictionary>()), ctx(Context::BuildContext())
+	{
+		ctx->setDictionary(dict);
+		dict->add(TE_TEXT("NAME"), TE_TEXT("Tom & \"Jerry\""));
+
+		DictionaryListPtr list = std::make_shared<DictionaryList>();
+		dict->add(TE_TEXT("items"), list);
+		for (const te_char_t* value : { TE_TEXT("a<b"), TE_TEXT("c") }) {
+			DictionaryPtr item = std::make_shared<Dictionary>();
+			list->add(item);
+			item->add(TE_TEXT("VALUE"), value);
+		}
+	}
+
+	te_string render(const te_string& definition, TemplateFilter filter = nullptr)
+	{
+		return parse(definition)->render(ctx, filter);
+	}
+
+	DictionaryPtr dict;
+	ContextPtr ctx;
+};
+}
+
+BOOST_FIXTURE_TEST_SUITE(FilterChainTest, FilterFixture);
+
+BOOST_AUTO_TEST_CASE(syntax)
+{
+	BOOST_CHECK_EQUAL(render(TE_TEXT("{{NAME|html}}")), TE_TEXT("Tom &amp; &quot;Jerry&quot;"));
+	BOOST_CHECK_EQUAL(render(TE_TEXT("{{NAME | upper | json }}")), TE_TEXT("TOM & \\\"JERRY\\\""));
+	BOOST_CHECK_EQUAL(render(TE_TEXT("{{NAME|HTML}}")), render(TE_TEXT("{{NAME|html}}")));
+	BOOST_CHECK_EQUAL(render(TE_TEXT("{{#repeat items}}{{VALUE|xml}},{{:NAME|lower}};{{/repeat}}")),
+		TE_TEXT("a&lt;b,tom & \"jerry\";c,tom & \"jerry\";"));
+
+	// left to right
+	BOOST_CHECK_EQUAL(render(TE_TEXT("{{NAME|html|c}}")), TE_TEXT("Tom &amp; &quot;Jerry&quot;"));
+	BOOST_CHECK_EQUAL(render(TE_TEXT("{{NAME|c|html}}")), TE_TEXT("Tom &amp; \\&quot;Jerry\\&quot;"));
+
+	// a pipe can't start an instruction, so the braces are plain text
+	BOOST_CHECK_EQUAL(render(TE_TEXT("{{|html}} a|b")), TE_TEXT("{{|html}} a|b"));
+
+	BOOST_CHECK_THROW(render(TE_TEXT("{{NAME|}}")), TemplateException);
+	BOOST_CHECK_THROW(render(TE_TEXT("{{NAME||html}}")), TemplateException);
+	BOOST_CHECK_THROW(render(TE_TEXT("{{NAME|html upper}}")), TemplateException);
+	BOOST_CHECK_THROW(parse(TE_TEXT("{{NAME|nonexistent}}")), TemplateException);
+	BOOST_CHECK_THROW(parse(TE_TEXT("{{#repeat items|html}}{{/repeat}}")), TemplateException);
+}
+
+BOOST_AUTO_TEST_CASE(render_filter)
+{
+	// the filters of the expansion come first, then the filter or escaper of the render
+	TemplatePtr t = parse(TE_TEXT("{{NAME|upper}} {{NAME}}"));
+	BOOST_CHECK_EQUAL(t->render(ctx, escapeFilter<HtmlEscaper>()), TE_TEXT("TOM &amp; &quot;JERRY&quot; Tom &amp; &quot;Jerry&quot;"));
+	BOOST_CHECK_EQUAL(t->render<HtmlEscaper>(ctx), TE_TEXT("TOM &amp; &quot;JERRY&quot; Tom &amp; &quot;Jerry&quot;"));
+
+	te_string out = TE_TEXT(">");
+	parse(TE_TEXT("{{NAME|upper|lower}}"))->renderInto(ctx, out);
+	BOOST_CHECK_EQUAL(out, TE_TEXT(">tom & \"jerry\""));
+}
+
+BOOST_AUTO_TEST_CASE(registry)
+{
+	BOOST_CHECK(FilterRegistry::find(TE_TEXT("Json")) == &JsonEscaper::append);
+	BOOST_CHECK(FilterRegistry::find(TE_TEXT("bracket")) == nullptr);
+	BOOST_CHECK_THROW(FilterRegistry::add(TE_TEXT(""), &bracketFilter), TemplateException);
+	BOOST_CHECK_THROW(FilterRegistry::add(TE_TEXT("bracket"), nullptr), TemplateException);
+
+	FilterRegistry::add(TE_TEXT("bracket"), &bracketFilter);
+	TemplatePtr t = parse(TE_TEXT("{{#repeat items}}{{VALUE|bracket|html}}{{/repeat}}"));
+	BOOST_CHECK_EQUAL(t->render(ctx), TE_TEXT("[a&lt;b][c]"));
+
+	// the filter was resolved when the template was parsed
+	FilterRegistry::add(TE_TEXT("bracket"), &CEscaper::append);
+	BOOST_CHECK_EQUAL(t->render(ctx), TE_TEXT("[a&lt;b][c]"));
+
+	FilterChain chain{ TE_TEXT("upper"), TE_TEXT("bracket") };
+	BOOST_CHECK_EQUAL(chain.getNames().size(), 2u);
+	BOOST_CHECK_EQUAL(chain.apply(TE_TEXT("a\"b")), TE_TEXT("A\\\"B"));
+	BOOST_CHECK_EQUAL(FilterChain().apply(TE_TEXT("a\"b")), TE_TEXT("a\"b"));
+}
+
+BOOST_AUTO_TEST_CASE(transformations)
+{
+	// every way of rendering an expansion applies its filters
+	const te_string definition = TE_TEXT("<{{NAME|html}}>{{#repeat items}}{{VALUE|upper|html}}{{/repeat}}");
+	const te_string expected = TE_TEXT("<Tom &amp; &quot;Jerry&quot;>A&lt;BC");
+	TemplatePtr t = parse(definition);
+	BOOST_CHECK_EQUAL(t->render(ctx), expected);
+
+	std::string image = TemplateImage::save(t);
+	TemplatePtr loaded = TemplateImage::load(image.data(), image.size(), nullptr);
+	BOOST_CHECK_EQUAL(loaded->render(ctx), expected);
+
+	RenderCache cache(t);
+	BOOST_CHECK_EQUAL(cache.render(ctx), expected);
+	BOOST_CHECK_EQUAL(cache.render(ctx), expected);
+
+	DictionaryPtr known = std::make_shared<Dictionary>();
+	known->add(TE_TEXT("NAME"), TE_TEXT("<known>"));
+	TemplatePtr residual = Template::specialize(t, known);
+	BOOST_CHECK_EQUAL(residual->render(ctx), TE_TEXT("<&lt;known&gt;>A&lt;BC"));
+
+	TemplatePtr folded = TemplateOptimizer(true).optimize(parse(TE_TEXT("{{APP|upper}}")));
+	BOOST_CHECK_EQUAL(folded->render(ctx), render(TE_TEXT("{{APP|upper}}")));
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,70 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#ifndef __FIXTURES_HPP_
+#define __FIXTURES_HPP_
+
+#include <TemplateEngine.hpp>
+
+/** \brief The page dictionary shared by the parser tests.
+ *
+ * TEST is "<TEST>", and the list section has the items B=b and B=c, each
+ * with a list inner holding the single item C=x.
+ */
+struct PageFixture {
+	PageFixture() :
+		dict(std::make_shared<template_engine::Dictionary>()),
+		ctx(template_engine::Context::BuildContext())
+	{
+		using namespace template_engine;
+
+		ctx->setDictionary(dict);
+		dict->add(TE_TEXT("TEST"), TE_TEXT("<TEST>"));
+
+		DictionaryListPtr list = std::make_shared<DictionaryList>();
+		dict->add(TE_TEXT("section"), list);
+
+		for (const te_char_t* value : { TE_TEXT("b"), TE_TEXT("c") }) {
+			DictionaryPtr child = std::make_shared<Dictionary>();
+			list->add(child);
+			child->add(TE_TEXT("B"), value);
+
+			DictionaryListPtr inner = std::make_shared<DictionaryList>();
+			child->add(TE_TEXT("inner"), inner);
+			DictionaryPtr item = std::make_shared<Dictionary>();
+			inner->add(item);
+			item->add(TE_TEXT("C"), TE_TEXT("x"));
+		}
+	}
+
+	/** \brief Parse the definition with the sequential parser */
+	static template_engine::TemplatePtr parse(const template_engine::te_string& definition)
+	{
+		template_engine::StringScanner scanner(definition);
+		return template_engine::Template::parse(scanner);
+	}
+
+	/** \brief Parse the definition with the sequential parser, and render it */
+	template_engine::te_string render(const template_engine::te_string& definition, template_engine::TemplateFilter filter = nullptr)
+	{
+		return parse(definition)->render(ctx, filter);
+	}
+
+	template_engine::DictionaryPtr dict;
+	template_engine::ContextPtr ctx;
+};
+
+#endif // !__FIXTURES_HPP_
@@ -0,0 +1,80 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include <boost/test/unit_test.hpp>
+
+#include <TemplateEngine.hpp>
+#include <GeneratedTemplate.hpp>
+
+#include "Fixtures.hpp"
+// generated by te-compile from the files in templates/
+#include "test_templates.hpp"
+
+using namespace template_engine;
+
+// Boost test doesn't know these types and cannot output their value
+BOOST_TEST_DONT_PRINT_LOG_VALUE(te_string);
+
+struct GeneratedFixture : PageFixture {
+	/** The template file, rendered by the interpreter */
+	te_string interpreted(const std::string& name, TemplateFilter filter = nullptr)
+	{
+		MappedFileScanner scanner(std::string(TEST_TEMPLATE_DIR) + "/" + name);
+		return Template::parse(scanner)->render(ctx, filter);
+	}
+};
+
+BOOST_FIXTURE_TEST_SUITE(GeneratedTest, GeneratedFixture);
+
+BOOST_AUTO_TEST_CASE(same_result)
+{
+	te_string out;
+	templates::render_page(out, dict);
+	BOOST_CHECK_EQUAL(out, interpreted("page.tmpl"));
+
+	// appended to what is there already
+	templates::render_unicode(out, dict);
+	BOOST_CHECK_EQUAL(out, interpreted("page.tmpl") + interpreted("unicode.tmpl"));
+
+	out.clear();
+	templates::render_empty(out, dict);
+	BOOST_CHECK(out.empty());
+}
+
+BOOST_AUTO_TEST_CASE(as_template)
+{
+	TemplateFilter upper = [](const te_string& value) {
+		te_string result(value);
+		for (te_char_t& ch : result)
+			ch = static_cast<te_char_t>(toupper(ch));
+		return result;
+	};
+
+	BOOST_CHECK_EQUAL(templates::page()->render(ctx, upper), interpreted("page.tmpl", upper));
+	BOOST_CHECK_EQUAL(templates::unicode()->render(ctx), interpreted("unicode.tmpl"));
+}
+
+BOOST_AUTO_TEST_CASE(errors)
+{
+	te_string out;
+	DictionaryPtr empty = std::make_shared<Dictionary>();
+	BOOST_CHECK_THROW(templates::render_page(out, empty), TemplateException);
+	BOOST_CHECK_THROW(GeneratedTemplate::expand(out, dict, TE_TEXT("section"), 0, nullptr), TemplateException);
+	BOOST_CHECK_THROW(GeneratedTemplate::expand(out, dict, TE_TEXT("TEST"), 5, nullptr), TemplateException);
+	BOOST_CHECK_THROW(GeneratedTemplate::repeat(dict, TE_TEXT("TEST"), [](const DictionaryPtr&) {}), TemplateException);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
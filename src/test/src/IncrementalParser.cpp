@@ -0,0 +1,150 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include <boost/test/unit_test.hpp>
+
+#include <random>
+
+#include <TemplateEngine.hpp>
+#include <TemplateList.hpp>
+
+#include "Fixtures.hpp"
+
+using namespace template_engine;
+
+// Boost test doesn't know these types and cannot output their value
+BOOST_TEST_DONT_PRINT_LOG_VALUE(te_string);
+
+struct IncrementalFixture : PageFixture {
+	IncrementalFixture()
+	{
+		DictionaryListPtr outer = std::make_shared<DictionaryList>();
+		dict->add(TE_TEXT("outer"), outer);
+		outer->add(std::make_shared<Dictionary>());
+	}
+
+	/** A definition of the given number of lines, with a large repeat instruction in the middle */
+	static te_string definition(size_t lines)
+	{
+		te_string result;
+		for (size_t i = 0; i < lines; ++i) {
+			if (i == lines / 3)
+				result += TE_TEXT("{{#repeat outer}}\n");
+			result += TE_TEXT("<p>{{TEST}} text {{- comment }} \\{{ {{#repeat section}}{{B}}{{/repeat}}</p>\n");
+			if (i % 7 == 3)
+				result += TE_TEXT("{{#repeat section}}<li>{{B}}{{#repeat inner}}{{C}}{{:B}}{{/repeat}}</li>\n{{/repeat}}");
+			if (i == 2 * lines / 3)
+				result += TE_TEXT("{{/repeat}}\n");
+		}
+		return result;
+	}
+
+	/** The image of the parsed template, or "error" if the definition can't be parsed
+	 *
+	 * Lists aren't part of an image and adjacent literals are merged, so
+	 * equal images are equal templates, however they are split into lists.
+	 */
+	static std::string image(const std::function<TemplatePtr()>& parse)
+	{
+		try {
+			return TemplateImage::save(parse());
+		}
+		catch (const TemplateException&) {
+			return "error";
+		}
+	}
+
+	static std::string interpreted(const te_string& definition)
+	{
+		return image([&]() {
+			return parse(definition);
+		});
+	}
+};
+
+BOOST_FIXTURE_TEST_SUITE(IncrementalParserTest, IncrementalFixture);
+
+BOOST_AUTO_TEST_CASE(same_result)
+{
+	te_string text = definition(60);
+	IncrementalParser parser(Template::defaultMaxDepth, 128);
+	parser.parse(text);
+	BOOST_CHECK_EQUAL(parser.getDefinition(), text);
+	BOOST_CHECK_EQUAL(parser.getTemplate()->render(ctx), render(text));
+
+	// edits which make and break instructions, comments and escapes
+	const te_char_t* snippets[] = { TE_TEXT(""), TE_TEXT("{"), TE_TEXT("}"), TE_TEXT("{{"), TE_TEXT("}}"), TE_TEXT("\\"),
+		TE_TEXT("{{TEST}}"), TE_TEXT("{{-"), TE_TEXT("{{#repeat section}}"), TE_TEXT("{{/repeat}}"), TE_TEXT("x\n"),
+		TE_TEXT("{{#repeat"), TE_TEXT("{{B}}"), TE_TEXT("-"), TE_TEXT(" ") };
+
+	std::mt19937 random(42);
+	for (int i = 0; i < 400; ++i) {
+		size_t offset = random() % (text.size() + 1);
+		size_t removed = std::min<size_t>(random() % 24, text.size() - offset);
+		te_string inserted = snippets[random() % (sizeof(snippets) / sizeof(snippets[0]))];
+
+		te_string edited = text;
+		edited.replace(offset, removed, inserted);
+		std::string expected = interpreted(edited);
+		std::string actual = image([&]() { return parser.edit(offset, removed, inserted); });
+
+		if (actual != "error" || expected != "error")
+			text = edited;
+		BOOST_REQUIRE_EQUAL(parser.getDefinition(), text);
+		BOOST_REQUIRE_EQUAL(actual, expected);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(shared)
+{
+	te_string text = definition(60);
+	IncrementalParser parser(Template::defaultMaxDepth, 128);
+	TemplatePtr before = parser.parse(text);
+
+	// only the edited block is parsed again
+	TemplatePtr after = parser.edit(12, 4, TE_TEXT("TEXT"));
+	std::shared_ptr<const TemplateList> beforeList = std::dynamic_pointer_cast<const TemplateList>(before);
+	std::shared_ptr<const TemplateList> afterList = std::dynamic_pointer_cast<const TemplateList>(after);
+	BOOST_REQUIRE(beforeList && afterList);
+	BOOST_REQUIRE_EQUAL(beforeList->size(), afterList->size());
+	BOOST_CHECK(beforeList->front() != afterList->front());
+	BOOST_CHECK(std::equal(beforeList->begin() + 1, beforeList->end(), afterList->begin() + 1));
+
+	// the previous template is unchanged
+	text.replace(12, 4, TE_TEXT("TEXT"));
+	BOOST_CHECK_EQUAL(after->render(ctx), render(text));
+	BOOST_CHECK(before->render(ctx) != after->render(ctx));
+}
+
+BOOST_AUTO_TEST_CASE(errors)
+{
+	IncrementalParser parser;
+	BOOST_CHECK(parser.getTemplate()->render(ctx).empty());
+
+	parser.parse(TE_TEXT("a{{TEST}}b"));
+	BOOST_CHECK_THROW(parser.edit(11, 0, TE_TEXT("x")), TemplateException);
+	BOOST_CHECK_THROW(parser.edit(3, 9, TE_TEXT("x")), TemplateException);
+
+	// the edit isn't applied when the result can't be parsed
+	BOOST_CHECK_THROW(parser.edit(7, 0, TE_TEXT(" x")), TemplateException);
+	BOOST_CHECK_EQUAL(parser.getDefinition(), TE_TEXT("a{{TEST}}b"));
+	BOOST_CHECK_EQUAL(parser.getTemplate()->render(ctx), TE_TEXT("a<TEST>b"));
+
+	BOOST_CHECK_THROW(parser.edit(10, 0, TE_TEXT("{{- runaway")), TemplateException);
+	BOOST_CHECK_EQUAL(parser.edit(10, 0, TE_TEXT("{{- closed }}"))->render(ctx), TE_TEXT("a<TEST>b"));
+}
+
+BOOST_AUTO_TEST_SUITE_END();
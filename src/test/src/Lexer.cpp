@@ -25,6 +25,15 @@ using namespace template_engine;
 BOOST_TEST_DONT_PRINT_LOG_VALUE(te_string);
 BOOST_TEST_DONT_PRINT_LOG_VALUE(Lexer::Token::token_t);
 
+namespace
+{
+// Is the token a run of plain text with the given value?
+bool isText(const Lexer::Token& t, const te_string& text)
+{
+	return Lexer::Token::token_t::Text == t.getType() && text == te_string(t.getText(), t.getTextLength());
+}
+}
+
 BOOST_AUTO_TEST_SUITE(LexerTest); // , *utf::disabled());
 
 BOOST_AUTO_TEST_CASE(lexer01)
@@ -40,9 +49,8 @@ BOOST_AUTO_TEST_CASE(lexer02)
 	StringScanner s(TE_TEXT("ABC"));
 	Lexer lexer(s);
 
-	BOOST_CHECK(Lexer::Token::token_t::Char == lexer.getNextToken().getType());
-	BOOST_CHECK(Lexer::Token::token_t::Char == lexer.getNextToken().getType());
-	BOOST_CHECK(Lexer::Token::token_t::Char == lexer.getNextToken().getType());
+	// plain text is a single literal run
+	BOOST_CHECK(isText(lexer.getNextToken(), TE_TEXT("ABC")));
 	BOOST_CHECK(Lexer::Token::token_t::Eos == lexer.getNextToken().getType());
 }
 
@@ -63,16 +71,13 @@ BOOST_AUTO_TEST_CASE(lexer04)
 	StringScanner s(TE_TEXT("}}"));
 	Lexer lexer(s);
 
-	Lexer::Token t = lexer.getNextToken();
-	BOOST_CHECK(Lexer::Token::token_t::Char == t.getType() && TE_TEXT('}') == t.getChar());
-	t = lexer.getNextToken();
-	BOOST_CHECK(Lexer::Token::token_t::Char == t.getType() && TE_TEXT('}') == t.getChar());
+	BOOST_CHECK(isText(lexer.getNextToken(), TE_TEXT("}}")));
 	BOOST_CHECK(Lexer::Token::token_t::Eos == lexer.getNextToken().getType());
 }
 
 BOOST_AUTO_TEST_CASE(lexer05)
 {
-	StringScanner s(uR"(\\)");
+	StringScanner s(TE_TEXT(R"(\\)"));
 	Lexer lexer(s);
 
 	BOOST_CHECK(TE_TEXT('\\') == lexer.getNextToken().getChar());
@@ -82,7 +87,7 @@ BOOST_AUTO_TEST_CASE(lexer05)
 
 BOOST_AUTO_TEST_CASE(lexer06)
 {
-	StringScanner s(uR"(\{)");
+	StringScanner s(TE_TEXT(R"(\{)"));
 	Lexer lexer(s);
 
 	BOOST_CHECK(TE_TEXT('\\') == lexer.getNextToken().getChar());
@@ -92,7 +97,7 @@ BOOST_AUTO_TEST_CASE(lexer06)
 
 BOOST_AUTO_TEST_CASE(lexer07)
 {
-	StringScanner s(uR"(\)");
+	StringScanner s(TE_TEXT(R"(\)"));
 	Lexer lexer(s);
 
 	BOOST_CHECK(TE_TEXT('\\') == lexer.getNextToken().getChar());
@@ -101,43 +106,33 @@ BOOST_AUTO_TEST_CASE(lexer07)
 
 BOOST_AUTO_TEST_CASE(lexer08)
 {
-	StringScanner s(uR"(\aaa)");
+	StringScanner s(TE_TEXT(R"(\aaa)"));
 	Lexer lexer(s);
 
 	BOOST_CHECK(TE_TEXT('\\') == lexer.getNextToken().getChar());
-	BOOST_CHECK(TE_TEXT('a') == lexer.getNextToken().getChar());
-	BOOST_CHECK(TE_TEXT('a') == lexer.getNextToken().getChar());
-	BOOST_CHECK(TE_TEXT('a') == lexer.getNextToken().getChar());
+	BOOST_CHECK(isText(lexer.getNextToken(), TE_TEXT("aaa")));
 	BOOST_CHECK(Lexer::Token::token_t::Eos == lexer.getNextToken().getType());
 }
 
 BOOST_AUTO_TEST_CASE(lexer09)
 {
-	StringScanner s(uR"(\{{ab)");
+	StringScanner s(TE_TEXT(R"(\{{ab)"));
 	Lexer lexer(s);
 
 	BOOST_CHECK(TE_TEXT('{') == lexer.getNextToken().getChar());
 	BOOST_CHECK(TE_TEXT('{') == lexer.getNextToken().getChar());
-	BOOST_CHECK(TE_TEXT('a') == lexer.getNextToken().getChar());
-	BOOST_CHECK(TE_TEXT('b') == lexer.getNextToken().getChar());
+	BOOST_CHECK(isText(lexer.getNextToken(), TE_TEXT("ab")));
 	BOOST_CHECK(Lexer::Token::token_t::Eos == lexer.getNextToken().getType());
 }
 
 BOOST_AUTO_TEST_CASE(lexer10)
 {
-	StringScanner s(uR"(\}}ab)");
+	StringScanner s(TE_TEXT(R"(\}}ab)"));
 	Lexer lexer(s);
 
 	Lexer::Token t = lexer.getNextToken();
 	BOOST_CHECK(Lexer::Token::token_t::Char == t.getType() && TE_TEXT('\\') == t.getChar());
-	t = lexer.getNextToken();
-	BOOST_CHECK(Lexer::Token::token_t::Char == t.getType() && TE_TEXT('}') == t.getChar());
-	t = lexer.getNextToken();
-	BOOST_CHECK(Lexer::Token::token_t::Char == t.getType() && TE_TEXT('}') == t.getChar());
-	t = lexer.getNextToken();
-	BOOST_CHECK(Lexer::Token::token_t::Char == t.getType() && TE_TEXT('a') == t.getChar());
-	t = lexer.getNextToken();
-	BOOST_CHECK(Lexer::Token::token_t::Char == t.getType() && TE_TEXT('b') == t.getChar());
+	BOOST_CHECK(isText(lexer.getNextToken(), TE_TEXT("}}ab")));
 	BOOST_CHECK(Lexer::Token::token_t::Eos == lexer.getNextToken().getType());
 }
 
@@ -150,24 +145,7 @@ BOOST_AUTO_TEST_CASE(lexer11)
 	BOOST_CHECK(Lexer::Token::token_t::Char == t.getType() && TE_TEXT('{') == t.getChar());
 	t = lexer.getNextToken();
 	BOOST_CHECK(Lexer::Token::token_t::Char == t.getType() && TE_TEXT('{') == t.getChar());
-	t = lexer.getNextToken();
-	BOOST_CHECK(Lexer::Token::token_t::Char == t.getType() && TE_TEXT(' ') == t.getChar());
-	t = lexer.getNextToken();
-	BOOST_CHECK(Lexer::Token::token_t::Char == t.getType() && TE_TEXT(' ') == t.getChar());
-	t = lexer.getNextToken();
-	BOOST_CHECK(Lexer::Token::token_t::Char == t.getType() && TE_TEXT(' ') == t.getChar());
-	t = lexer.getNextToken();
-	BOOST_CHECK(Lexer::Token::token_t::Char == t.getType() && TE_TEXT('T') == t.getChar());
-	t = lexer.getNextToken();
-	BOOST_CHECK(Lexer::Token::token_t::Char == t.getType() && TE_TEXT('E') == t.getChar());
-	t = lexer.getNextToken();
-	BOOST_CHECK(Lexer::Token::token_t::Char == t.getType() && TE_TEXT('S') == t.getChar());
-	t = lexer.getNextToken();
-	BOOST_CHECK(Lexer::Token::token_t::Char == t.getType() && TE_TEXT('T') == t.getChar());
-	t = lexer.getNextToken();
-	BOOST_CHECK(Lexer::Token::token_t::Char == t.getType() && TE_TEXT('}') == t.getChar());
-	t = lexer.getNextToken();
-	BOOST_CHECK(Lexer::Token::token_t::Char == t.getType() && TE_TEXT('}') == t.getChar());
+	BOOST_CHECK(isText(lexer.getNextToken(), TE_TEXT("   TEST}}")));
 	BOOST_CHECK(Lexer::Token::token_t::Eos == lexer.getNextToken().getType());
 }
 
@@ -179,7 +157,7 @@ BOOST_AUTO_TEST_CASE(lexer12)
 	BOOST_CHECK(Lexer::Token::token_t::StartTag == lexer.getNextToken().getType());
 	BOOST_CHECK(Lexer::Token::token_t::Name == lexer.getNextToken().getType());
 	BOOST_CHECK(Lexer::Token::token_t::EndTag == lexer.getNextToken().getType());
-	BOOST_CHECK(TE_TEXT('a') == lexer.getNextToken().getChar());
+	BOOST_CHECK(isText(lexer.getNextToken(), TE_TEXT("a")));
 	BOOST_CHECK(Lexer::Token::token_t::Eos == lexer.getNextToken().getType());
 }
 
@@ -202,10 +180,7 @@ BOOST_AUTO_TEST_CASE(lexer14)
 	BOOST_CHECK(Lexer::Token::token_t::Char == t.getType() && TE_TEXT('{') == t.getChar());
 	t = lexer.getNextToken();
 	BOOST_CHECK(Lexer::Token::token_t::Char == t.getType() && TE_TEXT('{') == t.getChar());
-	t = lexer.getNextToken();
-	BOOST_CHECK(Lexer::Token::token_t::Char == t.getType() && TE_TEXT('}') == t.getChar());
-	t = lexer.getNextToken();
-	BOOST_CHECK(Lexer::Token::token_t::Char == t.getType() && TE_TEXT('}') == t.getChar());
+	BOOST_CHECK(isText(lexer.getNextToken(), TE_TEXT("}}")));
 	BOOST_CHECK(Lexer::Token::token_t::Eos == lexer.getNextToken().getType());
 }
 
@@ -242,7 +217,7 @@ BOOST_AUTO_TEST_CASE(lexer16)
 
 BOOST_AUTO_TEST_CASE(lexer17)
 {
-	StringScanner s(uR"({{- this is a test and \{{ \}})");
+	StringScanner s(TE_TEXT(R"({{- this is a test and \{{ \}})"));
 	Lexer lexer(s);
 
 	BOOST_CHECK(Lexer::Token::token_t::Eos == lexer.getNextToken().getType());
@@ -250,36 +225,36 @@ BOOST_AUTO_TEST_CASE(lexer17)
 
 BOOST_AUTO_TEST_CASE(lexer18)
 {
-	StringScanner s(uR"(a{{- this is a test and \{{ \}}b)");
+	StringScanner s(TE_TEXT(R"(a{{- this is a test and \{{ \}}b)"));
 	Lexer lexer(s);
 
-	BOOST_CHECK(TE_TEXT('a') == lexer.getNextToken().getChar());
-	BOOST_CHECK(TE_TEXT('b') == lexer.getNextToken().getChar());
+	BOOST_CHECK(isText(lexer.getNextToken(), TE_TEXT("a")));
+	BOOST_CHECK(isText(lexer.getNextToken(), TE_TEXT("b")));
 	BOOST_CHECK(Lexer::Token::token_t::Eos == lexer.getNextToken().getType());
 }
 
 BOOST_AUTO_TEST_CASE(lexer19)
 {
-	StringScanner s(uR"(a{{- this is a test and )");
+	StringScanner s(TE_TEXT(R"(a{{- this is a test and )"));
 	Lexer lexer(s);
 
-	BOOST_CHECK(TE_TEXT('a') == lexer.getNextToken().getChar());
+	BOOST_CHECK(isText(lexer.getNextToken(), TE_TEXT("a")));
 	BOOST_REQUIRE_THROW(lexer.getNextToken().getType(), TemplateException);
 }
 
 BOOST_AUTO_TEST_CASE(lexer20)
 {
-	StringScanner s(uR"(a\{{\}}\b)");
+	StringScanner s(TE_TEXT(R"(a\{{\}}\b)"));
 	Lexer lexer(s);
 
-	BOOST_CHECK(TE_TEXT('a') == lexer.getNextToken().getChar());
+	BOOST_CHECK(isText(lexer.getNextToken(), TE_TEXT("a")));
 	BOOST_CHECK(TE_TEXT('{') == lexer.getNextToken().getChar());
 	BOOST_CHECK(TE_TEXT('{') == lexer.getNextToken().getChar());
 	BOOST_CHECK(TE_TEXT('\\') == lexer.getNextToken().getChar());
-	BOOST_CHECK(TE_TEXT('}') == lexer.getNextToken().getChar());
-	BOOST_CHECK(TE_TEXT('}') == lexer.getNextToken().getChar());
+	BOOST_CHECK(isText(lexer.getNextToken(), TE_TEXT("}}")));
 	BOOST_CHECK(TE_TEXT('\\') == lexer.getNextToken().getChar());
-	BOOST_CHECK(TE_TEXT('b') == lexer.getNextToken().getChar());
+	// looking for '\{{' peeks at the 'b' without buffering it, so it starts a literal run
+	BOOST_CHECK(isText(lexer.getNextToken(), TE_TEXT("b")));
 	BOOST_CHECK(Lexer::Token::token_t::Eos == lexer.getNextToken().getType());
 }
 
@@ -294,7 +269,7 @@ BOOST_AUTO_TEST_CASE(lexer21)
 	BOOST_CHECK(t1.getName() == TE_TEXT("APP"));
 	BOOST_CHECK(Lexer::Token::token_t::EndTag == lexer.getNextToken().getType());
 
-	BOOST_CHECK(TE_TEXT(' ') == lexer.getNextToken().getChar());
+	BOOST_CHECK(isText(lexer.getNextToken(), TE_TEXT(" ")));
 
 	BOOST_CHECK(Lexer::Token::token_t::StartTag == lexer.getNextToken().getType());
 	const Lexer::Token& t2 = lexer.getNextToken();
@@ -307,7 +282,7 @@ BOOST_AUTO_TEST_CASE(lexer21)
 
 BOOST_AUTO_TEST_CASE(lexer22)
 {
-	StringScanner s(uR"({{{TEST}})");
+	StringScanner s(TE_TEXT(R"({{{TEST}})"));
 	Lexer lexer(s);
 
 	BOOST_CHECK(TE_TEXT('{') == lexer.getNextToken().getChar());
@@ -321,7 +296,7 @@ BOOST_AUTO_TEST_CASE(lexer22)
 
 BOOST_AUTO_TEST_CASE(lexer23)
 {
-	StringScanner s(uR"({{{{TEST}})");
+	StringScanner s(TE_TEXT(R"({{{{TEST}})"));
 	Lexer lexer(s);
 
 	BOOST_CHECK(TE_TEXT('{') == lexer.getNextToken().getChar());
@@ -336,17 +311,94 @@ BOOST_AUTO_TEST_CASE(lexer23)
 
 BOOST_AUTO_TEST_CASE(lexer24)
 {
-	StringScanner s(uR"({{{}{}})");
+	StringScanner s(TE_TEXT(R"({{{}{}})"));
 	Lexer lexer(s);
 	BOOST_CHECK(TE_TEXT('{') == lexer.getNextToken().getChar());
 	BOOST_CHECK(TE_TEXT('{') == lexer.getNextToken().getChar());
 	BOOST_CHECK(TE_TEXT('{') == lexer.getNextToken().getChar());
-	BOOST_CHECK(TE_TEXT('}') == lexer.getNextToken().getChar());
+	BOOST_CHECK(isText(lexer.getNextToken(), TE_TEXT("}")));
 	BOOST_CHECK(TE_TEXT('{') == lexer.getNextToken().getChar());
-	BOOST_CHECK(TE_TEXT('}') == lexer.getNextToken().getChar());
-	BOOST_CHECK(TE_TEXT('}') == lexer.getNextToken().getChar());
+	BOOST_CHECK(isText(lexer.getNextToken(), TE_TEXT("}}")));
 	BOOST_CHECK(Lexer::Token::token_t::Eos == lexer.getNextToken().getType());
 }
+
+BOOST_AUTO_TEST_CASE(lexer25)
+{
+	// long enough for the vector kernels, with specials on both sides of a register boundary
+	te_string text(100, TE_TEXT('x'));
+	StringScanner s(text + TE_TEXT("{{A}}") + text + TE_TEXT("\\") + text);
+	Lexer lexer(s);
+
+	BOOST_CHECK(isText(lexer.getNextToken(), text));
+	BOOST_CHECK(Lexer::Token::token_t::StartTag == lexer.getNextToken().getType());
+	BOOST_CHECK(Lexer::Token::token_t::Name == lexer.getNextToken().getType());
+	BOOST_CHECK(Lexer::Token::token_t::EndTag == lexer.getNextToken().getType());
+	BOOST_CHECK(isText(lexer.getNextToken(), text));
+	BOOST_CHECK(TE_TEXT('\\') == lexer.getNextToken().getChar());
+	BOOST_CHECK(isText(lexer.getNextToken(), text));
+	BOOST_CHECK(Lexer::Token::token_t::Eos == lexer.getNextToken().getType());
+}
+
+BOOST_AUTO_TEST_CASE(lexer26)
+{
+	StringScanner s(TE_TEXT("abc{{A}}"));
+	Lexer lexer(s);
+
+	// a token put back is handed out again, unchanged
+	const Lexer::Token& t = lexer.getNextToken();
+	BOOST_CHECK(isText(t, TE_TEXT("abc")));
+	lexer.putTokenBack(t);
+	BOOST_CHECK(isText(lexer.getNextToken(), TE_TEXT("abc")));
+
+	BOOST_CHECK(Lexer::Token::token_t::StartTag == lexer.getNextToken().getType());
+	const Lexer::Token& name = lexer.getNextToken();
+	BOOST_CHECK(Lexer::Token::token_t::Name == name.getType());
+	lexer.putTokenBack(name);
+	BOOST_CHECK(lexer.getNextToken().getName() == TE_TEXT("A"));
+
+	// the lexer state isn't rewound, what follows the end tag is plain text again
+	BOOST_CHECK(Lexer::Token::token_t::EndTag == lexer.getNextToken().getType());
+	lexer.putTokenBack(lexer.getNextToken());
+	BOOST_CHECK(Lexer::Token::token_t::Eos == lexer.getNextToken().getType());
+}
+
+BOOST_AUTO_TEST_CASE(char_class)
+{
+	BOOST_CHECK(char_class_t::Name == classify(TE_TEXT('a')));
+	BOOST_CHECK(char_class_t::Name == classify(TE_TEXT('Z')));
+	BOOST_CHECK(char_class_t::Name == classify(TE_TEXT('7')));
+	BOOST_CHECK(char_class_t::Name == classify(TE_TEXT('-')));
+	BOOST_CHECK(char_class_t::Space == classify(TE_TEXT('\t')));
+	BOOST_CHECK(char_class_t::Marker == classify(TE_TEXT(':')));
+	BOOST_CHECK(char_class_t::Escape == classify(TE_TEXT('\\')));
+
+	// nothing outside ASCII is special, whatever the C library thinks of it
+	BOOST_CHECK(char_class_t::Other == classify(static_cast<te_char_t>(0xA0)));
+	BOOST_CHECK(char_class_t::Other == classify(static_cast<te_char_t>(0xC4)));
+	BOOST_CHECK(char_class_t::Other == classify(static_cast<te_char_t>(0xFF)));
+}
+
+BOOST_AUTO_TEST_CASE(specifier)
+{
+	// within an instruction, code units which can't be part of a name are single chars
+	StringScanner s(TE_TEXT("{{P:>+.1%}}"));
+	Lexer lexer(s);
+
+	BOOST_CHECK(Lexer::Token::token_t::StartTag == lexer.getNextToken().getType());
+	const Lexer::Token& name = lexer.getNextToken();
+	BOOST_CHECK(Lexer::Token::token_t::Name == name.getType() && name.getName() == TE_TEXT("P"));
+	for (te_char_t ch : te_string(TE_TEXT(":>+."))) {
+		const Lexer::Token& t = lexer.getNextToken();
+		BOOST_CHECK(Lexer::Token::token_t::Char == t.getType() && ch == t.getChar());
+	}
+	const Lexer::Token& precision = lexer.getNextToken();
+	BOOST_CHECK(Lexer::Token::token_t::Name == precision.getType() && precision.getName() == TE_TEXT("1"));
+	const Lexer::Token& percent = lexer.getNextToken();
+	BOOST_CHECK(Lexer::Token::token_t::Char == percent.getType() && TE_TEXT('%') == percent.getChar());
+	BOOST_CHECK(Lexer::Token::token_t::EndTag == lexer.getNextToken().getType());
+	BOOST_CHECK(Lexer::Token::token_t::Eos == lexer.getNextToken().getType());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 
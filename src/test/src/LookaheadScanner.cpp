@@ -142,4 +142,81 @@ BOOST_AUTO_TEST_CASE(peek_02)
 	BOOST_CHECK(false == l.moveNext());
 	BOOST_CHECK(true == l.atEos());
 }
+
+namespace
+{
+/** Scanner relying on the default one code unit block adapter */
+class PerUnitScanner : public Scanner
+{
+public:
+	PerUnitScanner(const te_char_t* t) : _scanner(t) {}
+
+	virtual bool moveNext() { return _scanner.moveNext(); }
+	virtual bool atEos() const { return _scanner.atEos(); }
+	virtual te_char_t getChar() const { return _scanner.getChar(); }
+
+private:
+	StringScanner _scanner;
+};
+}
+
+BOOST_AUTO_TEST_CASE(per_unit_scanner)
+{
+	PerUnitScanner s(TE_TEXT("Abc"));
+	LookaheadScanner l(s);
+
+	BOOST_CHECK(TE_TEXT('b') == l.peek(1));
+	BOOST_CHECK(TE_TEXT('A') == l.getChar());
+	BOOST_CHECK(true == l.moveNext());
+	BOOST_CHECK(TE_TEXT('b') == l.getChar());
+	BOOST_CHECK(TE_TEXT('c') == l.peek(1));
+	BOOST_CHECK(true == l.moveNext());
+	BOOST_CHECK(TE_TEXT('c') == l.getChar());
+	BOOST_CHECK(TE_TEXT('\0') == l.peek(1));
+	BOOST_CHECK(false == l.moveNext());
+	BOOST_CHECK(true == l.atEos());
+}
+
+BOOST_AUTO_TEST_CASE(block_01)
+{
+	StringScanner s(TE_TEXT("Abc"));
+	LookaheadScanner l(s);
+	size_t length;
+
+	// pushed back code units are handed out before the wrapped blocks
+	l.pushFront(TE_TEXT('X'));
+	const te_char_t* block = l.getBlock(length);
+	BOOST_CHECK(1 == length);
+	BOOST_CHECK(TE_TEXT('X') == *block);
+
+	l.advance(2);
+	BOOST_CHECK(TE_TEXT('b') == l.getChar());
+	block = l.getBlock(length);
+	BOOST_CHECK(2 == length);
+	BOOST_CHECK(te_string(TE_TEXT("bc")) == te_string(block, length));
+
+	l.advance(2);
+	BOOST_CHECK(true == l.atEos());
+	BOOST_CHECK(nullptr == l.getBlock(length));
+	BOOST_CHECK(0 == length);
+}
+
+BOOST_AUTO_TEST_CASE(push_front_03)
+{
+	StringScanner s(TE_TEXT("A"));
+	LookaheadScanner l(s);
+
+	// the ring buffer wraps, and is bounded
+	for (size_t i = 0; i < LookaheadScanner::capacity; ++i)
+		l.pushFront(TE_TEXT('X'));
+	BOOST_REQUIRE_THROW(l.pushBack(TE_TEXT('Y')), TemplateException);
+
+	for (size_t i = 0; i < LookaheadScanner::capacity; ++i) {
+		BOOST_CHECK(TE_TEXT('X') == l.getChar());
+		BOOST_CHECK(true == l.moveNext());
+	}
+	BOOST_CHECK(TE_TEXT('A') == l.getChar());
+	BOOST_CHECK(false == l.moveNext());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
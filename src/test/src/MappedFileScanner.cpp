@@ -0,0 +1,134 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <TemplateEngine.hpp>
+
+using namespace template_engine;
+
+// Boost test doesn't know these types and cannot output their value
+BOOST_TEST_DONT_PRINT_LOG_VALUE(te_string);
+
+namespace
+{
+/** Writes a temporary file, which is removed again at the end of the test */
+struct TemporaryFile
+{
+	TemporaryFile(const std::string& content) :
+		path("MappedFileScanner_" + std::to_string(sizeof(te_char_t)) + ".tmp")
+	{
+		std::ofstream file(path.c_str(), std::ios::binary);
+		file << content;
+	}
+
+	~TemporaryFile() { std::remove(path.c_str()); }
+
+	std::string path;
+};
+
+/** Read everything from the scanner, the way the lexer does */
+te_string readAll(Scanner& scanner)
+{
+	te_string result;
+	size_t length;
+	const te_char_t* block;
+	while ((block = scanner.getBlock(length)) != nullptr && length) {
+		result.append(block, length);
+		scanner.advance(length);
+	}
+	return result;
+}
+}
+
+BOOST_AUTO_TEST_SUITE(MappedFileScannerTest);
+
+BOOST_AUTO_TEST_CASE(empty_file)
+{
+	TemporaryFile file("");
+	MappedFileScanner s(file.path);
+
+	BOOST_CHECK(true == s.atEos());
+	BOOST_CHECK(false == s.moveNext());
+}
+
+BOOST_AUTO_TEST_CASE(missing_file)
+{
+	BOOST_REQUIRE_THROW(MappedFileScanner("no such file.tmp"), TemplateException);
+}
+
+BOOST_AUTO_TEST_CASE(simple_file)
+{
+	TemporaryFile file("Abc");
+	MappedFileScanner s(file.path);
+
+	BOOST_CHECK(TE_TEXT('A') == s.getChar());
+	BOOST_CHECK(true == s.moveNext());
+	BOOST_CHECK(TE_TEXT('b') == s.getChar());
+	BOOST_CHECK(true == s.moveNext());
+	BOOST_CHECK(TE_TEXT('c') == s.getChar());
+	BOOST_CHECK(false == s.moveNext());
+}
+
+BOOST_AUTO_TEST_CASE(byte_order_mark)
+{
+	TemporaryFile file("\xEF\xBB\xBF\xC3\xA6\xC3\xB8\xC3\xA5");
+	MappedFileScanner s(file.path);
+
+	BOOST_CHECK_EQUAL(readAll(s), from_utf8("\xC3\xA6\xC3\xB8\xC3\xA5"));
+}
+
+BOOST_AUTO_TEST_CASE(invalid_utf8)
+{
+	TemporaryFile file("abc\xC0\xAF");
+
+	BOOST_REQUIRE_THROW(MappedFileScanner(file.path), TemplateException);
+}
+
+BOOST_AUTO_TEST_CASE(large_file)
+{
+	// multi byte sequences straddling every possible chunk boundary
+	std::string content;
+	while (content.size() < 300 * 1024)
+		content += "x\xE2\x82\xAC\xF0\x9F\x98\x80{{-c}}";
+	TemporaryFile file(content);
+	MappedFileScanner s(file.path);
+
+	BOOST_CHECK(readAll(s) == from_utf8(content));
+}
+
+BOOST_AUTO_TEST_CASE(parse_file)
+{
+	// declared first, a mapped file can't be removed on all platforms
+	TemporaryFile file("a {{TEST}} \xC3\xA6 {{- comment }}b");
+	std::shared_ptr<Template> t;
+	{
+		MappedFileScanner s(file.path);
+		t = Template::parse(s);
+	}
+
+	DictionaryPtr dict = std::make_shared<Dictionary>();
+	dict->add(TE_TEXT("TEST"), TE_TEXT("<TEST>"));
+	ContextPtr ctx = Context::BuildContext();
+	ctx->setDictionary(dict);
+
+	// the template outlives the scanner
+	BOOST_CHECK_EQUAL(t->render(ctx), from_utf8("a <TEST> \xC3\xA6 b"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,86 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include <boost/test/unit_test.hpp>
+
+
+#include <TemplateEngine.hpp>
+#include <SimpleTemplate.hpp>
+#include <TemplateList.hpp>
+#include <Version.hpp>
+
+#include "Fixtures.hpp"
+
+using namespace template_engine;
+namespace utf = boost::unit_test;
+
+// Boost test doesn't know these types and cannot output their value
+BOOST_TEST_DONT_PRINT_LOG_VALUE(te_string);
+
+BOOST_FIXTURE_TEST_SUITE(OptimizerTest, PageFixture);
+
+BOOST_AUTO_TEST_CASE(single_literal)
+{
+	// a list with a single literal is replaced by it
+	TemplatePtr t = TemplateOptimizer().optimize(parse(TE_TEXT("a {{- comment }}b \\{{ c")));
+
+	BOOST_CHECK(nullptr != std::dynamic_pointer_cast<SimpleTemplate>(t));
+	BOOST_CHECK_EQUAL(t->render(ctx), TE_TEXT("a b {{ c"));
+}
+
+BOOST_AUTO_TEST_CASE(unchanged)
+{
+	TemplatePtr t = parse(TE_TEXT("a{{TEST}}b{{#repeat section}}{{B}}-{{B}}{{/repeat}}"));
+	TemplatePtr optimized = TemplateOptimizer().optimize(t);
+
+	BOOST_CHECK(t == optimized);
+	BOOST_CHECK_EQUAL(optimized->render(ctx), TE_TEXT("a<TEST>bb-bc-c"));
+}
+
+BOOST_AUTO_TEST_CASE(fold_constants)
+{
+	te_string definition(TE_TEXT("{{APP}} {{VERSION}} {{TEST}} {{#repeat section}}[{{APP}}]{{/repeat}}"));
+	te_string app = ctx->getValue(TE_TEXT("APP"));
+	te_string version = ctx->getValue(TE_TEXT("VERSION"));
+
+	TemplatePtr t = TemplateOptimizer(true).optimize(parse(definition));
+	BOOST_CHECK_EQUAL(t->render(ctx), app + TE_TEXT(" ") + version + TE_TEXT(" <TEST> [") + app + TE_TEXT("][") + app + TE_TEXT("]"));
+
+	// the leading constants and the text between them became a single literal
+	std::shared_ptr<TemplateList> list = std::dynamic_pointer_cast<TemplateList>(t);
+	BOOST_REQUIRE(nullptr != list);
+	BOOST_CHECK_EQUAL(list->size(), 4u);
+
+	// without folding, a dictionary may override the constants
+	dict->add(TE_TEXT("APP"), TE_TEXT("mine"));
+	BOOST_CHECK_EQUAL(TemplateOptimizer().optimize(parse(TE_TEXT("{{APP}}")))->render(ctx), TE_TEXT("mine"));
+}
+
+BOOST_AUTO_TEST_CASE(fold_filtered)
+{
+	TemplateFilter upper = [](const te_string& value) {
+		te_string result(value);
+		for (te_char_t& ch : result)
+			ch = static_cast<te_char_t>(toupper(ch));
+		return result;
+	};
+
+	TemplatePtr t = TemplateOptimizer(true, upper).optimize(parse(TE_TEXT("{{APP}}{{:APP}}")));
+	te_string app = ctx->getValue(TE_TEXT("APP"));
+	BOOST_CHECK_EQUAL(t->render(ctx, upper), upper(app) + upper(app));
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,96 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include <boost/test/unit_test.hpp>
+
+
+#include <TemplateEngine.hpp>
+
+#include "Fixtures.hpp"
+
+using namespace template_engine;
+namespace utf = boost::unit_test;
+
+// Boost test doesn't know these types and cannot output their value
+BOOST_TEST_DONT_PRINT_LOG_VALUE(te_string);
+
+struct ParallelFixture : PageFixture {
+	/** \brief The definition repeated count times */
+	static te_string repeat(const te_string& definition, size_t count)
+	{
+		te_string result;
+		for (size_t i = 0; i < count; ++i)
+			result += definition;
+		return result;
+	}
+
+	/** \brief The message of the exception thrown while parsing */
+	template<typename Parse>
+	static std::string error(Parse parse)
+	{
+		try {
+			parse();
+		}
+		catch (const TemplateException& e) {
+			return e.what();
+		}
+		return std::string();
+	}
+};
+
+BOOST_FIXTURE_TEST_SUITE(ParallelParserTest, ParallelFixture);
+
+BOOST_AUTO_TEST_CASE(same_result)
+{
+	te_string definition = repeat(TE_TEXT("a {{TEST}} {{- {c} }}\\{{ {{#repeat section}}[{{B}}]{{/repeat}} { } "), 50);
+	te_string expected = render(definition);
+
+	for (unsigned threads = 1; threads <= 5; ++threads) {
+		ParallelParser parser(threads, Template::defaultMaxDepth, 0);
+		BOOST_CHECK_EQUAL(parser.parse(SourceBuffer::borrow(definition))->render(ctx), expected);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(unsplittable)
+{
+	// a single top level repeat instruction can't be split
+	te_string definition = TE_TEXT("{{#repeat section}}") + repeat(TE_TEXT("{{B}} {{TEST}}"), 20) + TE_TEXT("{{/repeat}}");
+
+	ParallelParser parser(4, Template::defaultMaxDepth, 0);
+	BOOST_CHECK_EQUAL(parser.parse(SourceBuffer(definition))->render(ctx), render(definition));
+}
+
+BOOST_AUTO_TEST_CASE(unmatched_end_repeat)
+{
+	// ends the template, as it does for the sequential parser
+	te_string definition = repeat(TE_TEXT("a{{TEST}}"), 10) + TE_TEXT("{{/repeat}}") + repeat(TE_TEXT("b{{TEST}}"), 10);
+
+	ParallelParser parser(4, Template::defaultMaxDepth, 0);
+	BOOST_CHECK_EQUAL(parser.parse(SourceBuffer(definition))->render(ctx), render(definition));
+}
+
+BOOST_AUTO_TEST_CASE(errors)
+{
+	// the first error is reported, whichever region it is in
+	te_string definition = repeat(TE_TEXT("a{{TEST}}"), 10) + TE_TEXT("{{TEST x}}") + repeat(TE_TEXT("b{{TEST}}"), 10) + TE_TEXT("{{#foo}}");
+
+	ParallelParser parser(4, Template::defaultMaxDepth, 0);
+	std::string expected = error([&]() { parse(definition); });
+	BOOST_CHECK(!expected.empty());
+	BOOST_CHECK_EQUAL(error([&]() { parser.parse(SourceBuffer(definition)); }), expected);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -249,4 +249,52 @@ BOOST_AUTO_TEST_CASE(repeat_parser_04) // , *utf::enabled())
 	BOOST_REQUIRE_THROW(t4->render(context), TemplateException);
 }
 
+BOOST_AUTO_TEST_CASE(owned_source)
+{
+	std::shared_ptr<Template> t;
+	{
+		// the template keeps the text alive once the scanner is gone
+		StringScanner s(te_string(TE_TEXT("a {{TEST}} b \\{{ c")));
+		t = Template::parse(s);
+	}
+	BOOST_CHECK_EQUAL(t->render(ctx), TE_TEXT("a <TEST> b {{ c"));
+}
+
+BOOST_AUTO_TEST_CASE(borrowed_source)
+{
+	te_string text(TE_TEXT("a {{TEST}} b {{#repeat section}}{{B}}{{/repeat}}"));
+	StringScanner s(SourceBuffer::borrow(text));
+	std::shared_ptr<Template> t = Template::parse(s);
+
+	BOOST_CHECK(false == SourceBuffer::borrow(text).isOwned());
+	BOOST_CHECK_EQUAL(t->render(ctx), TE_TEXT("a <TEST> b bb"));
+}
+
+BOOST_AUTO_TEST_CASE(deep_nesting)
+{
+	// far deeper than a recursive parser, or destructor, would survive
+	const size_t depth = 20000;
+	te_string text;
+	for (size_t i = 0; i < depth; ++i)
+		text += TE_TEXT("{{#repeat section}}");
+	text += TE_TEXT("x");
+	for (size_t i = 0; i < depth; ++i)
+		text += TE_TEXT("{{/repeat}}");
+
+	StringScanner s(text);
+	BOOST_CHECK_EQUAL((bool)Template::parse(s, depth), true);
+
+	StringScanner limited(text);
+	BOOST_CHECK_THROW(Template::parse(limited, depth - 1), TemplateException);
+}
+
+BOOST_AUTO_TEST_CASE(nesting_limit)
+{
+	StringScanner s1(TE_TEXT("{{#repeat section}}{{#repeat section}}{{B}}{{/repeat}}{{/repeat}}"));
+	BOOST_CHECK_THROW(Template::parse(s1, 1), TemplateException);
+
+	StringScanner s2(TE_TEXT("{{#repeat section}}{{B}}{{/repeat}}{{#repeat section}}{{B}}{{/repeat}}"));
+	BOOST_CHECK_EQUAL(Template::parse(s2, 1)->render(ctx), TE_TEXT("bbbb"));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,362 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include <boost/test/unit_test.hpp>
+#include <random>
+
+
+#include <TemplateEngine.hpp>
+#include <SpecializedTemplate.hpp>
+using namespace template_engine;
+namespace utf = boost::unit_test;
+
+// Boost test doesn't know these types and cannot output their value
+BOOST_TEST_DONT_PRINT_LOG_VALUE(te_string);
+
+struct RenderCacheFixture {
+	RenderCacheFixture() :
+		root(std::make_shared<Dictionary>()),
+		items(std::make_shared<DictionaryList>()),
+		ctx(Context::BuildContext())
+	{
+		root->add(TE_TEXT("TITLE"), TE_TEXT("list"));
+		root->add(TE_TEXT("items"), items);
+		for (const te_char_t* value : { TE_TEXT("a"), TE_TEXT("b"), TE_TEXT("c") }) {
+			DictionaryPtr item = std::make_shared<Dictionary>();
+			items->add(item);
+			item->add(TE_TEXT("VALUE"), value);
+
+			DictionaryListPtr rows = std::make_shared<DictionaryList>();
+			item->add(TE_TEXT("rows"), rows);
+			for (const te_char_t* name : { TE_TEXT("x"), TE_TEXT("y") }) {
+				DictionaryPtr row = std::make_shared<Dictionary>();
+				rows->add(row);
+				row->add(TE_TEXT("NAME"), name);
+			}
+		}
+		ctx->setDictionary(root);
+	}
+
+	static TemplatePtr parse(const te_string& definition)
+	{
+		StringScanner s(definition);
+		return Template::parse(s);
+	}
+
+	// the cache must render the same text as the template itself
+	void check(RenderCache& cache, const TemplatePtr& templ)
+	{
+		te_string expected = templ->render(ctx);
+		BOOST_CHECK_EQUAL(cache.render(ctx), expected);
+	}
+
+	DictionaryPtr makeItem(const te_string& value)
+	{
+		DictionaryPtr item = std::make_shared<Dictionary>();
+		item->add(TE_TEXT("VALUE"), value);
+		item->add(TE_TEXT("rows"), std::make_shared<DictionaryList>());
+		return item;
+	}
+
+	DictionaryPtr item(size_t index)
+	{
+		items->resetCursor();
+		for (size_t i = 0; i < index; i++)
+			items->advanceCursor();
+		return items->getCurrent();
+	}
+
+	DictionaryPtr root;
+	DictionaryListPtr items;
+	ContextPtr ctx;
+};
+
+BOOST_FIXTURE_TEST_SUITE(RenderCacheTest, RenderCacheFixture);
+
+BOOST_AUTO_TEST_CASE(reuse)
+{
+	TemplatePtr t = parse(TE_TEXT("{{TITLE}}:{{#repeat items}}<{{VALUE}}{{#repeat rows}}[{{NAME}}{{:VALUE}}]{{/repeat}}>{{/repeat}}"));
+	RenderCache cache(t);
+
+	// the template, three items and six rows
+	check(cache, t);
+	BOOST_CHECK_EQUAL(cache.getRendered(), 10u);
+	BOOST_CHECK_EQUAL(cache.getReused(), 0u);
+
+	// nothing changed
+	check(cache, t);
+	BOOST_CHECK_EQUAL(cache.getRendered(), 0u);
+	BOOST_CHECK_EQUAL(cache.getReused(), 1u);
+
+	// the item and its rows, which read the value, are rendered, the other items are reused
+	item(1)->set(TE_TEXT("VALUE"), TE_TEXT("B"));
+	check(cache, t);
+	BOOST_CHECK_EQUAL(cache.getRendered(), 4u);
+	BOOST_CHECK_EQUAL(cache.getReused(), 2u);
+
+	// a value read by every row
+	root->set(TE_TEXT("TITLE"), TE_TEXT("LIST"));
+	check(cache, t);
+	BOOST_CHECK_EQUAL(cache.getRendered(), 1u);
+	BOOST_CHECK_EQUAL(cache.getReused(), 3u);
+
+	// a value which isn't read
+	root->set(TE_TEXT("UNUSED"), TE_TEXT("!"));
+	check(cache, t);
+	BOOST_CHECK_EQUAL(cache.getRendered(), 0u);
+	BOOST_CHECK_EQUAL(cache.getReused(), 1u);
+
+	// a nested row
+	item(2)->getList(TE_TEXT("rows"))->set(0, std::make_shared<Dictionary>());
+	BOOST_CHECK_THROW(cache.render(ctx), TemplateException);
+	item(2)->getList(TE_TEXT("rows"))->remove(0);
+	check(cache, t);
+	BOOST_CHECK_EQUAL(cache.getRendered(), 2u);
+	BOOST_CHECK_EQUAL(cache.getReused(), 3u);
+
+	cache.clear();
+	check(cache, t);
+	BOOST_CHECK_EQUAL(cache.getRendered(), 9u);
+}
+
+BOOST_AUTO_TEST_CASE(scopes)
+{
+	TemplatePtr t = parse(TE_TEXT("{{#repeat items}}{{TITLE}}{{VALUE}}{{/repeat}}"));
+	RenderCache cache(t);
+	check(cache, t);
+
+	// a value hiding one of an outer scope
+	item(0)->set(TE_TEXT("TITLE"), TE_TEXT("first"));
+	check(cache, t);
+	BOOST_CHECK_EQUAL(cache.getRendered(), 2u);
+
+	BOOST_CHECK(item(0)->remove(TE_TEXT("TITLE")));
+	check(cache, t);
+	BOOST_CHECK_EQUAL(cache.getRendered(), 2u);
+
+	// rows added and removed, the remaining rows are reused
+	DictionaryPtr added = std::make_shared<Dictionary>();
+	added->add(TE_TEXT("VALUE"), TE_TEXT("d"));
+	items->add(added);
+	check(cache, t);
+	BOOST_CHECK_EQUAL(cache.getRendered(), 2u);
+	BOOST_CHECK_EQUAL(cache.getReused(), 3u);
+
+	items->remove(0);
+	check(cache, t);
+	BOOST_CHECK_EQUAL(cache.getRendered(), 1u);
+	BOOST_CHECK_EQUAL(cache.getReused(), 3u);
+
+	// another dictionary
+	DictionaryPtr other = std::make_shared<Dictionary>();
+	other->add(TE_TEXT("TITLE"), TE_TEXT("other"));
+	other->add(TE_TEXT("items"), std::make_shared<DictionaryList>());
+	ctx->setDictionary(other);
+	check(cache, t);
+	BOOST_CHECK_EQUAL(cache.getReused(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(filter)
+{
+	TemplateFilter upper = [](const te_string& value) {
+		te_string result = value;
+		for (te_char_t& ch : result)
+			if (ch >= 'a' && ch <= 'z')
+				ch = static_cast<te_char_t>(ch - 'a' + 'A');
+		return result;
+	};
+
+	TemplatePtr t = parse(TE_TEXT("{{TITLE}}{{#repeat items}}{{VALUE}}{{/repeat}}"));
+	RenderCache cache(t, upper);
+	BOOST_CHECK_EQUAL(cache.render(ctx), t->render(ctx, upper));
+	item(0)->set(TE_TEXT("VALUE"), TE_TEXT("q"));
+	BOOST_CHECK_EQUAL(cache.render(ctx), t->render(ctx, upper));
+}
+
+BOOST_AUTO_TEST_CASE(untracked)
+{
+	// the residual template of a specialization doesn't record what it reads
+	DictionaryPtr known = std::make_shared<Dictionary>();
+	known->add(TE_TEXT("SEP"), TE_TEXT(";"));
+	TemplatePtr t = Template::specialize(parse(TE_TEXT("{{#repeat items}}{{VALUE}}{{SEP}}{{/repeat}}")), known);
+	RenderCache cache(t);
+
+	check(cache, t);
+	check(cache, t);
+	BOOST_CHECK_EQUAL(cache.getReused(), 0u);
+
+	item(0)->set(TE_TEXT("VALUE"), TE_TEXT("q"));
+	check(cache, t);
+}
+
+BOOST_AUTO_TEST_CASE(errors)
+{
+	TemplatePtr t = parse(TE_TEXT("{{#repeat items}}{{VALUE}}{{/repeat}}"));
+	RenderCache cache(t);
+	check(cache, t);
+
+	// a failed render keeps the memoized output
+	BOOST_CHECK(item(1)->remove(TE_TEXT("VALUE")));
+	BOOST_CHECK_THROW(cache.render(ctx), TemplateException);
+	item(1)->set(TE_TEXT("VALUE"), TE_TEXT("b"));
+	check(cache, t);
+	BOOST_CHECK_EQUAL(cache.getRendered(), 2u);
+	BOOST_CHECK_EQUAL(cache.getReused(), 2u);
+
+	BOOST_CHECK_THROW(RenderCache(parse(TE_TEXT("{{:TITLE}}"))).render(ctx), TemplateException);
+	BOOST_CHECK_THROW(RenderCache(parse(TE_TEXT("{{items}}"))).render(ctx), TemplateException);
+	BOOST_CHECK_THROW(RenderCache(parse(TE_TEXT("{{#repeat TITLE}}{{/repeat}}"))).render(ctx), TemplateException);
+}
+
+BOOST_AUTO_TEST_CASE(edits)
+{
+	TemplatePtr t = parse(TE_TEXT("{{TITLE}}:{{#repeat items}}<{{VALUE}}{{#repeat rows}}[{{NAME}}]{{/repeat}}>{{/repeat}}."));
+	RenderCache cache(t);
+
+	std::vector<OutputEdit> edits = cache.renderEdits(ctx);
+	BOOST_REQUIRE_EQUAL(edits.size(), 1u);
+	BOOST_CHECK_EQUAL(edits[0].offset, 0u);
+	BOOST_CHECK_EQUAL(edits[0].removed, 0u);
+	te_string output = edits[0].inserted;
+	BOOST_CHECK_EQUAL(output, TE_TEXT("list:<a[x][y]><b[x][y]><c[x][y]>."));
+
+	BOOST_CHECK(cache.renderEdits(ctx).empty());
+
+	// only the changed value
+	item(1)->set(TE_TEXT("VALUE"), TE_TEXT("B"));
+	edits = cache.renderEdits(ctx);
+	BOOST_REQUIRE_EQUAL(edits.size(), 1u);
+	BOOST_CHECK_EQUAL(edits[0].offset, 15u);
+	BOOST_CHECK_EQUAL(edits[0].removed, 1u);
+	BOOST_CHECK_EQUAL(edits[0].inserted, TE_TEXT("B"));
+	RenderCache::apply(output, edits);
+
+	// the value before the rows, and a row after them
+	root->set(TE_TEXT("TITLE"), TE_TEXT("items"));
+	items->remove(2);
+	edits = cache.renderEdits(ctx);
+	BOOST_REQUIRE_EQUAL(edits.size(), 2u);
+	BOOST_CHECK_EQUAL(edits[0].offset, 0u);
+	BOOST_CHECK_EQUAL(edits[0].removed, 4u);
+	BOOST_CHECK_EQUAL(edits[0].inserted, TE_TEXT("items"));
+	BOOST_CHECK_EQUAL(edits[1].offset, 24u);
+	BOOST_CHECK_EQUAL(edits[1].removed, 9u);
+	BOOST_CHECK(edits[1].inserted.empty());
+	RenderCache::apply(output, edits);
+	BOOST_CHECK_EQUAL(output, t->render(ctx));
+
+	// a row inserted in front
+	DictionaryPtr first = makeItem(TE_TEXT("0"));
+	items->set(0, first);
+	items->add(item(1));
+	edits = cache.renderEdits(ctx);
+	RenderCache::apply(output, edits);
+	BOOST_CHECK_EQUAL(output, t->render(ctx));
+
+	BOOST_CHECK_THROW(RenderCache::apply(output, { OutputEdit{ output.size(), 1, te_string() } }), TemplateException);
+}
+
+BOOST_AUTO_TEST_CASE(edits_random)
+{
+	TemplatePtr t = parse(TE_TEXT("{{TITLE}}\n{{#repeat items}}<li>{{VALUE}}: {{#repeat rows}}{{NAME}}/{{:VALUE}} {{/repeat}}</li>\n{{/repeat}}"));
+	RenderCache cache(t);
+	te_string output = RenderCache(t).render(ctx);
+	BOOST_CHECK(cache.renderEdits(ctx).size() == 1);
+
+	static const te_char_t* values[] = { TE_TEXT("a"), TE_TEXT("b"), TE_TEXT("ab"), TE_TEXT("ba"), TE_TEXT(""), TE_TEXT("long value") };
+	std::mt19937 random(42);
+	auto value = [&random]() { return te_string(values[random() % (sizeof(values) / sizeof(values[0]))]); };
+
+	for (int i = 0; i < 500; ++i) {
+		size_t size = items->size();
+		DictionaryPtr target = size ? item(random() % size) : nullptr;
+		DictionaryListPtr rows = target ? target->getList(TE_TEXT("rows")) : nullptr;
+
+		switch (random() % 8) {
+		case 0:
+			root->set(TE_TEXT("TITLE"), value());
+			break;
+		case 1:
+			items->add(makeItem(value()));
+			break;
+		case 2:
+			if (size)
+				items->remove(random() % size);
+			break;
+		case 3:
+			if (size)
+				items->set(random() % size, makeItem(value()));
+			break;
+		case 4:
+			if (target)
+				target->set(TE_TEXT("VALUE"), value());
+			break;
+		case 5:
+			if (rows) {
+				DictionaryPtr row = std::make_shared<Dictionary>();
+				row->add(TE_TEXT("NAME"), value());
+				rows->add(row);
+			}
+			break;
+		case 6:
+			if (rows && rows->size())
+				rows->remove(random() % rows->size());
+			break;
+		default:
+			if (rows && rows->size()) {
+				rows->resetCursor();
+				rows->getCurrent()->set(TE_TEXT("NAME"), value());
+			}
+			break;
+		}
+
+		te_string expected = t->render(ctx);
+		std::vector<OutputEdit> edits = cache.renderEdits(ctx);
+		RenderCache::apply(output, edits);
+		BOOST_REQUIRE_EQUAL(output, expected);
+
+		// never more than what changed, and a row
+		size_t inserted = 0;
+		for (const OutputEdit& edit : edits)
+			inserted += edit.inserted.size();
+		BOOST_CHECK_LE(inserted, 64u);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(edits_dictionaries)
+{
+	TemplatePtr t = parse(TE_TEXT("{{TITLE}}:{{#repeat items}}<{{VALUE}}>{{/repeat}}"));
+
+	// a separate copy, with one value changed and a row added
+	DictionaryPtr other = std::make_shared<Dictionary>();
+	other->add(TE_TEXT("TITLE"), TE_TEXT("list"));
+	DictionaryListPtr list = std::make_shared<DictionaryList>();
+	other->add(TE_TEXT("items"), list);
+	for (const te_char_t* value : { TE_TEXT("a"), TE_TEXT("B"), TE_TEXT("c"), TE_TEXT("d") })
+		list->add(makeItem(value));
+
+	ctx->setDictionary(root);
+	te_string output = t->render(ctx);
+	std::vector<OutputEdit> edits = RenderCache::diff(t, ctx, root, other);
+	BOOST_REQUIRE_EQUAL(edits.size(), 2u);
+	BOOST_CHECK_EQUAL(edits[0].inserted, TE_TEXT("B"));
+	BOOST_CHECK_EQUAL(edits[1].inserted, TE_TEXT("<d>"));
+
+	RenderCache::apply(output, edits);
+	BOOST_CHECK_EQUAL(output, t->render(ctx));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
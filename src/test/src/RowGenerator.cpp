@@ -0,0 +1,197 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include <boost/test/unit_test.hpp>
+#include <vector>
+
+
+#include <TemplateEngine.hpp>
+
+// generated by te-compile from the files in templates/
+#include "test_templates.hpp"
+
+using namespace template_engine;
+
+// Boost test doesn't know these types and cannot output their value
+BOOST_TEST_DONT_PRINT_LOG_VALUE(te_string);
+
+namespace
+{
+TemplatePtr parse(const te_string& definition)
+{
+	StringScanner s(definition);
+	return Template::parse(s);
+}
+
+/** Keeps every write, to check how the output was handed over */
+class RecordingSink : public OutputSink
+{
+public:
+	using OutputSink::write;
+
+	virtual void write(const te_char_t* data, size_t length)
+	{
+		writes.emplace_back(data, length);
+	}
+
+	te_string text() const
+	{
+		te_string result;
+		for (const te_string& w : writes)
+			result += w;
+		return result;
+	}
+
+	std::vector<te_string> writes;
+};
+
+struct GeneratorFixture {
+	GeneratorFixture() : dict(std::make_shared<Dictionary>()), ctx(Context::BuildContext()), rowCount(3), produced(0), maxAlive(0)
+	{
+		ctx->setDictionary(dict);
+		dict->add(TE_TEXT("TITLE"), TE_TEXT("t"));
+		dict->add(TE_TEXT("rows"), std::make_shared<DictionaryList>([this]() { return next(); }));
+	}
+
+	/** The next row, while checking that the rows already rendered have been released */
+	DictionaryPtr next()
+	{
+		size_t alive = 0;
+		for (const std::weak_ptr<Dictionary>& row : rows)
+			alive += row.expired() ? 0 : 1;
+		maxAlive = std::max(maxAlive, alive);
+
+		if (produced == rowCount) {
+			produced = 0;
+			return nullptr;
+		}
+
+		DictionaryPtr row = std::make_shared<Dictionary>();
+		row->add(TE_TEXT("ID"), TypedValue(produced++));
+		rows.push_back(row);
+		return row;
+	}
+
+	/** The same rows, stored in a list */
+	DictionaryListPtr materialized()
+	{
+		DictionaryListPtr list = std::make_shared<DictionaryList>();
+		for (size_t i = 0; i < rowCount; i++) {
+			DictionaryPtr row = std::make_shared<Dictionary>();
+			list->add(row);
+			row->add(TE_TEXT("ID"), TypedValue(i));
+		}
+		return list;
+	}
+
+	DictionaryPtr dict;
+	ContextPtr ctx;
+	size_t rowCount;
+	size_t produced;
+	size_t maxAlive;
+	std::vector<std::weak_ptr<Dictionary>> rows;
+};
+}
+
+BOOST_FIXTURE_TEST_SUITE(RowGeneratorTest, GeneratorFixture);
+
+BOOST_AUTO_TEST_CASE(rows_on_demand)
+{
+	TemplatePtr t = parse(TE_TEXT("{{#repeat rows}}{{ID}}{{:TITLE}};{{/repeat}}"));
+	BOOST_CHECK_EQUAL(t->render(ctx), TE_TEXT("0t;1t;2t;"));
+	BOOST_CHECK_EQUAL(maxAlive, 0u);
+
+	// every repeat calls the generator again
+	BOOST_CHECK_EQUAL(t->render<HtmlEscaper>(ctx), TE_TEXT("0t;1t;2t;"));
+	BOOST_CHECK_EQUAL(t->render(ctx, [](const te_string& value) { return value + TE_TEXT("!"); }), TE_TEXT("0!t!;1!t!;2!t!;"));
+
+	const DictionaryListPtr& list = dict->getList(TE_TEXT("rows"));
+	BOOST_CHECK(list->isGenerated());
+	BOOST_CHECK(!DictionaryList().isGenerated());
+	BOOST_CHECK_EQUAL(list->size(), 0u);
+	BOOST_CHECK_THROW(list->add(std::make_shared<Dictionary>()), TemplateException);
+	BOOST_CHECK_THROW(DictionaryList{ RowGenerator() }, TemplateException);
+}
+
+BOOST_AUTO_TEST_CASE(streaming)
+{
+	rowCount = 5000;
+	const te_string definition = TE_TEXT("<table>{{#repeat rows}}<tr><td>{{ID:>8}}</td></tr>\n{{/repeat}}</table>");
+	TemplatePtr t = parse(definition);
+
+	RecordingSink sink;
+	t->renderInto(ctx, sink);
+	BOOST_CHECK_EQUAL(maxAlive, 0u);
+
+	te_string expected = t->render(ctx);
+	BOOST_CHECK_EQUAL(sink.text(), expected);
+
+	// handed over in chunks while the rows were rendered
+	BOOST_REQUIRE(sink.writes.size() > 1);
+	for (size_t i = 0; i + 1 < sink.writes.size(); i++)
+		BOOST_CHECK(sink.writes[i].size() >= StreamedOutput::defaultChunkSize);
+
+	// the same for stored rows, and without a filter by render as well
+	dict->set(TE_TEXT("rows"), materialized());
+	RecordingSink stored;
+	t->render(ctx, stored);
+	BOOST_CHECK_EQUAL(stored.text(), expected);
+	BOOST_CHECK_EQUAL(stored.writes.size(), sink.writes.size());
+
+	RecordingSink filtered;
+	t->render(ctx, filtered, [](const te_string& value) { return value; });
+	BOOST_CHECK_EQUAL(filtered.writes.size(), 1u);
+	BOOST_CHECK_EQUAL(filtered.text(), expected);
+}
+
+BOOST_AUTO_TEST_CASE(transformations)
+{
+	TemplatePtr t = parse(TE_TEXT("{{TITLE}}{{#repeat rows}}[{{ID}}]{{/repeat}}"));
+	const te_string expected = TE_TEXT("t[0][1][2]");
+
+	RenderCache cache(t);
+	BOOST_CHECK_EQUAL(cache.render(ctx), expected);
+	rowCount = 2;
+	BOOST_CHECK_EQUAL(cache.render(ctx), TE_TEXT("t[0][1]"));
+	rowCount = 3;
+
+	std::string image = TemplateImage::save(t);
+	BOOST_CHECK_EQUAL(TemplateImage::load(image.data(), image.size(), nullptr)->render(ctx), expected);
+
+	// the rows are specialized as they are produced then
+	TemplatePtr residual = Template::specialize(t, dict);
+	rowCount = 1;
+	BOOST_CHECK_EQUAL(residual->render(ctx), expected);
+
+	// generated templates iterate the rows the same way
+	dict->add(TE_TEXT("TEST"), TE_TEXT("x"));
+	dict->add(TE_TEXT("section"), std::make_shared<DictionaryList>([this]() -> DictionaryPtr {
+		if (produced++ == 2) {
+			produced = 0;
+			return nullptr;
+		}
+		DictionaryPtr row = std::make_shared<Dictionary>();
+		row->add(TE_TEXT("B"), TE_TEXT("b"));
+		row->add(TE_TEXT("inner"), std::make_shared<DictionaryList>());
+		return row;
+	}));
+	te_string out;
+	templates::render_page(out, dict);
+	BOOST_CHECK_EQUAL(out, templates::page()->render(ctx));
+	BOOST_CHECK(out.find(TE_TEXT("<li class=\"item\">bB of x")) != te_string::npos);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,189 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include <boost/test/unit_test.hpp>
+
+#include <thread>
+#include <vector>
+
+
+#include <TemplateEngine.hpp>
+#include <SimpleTemplate.hpp>
+#include <SpecializedTemplate.hpp>
+using namespace template_engine;
+namespace utf = boost::unit_test;
+
+// Boost test doesn't know these types and cannot output their value
+BOOST_TEST_DONT_PRINT_LOG_VALUE(te_string);
+
+struct SpecializerFixture {
+	SpecializerFixture() :
+		known(std::make_shared<Dictionary>()),
+		request(std::make_shared<Dictionary>()),
+		full(std::make_shared<Dictionary>()),
+		ctx(Context::BuildContext())
+	{
+		// known ahead of time, e.g. per tenant
+		for (DictionaryPtr d : { known, full }) {
+			d->add(TE_TEXT("TENANT"), TE_TEXT("acme"));
+			DictionaryListPtr menu = std::make_shared<DictionaryList>();
+			d->add(TE_TEXT("menu"), menu);
+			for (const te_char_t* label : { TE_TEXT("home"), TE_TEXT("shop") }) {
+				DictionaryPtr item = std::make_shared<Dictionary>();
+				menu->add(item);
+				item->add(TE_TEXT("LABEL"), label);
+			}
+		}
+
+		// given with every request
+		for (DictionaryPtr d : { request, full }) {
+			d->add(TE_TEXT("USER"), TE_TEXT("bob"));
+			DictionaryListPtr rows = std::make_shared<DictionaryList>();
+			d->add(TE_TEXT("rows"), rows);
+			for (const te_char_t* cell : { TE_TEXT("1"), TE_TEXT("2") }) {
+				DictionaryPtr item = std::make_shared<Dictionary>();
+				rows->add(item);
+				item->add(TE_TEXT("CELL"), cell);
+			}
+		}
+	}
+
+	static TemplatePtr parse(const te_string& definition)
+	{
+		StringScanner s(definition);
+		return Template::parse(s);
+	}
+
+	// render the original with every value, and the residual with those of the request
+	void check(const te_string& definition, TemplatePtr& residual)
+	{
+		TemplatePtr t = parse(definition);
+		residual = Template::specialize(t, known);
+
+		ctx->setDictionary(full);
+		te_string expected = t->render(ctx);
+		ctx->setDictionary(request);
+		BOOST_CHECK_EQUAL(residual->render(ctx), expected);
+
+		// and once more, rendering mustn't change the residual template or the dictionaries
+		BOOST_CHECK_EQUAL(residual->render(ctx), expected);
+	}
+
+	DictionaryPtr known;
+	DictionaryPtr request;
+	DictionaryPtr full;
+	ContextPtr ctx;
+};
+
+BOOST_FIXTURE_TEST_SUITE(SpecializerTest, SpecializerFixture);
+
+BOOST_AUTO_TEST_CASE(fully_known)
+{
+	TemplatePtr residual;
+	check(TE_TEXT("{{TENANT}}: {{#repeat menu}}[{{LABEL}}@{{:TENANT}}]{{/repeat}}"), residual);
+
+	BOOST_CHECK(nullptr != std::dynamic_pointer_cast<SimpleTemplate>(residual));
+}
+
+BOOST_AUTO_TEST_CASE(unrolled)
+{
+	// the unknown names left in the unrolled body are looked up in the root scope
+	TemplatePtr residual;
+	check(TE_TEXT("{{TENANT}}/{{USER}} {{#repeat menu}}[{{LABEL}} {{USER}} {{:USER}} {{::USER}} {{:::APP}}]{{/repeat}}"), residual);
+
+	BOOST_CHECK(nullptr == std::dynamic_pointer_cast<SpecializedTemplate>(residual));
+}
+
+BOOST_AUTO_TEST_CASE(kept)
+{
+	// the list isn't known, the body still refers to a known value
+	TemplatePtr residual;
+	check(TE_TEXT("{{#repeat rows}}{{CELL}} {{TENANT}} {{USER}};{{/repeat}}"), residual);
+	BOOST_CHECK(nullptr != std::dynamic_pointer_cast<SpecializedTemplate>(residual));
+
+	// the known list contains a list which isn't known, so it isn't unrolled
+	check(TE_TEXT("{{TENANT}}{{#repeat menu}}{{#repeat rows}}{{LABEL}}{{CELL}}{{/repeat}}{{/repeat}}"), residual);
+	BOOST_CHECK(nullptr != std::dynamic_pointer_cast<SpecializedTemplate>(residual));
+}
+
+BOOST_AUTO_TEST_CASE(concurrent)
+{
+	// a residual template is shared, e.g. cached per tenant, and rendered by several threads at once
+	// the known menu is repeated in the rows of each thread, with the row as its parent scope
+	TemplatePtr t = parse(TE_TEXT("{{TENANT}}:{{#repeat rows}}{{CELL}} {{TENANT}} {{USER}};{{#repeat menu}}{{LABEL}}={{:CELL}};{{/repeat}}{{/repeat}}"));
+	TemplatePtr residual = Template::specialize(t, known);
+	BOOST_CHECK(nullptr != std::dynamic_pointer_cast<SpecializedTemplate>(residual));
+
+	std::vector<te_string> users{ TE_TEXT("ann"), TE_TEXT("bob"), TE_TEXT("cid"), TE_TEXT("dan") };
+	std::vector<size_t> failures(users.size(), 0);
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < users.size(); i++) {
+		threads.emplace_back([&, i]() {
+			DictionaryPtr dict = std::make_shared<Dictionary>();
+			dict->add(TE_TEXT("USER"), users[i]);
+			DictionaryListPtr rows = std::make_shared<DictionaryList>();
+			dict->add(TE_TEXT("rows"), rows);
+			DictionaryPtr item = std::make_shared<Dictionary>();
+			rows->add(item);
+			item->add(TE_TEXT("CELL"), users[i]);
+
+			ContextPtr context = Context::BuildContext();
+			context->setDictionary(dict);
+			te_string expected = TE_TEXT("acme:") + users[i] + TE_TEXT(" acme ") + users[i] + TE_TEXT(";home=") + users[i] + TE_TEXT(";shop=") + users[i] + TE_TEXT(";");
+			for (int n = 0; n < 2000; n++)
+				if (residual->render(context) != expected)
+					failures[i]++;
+
+			// the dictionary is left with its own parent
+			if (dict->getParent() != context)
+				failures[i]++;
+		});
+	}
+	for (std::thread& thread : threads)
+		thread.join();
+
+	for (size_t failed : failures)
+		BOOST_CHECK_EQUAL(failed, 0u);
+	BOOST_CHECK(nullptr == known->getParent());
+	BOOST_CHECK(known == known->getList(TE_TEXT("menu"))->getParent());
+}
+
+BOOST_AUTO_TEST_CASE(filtered)
+{
+	TemplateFilter upper = [](const te_string& value) {
+		te_string result(value);
+		for (te_char_t& ch : result)
+			ch = static_cast<te_char_t>(toupper(ch));
+		return result;
+	};
+
+	TemplatePtr residual = Template::specialize(parse(TE_TEXT("{{TENANT}} {{USER}}")), known, upper);
+	ctx->setDictionary(request);
+	BOOST_CHECK_EQUAL(residual->render(ctx, upper), TE_TEXT("ACME BOB"));
+}
+
+BOOST_AUTO_TEST_CASE(errors)
+{
+	BOOST_CHECK_THROW(Template::specialize(parse(TE_TEXT("{{menu}}")), known), TemplateException);
+	BOOST_CHECK_THROW(Template::specialize(parse(TE_TEXT("{{#repeat TENANT}}{{/repeat}}")), known), TemplateException);
+
+	// names which aren't known are reported when rendering
+	TemplatePtr residual = Template::specialize(parse(TE_TEXT("{{#repeat menu}}{{MISSING}}{{/repeat}}")), known);
+	ctx->setDictionary(request);
+	BOOST_CHECK_THROW(residual->render(ctx), TemplateException);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
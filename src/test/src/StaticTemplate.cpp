@@ -0,0 +1,104 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include <boost/test/unit_test.hpp>
+
+#include <TemplateEngine.hpp>
+
+#include "Fixtures.hpp"
+
+using namespace template_engine;
+
+// Boost test doesn't know these types and cannot output their value
+BOOST_TEST_DONT_PRINT_LOG_VALUE(te_string);
+
+namespace
+{
+TE_STATIC_TEMPLATE(page, "<h1>{{TEST}}</h1>{{- comment }}\n{{#repeat section}}<p>{{B}} {{:TEST}}{{#REPEAT inner}}[{{C}}]{{/repeat}}</p>{{/repeat}}");
+TE_STATIC_TEMPLATE(escaped, "\\{{TEST}} { {{ }} {{TEST }}\\x");
+TE_STATIC_TEMPLATE(unmatched, "a{{/repeat}}{{NOT_RENDERED}}");
+TE_STATIC_TEMPLATE(empty, "");
+TE_STATIC_TEMPLATE(formatted, "{{TEST:>10}}|{{TEST :.2 |html}}{{#repeat section}}{{B:^3}}{{/repeat}}{{PRICE:+.2f}}");
+TE_STATIC_TEMPLATE(filtered, "{{TEST|html}} {{#repeat section}}{{:TEST | upper|HTML }}{{B|upper}}{{/repeat}}");
+
+// parsed while compiling
+static_assert(page.size() == 14, "page is parsed into 14 nodes");
+static_assert(escaped.size() == 3, "escaped is parsed into 3 nodes");
+static_assert(unmatched.size() == 1, "the template ends at an unmatched end repeat");
+static_assert(empty.size() == 0, "empty has no nodes");
+static_assert(formatted.size() == 6, "formatted is parsed into 6 nodes");
+static_assert(filtered.size() == 5, "filtered is parsed into 5 nodes");
+}
+
+BOOST_FIXTURE_TEST_SUITE(StaticTemplateTest, PageFixture);
+
+BOOST_AUTO_TEST_CASE(same_result)
+{
+	BOOST_CHECK_EQUAL(page.render(ctx), render(page_definition));
+	BOOST_CHECK_EQUAL(escaped.render(ctx), render(escaped_definition));
+	BOOST_CHECK_EQUAL(unmatched.render(ctx), TE_TEXT("a"));
+	BOOST_CHECK(empty.render(ctx).empty());
+	BOOST_CHECK_EQUAL(filtered.render(ctx), render(filtered_definition));
+	dict->add(TE_TEXT("PRICE"), TypedValue(19.5));
+	BOOST_CHECK_EQUAL(formatted.render(ctx), render(formatted_definition));
+	BOOST_CHECK_EQUAL(formatted.render(ctx), TE_TEXT("    <TEST>|&lt;T b  c +19.50"));
+	BOOST_CHECK_EQUAL(filtered.render(ctx), TE_TEXT("&lt;TEST&gt; &lt;TEST&gt;B&lt;TEST&gt;C"));
+
+	TemplateFilter upper = [](const te_string& value) {
+		te_string result(value);
+		for (te_char_t& ch : result)
+			ch = static_cast<te_char_t>(toupper(ch));
+		return result;
+	};
+	BOOST_CHECK_EQUAL(page.render(ctx, upper), render(page_definition, upper));
+
+	// appended to what is there already
+	te_string out(TE_TEXT(">"));
+	escaped.render(out, dict);
+	BOOST_CHECK_EQUAL(out, TE_TEXT(">") + render(escaped_definition));
+}
+
+BOOST_AUTO_TEST_CASE(errors)
+{
+	// constructed at runtime the syntax errors are thrown
+	BOOST_CHECK_THROW(StaticTemplate<4>(TE_TEXT("{{- runaway")), TemplateException);
+	BOOST_CHECK_THROW(StaticTemplate<4>(TE_TEXT("{{#repeat}}")), TemplateException);
+	BOOST_CHECK_THROW(StaticTemplate<4>(TE_TEXT("{{#loop x}}")), TemplateException);
+	BOOST_CHECK_THROW(StaticTemplate<4>(TE_TEXT("{{#repeat x y}}")), TemplateException);
+	BOOST_CHECK_THROW(StaticTemplate<4>(TE_TEXT("{{/repeat x}}")), TemplateException);
+	BOOST_CHECK_THROW(StaticTemplate<4>(TE_TEXT("{{NAME")), TemplateException);
+	BOOST_CHECK_THROW(StaticTemplate<4>(TE_TEXT("{{:}}")), TemplateException);
+	BOOST_CHECK_THROW(StaticTemplate<1>(TE_TEXT("a{{B}}")), TemplateException);
+	BOOST_CHECK_THROW(StaticTemplate<4>(TE_TEXT("{{NAME|}}")), TemplateException);
+	BOOST_CHECK_THROW(StaticTemplate<4>(TE_TEXT("{{NAME|html html}}")), TemplateException);
+	BOOST_CHECK_THROW(StaticTemplate<4>(TE_TEXT("{{NAME:}}")), TemplateException);
+	BOOST_CHECK_THROW(StaticTemplate<4>(TE_TEXT("{{NAME:q}}")), TemplateException);
+	BOOST_CHECK_THROW(StaticTemplate<4>(TE_TEXT("{{NAME:.}}")), TemplateException);
+	BOOST_CHECK_THROW(StaticTemplate<4>(TE_TEXT("{{NAME:10000}}")), TemplateException);
+	BOOST_CHECK_THROW(StaticTemplate<4>(TE_TEXT("{{NAME:>4:s}}")), TemplateException);
+	BOOST_CHECK_THROW(StaticTemplate<4>(TE_TEXT("{{NAME|html:4}}")), TemplateException);
+
+	// and so are the render errors
+	DictionaryPtr empty = std::make_shared<Dictionary>();
+	te_string out;
+	BOOST_CHECK_THROW(page.render(out, empty), TemplateException);
+
+	// filters are registered at runtime, so an unknown one is reported when rendering
+	StaticTemplate<1> unknown(TE_TEXT("{{TEST|nosuchfilter}}"));
+	BOOST_CHECK_THROW(unknown.render(ctx), TemplateException);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -71,4 +71,26 @@ BOOST_AUTO_TEST_CASE(multiple_line_string)
 	BOOST_CHECK(false == reader.moveNext());
 }
 
+BOOST_AUTO_TEST_CASE(block)
+{
+	StringScanner reader(TE_TEXT("Abc\ndef"));
+	size_t length;
+
+	// the whole string is a single block
+	const te_char_t* block = reader.getBlock(length);
+	BOOST_CHECK(7 == length);
+	BOOST_CHECK(te_string(TE_TEXT("Abc\ndef")) == te_string(block, length));
+
+	reader.advance(4);
+	BOOST_CHECK(TE_TEXT('d') == reader.getChar());
+	block = reader.getBlock(length);
+	BOOST_CHECK(3 == length);
+	BOOST_CHECK(TE_TEXT('d') == *block);
+
+	reader.advance(3);
+	BOOST_CHECK(true == reader.atEos());
+	reader.getBlock(length);
+	BOOST_CHECK(0 == length);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,146 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <TemplateEngine.hpp>
+#include <SpecializedTemplate.hpp>
+
+#include "Fixtures.hpp"
+
+using namespace template_engine;
+
+// Boost test doesn't know these types and cannot output their value
+BOOST_TEST_DONT_PRINT_LOG_VALUE(te_string);
+
+namespace
+{
+/** Writes a temporary file, which is removed again at the end of the test */
+struct TemporaryFile
+{
+	TemporaryFile(const std::string& name, const std::string& content) :
+		path("TemplateImage_" + name + "_" + std::to_string(sizeof(te_char_t)) + ".tmp")
+	{
+		write(content);
+	}
+
+	~TemporaryFile() { std::remove(path.c_str()); }
+
+	void write(const std::string& content)
+	{
+		std::ofstream file(path.c_str(), std::ios::binary | std::ios::trunc);
+		file << content;
+	}
+
+	std::string path;
+};
+}
+
+BOOST_FIXTURE_TEST_SUITE(TemplateImageTest, PageFixture);
+
+BOOST_AUTO_TEST_CASE(round_trip)
+{
+	TemplatePtr t = parse(TE_TEXT("a{{- comment }}b {{TEST}} {{#repeat section}}[{{B}} {{:TEST}}]{{/repeat}} {{TEST}}"));
+	std::string image = TemplateImage::save(t);
+
+	// copied, and referring to the image
+	std::shared_ptr<std::string> owner = std::make_shared<std::string>(image);
+	BOOST_CHECK_EQUAL(TemplateImage::load(image.data(), image.size(), nullptr)->render(ctx), t->render(ctx));
+	BOOST_CHECK_EQUAL(TemplateImage::load(owner->data(), owner->size(), owner)->render(ctx), t->render(ctx));
+
+	// the name is stored once, and the literals on both sides of the comment are merged
+	BOOST_CHECK(std::string::npos != image.find("TEIM"));
+	BOOST_CHECK_EQUAL(TemplateImage::save(TemplateImage::load(image.data(), image.size(), nullptr)), image);
+
+	// nested repeats
+	image = TemplateImage::save(parse(TE_TEXT("{{#repeat a}}x{{#repeat b}}{{C}}{{/repeat}}{{#repeat c}}{{/repeat}}y{{/repeat}}z")));
+	BOOST_CHECK_EQUAL(TemplateImage::save(TemplateImage::load(image.data(), image.size(), nullptr)), image);
+}
+
+BOOST_AUTO_TEST_CASE(empty)
+{
+	std::string image = TemplateImage::save(parse(TE_TEXT("")));
+	BOOST_CHECK_EQUAL(TemplateImage::load(image.data(), image.size(), nullptr)->render(ctx), TE_TEXT(""));
+}
+
+BOOST_AUTO_TEST_CASE(mapped_file)
+{
+	TemplatePtr t = parse(TE_TEXT("{{TEST}} {{#repeat section}}{{B}}{{/repeat}}"));
+	TemporaryFile file("mapped", "");
+	TemplateImage::save(t, file.path);
+
+	TemplatePtr loaded = TemplateImage::load(file.path);
+	BOOST_CHECK_EQUAL(loaded->render(ctx), TE_TEXT("<TEST> bc"));
+}
+
+BOOST_AUTO_TEST_CASE(invalid)
+{
+	std::string image = TemplateImage::save(parse(TE_TEXT("a{{TEST}}b{{#repeat section}}{{B}}{{/repeat}}")));
+
+	BOOST_CHECK_THROW(TemplateImage::load(image.data(), 10, nullptr), TemplateException);
+	BOOST_CHECK_THROW(TemplateImage::load(image.data(), image.size() - 1, nullptr), TemplateException);
+
+	std::string damaged(image);
+	damaged[0] = 'X';
+	BOOST_CHECK_THROW(TemplateImage::load(damaged.data(), damaged.size(), nullptr), TemplateException);
+
+	// an instruction pointing outside the literal pool
+	damaged = image;
+	damaged[28] = '\x7f';
+	BOOST_CHECK_THROW(TemplateImage::load(damaged.data(), damaged.size(), nullptr), TemplateException);
+
+	// a specialized template refers to a dictionary
+	DictionaryPtr known = std::make_shared<Dictionary>();
+	TemplatePtr residual = Template::specialize(parse(TE_TEXT("{{#repeat section}}{{B}}{{/repeat}}")), known);
+	BOOST_REQUIRE(nullptr != std::dynamic_pointer_cast<SpecializedTemplate>(residual));
+	BOOST_CHECK_THROW(TemplateImage::save(residual), TemplateException);
+}
+
+BOOST_AUTO_TEST_CASE(cache)
+{
+	std::string directory("TemplateImage_" + std::to_string(sizeof(te_char_t)) + ".cache");
+	TemplateCache cache(directory);
+	TemporaryFile file("source", "x{{TEST}}x");
+
+	std::string image = cache.getImagePath(file.path);
+	std::remove(image.c_str());
+
+	BOOST_CHECK_EQUAL(cache.load(file.path)->render(ctx), TE_TEXT("x<TEST>x"));
+	BOOST_CHECK_EQUAL(TemplateImage::load(image)->render(ctx), TE_TEXT("x<TEST>x"));
+	BOOST_CHECK_EQUAL(cache.load(file.path)->render(ctx), TE_TEXT("x<TEST>x"));
+
+	// a changed file gets an image of its own
+	file.write("y{{TEST}}y");
+	std::string changed = cache.getImagePath(file.path);
+	BOOST_CHECK(image != changed);
+	BOOST_CHECK_EQUAL(cache.load(file.path)->render(ctx), TE_TEXT("y<TEST>y"));
+
+	// a damaged image is written again
+	{
+		std::ofstream damaged(changed.c_str(), std::ios::binary | std::ios::trunc);
+		damaged << "garbage";
+	}
+	BOOST_CHECK_EQUAL(cache.load(file.path)->render(ctx), TE_TEXT("y<TEST>y"));
+	BOOST_CHECK_EQUAL(TemplateImage::load(changed)->render(ctx), TE_TEXT("y<TEST>y"));
+
+	std::remove(image.c_str());
+	std::remove(changed.c_str());
+	std::remove(directory.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,142 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include <boost/test/unit_test.hpp>
+
+
+#include <TemplateEngine.hpp>
+
+#include "Fixtures.hpp"
+
+using namespace template_engine;
+namespace utf = boost::unit_test;
+
+// Boost test doesn't know these types and cannot output their value
+BOOST_TEST_DONT_PRINT_LOG_VALUE(te_string);
+
+struct PushFixture : PageFixture {
+	using PageFixture::render;
+
+	/** \brief Feed the definition in chunks of the given size, and render the result */
+	te_string render(const te_string& definition, size_t chunkSize)
+	{
+		TemplateParser parser;
+		for (size_t pos = 0; pos < definition.size(); pos += chunkSize)
+			parser.feed(definition.substr(pos, chunkSize));
+
+		return parser.finish()->render(ctx);
+	}
+};
+
+BOOST_FIXTURE_TEST_SUITE(TemplateParserTest, PushFixture);
+
+BOOST_AUTO_TEST_CASE(empty)
+{
+	TemplateParser parser;
+	BOOST_CHECK_EQUAL(parser.finish()->render(ctx), TE_TEXT(""));
+}
+
+BOOST_AUTO_TEST_CASE(single_chunk)
+{
+	BOOST_CHECK_EQUAL(render(TE_TEXT("a {{TEST}} b"), 100), TE_TEXT("a <TEST> b"));
+}
+
+BOOST_AUTO_TEST_CASE(every_split)
+{
+	// tags, names, comments and escapes split at every possible position
+	te_string definition(TE_TEXT("a {{TEST}} {{- a {comment} }}b \\{{ c {{#repeat section}}[{{B}}]{{/repeat}} { } \\x {{TEST }}"));
+	te_string expected = render(definition);
+	BOOST_CHECK_EQUAL(expected, TE_TEXT("a <TEST> b {{ c [b][c] { } \\x <TEST>"));
+
+	for (size_t split = 1; split < definition.size(); ++split) {
+		TemplateParser parser;
+		parser.feed(definition.substr(0, split));
+		parser.feed(definition.substr(split));
+		BOOST_CHECK_EQUAL(parser.finish()->render(ctx), expected);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(chunk_sizes)
+{
+	te_string definition(TE_TEXT("{{#repeat section}}{{- skip }}{{B}}\\{{{{/repeat}}{{TEST}}"));
+	for (size_t size = 1; size <= 8; ++size)
+		BOOST_CHECK_EQUAL(render(definition, size), TE_TEXT("b{{c{{<TEST>"));
+}
+
+BOOST_AUTO_TEST_CASE(trailing_brace)
+{
+	// a brace at the end of a chunk is only plain text once the stream ends
+	BOOST_CHECK_EQUAL(render(TE_TEXT("a{"), 1), TE_TEXT("a{"));
+	BOOST_CHECK_EQUAL(render(TE_TEXT("a\\"), 1), TE_TEXT("a\\"));
+}
+
+BOOST_AUTO_TEST_CASE(bounded_pending)
+{
+	// literal text is not held back, even when no instruction ever arrives
+	TemplateParser parser;
+	te_string chunk(1000, TE_TEXT('x'));
+	for (int i = 0; i < 100; ++i)
+		parser.feed(chunk);
+
+	BOOST_CHECK_EQUAL(parser.finish()->render(ctx).size(), 100000u);
+}
+
+BOOST_AUTO_TEST_CASE(linear_rescan)
+{
+	// a long comment or name fed a code unit at a time isn't tokenized again for every chunk
+	const te_string filler(20000, TE_TEXT('a'));
+	dict->add(filler, TE_TEXT("name"));
+	for (const te_string& definition : { TE_TEXT("<{{- ") + filler + TE_TEXT(" }}>"), TE_TEXT("<{{") + filler + TE_TEXT("}}>") }) {
+		TemplateParser parser;
+		for (te_char_t ch : definition)
+			parser.feed(&ch, 1);
+		BOOST_CHECK_EQUAL(parser.finish()->render(ctx), definition[3] == TE_TEXT('-') ? TE_TEXT("<>") : TE_TEXT("<name>"));
+		BOOST_CHECK_LE(parser.getLexedLength(), 4 * definition.size());
+	}
+}
+
+BOOST_AUTO_TEST_CASE(unmatched_end)
+{
+	// an unmatched end repeat instruction ends the template, as it does for Template::parse
+	for (const te_string& definition : { te_string(TE_TEXT("a{{/repeat}}{{A{")), te_string(TE_TEXT("-{{/repeat}}{{-/repeat\u00e9")) }) {
+		te_string expected = render(definition);
+		for (size_t chunkSize = 1; chunkSize <= definition.size(); chunkSize++)
+			BOOST_CHECK_EQUAL(render(definition, chunkSize), expected);
+	}
+
+	TemplateParser parser;
+	parser.feed(TE_TEXT("b{{/repeat}}"));
+	parser.feed(TE_TEXT("{{TEST"));
+	BOOST_CHECK_EQUAL(parser.finish()->render(ctx), TE_TEXT("b"));
+}
+
+BOOST_AUTO_TEST_CASE(errors)
+{
+	TemplateParser unknown;
+	unknown.feed(TE_TEXT("{{#rep"));
+	BOOST_CHECK_THROW(unknown.feed(TE_TEXT("ort x}}")), TemplateException);
+
+	TemplateParser missing;
+	missing.feed(TE_TEXT("{{TEST"));
+	BOOST_CHECK_THROW(missing.finish(), TemplateException);
+
+	TemplateParser comment;
+	comment.feed(TE_TEXT("{{- open"));
+	comment.feed(TE_TEXT(" comment"));
+	BOOST_CHECK_THROW(comment.finish(), TemplateException);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
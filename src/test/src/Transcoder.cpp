@@ -0,0 +1,138 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include <boost/test/unit_test.hpp>
+
+#include <sstream>
+#include <type_traits>
+#include <TemplateEngine.hpp>
+using namespace template_engine;
+namespace utf = boost::unit_test;
+
+// Boost test doesn't know these types and cannot output their value
+BOOST_TEST_DONT_PRINT_LOG_VALUE(std::u16string);
+
+BOOST_AUTO_TEST_SUITE(TranscoderTest); // , *utf::disabled());
+
+BOOST_AUTO_TEST_CASE(empty_string)
+{
+	BOOST_CHECK(Transcoder::utf8ToUtf16(std::string()).empty());
+	BOOST_CHECK(Transcoder::utf16ToUtf8(std::u16string()).empty());
+}
+
+BOOST_AUTO_TEST_CASE(ascii_round_trip)
+{
+	// long enough to pass through the vector kernels and the scalar tail
+	std::string ascii;
+	for (int i = 0; i < 100; ++i)
+		ascii += static_cast<char>('0' + i % 64);
+
+	std::u16string wide = Transcoder::utf8ToUtf16(ascii);
+	BOOST_REQUIRE_EQUAL(wide.size(), ascii.size());
+	for (size_t i = 0; i < ascii.size(); ++i)
+		BOOST_CHECK(wide[i] == static_cast<char16_t>(ascii[i]));
+
+	BOOST_CHECK_EQUAL(Transcoder::utf16ToUtf8(wide), ascii);
+}
+
+BOOST_AUTO_TEST_CASE(mixed_round_trip)
+{
+	// ASCII, Latin-1, CJK and astral plane code points, non ASCII at varying offsets
+	std::u16string wide = u"abcdefghijklmnopqrstuvwxyz0123456789 Prénom 日本語テキスト \U0001F600 end ";
+	wide += wide;
+	wide += u"é";
+
+	std::string narrow = Transcoder::utf16ToUtf8(wide);
+	BOOST_CHECK(narrow.find("Pr\xC3\xA9nom") != std::string::npos);
+	BOOST_CHECK(narrow.find("\xF0\x9F\x98\x80") != std::string::npos);
+	BOOST_CHECK(Transcoder::utf8ToUtf16(narrow) == wide);
+}
+
+BOOST_AUTO_TEST_CASE(invalid_utf8)
+{
+	const char* invalid[] = {
+		"\x80",					// lone continuation byte
+		"\xC0\xAF",				// overlong
+		"\xE0\x80\xAF",			// overlong
+		"\xED\xA0\x80",			// surrogate code point
+		"\xF4\x90\x80\x80",		// beyond U+10FFFF
+		"abc\xE6\x97",			// truncated
+		"\xFF",
+	};
+
+	for (const char* s : invalid) {
+		BOOST_CHECK_THROW(Transcoder::utf8ToUtf16(std::string(s)), TemplateException);
+		BOOST_CHECK(!Transcoder::isValidUtf8(s, std::char_traits<char>::length(s)));
+	}
+	BOOST_CHECK(Transcoder::isValidUtf8("\xE6\x97\xA5", 3));
+}
+
+BOOST_AUTO_TEST_CASE(invalid_utf16)
+{
+	std::u16string loneHigh(1, char16_t(0xD800));
+	std::u16string loneLow(1, char16_t(0xDC00));
+	std::u16string reversed = { char16_t(0xDC00), char16_t(0xD800) };
+
+	BOOST_CHECK_THROW(Transcoder::utf16ToUtf8(loneHigh), TemplateException);
+	BOOST_CHECK_THROW(Transcoder::utf16ToUtf8(loneLow), TemplateException);
+	BOOST_CHECK_THROW(Transcoder::utf16ToUtf8(reversed), TemplateException);
+}
+
+BOOST_AUTO_TEST_CASE(complete_length)
+{
+	BOOST_CHECK_EQUAL(Transcoder::utf8CompleteLength("abc", 3), 3u);
+	BOOST_CHECK_EQUAL(Transcoder::utf8CompleteLength("a\xE6\x97", 3), 1u);
+	BOOST_CHECK_EQUAL(Transcoder::utf8CompleteLength("a\xE6\x97\xA5", 4), 4u);
+	BOOST_CHECK_EQUAL(Transcoder::utf8CompleteLength("\xF0\x9F\x98", 3), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(utf8_stream_sink)
+{
+	std::ostringstream stream;
+	Utf8StreamSink sink(stream);
+
+	sink.write(TE_TEXT("Prénom "));
+#ifndef TE_USE_UTF8
+	// a surrogate pair split between two writes
+	te_string smiley = TE_TEXT("\U0001F600");
+	sink.write(smiley.data(), 1);
+	sink.write(smiley.data() + 1, 1);
+#else
+	sink.write(TE_TEXT("\U0001F600"));
+#endif
+	sink.flush();
+
+	BOOST_CHECK_EQUAL(stream.str(), std::string("Pr\xC3\xA9nom \xF0\x9F\x98\x80"));
+}
+
+BOOST_AUTO_TEST_CASE(engine_strings)
+{
+	// the conversions return a string of their own in both flavours, so a temporary may be converted
+	te_string name = TE_TEXT("Pr");
+	const std::string& narrow = to_utf8(name + TE_TEXT("\u00e9nom"));
+	BOOST_CHECK_EQUAL(narrow, std::string("Pr\xC3\xA9nom"));
+	const te_string& engine = from_utf8(narrow + "!");
+	BOOST_CHECK(engine == TE_TEXT("Pr\u00e9nom!"));
+
+	// each flavour has a namespace of its own
+#ifdef TE_USE_UTF8
+	BOOST_CHECK((std::is_same<Dictionary, template_engine::utf8::Dictionary>::value));
+#else
+	BOOST_CHECK((std::is_same<Dictionary, template_engine::utf16::Dictionary>::value));
+#endif
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,234 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include <boost/test/unit_test.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+
+
+#include <TemplateEngine.hpp>
+using namespace template_engine;
+
+// Boost test doesn't know these types and cannot output their value
+BOOST_TEST_DONT_PRINT_LOG_VALUE(te_string);
+
+namespace
+{
+TemplatePtr parse(const te_string& definition)
+{
+	StringScanner s(definition);
+	return Template::parse(s);
+}
+
+te_string format(const te_string& spec, const TypedValue& value)
+{
+	te_string out;
+	ValueFormat(spec).format(out, value);
+	return out;
+}
+
+TypedValue timestamp(int64_t nanoseconds)
+{
+	return TypedValue(std::chrono::system_clock::time_point(
+		std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(nanoseconds))));
+}
+
+struct TypedFixture {
+	TypedFixture() : dict(std::make_shared<Dictionary>()), ctx(Context::BuildContext())
+	{
+		ctx->setDictionary(dict);
+		dict->add(TE_TEXT("PRICE"), TypedValue(19.95));
+		dict->add(TE_TEXT("COUNT"), TypedValue(42));
+		dict->add(TE_TEXT("NAME"), TE_TEXT("Tom & Jerry"));
+
+		DictionaryListPtr list = std::make_shared<DictionaryList>();
+		dict->add(TE_TEXT("items"), list);
+		for (int quantity : { 1, 12 }) {
+			DictionaryPtr item = std::make_shared<Dictionary>();
+			list->add(item);
+			item->add(TE_TEXT("QUANTITY"), TypedValue(quantity));
+			item->add(TE_TEXT("IN_STOCK"), TypedValue(quantity > 5));
+		}
+	}
+
+	te_string render(const te_string& definition)
+	{
+		return parse(definition)->render(ctx);
+	}
+
+	DictionaryPtr dict;
+	ContextPtr ctx;
+};
+}
+
+BOOST_AUTO_TEST_SUITE(TypedValueTest);
+
+BOOST_AUTO_TEST_CASE(integers)
+{
+	BOOST_CHECK_EQUAL(TypedValue(0).toString(), TE_TEXT("0"));
+	BOOST_CHECK_EQUAL(TypedValue(-1234567).toString(), TE_TEXT("-1234567"));
+	BOOST_CHECK_EQUAL(TypedValue(std::numeric_limits<int64_t>::min()).toString(), TE_TEXT("-9223372036854775808"));
+	BOOST_CHECK_EQUAL(TypedValue(std::numeric_limits<int64_t>::max()).toString(), TE_TEXT("9223372036854775807"));
+
+	BOOST_CHECK_EQUAL(format(TE_TEXT("05d"), TypedValue(42)), TE_TEXT("00042"));
+	BOOST_CHECK_EQUAL(format(TE_TEXT("05"), TypedValue(-42)), TE_TEXT("-0042"));
+	BOOST_CHECK_EQUAL(format(TE_TEXT("+d"), TypedValue(42)), TE_TEXT("+42"));
+	BOOST_CHECK_EQUAL(format(TE_TEXT("x"), TypedValue(255)), TE_TEXT("ff"));
+	BOOST_CHECK_EQUAL(format(TE_TEXT("X"), TypedValue(-255)), TE_TEXT("-FF"));
+	BOOST_CHECK_EQUAL(format(TE_TEXT("o"), TypedValue(8)), TE_TEXT("10"));
+	BOOST_CHECK_EQUAL(format(TE_TEXT("08b"), TypedValue(5)), TE_TEXT("00000101"));
+	BOOST_CHECK_EQUAL(format(TE_TEXT("6"), TypedValue(42)), TE_TEXT("    42"));
+	BOOST_CHECK_EQUAL(format(TE_TEXT("*<6"), TypedValue(42)), TE_TEXT("42****"));
+	BOOST_CHECK_EQUAL(format(TE_TEXT("^6"), TypedValue(42)), TE_TEXT("  42  "));
+	BOOST_CHECK_EQUAL(format(TE_TEXT(".2f"), TypedValue(3)), TE_TEXT("3.00"));
+}
+
+BOOST_AUTO_TEST_CASE(reals)
+{
+	BOOST_CHECK_EQUAL(TypedValue(19.95).toString(), TE_TEXT("19.95"));
+	BOOST_CHECK_EQUAL(TypedValue(0.1).toString(), TE_TEXT("0.1"));
+	BOOST_CHECK_EQUAL(TypedValue(1.0 / 3).toString(), TE_TEXT("0.3333333333333333"));
+	BOOST_CHECK_EQUAL(TypedValue(1e100).toString(), TE_TEXT("1e+100"));
+	// subnormal doubles have fewer significant digits
+	BOOST_CHECK_EQUAL(TypedValue(5e-324).toString(), TE_TEXT("5e-324"));
+	BOOST_CHECK_EQUAL(TypedValue(2.5e-320).toString(), TE_TEXT("2.5e-320"));
+
+	BOOST_CHECK_EQUAL(format(TE_TEXT(".2f"), TypedValue(19.951)), TE_TEXT("19.95"));
+	BOOST_CHECK_EQUAL(format(TE_TEXT(">8.2f"), TypedValue(19.95)), TE_TEXT("   19.95"));
+	BOOST_CHECK_EQUAL(format(TE_TEXT("08.2f"), TypedValue(-1.5)), TE_TEXT("-0001.50"));
+	BOOST_CHECK_EQUAL(format(TE_TEXT("+.1f"), TypedValue(1.25f)), TE_TEXT("+1.2"));
+	BOOST_CHECK_EQUAL(format(TE_TEXT("e"), TypedValue(1234.5)), TE_TEXT("1.234500e+03"));
+	BOOST_CHECK_EQUAL(format(TE_TEXT(".3g"), TypedValue(1234.5)), TE_TEXT("1.23e+03"));
+	BOOST_CHECK_EQUAL(format(TE_TEXT(".1%"), TypedValue(0.256)), TE_TEXT("25.6%"));
+	BOOST_CHECK_THROW(format(TE_TEXT("x"), TypedValue(1.5)), TemplateException);
+
+	// fixed point is written without snprintf where the rounding is unambiguous, and must agree with it
+	for (double value : { 0.0, -0.0, 0.125, 2.675, 1.005, -0.001, 0.5, 1e-7, 123456.789, 9.995, 1e14 + 0.5, 1e16, 3.0e300 }) {
+		for (int precision : { 0, 1, 2, 3, 6, 9, 12 }) {
+			char expected[512];
+			std::snprintf(expected, sizeof(expected), "%.*f", precision, value);
+			te_string spec = TE_TEXT(".") + from_utf8(std::to_string(precision)) + TE_TEXT("f");
+			BOOST_CHECK_EQUAL(format(spec, TypedValue(value)), from_utf8(expected));
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(booleans_and_timestamps)
+{
+	BOOST_CHECK_EQUAL(TypedValue(true).toString(), TE_TEXT("true"));
+	BOOST_CHECK_EQUAL(format(TE_TEXT(">6"), TypedValue(false)), TE_TEXT(" false"));
+	BOOST_CHECK_EQUAL(format(TE_TEXT("d"), TypedValue(true)), TE_TEXT("1"));
+	BOOST_CHECK_THROW(format(TE_TEXT("f"), TypedValue(true)), TemplateException);
+
+	const int64_t second = 1000000000;
+	BOOST_CHECK_EQUAL(timestamp(0).toString(), TE_TEXT("1970-01-01T00:00:00Z"));
+	BOOST_CHECK_EQUAL(timestamp(1700000000 * second).toString(), TE_TEXT("2023-11-14T22:13:20Z"));
+	BOOST_CHECK_EQUAL(timestamp(951782400 * second).toString(), TE_TEXT("2000-02-29T00:00:00Z"));
+	BOOST_CHECK_EQUAL(format(TE_TEXT(".3"), timestamp(second + second / 2)), TE_TEXT("1970-01-01T00:00:01.500Z"));
+
+	// before the epoch
+	BOOST_CHECK_EQUAL(timestamp(-second).toString(), TE_TEXT("1969-12-31T23:59:59Z"));
+	BOOST_CHECK_EQUAL(format(TE_TEXT(".1"), timestamp(-second / 2)), TE_TEXT("1969-12-31T23:59:59.5Z"));
+	BOOST_CHECK_EQUAL(format(TE_TEXT("d"), timestamp(-second / 2)), TE_TEXT("-1"));
+	BOOST_CHECK_EQUAL(format(TE_TEXT("d"), timestamp(1700000000 * second)), TE_TEXT("1700000000"));
+	BOOST_CHECK_THROW(format(TE_TEXT("x"), timestamp(0)), TemplateException);
+}
+
+BOOST_AUTO_TEST_CASE(strings)
+{
+	te_string out;
+	ValueFormat(TE_TEXT(">5")).format(out, TE_TEXT("ab"), 2);
+	ValueFormat(TE_TEXT("-^6s")).format(out, TE_TEXT("ab"), 2);
+	ValueFormat(TE_TEXT(".3")).format(out, TE_TEXT("abcdef"), 6);
+	BOOST_CHECK_EQUAL(out, TE_TEXT("   ab--ab--abc"));
+	BOOST_CHECK_THROW(ValueFormat(TE_TEXT("d")).format(out, TE_TEXT("ab"), 2), TemplateException);
+
+	BOOST_CHECK(ValueFormat().isDefault());
+	BOOST_CHECK_EQUAL(ValueFormat(TE_TEXT("*>8.2f")).getSpec(), TE_TEXT("*>8.2f"));
+	for (const te_char_t* spec : { TE_TEXT(""), TE_TEXT("q"), TE_TEXT("."), TE_TEXT(".f"), TE_TEXT("5x5"), TE_TEXT("99999"), TE_TEXT(".100f"), TE_TEXT("ff") })
+		BOOST_CHECK_THROW(ValueFormat{ te_string(spec) }, TemplateException);
+}
+
+BOOST_FIXTURE_TEST_CASE(dictionary, TypedFixture)
+{
+	BOOST_CHECK(dict->isValue(TE_TEXT("PRICE")));
+	BOOST_CHECK(dict->isTyped(TE_TEXT("PRICE")));
+	BOOST_CHECK(!dict->isTyped(TE_TEXT("NAME")));
+	BOOST_CHECK_EQUAL(dict->getTyped(TE_TEXT("COUNT")).getInteger(), 42);
+	BOOST_CHECK_THROW(dict->getValue(TE_TEXT("PRICE")), TemplateException);
+	BOOST_CHECK_THROW(dict->getTyped(TE_TEXT("NAME")), TemplateException);
+
+	te_string out;
+	dict->formatValue(TE_TEXT("PRICE"), ValueFormat(TE_TEXT(".1f")), out);
+	dict->formatValue(TE_TEXT("NAME"), ValueFormat(), out);
+	BOOST_CHECK_EQUAL(out, TE_TEXT("19.9Tom & Jerry"));
+
+	dict->set(TE_TEXT("COUNT"), TypedValue(7));
+	dict->set(TE_TEXT("NAME"), TypedValue(false));
+	BOOST_CHECK_EQUAL(render(TE_TEXT("{{COUNT}} {{NAME}}")), TE_TEXT("7 false"));
+}
+
+BOOST_FIXTURE_TEST_CASE(expansion, TypedFixture)
+{
+	BOOST_CHECK_EQUAL(render(TE_TEXT("{{PRICE}} {{PRICE:.1f}} {{COUNT:04}}")), TE_TEXT("19.95 19.9 0042"));
+	BOOST_CHECK_EQUAL(render(TE_TEXT("[{{NAME:<14}}] [{{NAME:.3}}]")), TE_TEXT("[Tom & Jerry   ] [Tom]"));
+	BOOST_CHECK_EQUAL(render(TE_TEXT("{{#repeat items}}{{QUANTITY:>3}} {{IN_STOCK}} {{:PRICE:.2f}};{{/repeat}}")),
+		TE_TEXT("  1 false 19.95; 12 true 19.95;"));
+
+	// the format comes before the filters, and the filters before the escaper
+	BOOST_CHECK_EQUAL(render(TE_TEXT("{{NAME:>13|upper|html}}")), TE_TEXT("  TOM &amp; JERRY"));
+	BOOST_CHECK_EQUAL(parse(TE_TEXT("{{COUNT:*^6}}|{{NAME:.5}}"))->render<HtmlEscaper>(ctx), TE_TEXT("**42**|Tom &amp;"));
+	te_string out = TE_TEXT(">");
+	parse(TE_TEXT("{{PRICE:e}}"))->renderInto(ctx, out);
+	BOOST_CHECK_EQUAL(out, TE_TEXT(">1.995000e+01"));
+
+	BOOST_CHECK_THROW(parse(TE_TEXT("{{PRICE:}}")), TemplateException);
+	BOOST_CHECK_THROW(parse(TE_TEXT("{{PRICE:.2q}}")), TemplateException);
+	BOOST_CHECK_THROW(parse(TE_TEXT("{{PRICE:.2f x}}")), TemplateException);
+	BOOST_CHECK_THROW(parse(TE_TEXT("{{PRICE|html:.2f}}")), TemplateException);
+	BOOST_CHECK_THROW(parse(TE_TEXT("{{#repeat items:5}}{{/repeat}}")), TemplateException);
+	BOOST_CHECK_THROW(render(TE_TEXT("{{NAME:d}}")), TemplateException);
+	BOOST_CHECK_THROW(render(TE_TEXT("{{items:5}}")), TemplateException);
+}
+
+BOOST_FIXTURE_TEST_CASE(transformations, TypedFixture)
+{
+	// every way of rendering an expansion formats it
+	const te_string definition = TE_TEXT("{{PRICE:>7.2f|html}} {{#repeat items}}{{QUANTITY:03}},{{/repeat}}");
+	const te_string expected = TE_TEXT("  19.95 001,012,");
+	TemplatePtr t = parse(definition);
+	BOOST_CHECK_EQUAL(t->render(ctx), expected);
+
+	std::string image = TemplateImage::save(t);
+	TemplatePtr loaded = TemplateImage::load(image.data(), image.size(), nullptr);
+	BOOST_CHECK_EQUAL(loaded->render(ctx), expected);
+
+	RenderCache cache(t);
+	BOOST_CHECK_EQUAL(cache.render(ctx), expected);
+	dict->set(TE_TEXT("PRICE"), TypedValue(5));
+	BOOST_CHECK_EQUAL(cache.render(ctx), TE_TEXT("   5.00 001,012,"));
+
+	DictionaryPtr known = std::make_shared<Dictionary>();
+	known->add(TE_TEXT("PRICE"), TypedValue(0.5));
+	TemplatePtr residual = Template::specialize(t, known);
+	BOOST_CHECK_EQUAL(residual->render(ctx), TE_TEXT("   0.50 001,012,"));
+
+	TemplatePtr folded = TemplateOptimizer(true).optimize(parse(TE_TEXT("{{APP:>20}}")));
+	BOOST_CHECK_EQUAL(folded->render(ctx), render(TE_TEXT("{{APP:>20}}")));
+}
+
+BOOST_AUTO_TEST_SUITE_END();
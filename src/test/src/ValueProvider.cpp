@@ -0,0 +1,179 @@
+// Copyright (C) 2015,2016 Anton Lauridsen
+//
+// This file is part of libTemplateEngine.
+//
+// libTemplateEngine is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libTemplateEngine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with libTemplateEngine. If not, see <http://www.gnu.org/licenses/>.
+#include <boost/test/unit_test.hpp>
+
+
+#include <TemplateEngine.hpp>
+
+// generated by te-compile from the files in templates/
+#include "test_templates.hpp"
+
+using namespace template_engine;
+
+// Boost test doesn't know these types and cannot output their value
+BOOST_TEST_DONT_PRINT_LOG_VALUE(te_string);
+
+namespace
+{
+TemplatePtr parse(const te_string& definition)
+{
+	StringScanner s(definition);
+	return Template::parse(s);
+}
+
+struct ProviderFixture {
+	ProviderFixture() : dict(std::make_shared<Dictionary>()), ctx(Context::BuildContext()), calls(0), unusedCalls(0)
+	{
+		ctx->setDictionary(dict);
+		dict->addProvider(TE_TEXT("TOTAL"), [this]() {
+			++calls;
+			return from_utf8(std::to_string(calls * 100));
+		});
+		dict->addProvider(TE_TEXT("UNUSED"), [this]() {
+			++unusedCalls;
+			return te_string(TE_TEXT("unused"));
+		});
+
+		DictionaryListPtr list = std::make_shared<DictionaryList>();
+		dict->add(TE_TEXT("items"), list);
+		for (const te_char_t* value : { TE_TEXT("a"), TE_TEXT("b") }) {
+			DictionaryPtr item = std::make_shared<Dictionary>();
+			list->add(item);
+			item->add(TE_TEXT("VALUE"), value);
+		}
+	}
+
+	te_string render(const te_string& definition)
+	{
+		return parse(definition)->render(ctx);
+	}
+
+	DictionaryPtr dict;
+	ContextPtr ctx;
+	int calls;
+	int unusedCalls;
+};
+}
+
+BOOST_FIXTURE_TEST_SUITE(ValueProviderTest, ProviderFixture);
+
+BOOST_AUTO_TEST_CASE(once_per_render)
+{
+	TemplatePtr t = parse(TE_TEXT("{{TOTAL}} {{#repeat items}}{{VALUE}}={{:TOTAL:>4}};{{/repeat}}"));
+	BOOST_CHECK_EQUAL(t->render(ctx), TE_TEXT("100 a= 100;b= 100;"));
+	BOOST_CHECK_EQUAL(calls, 1);
+
+	// every render computes the value again
+	BOOST_CHECK_EQUAL(t->render<HtmlEscaper>(ctx), TE_TEXT("200 a= 200;b= 200;"));
+	te_string out;
+	t->renderInto(ctx, out);
+	BOOST_CHECK_EQUAL(out, TE_TEXT("300 a= 300;b= 300;"));
+	BOOST_CHECK_EQUAL(calls, 3);
+
+	// unless the renders share a scope
+	{
+		RenderScope scope;
+		BOOST_CHECK_EQUAL(t->render(ctx), t->render(ctx));
+		BOOST_CHECK_EQUAL(dict->getValue(TE_TEXT("TOTAL")), TE_TEXT("400"));
+	}
+	BOOST_CHECK_EQUAL(calls, 4);
+
+	BOOST_CHECK_EQUAL(unusedCalls, 0);
+	BOOST_CHECK(dict->isValue(TE_TEXT("UNUSED")));
+	BOOST_CHECK(dict->isProvided(TE_TEXT("UNUSED")));
+	BOOST_CHECK(!dict->isProvided(TE_TEXT("items")));
+	BOOST_CHECK_EQUAL(unusedCalls, 0);
+}
+
+BOOST_AUTO_TEST_CASE(errors)
+{
+	BOOST_CHECK_THROW(dict->addProvider(TE_TEXT("EMPTY"), ValueProvider()), TemplateException);
+	BOOST_CHECK_THROW(dict->getValue(TE_TEXT("TOTAL")), TemplateException);
+	BOOST_CHECK_THROW(render(TE_TEXT("{{TOTAL:d}}")), TemplateException);
+	BOOST_CHECK_EQUAL(calls, 1);
+
+	// a provider which throws is called again
+	bool fail = true;
+	dict->setProvider(TE_TEXT("FLAKY"), [&]() {
+		if (fail)
+			throw TemplateException("unavailable");
+		return te_string(TE_TEXT("ok"));
+	});
+	TemplatePtr t = parse(TE_TEXT("{{FLAKY}}"));
+	{
+		RenderScope scope;
+		BOOST_CHECK_THROW(t->render(ctx), TemplateException);
+		fail = false;
+		BOOST_CHECK_EQUAL(t->render(ctx), TE_TEXT("ok"));
+	}
+
+	// a provider expanding its own value
+	TemplatePtr self = parse(TE_TEXT("<{{SELF}}>"));
+	dict->setProvider(TE_TEXT("SELF"), [&]() { return self->render(ctx); });
+	BOOST_CHECK_THROW(self->render(ctx), TemplateException);
+
+	// providers may expand other provided values
+	TemplatePtr total = parse(TE_TEXT("[{{TOTAL}}]"));
+	dict->setProvider(TE_TEXT("SELF"), [&]() { return total->render(ctx); });
+	BOOST_CHECK_EQUAL(render(TE_TEXT("{{SELF}} {{TOTAL}}")), TE_TEXT("[200] 200"));
+}
+
+BOOST_AUTO_TEST_CASE(transformations)
+{
+	const te_string definition = TE_TEXT("{{#repeat items}}{{VALUE}}{{/repeat}} {{TOTAL|html}}");
+	TemplatePtr t = parse(definition);
+
+	// the value is read every time, so the cache renders the memos around it again
+	RenderCache cache(t);
+	BOOST_CHECK_EQUAL(cache.render(ctx), TE_TEXT("ab 100"));
+	BOOST_CHECK_EQUAL(cache.render(ctx), TE_TEXT("ab 200"));
+	BOOST_CHECK_EQUAL(cache.getReused(), 2u);
+
+	std::string image = TemplateImage::save(t);
+	BOOST_CHECK_EQUAL(TemplateImage::load(image.data(), image.size(), nullptr)->render(ctx), TE_TEXT("ab 300"));
+
+	// the values known ahead of time may be provided too, they are computed for every render
+	TemplatePtr residual = Template::specialize(parse(TE_TEXT("{{TOTAL}} {{TOTAL}}")), dict);
+	BOOST_CHECK_EQUAL(calls, 3);
+	BOOST_CHECK_EQUAL(residual->render(ctx), TE_TEXT("400 400"));
+	BOOST_CHECK_EQUAL(residual->render(ctx), TE_TEXT("500 500"));
+	BOOST_CHECK_EQUAL(calls, 5);
+	BOOST_CHECK_THROW(TemplateImage::save(residual), TemplateException);
+}
+
+BOOST_AUTO_TEST_CASE(generated)
+{
+	// a generated render function opens a scope of its own
+	dict->setProvider(TE_TEXT("TEST"), [this]() {
+		++calls;
+		return te_string(TE_TEXT("<TEST>"));
+	});
+	DictionaryListPtr list = std::make_shared<DictionaryList>();
+	dict->add(TE_TEXT("section"), list);
+	DictionaryPtr child = std::make_shared<Dictionary>();
+	list->add(child);
+	child->add(TE_TEXT("B"), TE_TEXT("b"));
+	child->add(TE_TEXT("inner"), std::make_shared<DictionaryList>());
+
+	te_string out;
+	templates::render_page(out, dict);
+	BOOST_CHECK_EQUAL(calls, 1);
+	BOOST_CHECK_EQUAL(out, templates::page()->render(ctx));
+	BOOST_CHECK_EQUAL(calls, 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END();